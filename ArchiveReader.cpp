@@ -0,0 +1,766 @@
+#include "ArchiveReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+constexpr size_t TAR_BLOCK = 512;
+// Длинное имя GNU и заголовок pax читаются в память целиком
+constexpr uint64_t MAX_TAR_META_SIZE = 1 << 20;
+// Буфер потока члена: заглядывание вперед для вложенного архива
+constexpr size_t MEMBER_BUFFER_SIZE = 64 << 10;
+constexpr uint64_t UNKNOWN_SIZE = std::numeric_limits<uint64_t>::max();
+
+constexpr uint32_t ZIP_LOCAL_HEADER = 0x04034b50;
+constexpr uint32_t ZIP_CENTRAL_HEADER = 0x02014b50;
+constexpr uint32_t ZIP64_END_RECORD = 0x06064b50;
+constexpr uint32_t ZIP_END_RECORD = 0x06054b50;
+constexpr uint32_t ZIP_DESCRIPTOR = 0x08074b50;
+constexpr uint16_t ZIP_FLAG_ENCRYPTED = 0x0001;
+constexpr uint16_t ZIP_FLAG_DESCRIPTOR = 0x0008;
+constexpr uint16_t ZIP_STORED = 0;
+constexpr uint16_t ZIP_DEFLATED = 8;
+
+// Поврежденный архив или превышенный лимит: разбор обрывается, дайджест
+// самого файла все равно досчитывается
+class ArchiveError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// Превышен лимит из ArchiveOptions: обрывает разбор всего файла, в том
+// числе из вложенного архива
+class LimitError : public ArchiveError {
+    using ArchiveError::ArchiveError;
+};
+
+// Ошибка чтения самого файла: дайджестов у него нет
+class FileReadError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct FdGuard {
+    int fd;
+    ~FdGuard() { if (fd >= 0) ::close(fd); }
+};
+
+uint16_t load_le16(const unsigned char* p) noexcept {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t load_le32(const unsigned char* p) noexcept {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t load_le64(const unsigned char* p) noexcept {
+    return static_cast<uint64_t>(load_le32(p)) | (static_cast<uint64_t>(load_le32(p + 4)) << 32);
+}
+
+class Source {
+public:
+    virtual ~Source() = default;
+    // 0 - конец потока
+    virtual size_t Read(unsigned char* data, size_t size) = 0;
+};
+
+class FileSource : public Source {
+private:
+    int fd_;
+    ReadTimings& timings_;
+public:
+    FileSource(int fd, ReadTimings& timings) : fd_(fd), timings_(timings) {}
+
+    size_t Read(unsigned char* data, size_t size) override {
+        const auto started = std::chrono::steady_clock::now();
+        ssize_t n;
+        do {
+            n = ::read(fd_, data, size);
+        } while (n < 0 && errno == EINTR);
+        timings_.read += std::chrono::steady_clock::now() - started;
+        if (n < 0) {
+            throw FileReadError("ошибка чтения");
+        }
+        timings_.bytes += static_cast<uint64_t>(n);
+        return static_cast<size_t>(n);
+    }
+};
+
+// Все прочитанные байты попутно уходят в дайджесты
+class DigestSource : public Source {
+private:
+    Source& inner_;
+    DigestAccumulator* accumulator_;
+    ReadTimings* timings_;
+    uint64_t bytes_ = 0;
+public:
+    // accumulator == nullptr - только считать байты
+    DigestSource(Source& inner, DigestAccumulator* accumulator, ReadTimings* timings = nullptr)
+        : inner_(inner), accumulator_(accumulator), timings_(timings) {}
+
+    uint64_t bytes() const noexcept { return bytes_; }
+
+    size_t Read(unsigned char* data, size_t size) override {
+        const size_t n = inner_.Read(data, size);
+        bytes_ += n;
+        if (accumulator_ != nullptr && n > 0) {
+            const auto started = timings_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            if (!accumulator_->update(data, n)) {
+                throw FileReadError("ошибка хеширования");
+            }
+            if (timings_) {
+                timings_->hash += std::chrono::steady_clock::now() - started;
+            }
+        }
+        return n;
+    }
+};
+
+// Буфер над источником: заглядывание вперед для определения формата и
+// заголовков; распаковщик берет сжатые байты прямо из него, и то, что он
+// не съел, достается следующему заголовку
+class BufferedSource : public Source {
+private:
+    Source& inner_;
+    std::vector<unsigned char> buffer_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    bool eof_ = false;
+public:
+    BufferedSource(Source& inner, size_t capacity)
+        : inner_(inner), buffer_(std::max(capacity, ArchiveReader::DETECT_SIZE)) {}
+
+    // До size байт (меньше - только у конца потока)
+    std::span<const unsigned char> Peek(size_t size) {
+        size = std::min(size, buffer_.size());
+        if (end_ - begin_ < size && !eof_) {
+            std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+            while (end_ < size) {
+                const size_t n = inner_.Read(buffer_.data() + end_, buffer_.size() - end_);
+                if (n == 0) {
+                    eof_ = true;
+                    break;
+                }
+                end_ += n;
+            }
+        }
+        return {buffer_.data() + begin_, std::min(size, end_ - begin_)};
+    }
+
+    // Хотя бы один байт, если поток не кончился
+    std::span<const unsigned char> Available() {
+        if (begin_ == end_ && !eof_) {
+            begin_ = end_ = 0;
+            end_ = inner_.Read(buffer_.data(), buffer_.size());
+            eof_ = end_ == 0;
+        }
+        return {buffer_.data() + begin_, end_ - begin_};
+    }
+
+    void Consume(size_t size) noexcept { begin_ += size; }
+
+    size_t Read(unsigned char* data, size_t size) override {
+        const auto available = Available();
+        const size_t n = std::min(size, available.size());
+        std::memcpy(data, available.data(), n);
+        Consume(n);
+        return n;
+    }
+
+    void ReadExact(void* data, size_t size) {
+        auto* out = static_cast<unsigned char*>(data);
+        while (size > 0) {
+            const size_t n = Read(out, size);
+            if (n == 0) {
+                throw ArchiveError("неожиданный конец архива");
+            }
+            out += n;
+            size -= n;
+        }
+    }
+
+    void Skip(uint64_t size) {
+        while (size > 0) {
+            const auto available = Available();
+            if (available.empty()) {
+                throw ArchiveError("неожиданный конец архива");
+            }
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(size, available.size()));
+            Consume(n);
+            size -= n;
+        }
+    }
+
+    void Drain() {
+        for (auto available = Available(); !available.empty(); available = Available()) {
+            Consume(available.size());
+        }
+    }
+};
+
+// Кусок потока известной длины: член tar, член zip без сжатия
+class LimitedSource : public Source {
+private:
+    BufferedSource& inner_;
+    uint64_t remaining_;
+public:
+    LimitedSource(BufferedSource& inner, uint64_t size) : inner_(inner), remaining_(size) {}
+
+    size_t Read(unsigned char* data, size_t size) override {
+        if (remaining_ == 0) {
+            return 0;
+        }
+        const size_t n = inner_.Read(data, static_cast<size_t>(std::min<uint64_t>(size, remaining_)));
+        if (n == 0) {
+            throw ArchiveError("неожиданный конец архива");
+        }
+        remaining_ -= n;
+        return n;
+    }
+};
+
+// Общие на файл лимиты: распакованные байты всех уровней и число членов
+class Budget {
+private:
+    const ArchiveOptions& options_;
+    uint64_t expanded_ = 0;
+    size_t members_ = 0;
+public:
+    explicit Budget(const ArchiveOptions& options) : options_(options) {}
+
+    size_t members() const noexcept { return members_; }
+
+    void AddExpanded(size_t bytes) {
+        expanded_ += bytes;
+        if (expanded_ > options_.max_expanded_size) {
+            throw LimitError("превышен предел распакованного размера");
+        }
+    }
+
+    void AddMember() {
+        if (++members_ > options_.max_members) {
+            throw LimitError("превышено число членов архива");
+        }
+    }
+};
+
+// Распаковка deflate. gzip - с оберткой gzip (и несколькими членами
+// подряд), иначе сырой поток члена zip: конец определяется самим deflate.
+class InflateSource : public Source {
+private:
+    BufferedSource& inner_;
+    Budget& budget_;
+    const bool gzip_;
+    z_stream stream_{};
+    bool finished_ = false;
+public:
+    InflateSource(BufferedSource& inner, Budget& budget, bool gzip)
+        : inner_(inner), budget_(budget), gzip_(gzip) {
+        if (inflateInit2(&stream_, gzip ? 16 + MAX_WBITS : -MAX_WBITS) != Z_OK) {
+            throw ArchiveError("не удалось инициализировать распаковку");
+        }
+    }
+
+    ~InflateSource() override { inflateEnd(&stream_); }
+
+    InflateSource(const InflateSource&) = delete;
+    InflateSource& operator=(const InflateSource&) = delete;
+
+    size_t Read(unsigned char* data, size_t size) override {
+        size = std::min<size_t>(size, UINT_MAX);
+        while (!finished_) {
+            const auto input = inner_.Available();
+            if (input.empty()) {
+                throw ArchiveError("обрыв сжатых данных");
+            }
+            stream_.next_in = const_cast<Bytef*>(input.data());
+            stream_.avail_in = static_cast<uInt>(std::min<size_t>(input.size(), UINT_MAX));
+            const uInt offered = stream_.avail_in;
+            stream_.next_out = data;
+            stream_.avail_out = static_cast<uInt>(size);
+            const int rc = inflate(&stream_, Z_NO_FLUSH);
+            inner_.Consume(offered - stream_.avail_in);
+            const size_t produced = size - stream_.avail_out;
+            if (rc == Z_STREAM_END) {
+                const auto next = gzip_ ? inner_.Peek(2) : std::span<const unsigned char>{};
+                if (next.size() == 2 && next[0] == 0x1f && next[1] == 0x8b) {
+                    inflateReset(&stream_);
+                } else {
+                    finished_ = true;
+                }
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                throw ArchiveError("поврежденные сжатые данные");
+            }
+            if (produced > 0) {
+                budget_.AddExpanded(produced);
+                return produced;
+            }
+        }
+        return 0;
+    }
+};
+
+void drain(Source& source, std::vector<unsigned char>& scratch) {
+    while (source.Read(scratch.data(), scratch.size()) > 0) {
+    }
+}
+
+// Имя единственного члена gzip: имя файла без .gz, у .tgz - .tar
+std::string gzip_member_name(const std::string& path) {
+    const size_t slash = path.find_last_of("/!");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (name.size() > 4 && name.ends_with(".tgz")) {
+        return name.substr(0, name.size() - 4) + ".tar";
+    }
+    if (name.size() > 3 && name.ends_with(".gz")) {
+        return name.substr(0, name.size() - 3);
+    }
+    return name.empty() ? "data" : name;
+}
+
+// Число tar: восьмеричное с пробелами и NUL либо base-256 (старший бит)
+uint64_t parse_tar_number(const unsigned char* field, size_t size) {
+    uint64_t value = 0;
+    if (field[0] & 0x80) {
+        // Отрицательные (бит 0x40) для размеров не бывают
+        if (field[0] & 0x40) {
+            throw ArchiveError("неверное число в заголовке tar");
+        }
+        value = field[0] & 0x3f;
+        for (size_t i = 1; i < size; ++i) {
+            if (value >> 56) {
+                throw ArchiveError("неверное число в заголовке tar");
+            }
+            value = (value << 8) | field[i];
+        }
+        return value;
+    }
+    size_t i = 0;
+    while (i < size && field[i] == ' ') {
+        ++i;
+    }
+    for (; i < size && field[i] >= '0' && field[i] <= '7'; ++i) {
+        if (value >> 61) {
+            throw ArchiveError("неверное число в заголовке tar");
+        }
+        value = (value << 3) | static_cast<uint64_t>(field[i] - '0');
+    }
+    if (i < size && field[i] != ' ' && field[i] != '\0') {
+        throw ArchiveError("неверное число в заголовке tar");
+    }
+    return value;
+}
+
+bool tar_checksum_valid(const unsigned char* header) {
+    const uint64_t stored = parse_tar_number(header + 148, 8);
+    uint64_t unsigned_sum = 0;
+    int64_t signed_sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK; ++i) {
+        const unsigned char byte = i >= 148 && i < 156 ? ' ' : header[i];
+        unsigned_sum += byte;
+        signed_sum += static_cast<signed char>(byte);
+    }
+    // Старые tar считали сумму по знаковым байтам
+    return stored == unsigned_sum || static_cast<int64_t>(stored) == signed_sum;
+}
+
+std::string tar_field(const unsigned char* field, size_t size) {
+    const auto* end = static_cast<const unsigned char*>(std::memchr(field, 0, size));
+    return std::string(reinterpret_cast<const char*>(field), end ? static_cast<size_t>(end - field) : size);
+}
+
+std::string tar_header_name(const unsigned char* header) {
+    std::string name = tar_field(header, 100);
+    // Префикс пути есть только у POSIX ustar; у GNU на его месте времена
+    if (std::memcmp(header + 257, "ustar\0", 6) == 0) {
+        std::string prefix = tar_field(header + 345, 155);
+        if (!prefix.empty()) {
+            name = prefix + "/" + name;
+        }
+    }
+    return name;
+}
+
+// Записи pax "<длина> <ключ>=<значение>\n"; нужны только path и size, не
+// заданные остаются пустой строкой и UNKNOWN_SIZE
+void parse_pax(const std::string& records, std::string& path, uint64_t& size) {
+    size_t pos = 0;
+    while (pos < records.size()) {
+        const size_t space = records.find(' ', pos);
+        if (space == std::string::npos) {
+            break;
+        }
+        const uint64_t length = std::strtoull(records.c_str() + pos, nullptr, 10);
+        if (length == 0 || length > records.size() - pos) {
+            throw ArchiveError("неверный заголовок pax");
+        }
+        const std::string record = records.substr(space + 1, pos + length - space - 2);
+        const size_t equals = record.find('=');
+        if (equals != std::string::npos) {
+            const std::string key = record.substr(0, equals);
+            if (key == "path") {
+                path = record.substr(equals + 1);
+            } else if (key == "size") {
+                size = std::strtoull(record.c_str() + equals + 1, nullptr, 10);
+            }
+        }
+        pos += length;
+    }
+}
+
+class MemberScanner {
+private:
+    const ArchiveOptions& options_;
+    const unsigned algorithms_;
+    const ArchiveReader::MemberCallback& on_member_;
+    Budget budget_;
+    std::vector<unsigned char> scratch_;
+public:
+    MemberScanner(const ArchiveOptions& options, unsigned algorithms, const ArchiveReader::MemberCallback& on_member)
+        : options_(options), algorithms_(algorithms), on_member_(on_member), budget_(options),
+          scratch_(MEMBER_BUFFER_SIZE) {}
+
+    size_t members() const noexcept { return budget_.members(); }
+
+    // prefix - путь содержащего члена с '!' на конце; depth - уровень этого
+    // архива, 1 - сам файл
+    void ScanArchive(BufferedSource& source, ArchiveFormat format, const std::string& prefix,
+                     const std::string& gzip_name, unsigned depth) {
+        switch (format) {
+            case ArchiveFormat::Tar:
+                scan_tar(source, prefix, depth);
+                break;
+            case ArchiveFormat::Zip:
+                scan_zip(source, prefix, depth);
+                break;
+            case ArchiveFormat::Gzip: {
+                InflateSource inflated(source, budget_, true);
+                BufferedSource unpacked(inflated, MEMBER_BUFFER_SIZE);
+                if (ArchiveReader::Detect(unpacked.Peek(ArchiveReader::DETECT_SIZE)) == ArchiveFormat::Tar) {
+                    // tar.gz: члены tar на том же уровне, что и сам файл
+                    scan_tar(unpacked, prefix, depth);
+                    unpacked.Drain();
+                } else {
+                    scan_member(unpacked, prefix + gzip_name, UNKNOWN_SIZE, depth);
+                }
+                break;
+            }
+            case ArchiveFormat::None:
+                break;
+        }
+    }
+
+private:
+    void scan_member(Source& data, const std::string& path, uint64_t declared_size, unsigned depth) {
+        budget_.AddMember();
+        const bool hash = declared_size == UNKNOWN_SIZE || declared_size <= options_.max_member_size;
+        std::optional<DigestAccumulator> accumulator;
+        if (hash) {
+            accumulator.emplace(algorithms_);
+        }
+        DigestSource hashed(data, accumulator ? &*accumulator : nullptr);
+        ArchiveMember member;
+        member.path = path;
+        if (depth < options_.max_depth) {
+            const size_t capacity = static_cast<size_t>(
+                std::min<uint64_t>(declared_size, MEMBER_BUFFER_SIZE));
+            BufferedSource buffered(hashed, capacity);
+            const ArchiveFormat format = ArchiveReader::Detect(buffered.Peek(ArchiveReader::DETECT_SIZE));
+            if (format != ArchiveFormat::None) {
+                try {
+                    ScanArchive(buffered, format, path + "!", gzip_member_name(path), depth + 1);
+                } catch (const LimitError&) {
+                    throw;
+                } catch (const ArchiveError& e) {
+                    // Поврежденный вложенный архив не прячет ни сам член, ни
+                    // следующие за ним. Если поврежден внешний поток, Drain
+                    // наткнется на ту же ошибку и оборвет внешний архив.
+                    member.error = e.what();
+                }
+            }
+            buffered.Drain();
+        } else {
+            drain(hashed, scratch_);
+        }
+
+        member.size = hashed.bytes();
+        if (accumulator && member.size <= options_.max_member_size) {
+            member.digests = accumulator->finish();
+        } else {
+            member.skip_reason = "превышен размер члена";
+        }
+        on_member_(member);
+    }
+
+    void skip_member(const std::string& path, uint64_t size, const char* reason) {
+        budget_.AddMember();
+        ArchiveMember member;
+        member.path = path;
+        member.size = size;
+        member.skip_reason = reason;
+        on_member_(member);
+    }
+
+    void scan_tar(BufferedSource& source, const std::string& prefix, unsigned depth) {
+        unsigned char header[TAR_BLOCK];
+        // Имя и размер из заголовков перед членом, пустые между членами
+        std::string long_name;
+        std::string pax_path;
+        uint64_t pax_size = UNKNOWN_SIZE;
+        for (;;) {
+            const auto block = source.Peek(TAR_BLOCK);
+            if (block.empty()) {
+                // Архив без завершающих нулевых блоков
+                return;
+            }
+            if (block.size() < TAR_BLOCK) {
+                throw ArchiveError("обрезанный заголовок tar");
+            }
+            std::memcpy(header, block.data(), TAR_BLOCK);
+            source.Consume(TAR_BLOCK);
+            if (std::all_of(header, header + TAR_BLOCK, [](unsigned char byte) { return byte == 0; })) {
+                return;
+            }
+            if (!tar_checksum_valid(header)) {
+                throw ArchiveError("неверная контрольная сумма заголовка tar");
+            }
+
+            uint64_t size = parse_tar_number(header + 124, 12);
+            const char type = static_cast<char>(header[156]);
+            if (type == 'L' || type == 'x') {
+                // Длинное имя GNU или заголовок pax - для следующего члена
+                if (size > MAX_TAR_META_SIZE) {
+                    throw ArchiveError("слишком длинный заголовок tar");
+                }
+                std::string meta(static_cast<size_t>(size), '\0');
+                source.ReadExact(meta.data(), meta.size());
+                source.Skip(padding(size));
+                if (type == 'L') {
+                    long_name = meta.c_str();
+                } else {
+                    parse_pax(meta, pax_path, pax_size);
+                }
+                continue;
+            }
+
+            std::string name = tar_header_name(header);
+            if (!pax_path.empty()) {
+                name = std::move(pax_path);
+            } else if (!long_name.empty()) {
+                name = std::move(long_name);
+            }
+            if (pax_size != UNKNOWN_SIZE) {
+                size = pax_size;
+            }
+            long_name.clear();
+            pax_path.clear();
+            pax_size = UNKNOWN_SIZE;
+
+            if (type == '0' || type == '\0' || type == '7') {
+                LimitedSource data(source, size);
+                scan_member(data, prefix + name, size, depth);
+            } else {
+                // Директории, ссылки, глобальные заголовки pax
+                source.Skip(size);
+            }
+            source.Skip(padding(size));
+        }
+    }
+
+    static uint64_t padding(uint64_t size) noexcept {
+        return (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK;
+    }
+
+    void scan_zip(BufferedSource& source, const std::string& prefix, unsigned depth) {
+        unsigned char header[30];
+        for (;;) {
+            const auto signature_bytes = source.Peek(4);
+            if (signature_bytes.empty()) {
+                return;
+            }
+            if (signature_bytes.size() < 4) {
+                throw ArchiveError("обрезанный заголовок zip");
+            }
+            const uint32_t signature = load_le32(signature_bytes.data());
+            if (signature == ZIP_CENTRAL_HEADER || signature == ZIP64_END_RECORD || signature == ZIP_END_RECORD) {
+                // Дальше центральный каталог: все члены уже пройдены
+                source.Drain();
+                return;
+            }
+            if (signature != ZIP_LOCAL_HEADER) {
+                throw ArchiveError("неверный заголовок zip");
+            }
+            source.ReadExact(header, sizeof(header));
+            const uint16_t flags = load_le16(header + 6);
+            const uint16_t method = load_le16(header + 8);
+            uint64_t compressed = load_le32(header + 18);
+            uint64_t size = load_le32(header + 22);
+            std::string name(load_le16(header + 26), '\0');
+            source.ReadExact(name.data(), name.size());
+            std::vector<unsigned char> extra(load_le16(header + 28));
+            source.ReadExact(extra.data(), extra.size());
+
+            // Поле zip64: 64-битные размеры вместо 0xFFFFFFFF
+            bool zip64 = false;
+            for (size_t pos = 0; pos + 4 <= extra.size();) {
+                const uint16_t id = load_le16(extra.data() + pos);
+                const size_t length = load_le16(extra.data() + pos + 2);
+                const unsigned char* field = extra.data() + pos + 4;
+                if (pos + 4 + length > extra.size()) {
+                    break;
+                }
+                if (id == 0x0001) {
+                    zip64 = true;
+                    size_t offset = 0;
+                    if (size == 0xffffffff && offset + 8 <= length) {
+                        size = load_le64(field + offset);
+                        offset += 8;
+                    }
+                    if (compressed == 0xffffffff && offset + 8 <= length) {
+                        compressed = load_le64(field + offset);
+                    }
+                }
+                pos += 4 + length;
+            }
+
+            const bool descriptor = flags & ZIP_FLAG_DESCRIPTOR;
+            const bool directory = !name.empty() && name.back() == '/';
+            const std::string path = prefix + name;
+            if ((flags & ZIP_FLAG_ENCRYPTED) || (method != ZIP_STORED && method != ZIP_DEFLATED)) {
+                // Без расшифровки и неизвестным методом конец данных находится
+                // только по размеру из заголовка
+                if (descriptor && compressed == 0) {
+                    throw ArchiveError("член zip без размера: " + path);
+                }
+                source.Skip(compressed);
+                if (!directory) {
+                    skip_member(path, size, (flags & ZIP_FLAG_ENCRYPTED) ? "зашифрован" : "неизвестный метод сжатия");
+                }
+            } else if (method == ZIP_STORED) {
+                if (descriptor && compressed == 0 && size == 0 && !directory) {
+                    throw ArchiveError("член zip без размера: " + path);
+                }
+                LimitedSource data(source, compressed);
+                if (directory) {
+                    drain(data, scratch_);
+                } else {
+                    scan_member(data, path, compressed, depth);
+                }
+            } else {
+                InflateSource data(source, budget_, false);
+                if (directory) {
+                    drain(data, scratch_);
+                } else {
+                    scan_member(data, path, descriptor ? UNKNOWN_SIZE : size, depth);
+                }
+            }
+
+            if (descriptor) {
+                // Необязательная сигнатура, CRC и два размера
+                const auto next = source.Peek(4);
+                if (next.size() == 4 && load_le32(next.data()) == ZIP_DESCRIPTOR) {
+                    source.Consume(4);
+                }
+                source.Skip(zip64 ? 20 : 12);
+            }
+        }
+    }
+};
+
+} // namespace
+
+ArchiveReader::ArchiveReader(const ArchiveOptions& options, unsigned algorithms, size_t buffer_size)
+    : options_(options), algorithms_(algorithms), buffer_size_(buffer_size) {}
+
+ArchiveFormat ArchiveReader::Detect(std::span<const unsigned char> head) noexcept {
+    if (head.size() >= 4 && head[0] == 'P' && head[1] == 'K' &&
+        ((head[2] == 3 && head[3] == 4) || (head[2] == 5 && head[3] == 6))) {
+        return ArchiveFormat::Zip;
+    }
+    if (head.size() >= 2 && head[0] == 0x1f && head[1] == 0x8b) {
+        return ArchiveFormat::Gzip;
+    }
+    if (head.size() >= 262 && std::memcmp(head.data() + 257, "ustar", 5) == 0) {
+        return ArchiveFormat::Tar;
+    }
+    return ArchiveFormat::None;
+}
+
+ArchiveFormat ArchiveReader::DetectFile(const std::filesystem::path& path) noexcept {
+    size_t file_size = 0;
+    FdGuard file{MD5Compute::openFileForReading(path, file_size)};
+    if (file.fd < 0) {
+        return ArchiveFormat::None;
+    }
+    unsigned char head[DETECT_SIZE];
+    ssize_t n;
+    do {
+        n = ::pread(file.fd, head, sizeof(head), 0);
+    } while (n < 0 && errno == EINTR);
+    return n > 0 ? Detect({head, static_cast<size_t>(n)}) : ArchiveFormat::None;
+}
+
+ArchiveScanResult ArchiveReader::ScanFile(const std::filesystem::path& path, const MemberCallback& on_member,
+                                          ReadTimings* timings, bool archives_only) const {
+    ArchiveScanResult result;
+    ReadTimings local_timings;
+    ReadTimings& file_timings = timings ? *timings : local_timings;
+
+    size_t file_size = 0;
+    const auto open_started = std::chrono::steady_clock::now();
+    FdGuard file{MD5Compute::openFileForReading(path, file_size)};
+    file_timings.open += std::chrono::steady_clock::now() - open_started;
+    file_timings.opened = file.fd >= 0;
+    if (file.fd < 0) {
+        return result;
+    }
+    if (archives_only) {
+        // pread не сдвигает позицию: архив дальше читается с начала
+        unsigned char head[DETECT_SIZE];
+        const auto read_started = std::chrono::steady_clock::now();
+        ssize_t n;
+        do {
+            n = ::pread(file.fd, head, sizeof(head), 0);
+        } while (n < 0 && errno == EINTR);
+        file_timings.read += std::chrono::steady_clock::now() - read_started;
+        if (n <= 0 || options_.max_depth == 0 || Detect({head, static_cast<size_t>(n)}) == ArchiveFormat::None) {
+            return result;
+        }
+    }
+
+    DigestAccumulator accumulator(algorithms_);
+    FileSource file_source(file.fd, file_timings);
+    DigestSource hashed(file_source, &accumulator, &file_timings);
+    BufferedSource source(hashed, buffer_size_);
+    MemberScanner scanner(options_, algorithms_, on_member);
+    try {
+        try {
+            const ArchiveFormat format = Detect(source.Peek(DETECT_SIZE));
+            if (options_.max_depth > 0 && format != ArchiveFormat::None) {
+                result.format = format;
+                scanner.ScanArchive(source, format, {}, gzip_member_name(path.filename().string()), 1);
+            }
+        } catch (const ArchiveError& e) {
+            result.error = e.what();
+        }
+        // Остаток файла (каталог zip, хвост после ошибки) - только в дайджест
+        source.Drain();
+    } catch (const FileReadError&) {
+        result.members = scanner.members();
+        return result;
+    }
+    result.members = scanner.members();
+    result.digests = accumulator.finish();
+    return result;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include "Digest.h"
+#include "MD5Compute.h"
+
+enum class ArchiveFormat {
+    None,
+    Tar,
+    // gzip с tar внутри разбирается как tar, иначе - один член
+    Gzip,
+    Zip
+};
+
+struct ArchiveOptions {
+    // Уровней архивов, которые раскрываются: 1 - только члены самого файла,
+    // 0 - архив не разбирается
+    unsigned max_depth = 3;
+    // Члены больше этого не хешируются, их байты только проходят мимо
+    uint64_t max_member_size = 256ull << 20;
+    // Распакованных байт на файл со всеми вложенными архивами; превышение
+    // обрывает разбор (защита от zip-бомб)
+    uint64_t max_expanded_size = 4ull << 30;
+    size_t max_members = 100000;
+};
+
+struct ArchiveMember {
+    // Путь внутри файла; уровни вложенных архивов разделены '!'
+    std::string path;
+    uint64_t size = 0;
+    // nullopt - член не хешировался, причина в skip_reason
+    std::optional<FileDigests> digests;
+    const char* skip_reason = nullptr;
+    // Член - поврежденный архив: его члены после ошибки не разобраны, но
+    // дайджест самого члена посчитан
+    std::string error;
+};
+
+struct ArchiveScanResult {
+    // Формат самого файла по первым байтам; None - не архив или max_depth == 0
+    ArchiveFormat format = ArchiveFormat::None;
+    // Дайджесты самого файла; nullopt - файл не открылся, не прочитался или
+    // не дочитывался (archives_only)
+    std::optional<FileDigests> digests;
+    size_t members = 0;
+    // Поврежденный архив или превышенный лимит; члены до ошибки уже отданы
+    std::string error;
+};
+
+// Потоковый разбор tar, tar.gz, gzip и zip без распаковки на диск. Файл
+// читается один раз: те же байты идут в дайджесты файла и в разбор, члены
+// хешируются по ходу распаковки, вложенные архивы раскрываются прямо из
+// потока члена. Zip читается по локальным заголовкам, без центрального
+// каталога: так же читаются и вложенные zip, у которых нет произвольного
+// доступа. Зашифрованные члены и методы сжатия кроме stored и deflate
+// пропускаются.
+class DLL_EXPORT ArchiveReader {
+public:
+    using MemberCallback = std::function<void(const ArchiveMember&)>;
+    // Сколько первых байт нужно Detect (магия tar - на смещении 257)
+    static constexpr size_t DETECT_SIZE = 512;
+
+private:
+    ArchiveOptions options_;
+    unsigned algorithms_;
+    size_t buffer_size_;
+
+public:
+    ArchiveReader(const ArchiveOptions& options, unsigned algorithms, size_t buffer_size = 1 << 20);
+
+    static ArchiveFormat Detect(std::span<const unsigned char> head) noexcept;
+    // None - не архив или файл не читается
+    static ArchiveFormat DetectFile(const std::filesystem::path& path) noexcept;
+
+    // on_member вызывается для каждого члена по ходу чтения, вложенные -
+    // раньше содержащего их архива. timings - по самому файлу. Не-архив
+    // просто хешируется тем же проходом. archives_only - файл нужен только
+    // ради членов: формат определяется по первым DETECT_SIZE байт, и
+    // не-архив дальше не читается.
+    ArchiveScanResult ScanFile(const std::filesystem::path& path, const MemberCallback& on_member,
+                               ReadTimings* timings = nullptr, bool archives_only = false) const;
+};
@@ -0,0 +1,368 @@
+#include "AsyncDigestEngine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "IoUring.h"
+#include "RingBlockQueue.h"
+
+namespace {
+
+constexpr size_t BUFFER_ALIGNMENT = 4096;
+// user_data завершения чтения eventfd; у чтений файлов - номер полосы
+constexpr uint64_t EVENT_TAG = ~uint64_t{0};
+
+} // namespace
+
+// Поток отправки со своим кольцом. Полоса = буфер + слот в таблице файлов;
+// файл занимает полосу от первого чтения до последнего куска.
+class AsyncDigestEngine::Submitter {
+private:
+    struct Lane {
+        std::unique_ptr<FileJob> job;
+        unsigned char* buffer = nullptr;
+        unsigned read_length = 0;
+        bool fixed_file = false;
+        std::chrono::steady_clock::time_point read_started;
+        // Выставляет поток хеширования после последнего куска
+        bool finished = false;
+    };
+    struct FreeDeleter {
+        void operator()(unsigned char* p) const noexcept { std::free(p); }
+    };
+
+private:
+    AsyncDigestEngine& engine_;
+    unsigned depth_;
+    size_t buffer_size_;
+    // Буферы и приемник eventfd объявлены раньше кольца: разрушаются после
+    // него, когда ядро уже не может в них писать
+    std::unique_ptr<unsigned char, FreeDeleter> memory_;
+    uint64_t event_value_ = 0;
+    IoUring ring_;
+    std::vector<Lane> lanes_;
+    std::vector<unsigned> free_lanes_;
+    unsigned active_ = 0;
+    bool fixed_buffers_ = false;
+    bool fixed_files_ = false;
+    RingBlockQueue<FileJob*> incoming_;
+    // Полосы, чей кусок захеширован: дочитать или освободить
+    RingBlockQueue<unsigned> ready_;
+    int event_fd_ = -1;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+private:
+    void loop();
+    void arm_eventfd();
+    void start(FileJob* job);
+    void submit_read(unsigned lane);
+    void retire(unsigned lane);
+    void on_completion(const io_uring_cqe& cqe);
+    void hash_chunk(unsigned lane, int result) noexcept;
+    io_uring_sqe* next_sqe();
+public:
+    Submitter(AsyncDigestEngine& engine, unsigned depth, size_t buffer_size);
+    ~Submitter() noexcept;
+
+    void enqueue(FileJob* job);
+    void wake() noexcept;
+    bool fixed_buffers() const noexcept { return fixed_buffers_; }
+};
+
+AsyncDigestEngine::Submitter::Submitter(AsyncDigestEngine& engine, unsigned depth, size_t buffer_size)
+    : engine_(engine), depth_(depth), buffer_size_(buffer_size), ring_(depth + 1),
+      incoming_(depth * 2), ready_(depth) {
+    memory_.reset(static_cast<unsigned char*>(std::aligned_alloc(BUFFER_ALIGNMENT, depth_ * buffer_size_)));
+    if (!memory_) {
+        throw std::runtime_error("Не удается выделить буферы io_uring");
+    }
+    lanes_.resize(depth_);
+    free_lanes_.reserve(depth_);
+    std::vector<iovec> iovecs(depth_);
+    for (unsigned i = 0; i < depth_; ++i) {
+        lanes_[i].buffer = memory_.get() + i * buffer_size_;
+        iovecs[i] = iovec{lanes_[i].buffer, buffer_size_};
+        free_lanes_.push_back(depth_ - 1 - i);
+    }
+    // Без регистрации (мало RLIMIT_MEMLOCK, старое ядро) работают обычные чтения
+    fixed_buffers_ = ring_.register_buffers(iovecs.data(), depth_) == 0;
+    const std::vector<int> empty_slots(depth_, -1);
+    fixed_files_ = ring_.register_files(empty_slots.data(), depth_) == 0;
+
+    event_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (event_fd_ < 0) {
+        throw std::runtime_error("Не удается создать eventfd для io_uring");
+    }
+    thread_ = std::thread([this]() { loop(); });
+}
+
+AsyncDigestEngine::Submitter::~Submitter() noexcept {
+    stopping_.store(true, std::memory_order_seq_cst);
+    const uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = ::write(event_fd_, &one, sizeof(one));
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::close(event_fd_);
+}
+
+void AsyncDigestEngine::Submitter::enqueue(FileJob* job) {
+    incoming_.Push(job);
+    wake();
+}
+
+// Будим поток отправки, только если он уснул в io_uring_enter
+void AsyncDigestEngine::Submitter::wake() noexcept {
+    if (sleeping_.exchange(false, std::memory_order_seq_cst)) {
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(event_fd_, &one, sizeof(one));
+    }
+}
+
+io_uring_sqe* AsyncDigestEngine::Submitter::next_sqe() {
+    io_uring_sqe* sqe = ring_.get_sqe();
+    while (sqe == nullptr) {
+        ring_.submit_and_wait(0);
+        sqe = ring_.get_sqe();
+    }
+    return sqe;
+}
+
+void AsyncDigestEngine::Submitter::arm_eventfd() {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = event_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&event_value_);
+    sqe->len = sizeof(event_value_);
+    sqe->off = ~uint64_t{0};
+    sqe->user_data = EVENT_TAG;
+}
+
+void AsyncDigestEngine::Submitter::start(FileJob* job) {
+    const unsigned index = free_lanes_.back();
+    free_lanes_.pop_back();
+    ++active_;
+    Lane& lane = lanes_[index];
+    lane.job.reset(job);
+    lane.finished = false;
+    // Регистрация файла - лишний системный вызов, окупается только на
+    // файлах в несколько чтений
+    lane.fixed_file = fixed_files_ && job->size > buffer_size_ && ring_.update_file(index, job->fd) == 0;
+    submit_read(index);
+}
+
+void AsyncDigestEngine::Submitter::submit_read(unsigned index) {
+    Lane& lane = lanes_[index];
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = fixed_buffers_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    if (fixed_buffers_) {
+        sqe->buf_index = static_cast<uint16_t>(index);
+    }
+    if (lane.fixed_file) {
+        sqe->fd = static_cast<int>(index);
+        sqe->flags |= IOSQE_FIXED_FILE;
+    } else {
+        sqe->fd = lane.job->fd;
+    }
+    sqe->addr = reinterpret_cast<uint64_t>(lane.buffer);
+    sqe->len = static_cast<uint32_t>(buffer_size_);
+    sqe->off = lane.job->offset;
+    sqe->user_data = index;
+    lane.read_length = static_cast<unsigned>(buffer_size_);
+    if (engine_.metrics_ != nullptr) {
+        lane.read_started = std::chrono::steady_clock::now();
+    }
+}
+
+void AsyncDigestEngine::Submitter::retire(unsigned index) {
+    Lane& lane = lanes_[index];
+    if (lane.fixed_file) {
+        ring_.update_file(index, -1);
+    }
+    ::close(lane.job->fd);
+    lane.job.reset();
+    free_lanes_.push_back(index);
+    --active_;
+}
+
+void AsyncDigestEngine::Submitter::hash_chunk(unsigned index, int result) noexcept {
+    Lane& lane = lanes_[index];
+    FileJob& job = *lane.job;
+    bool failed = result < 0;
+    if (!failed && result > 0) {
+        const auto hash_started = std::chrono::steady_clock::now();
+        failed = !job.digests.update(lane.buffer, static_cast<size_t>(result));
+        job.hash_time += std::chrono::steady_clock::now() - hash_started;
+    }
+    // Короткое чтение за пределами размера из fstat - конец файла, лишнее
+    // чтение ради нулевого ответа не нужно
+    bool finished = failed;
+    if (!failed) {
+        job.offset += static_cast<uint64_t>(result);
+        finished = result == 0 || (static_cast<unsigned>(result) < lane.read_length && job.offset >= job.size);
+    }
+    if (finished) {
+        std::optional<FileDigests> digests;
+        if (!failed) {
+            digests = job.digests.finish();
+        }
+        if (ScanMetrics* metrics = engine_.metrics_) {
+            if (digests.has_value()) {
+                metrics->Record(ScanStage::Read, job.read_time);
+                metrics->Record(ScanStage::Hash, job.hash_time);
+                metrics->AddBytes(job.offset);
+            } else if (result < 0) {
+                metrics->AddSkipped(SkipReason::ReadFailed);
+            }
+        }
+        Completion done = std::move(job.done);
+        lane.finished = true;
+        try {
+            done(std::move(digests));
+        } catch (...) {
+            // Завершение отвечает за свои ошибки; поток хеширования не
+            // останавливаем, но потерянный итог файла виден в метриках
+            if (ScanMetrics* metrics = engine_.metrics_) {
+                metrics->AddFailedCompletion();
+            }
+        }
+        engine_.file_done();
+    }
+    ready_.TryPush(index);
+    wake();
+}
+
+void AsyncDigestEngine::Submitter::on_completion(const io_uring_cqe& cqe) {
+    if (cqe.user_data == EVENT_TAG) {
+        if (!stopping_.load(std::memory_order_acquire)) {
+            arm_eventfd();
+        }
+        return;
+    }
+    const auto index = static_cast<unsigned>(cqe.user_data);
+    if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+        submit_read(index);
+        return;
+    }
+    const int result = cqe.res;
+    if (engine_.metrics_ != nullptr) {
+        Lane& lane = lanes_[index];
+        lane.job->read_time += std::chrono::steady_clock::now() - lane.read_started;
+    }
+    engine_.hash_pool_->Add([this, index, result]() { hash_chunk(index, result); });
+}
+
+void AsyncDigestEngine::Submitter::loop() {
+    arm_eventfd();
+    while (true) {
+        while (auto index = ready_.TryGet()) {
+            if (lanes_[*index].finished) {
+                retire(*index);
+            } else {
+                submit_read(*index);
+            }
+        }
+        while (!free_lanes_.empty()) {
+            auto job = incoming_.TryGet();
+            if (!job.has_value()) {
+                break;
+            }
+            start(*job);
+        }
+        if (stopping_.load(std::memory_order_acquire) && active_ == 0 && incoming_.Empty()) {
+            break;
+        }
+
+        // Засыпаем в io_uring_enter, только если после выставления флага
+        // не появилось работы; иначе производитель разбудит через eventfd
+        unsigned wait = 1;
+        sleeping_.store(true, std::memory_order_seq_cst);
+        if (!ready_.Empty() || (!free_lanes_.empty() && !incoming_.Empty()) ||
+            (stopping_.load(std::memory_order_seq_cst) && active_ == 0)) {
+            sleeping_.store(false, std::memory_order_relaxed);
+            wait = 0;
+        }
+        ring_.submit_and_wait(wait);
+        sleeping_.store(false, std::memory_order_relaxed);
+        ring_.drain_completions([this](const io_uring_cqe& cqe) { on_completion(cqe); });
+    }
+}
+
+AsyncDigestEngine::AsyncDigestEngine(const ReadOptions& options, size_t hash_threads, ScanMetrics* metrics)
+    : metrics_(metrics) {
+    const unsigned depth = std::max(1u, options.io_queue_depth);
+    const unsigned submitters = std::max(1u, options.io_submitters);
+    lane_buffer_size_ = std::min(std::max(options.buffer_size, BUFFER_ALIGNMENT), MAX_LANE_BUFFER_SIZE);
+    lane_buffer_size_ = (lane_buffer_size_ + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+
+    // На полосу не больше одной задачи хеширования: очередь пула не
+    // переполняется, и поток отправки никогда на ней не блокируется
+    hash_pool_ = std::make_unique<ThreadPool<UniqueFunction<void()>>>(std::max<size_t>(1, hash_threads),
+                                                                        size_t{depth} * submitters);
+    submitters_.reserve(submitters);
+    for (unsigned i = 0; i < submitters; ++i) {
+        submitters_.push_back(std::make_unique<Submitter>(*this, depth, lane_buffer_size_));
+    }
+}
+
+AsyncDigestEngine::~AsyncDigestEngine() noexcept {
+    Drain();
+    // Сначала потоки хеширования: их последние задачи еще обращаются к потокам отправки
+    hash_pool_.reset();
+    submitters_.clear();
+}
+
+bool AsyncDigestEngine::available() noexcept {
+    return IoUring::available();
+}
+
+bool AsyncDigestEngine::uses_registered_buffers() const noexcept {
+    return !submitters_.empty() && submitters_.front()->fixed_buffers();
+}
+
+bool AsyncDigestEngine::Submit(const std::filesystem::path& file_path, unsigned algorithms, Completion done) {
+    size_t file_size = 0;
+    const auto open_started = std::chrono::steady_clock::now();
+    const int fd = MD5Compute::openFileForReading(file_path, file_size);
+    if (metrics_ != nullptr) {
+        metrics_->Record(ScanStage::Open, std::chrono::steady_clock::now() - open_started);
+        if (fd < 0) {
+            metrics_->AddSkipped(SkipReason::OpenFailed);
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::unique_ptr<FileJob> job;
+    try {
+        job = std::make_unique<FileJob>(fd, file_size, algorithms, std::move(done));
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    const size_t index = next_submitter_.fetch_add(1, std::memory_order_relaxed) % submitters_.size();
+    submitters_[index]->enqueue(job.release());
+    return true;
+}
+
+void AsyncDigestEngine::file_done() noexcept {
+    if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        drain_cv_.notify_all();
+    }
+}
+
+void AsyncDigestEngine::Drain() {
+    std::unique_lock<std::mutex> lock(drain_mutex_);
+    drain_cv_.wait(lock, [this] { return in_flight_.load(std::memory_order_acquire) == 0; });
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "Digest.h"
+#include "MD5Compute.h"
+#include "ScanMetrics.h"
+#include "ThreadPool.h"
+#include "UniqueFunction.h"
+
+// Хеширование с асинхронным чтением через io_uring. Несколько потоков
+// отправки держат в полете до io_queue_depth чтений каждый (буферы и
+// дескрипторы зарегистрированы в кольце), прочитанные куски хешируют
+// собственные потоки движка. У файла в полете одно чтение за раз: следующее
+// отправляется, когда предыдущий кусок захеширован, - так порядок данных для
+// MD5/SHA сохраняется, а глубина очереди набирается за счет многих файлов.
+class DLL_EXPORT AsyncDigestEngine {
+public:
+    // Вызывается в потоке хеширования; nullopt - ошибка чтения
+    using Completion = UniqueFunction<void(std::optional<FileDigests>)>;
+
+private:
+    struct FileJob {
+        int fd = -1;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+        DigestAccumulator digests;
+        Completion done;
+        // Время от отправки чтений до их завершений и время хеширования кусков
+        std::chrono::nanoseconds read_time{0};
+        std::chrono::nanoseconds hash_time{0};
+
+        FileJob(int file_fd, uint64_t file_size, unsigned algorithms, Completion completion)
+            : fd(file_fd), size(file_size), digests(algorithms), done(std::move(completion)) {}
+    };
+    class Submitter;
+
+private:
+    ScanMetrics* metrics_;
+    size_t lane_buffer_size_;
+    std::unique_ptr<ThreadPool<UniqueFunction<void()>>> hash_pool_;
+    std::vector<std::unique_ptr<Submitter>> submitters_;
+    std::atomic<size_t> next_submitter_{0};
+    std::atomic<size_t> in_flight_{0};
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+private:
+    void file_done() noexcept;
+public:
+    // Буфер на одно чтение: зарегистрированная память закреплена в ОЗУ
+    static constexpr size_t MAX_LANE_BUFFER_SIZE = 256 << 10;
+
+    // metrics, если задан, должен пережить движок
+    AsyncDigestEngine(const ReadOptions& options, size_t hash_threads, ScanMetrics* metrics = nullptr);
+    ~AsyncDigestEngine() noexcept;
+
+    AsyncDigestEngine(const AsyncDigestEngine&) = delete;
+    AsyncDigestEngine& operator=(const AsyncDigestEngine&) = delete;
+
+    static bool available() noexcept;
+
+    // Открывает файл в вызывающем потоке; false - не открылся, done не
+    // вызывается. Ждет, если у потоков отправки переполнена очередь.
+    bool Submit(const std::filesystem::path& file_path, unsigned algorithms, Completion done);
+    // Ждет завершения всех отправленных файлов
+    void Drain();
+
+    bool uses_registered_buffers() const noexcept;
+    // Файлов, отправленных и еще не завершенных
+    size_t in_flight() const noexcept { return in_flight_.load(std::memory_order_relaxed); }
+    size_t lane_buffer_size() const noexcept { return lane_buffer_size_; }
+};
@@ -0,0 +1,85 @@
+#include "AsyncLogger.h"
+
+#include <stdexcept>
+
+AsyncLogger::RecordBuilder::~RecordBuilder() noexcept {
+    try {
+        std::string text = stream_.str();
+        text += '\n';
+        logger_.Write(std::move(text));
+    } catch (...) {
+    }
+}
+
+AsyncLogger::AsyncLogger(const std::string& path,
+                         std::chrono::milliseconds flush_interval,
+                         size_t capacity)
+    : flush_interval_(flush_interval), queue_(capacity) {
+    file_.open(path, std::ios::out | std::ios::app);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Не удается открыть файл лога: " + path);
+    }
+    writer_ = std::thread([this] { writer_loop(); });
+}
+
+AsyncLogger::~AsyncLogger() noexcept {
+    // Закрытая очередь отдает писателю остаток, затем nullopt
+    queue_.Lock();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void AsyncLogger::Write(std::string record) {
+    // Счетчик растет до постановки: Flush не должен засчитать чужую запись,
+    // сброшенную раньше той, что уже учтена в submitted_
+    submitted_.fetch_add(1, std::memory_order_acq_rel);
+    if (!queue_.Push(std::move(record))) {
+        publish_flushed(1);
+    }
+}
+
+void AsyncLogger::Flush() {
+    const size_t target = submitted_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    flush_cv_.wait(lock, [this, target] { return flushed_ >= target; });
+}
+
+void AsyncLogger::publish_flushed(size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        flushed_ += count;
+    }
+    flush_cv_.notify_all();
+}
+
+void AsyncLogger::writer_loop() {
+    std::string batch;
+    size_t unflushed = 0;
+    auto last_flush = std::chrono::steady_clock::now();
+    while (auto record = queue_.Get()) {
+        // Буфер пачки переиспользуется между итерациями
+        batch.assign(*record);
+        size_t records = 1;
+        while (batch.size() < MAX_BATCH_BYTES) {
+            auto next = queue_.TryGet();
+            if (!next.has_value()) {
+                break;
+            }
+            batch += *next;
+            ++records;
+        }
+        file_.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        unflushed += records;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (queue_.Empty() || now - last_flush >= flush_interval_) {
+            file_.flush();
+            last_flush = now;
+            publish_flushed(unflushed);
+            unflushed = 0;
+        }
+    }
+    file_.flush();
+    publish_flushed(unflushed);
+}
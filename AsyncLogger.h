@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "RingBlockQueue.h"
+
+// Асинхронный лог: потоки кладут готовые записи в lock-free очередь,
+// отдельный поток пишет их в файл пачками. Сброс на диск - когда очередь
+// опустела или прошло flush_interval с прошлого сброса, так что под
+// нагрузкой записи не копятся дольше интервала. Деструктор дописывает все,
+// что успели поставить.
+class DLL_EXPORT AsyncLogger {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 8192;
+    static constexpr std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL{100};
+    // Больше этого пачка не растет, даже если очередь не пустеет
+    static constexpr size_t MAX_BATCH_BYTES = 256 << 10;
+
+    // Запись собирается в строку и ставится в очередь при разрушении:
+    // logger.Record() << "Путь: " << path;  - перевод строки добавляется сам
+    class RecordBuilder {
+    private:
+        AsyncLogger& logger_;
+        std::ostringstream stream_;
+    public:
+        explicit RecordBuilder(AsyncLogger& logger) : logger_(logger) {}
+        ~RecordBuilder() noexcept;
+
+        RecordBuilder(const RecordBuilder&) = delete;
+        RecordBuilder& operator=(const RecordBuilder&) = delete;
+
+        template<typename T>
+        RecordBuilder& operator<<(const T& value) {
+            stream_ << value;
+            return *this;
+        }
+        RecordBuilder& operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+            stream_ << manipulator;
+            return *this;
+        }
+    };
+
+private:
+    std::ofstream file_;
+    std::chrono::milliseconds flush_interval_;
+    RingBlockQueue<std::string> queue_;
+    std::atomic<size_t> submitted_{0};
+    // Записи, уже сброшенные на диск; меняется под flush_mutex_
+    size_t flushed_ = 0;
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    std::thread writer_;
+private:
+    void writer_loop();
+    void publish_flushed(size_t count);
+public:
+    explicit AsyncLogger(const std::string& path,
+                         std::chrono::milliseconds flush_interval = DEFAULT_FLUSH_INTERVAL,
+                         size_t capacity = DEFAULT_CAPACITY);
+    ~AsyncLogger() noexcept;
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Готовая запись целиком, с переводами строк. Ждет только если очередь
+    // заполнена; после остановки запись отбрасывается.
+    void Write(std::string record);
+    RecordBuilder Record() { return RecordBuilder(*this); }
+    // Ждет, пока все поставленные до вызова записи окажутся в файле
+    void Flush();
+};
@@ -8,6 +8,14 @@
 #  endif
 #endif
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include "Instrumentation.h"
+
 template<typename T>
 class BlockQueue {
 private:
@@ -16,33 +24,84 @@ private:
     std::condition_variable cv_;
     bool open_;
     size_t waiting_count_;
+    // Пусты, если инструментирование выключено (см. Instrumentation.h)
+    [[no_unique_address]] instrumentation::QueueCounters counters_;
+
+    // Ожидание мьютекса засекается, только если он занят
+    std::unique_lock<std::mutex> acquire() {
+        if constexpr (instrumentation::ENABLED) {
+            std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                instrumentation::Stopwatch watch;
+                lock.lock();
+                counters_.lock_wait_ns.Add(watch.ElapsedNs());
+            }
+            return lock;
+        } else {
+            return std::unique_lock<std::mutex>(mutex_);
+        }
+    }
 
 public:
     BlockQueue() : open_(true), waiting_count_(0) {}
     void Lock() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        auto lock = acquire();
         open_ = false; 
         cv_.notify_all(); 
     }
     void Push(const T& val) {
         {
-            std::lock_guard<std::mutex> lock(mutex_);
+            auto lock = acquire();
             if (!open_) return;
             queue_.push(val);
+            counters_.pushes.Add();
+            counters_.high_water.Observe(queue_.size());
         }
         cv_.notify_one();
     }
     std::optional<T> Get() {
-        std::unique_lock<std::mutex> lock(mutex_);
+        auto lock = acquire();
         ++waiting_count_;
-        cv_.wait(lock, [this] { return !queue_.empty() || !open_; });
+        if (queue_.empty() && open_) {
+            instrumentation::Stopwatch watch;
+            cv_.wait(lock, [this] { return !queue_.empty() || !open_; });
+            counters_.pop_wait_ns.Add(watch.ElapsedNs());
+        }
         --waiting_count_;
         if (queue_.empty())
             return std::nullopt;
         T val = std::move(queue_.front());
         queue_.pop();
+        counters_.pops.Add();
         return val;
     }
+    // Неблокирующий вариант Get: nullopt, если очередь пуста
+    std::optional<T> TryGet() {
+        auto lock = acquire();
+        if (queue_.empty())
+            return std::nullopt;
+        T val = std::move(queue_.front());
+        queue_.pop();
+        counters_.pops.Add();
+        return val;
+    }
+
+    // Потоков, ждущих в Get
+    size_t Waiting() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiting_count_;
+    }
+
+    QueueStats Stats() {
+        QueueStats stats;
+        stats.pushes = counters_.pushes.Load();
+        stats.pops = counters_.pops.Load();
+        stats.lock_wait = std::chrono::nanoseconds(counters_.lock_wait_ns.Load());
+        stats.pop_wait = std::chrono::nanoseconds(counters_.pop_wait_ns.Load());
+        stats.high_water = counters_.high_water.Load();
+        stats.waiting = Waiting();
+        return stats;
+    }
 
     bool Empty() {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -0,0 +1,90 @@
+#include "BloomFilter.h"
+
+#include <utility>
+
+namespace {
+
+// Нечетные множители из спецификации split-block Bloom filter (Parquet)
+constexpr uint32_t SALT[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+constexpr size_t BLOCK_BITS = 256;
+
+} // namespace
+
+BloomFilter::BloomFilter(const BloomFilter& other)
+    : owned_(other.blocks_, other.blocks_ + other.block_count_),
+      blocks_(owned_.empty() ? nullptr : owned_.data()),
+      block_count_(other.block_count_) {}
+
+BloomFilter& BloomFilter::operator=(const BloomFilter& other) {
+    if (this != &other) {
+        BloomFilter copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+BloomFilter::Block BloomFilter::make_mask(uint32_t key) noexcept {
+    Block mask;
+    for (int i = 0; i < 8; ++i) {
+        mask.words[i] = 1U << ((key * SALT[i]) >> 27);
+    }
+    return mask;
+}
+
+size_t BloomFilter::block_index(uint64_t hash) const noexcept {
+    return static_cast<size_t>(((hash >> 32) * static_cast<uint64_t>(block_count_)) >> 32);
+}
+
+void BloomFilter::init(size_t expected_keys, size_t bits_per_key) {
+    const size_t bits = expected_keys * bits_per_key;
+    const size_t block_count = (bits + BLOCK_BITS - 1) / BLOCK_BITS;
+    owned_.assign(block_count == 0 ? 1 : block_count, Block{});
+    blocks_ = owned_.data();
+    block_count_ = owned_.size();
+}
+
+void BloomFilter::insert(uint64_t hash) noexcept {
+    if (block_count_ == 0 || blocks_ != owned_.data()) {
+        return;
+    }
+    const Block mask = make_mask(static_cast<uint32_t>(hash));
+    Block& block = owned_[block_index(hash)];
+    for (int i = 0; i < 8; ++i) {
+        block.words[i] |= mask.words[i];
+    }
+}
+
+bool BloomFilter::may_contain(uint64_t hash) const noexcept {
+    if (block_count_ == 0) {
+        return true;
+    }
+    const Block mask = make_mask(static_cast<uint32_t>(hash));
+    const Block& block = blocks_[block_index(hash)];
+    bool present = true;
+    for (int i = 0; i < 8; ++i) {
+        present &= (block.words[i] & mask.words[i]) != 0;
+    }
+    return present;
+}
+
+bool BloomFilter::attach(const Block* blocks, size_t block_count) noexcept {
+    if (blocks == nullptr || block_count == 0 || block_count > UINT32_MAX) {
+        return false;
+    }
+    owned_.clear();
+    owned_.shrink_to_fit();
+    blocks_ = blocks;
+    block_count_ = block_count;
+    return true;
+}
+
+void BloomFilter::clear() noexcept {
+    owned_.clear();
+    owned_.shrink_to_fit();
+    blocks_ = nullptr;
+    block_count_ = 0;
+}
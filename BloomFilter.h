@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Split-block Bloom filter: каждый ключ попадает ровно в один 256-битный
+// блок и выставляет в нем по биту в каждом из 8 слов, поэтому проверка
+// стоит одного обращения к кэш-линии. Ключ - уже равномерный 64-битный хеш
+// (часть дайджеста), дополнительное хеширование не нужно.
+class DLL_EXPORT BloomFilter {
+public:
+    struct Block {
+        uint32_t words[8];
+    };
+
+private:
+    std::vector<Block> owned_;
+    const Block* blocks_ = nullptr;
+    size_t block_count_ = 0;
+private:
+    static Block make_mask(uint32_t key) noexcept;
+    size_t block_index(uint64_t hash) const noexcept;
+public:
+    static constexpr size_t DEFAULT_BITS_PER_KEY = 8;
+
+    BloomFilter() = default;
+    BloomFilter(const BloomFilter& other);
+    BloomFilter& operator=(const BloomFilter& other);
+    BloomFilter(BloomFilter&&) noexcept = default;
+    BloomFilter& operator=(BloomFilter&&) noexcept = default;
+
+    void init(size_t expected_keys, size_t bits_per_key = DEFAULT_BITS_PER_KEY);
+    void insert(uint64_t hash) noexcept;
+    bool may_contain(uint64_t hash) const noexcept;
+    bool attach(const Block* blocks, size_t block_count) noexcept;
+    void clear() noexcept;
+
+    bool empty() const noexcept { return block_count_ == 0; }
+    const Block* data() const noexcept { return blocks_; }
+    size_t block_count() const noexcept { return block_count_; }
+    size_t size_bytes() const noexcept { return block_count_ * sizeof(Block); }
+};
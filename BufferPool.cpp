@@ -0,0 +1,41 @@
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+void BufferPool::FreeDeleter::operator()(unsigned char* p) const noexcept {
+    std::free(p);
+}
+
+BufferPool::BufferPool(size_t buffer_count, size_t buffer_size)
+    : buffer_size_((std::max(buffer_size, size_t{1}) + ALIGNMENT - 1) & ~(ALIGNMENT - 1)),
+      count_(buffer_count),
+      free_(std::max(buffer_count, size_t{1})) {
+    if (buffer_count == 0) {
+        throw std::invalid_argument("BufferPool: buffer_count > 0");
+    }
+    memory_.reset(static_cast<unsigned char*>(std::aligned_alloc(ALIGNMENT, buffer_size_ * count_)));
+    if (!memory_) {
+        throw std::runtime_error("Не удается выделить пул буферов: " +
+                                 std::to_string(buffer_size_ * count_) + " байт");
+    }
+    for (size_t i = 0; i < count_; ++i) {
+        free_.Push(memory_.get() + i * buffer_size_);
+    }
+}
+
+unsigned char* BufferPool::Acquire() {
+    return free_.Get().value_or(nullptr);
+}
+
+unsigned char* BufferPool::TryAcquire() {
+    return free_.TryGet().value_or(nullptr);
+}
+
+void BufferPool::Release(unsigned char* buffer) {
+    if (buffer != nullptr) {
+        free_.Push(buffer);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <memory>
+#include "RingBlockQueue.h"
+
+// Предвыделенные буферы чтения одного размера, выровненные по странице
+// (подходят для O_DIRECT и регистрации в io_uring). Память выделяется
+// один раз; свободные буферы лежат в очереди, и Acquire ждет, пока
+// какой-нибудь буфер не вернут, - так пул ограничивает объем прочитанных,
+// но еще не обработанных данных.
+class DLL_EXPORT BufferPool {
+private:
+    struct FreeDeleter {
+        void operator()(unsigned char* p) const noexcept;
+    };
+
+private:
+    size_t buffer_size_;
+    size_t count_;
+    std::unique_ptr<unsigned char, FreeDeleter> memory_;
+    RingBlockQueue<unsigned char*> free_;
+public:
+    static constexpr size_t ALIGNMENT = 4096;
+
+    // buffer_size округляется вверх до ALIGNMENT
+    BufferPool(size_t buffer_count, size_t buffer_size);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Ждет свободный буфер
+    unsigned char* Acquire();
+    // nullptr, если свободных нет
+    unsigned char* TryAcquire();
+    void Release(unsigned char* buffer);
+
+    size_t buffer_size() const noexcept { return buffer_size_; }
+    size_t count() const noexcept { return count_; }
+    size_t available() const noexcept { return free_.Size(); }
+};
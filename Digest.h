@@ -0,0 +1,106 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+inline constexpr size_t MD5_DIGEST_SIZE = 16;
+inline constexpr size_t SHA1_DIGEST_SIZE = 20;
+inline constexpr size_t SHA256_DIGEST_SIZE = 32;
+
+template<size_t N>
+using Digest = std::array<unsigned char, N>;
+
+using MD5Digest = Digest<MD5_DIGEST_SIZE>;
+using SHA1Digest = Digest<SHA1_DIGEST_SIZE>;
+using SHA256Digest = Digest<SHA256_DIGEST_SIZE>;
+
+// Значения - биты, набор алгоритмов передается маской
+enum DigestAlgorithm : unsigned {
+    DIGEST_MD5 = 1u << 0,
+    DIGEST_SHA1 = 1u << 1,
+    DIGEST_SHA256 = 1u << 2,
+};
+
+inline constexpr unsigned DIGEST_ALL = DIGEST_MD5 | DIGEST_SHA1 | DIGEST_SHA256;
+
+// Дайджесты одного файла за один проход чтения; algorithms - посчитанные
+struct FileDigests {
+    unsigned algorithms = 0;
+    MD5Digest md5{};
+    SHA1Digest sha1{};
+    SHA256Digest sha256{};
+};
+
+inline const char* digest_algorithm_name(DigestAlgorithm algorithm) noexcept {
+    switch (algorithm) {
+        case DIGEST_MD5: return "MD5";
+        case DIGEST_SHA1: return "SHA1";
+        case DIGEST_SHA256: return "SHA256";
+    }
+    return "";
+}
+
+// Метка строки базы ("md5", "sha1", "sha256", регистр не важен)
+inline bool parse_digest_algorithm(std::string_view name, DigestAlgorithm& out) noexcept {
+    for (DigestAlgorithm algorithm : {DIGEST_MD5, DIGEST_SHA1, DIGEST_SHA256}) {
+        const std::string_view expected = digest_algorithm_name(algorithm);
+        if (name.size() != expected.size()) {
+            continue;
+        }
+        bool same = true;
+        for (size_t i = 0; i < name.size() && same; ++i) {
+            const char c = (name[i] >= 'a' && name[i] <= 'z') ? static_cast<char>(name[i] - 'a' + 'A') : name[i];
+            same = c == expected[i];
+        }
+        if (same) {
+            out = algorithm;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int hex_nibble(char c) noexcept {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Разбирает hex-строку ровно из 2*N символов (регистр не важен) без аллокаций.
+template<size_t N>
+bool parse_hex_digest(std::string_view hex, Digest<N>& out) noexcept {
+    if (hex.size() != 2 * N) {
+        return false;
+    }
+    for (size_t i = 0; i < N; ++i) {
+        const int hi = hex_nibble(hex[2 * i]);
+        const int lo = hex_nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        out[i] = static_cast<unsigned char>((hi << 4) | lo);
+    }
+    return true;
+}
+
+template<size_t N>
+std::string digest_to_hex(const Digest<N>& digest) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    std::string hex(2 * N, '0');
+    for (size_t i = 0; i < N; ++i) {
+        hex[2 * i] = HEX[digest[i] >> 4];
+        hex[2 * i + 1] = HEX[digest[i] & 0x0f];
+    }
+    return hex;
+}
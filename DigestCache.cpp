@@ -0,0 +1,478 @@
+#include "DigestCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = {'S', 'C', 'N', 'C', 'A', 'C', 'H', 'E'};
+constexpr char LOG_MAGIC[8] = {'S', 'C', 'N', 'C', 'L', 'O', 'G', '\0'};
+
+static_assert(sizeof(DigestCache::Record) == 120, "DigestCache::Record layout");
+static_assert(sizeof(DigestCache::FileHeader) == 32, "DigestCache::FileHeader layout");
+
+bool key_less(const DigestCache::Record& record, uint64_t device, uint64_t inode) noexcept {
+    return record.device != device ? record.device < device : record.inode < inode;
+}
+
+bool record_less(const DigestCache::Record& a, const DigestCache::Record& b) noexcept {
+    return key_less(a, b.device, b.inode);
+}
+
+bool same_key(const DigestCache::Record& a, const DigestCache::Record& b) noexcept {
+    return a.device == b.device && a.inode == b.inode;
+}
+
+// Запись отсортированной серии журнала во временном файле
+struct RunEntry {
+    DigestCache::Record record;
+    uint64_t seen;
+};
+
+class RunReader {
+private:
+    std::ifstream in_;
+    RunEntry entry_ {};
+    bool valid_ = false;
+public:
+    explicit RunReader(const std::string& path) : in_(path, std::ios::binary) {
+        if (!in_.is_open()) {
+            throw std::runtime_error("Не удается открыть серию кэша дайджестов: " + path);
+        }
+        next();
+    }
+
+    bool valid() const noexcept { return valid_; }
+    const RunEntry& entry() const noexcept { return entry_; }
+    void next() { valid_ = static_cast<bool>(in_.read(reinterpret_cast<char*>(&entry_), sizeof(entry_))); }
+};
+
+void remove_runs(const std::vector<std::string>& runs) noexcept {
+    std::error_code ec;
+    for (const auto& run : runs) {
+        std::filesystem::remove(run, ec);
+    }
+}
+
+int64_t realtime_ns() noexcept {
+    timespec ts {};
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+} // namespace
+
+DigestCache::DigestCache(const std::string& path, std::chrono::nanoseconds racy_window, size_t memory_records)
+    : path_(path), log_path_(path + ".log"), racy_window_(racy_window),
+      memory_records_(std::max<size_t>(memory_records, 1)) {
+    load_index();
+    load_log();
+    // Журнал не влез в память (прошлый запуск упал до сжатия)
+    if (log_records_ > memory_records_) {
+        compact();
+    }
+}
+
+DigestCache::~DigestCache() noexcept {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+uint32_t DigestCache::record_checksum(const Record& record) noexcept {
+    Record copy = record;
+    copy.checksum = 0;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&copy);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(copy); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+std::optional<FileIdentity> DigestCache::identify(const std::filesystem::path& file_path) noexcept {
+    FileIdentity identity;
+    identity.observed_ns = realtime_ns();
+    struct stat st {};
+    if (::stat(file_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return std::nullopt;
+    }
+    identity.device = static_cast<uint64_t>(st.st_dev);
+    identity.inode = static_cast<uint64_t>(st.st_ino);
+    identity.size = static_cast<uint64_t>(st.st_size);
+    identity.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    identity.ctime_ns = static_cast<int64_t>(st.st_ctim.tv_sec) * 1'000'000'000 + st.st_ctim.tv_nsec;
+    return identity;
+}
+
+void DigestCache::remove(const std::string& path) {
+    std::error_code ec;
+    for (const auto& file : {path, path + ".log", path + ".tmp"}) {
+        std::filesystem::remove(file, ec);
+        if (ec) {
+            throw std::runtime_error("Не удается удалить файл кэша дайджестов: " + file);
+        }
+    }
+}
+
+void DigestCache::load_index() {
+    index_ = MappedFile();
+    index_records_ = nullptr;
+    index_count_ = 0;
+    index_seen_.reset();
+
+    std::error_code ec;
+    if (!std::filesystem::exists(path_, ec)) {
+        return;
+    }
+    MappedFile index(path_);
+    FileHeader header {};
+    if (index.size() >= sizeof(header)) {
+        std::memcpy(&header, index.data(), sizeof(header));
+    }
+    if (index.size() < sizeof(header) || std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header.version != VERSION || header.record_size != sizeof(Record) ||
+        header.count != (index.size() - sizeof(header)) / sizeof(Record) ||
+        (index.size() - sizeof(header)) % sizeof(Record) != 0) {
+        warnings_.push_back("Предупреждение: индекс кэша дайджестов поврежден и будет пересоздан: " + path_);
+        return;
+    }
+    index_ = std::move(index);
+    index_.advise_random();
+    index_records_ = reinterpret_cast<const Record*>(index_.data() + sizeof(FileHeader));
+    index_count_ = header.count;
+    index_seen_ = std::make_unique<std::atomic<uint64_t>[]>((index_count_ + 63) / 64);
+}
+
+void DigestCache::load_log() {
+    pending_.clear();
+    log_records_ = 0;
+    session_log_start_ = 0;
+
+    std::ifstream in(log_path_, std::ios::binary);
+    if (!in.is_open()) {
+        open_log(true);
+        return;
+    }
+    FileHeader header {};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+        header.version != VERSION || header.record_size != sizeof(Record)) {
+        warnings_.push_back("Предупреждение: журнал кэша дайджестов поврежден и будет пересоздан: " + log_path_);
+        in.close();
+        open_log(true);
+        return;
+    }
+
+    // Недописанная при аварии запись в конце журнала отбрасывается
+    uint64_t good_size = sizeof(header);
+    Record record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.checksum != record_checksum(record)) {
+            break;
+        }
+        const InodeKey key{record.device, record.inode};
+        if (pending_.size() < memory_records_ || pending_.count(key) != 0) {
+            pending_[key].record = record;
+        }
+        ++log_records_;
+        good_size += sizeof(record);
+    }
+    in.close();
+    session_log_start_ = log_records_;
+
+    std::error_code ec;
+    if (std::filesystem::file_size(log_path_, ec) != good_size && !ec) {
+        warnings_.push_back("Предупреждение: хвост журнала кэша дайджестов отброшен: " + log_path_);
+        std::filesystem::resize_file(log_path_, good_size, ec);
+    }
+    open_log(false);
+}
+
+void DigestCache::open_log(bool truncate) {
+    log_.close();
+    log_.clear();
+    log_.open(log_path_, std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+    if (!log_.is_open()) {
+        throw std::runtime_error("Не удается открыть журнал кэша дайджестов: " + log_path_);
+    }
+    if (truncate) {
+        FileHeader header {};
+        std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+        header.version = VERSION;
+        header.record_size = sizeof(Record);
+        log_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        log_.flush();
+    }
+}
+
+const DigestCache::Record* DigestCache::find_indexed(const InodeKey& key) const noexcept {
+    const Record* end = index_records_ + index_count_;
+    const Record* it = std::lower_bound(index_records_, end, key, [](const Record& record, const InodeKey& k) {
+        return key_less(record, k.device, k.inode);
+    });
+    if (it == end || it->device != key.device || it->inode != key.inode) {
+        return nullptr;
+    }
+    return it;
+}
+
+std::optional<FileDigests> DigestCache::lookup(const FileIdentity& identity, unsigned algorithms) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const InodeKey key{identity.device, identity.inode};
+    const Record* record = nullptr;
+    auto it = pending_.find(key);
+    if (it != pending_.end()) {
+        record = &it->second.record;
+    } else {
+        record = find_indexed(key);
+    }
+    if (record == nullptr || record->size != identity.size || record->mtime_ns != identity.mtime_ns ||
+        record->ctime_ns != identity.ctime_ns || (record->algorithms & algorithms) != algorithms ||
+        record->checksum != record_checksum(*record)) {
+        return std::nullopt;
+    }
+    if (it != pending_.end()) {
+        it->second.seen.store(true, std::memory_order_relaxed);
+    } else {
+        const size_t position = static_cast<size_t>(record - index_records_);
+        auto& word = index_seen_[position / 64];
+        const uint64_t bit = uint64_t{1} << (position % 64);
+        if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+            word.fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+    return FileDigests{record->algorithms, record->md5, record->sha1, record->sha256};
+}
+
+void DigestCache::store(const FileIdentity& identity, const FileDigests& digests) {
+    if (identity.observed_ns - std::max(identity.mtime_ns, identity.ctime_ns) <= racy_window_.count()) {
+        return;
+    }
+    Record record {};
+    record.device = identity.device;
+    record.inode = identity.inode;
+    record.size = identity.size;
+    record.mtime_ns = identity.mtime_ns;
+    record.ctime_ns = identity.ctime_ns;
+    record.algorithms = digests.algorithms;
+    record.md5 = digests.md5;
+    record.sha1 = digests.sha1;
+    record.sha256 = digests.sha256;
+    record.checksum = record_checksum(record);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // Сверх memory_records_ запись есть только в журнале: до сжатия lookup
+    // ее не видит, и файл, встреченный повторно, хешируется заново
+    const InodeKey key{record.device, record.inode};
+    auto it = pending_.find(key);
+    if (it == pending_.end() && pending_.size() < memory_records_) {
+        it = pending_.try_emplace(key).first;
+    }
+    if (it != pending_.end()) {
+        it->second.record = record;
+        it->second.seen.store(true, std::memory_order_relaxed);
+    }
+    log_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    ++log_records_;
+}
+
+void DigestCache::flush() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    log_.flush();
+    if (!log_.good()) {
+        throw std::runtime_error("Ошибка записи журнала кэша дайджестов: " + log_path_);
+    }
+}
+
+// Запись журнала из прошлого запуска встречена, только если ее нашел lookup
+bool DigestCache::log_record_seen(const Record& record, size_t position) const noexcept {
+    if (position >= session_log_start_) {
+        return true;
+    }
+    auto it = pending_.find(InodeKey{record.device, record.inode});
+    return it != pending_.end() && it->second.seen.load(std::memory_order_relaxed);
+}
+
+// Журнал читается кусками по memory_records_ записей; каждый сортируется по
+// ключу и пишется в свою серию, из записей одного inode остается последняя
+void DigestCache::sort_log(std::vector<std::string>& runs) const {
+    std::ifstream in(log_path_, std::ios::binary);
+    in.seekg(sizeof(FileHeader));
+    if (!in) {
+        throw std::runtime_error("Не удается прочитать журнал кэша дайджестов: " + log_path_);
+    }
+    struct Positioned {
+        RunEntry entry;
+        size_t position;
+    };
+    std::vector<Positioned> chunk;
+    chunk.reserve(std::min(log_records_, memory_records_));
+    size_t position = 0;
+    while (position < log_records_) {
+        chunk.clear();
+        Record record;
+        while (chunk.size() < memory_records_ && position < log_records_ &&
+               in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            chunk.push_back({{record, log_record_seen(record, position)}, position});
+            ++position;
+        }
+        if (chunk.size() < memory_records_ && position < log_records_) {
+            throw std::runtime_error("Не удается прочитать журнал кэша дайджестов: " + log_path_);
+        }
+        std::sort(chunk.begin(), chunk.end(), [](const Positioned& a, const Positioned& b) {
+            return same_key(a.entry.record, b.entry.record) ? a.position < b.position
+                                                            : record_less(a.entry.record, b.entry.record);
+        });
+
+        runs.push_back(path_ + ".run" + std::to_string(runs.size()));
+        std::ofstream out(runs.back(), std::ios::binary | std::ios::trunc);
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            if (i + 1 < chunk.size() && same_key(chunk[i].entry.record, chunk[i + 1].entry.record)) {
+                continue;
+            }
+            out.write(reinterpret_cast<const char*>(&chunk[i].entry), sizeof(RunEntry));
+        }
+        out.flush();
+        if (!out.good()) {
+            throw std::runtime_error("Ошибка записи серии кэша дайджестов: " + runs.back());
+        }
+    }
+}
+
+// Новый индекс = старый индекс + серии журнала (более поздняя серия новее),
+// без отброшенных keep записей, а с prune - и без не встреченных. Сначала
+// атомарно подменяется индекс, потом очищается журнал: после сбоя между
+// шагами журнал просто применится повторно.
+size_t DigestCache::rewrite(const std::function<bool(const Record&)>& keep, bool prune) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    log_.flush();
+    if (!log_.good()) {
+        throw std::runtime_error("Ошибка записи журнала кэша дайджестов: " + log_path_);
+    }
+
+    const std::string tmp_path = path_ + ".tmp";
+    std::vector<std::string> runs;
+    size_t dropped = 0;
+    uint64_t count = 0;
+    try {
+        sort_log(runs);
+        std::vector<RunReader> readers;
+        readers.reserve(runs.size());
+        for (const auto& run : runs) {
+            readers.emplace_back(run);
+        }
+
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Не удается создать индекс кэша дайджестов: " + tmp_path);
+        }
+        FileHeader header {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        auto emit = [&](const Record& record, bool seen) {
+            if (!keep(record) || (prune && !seen)) {
+                ++dropped;
+                return;
+            }
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            ++count;
+        };
+        size_t i = 0;
+        while (true) {
+            // Наименьший ключ среди серий, при равных - из более поздней
+            const RunEntry* best = nullptr;
+            for (const auto& reader : readers) {
+                if (reader.valid() && (best == nullptr || !record_less(best->record, reader.entry().record))) {
+                    best = &reader.entry();
+                }
+            }
+            if (i < index_count_ && (best == nullptr || record_less(index_records_[i], best->record))) {
+                const uint64_t seen_word = index_seen_[i / 64].load(std::memory_order_relaxed);
+                emit(index_records_[i], (seen_word >> (i % 64)) & 1);
+                ++i;
+                continue;
+            }
+            if (best == nullptr) {
+                break;
+            }
+            const RunEntry newest = *best;
+            for (auto& reader : readers) {
+                if (reader.valid() && same_key(reader.entry().record, newest.record)) {
+                    reader.next();
+                }
+            }
+            if (i < index_count_ && same_key(index_records_[i], newest.record)) {
+                ++i;
+            }
+            emit(newest.record, newest.seen != 0);
+        }
+
+        std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        header.version = VERSION;
+        header.record_size = sizeof(Record);
+        header.count = count;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.flush();
+        if (!out.good()) {
+            throw std::runtime_error("Ошибка записи индекса кэша дайджестов: " + tmp_path);
+        }
+    } catch (...) {
+        remove_runs(runs);
+        throw;
+    }
+    remove_runs(runs);
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path_, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        throw std::runtime_error("Не удается сохранить индекс кэша дайджестов: " + path_);
+    }
+    load_index();
+    pending_.clear();
+    log_records_ = 0;
+    session_log_start_ = 0;
+    open_log(true);
+    return dropped;
+}
+
+void DigestCache::compact() {
+    rewrite([](const Record&) { return true; }, false);
+}
+
+size_t DigestCache::prune() {
+    return rewrite([](const Record&) { return true; }, true);
+}
+
+size_t DigestCache::drop_device(uint64_t device) {
+    return rewrite([device](const Record& record) { return record.device != device; }, false);
+}
+
+bool DigestCache::needs_compaction() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return log_records_ >= COMPACT_MIN_LOG_RECORDS &&
+           (log_records_ * 2 >= index_count_ || log_records_ > memory_records_);
+}
+
+size_t DigestCache::index_records() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return index_count_;
+}
+
+size_t DigestCache::log_records() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return log_records_;
+}
+
+const std::vector<std::string>& DigestCache::load_warnings() const noexcept {
+    return warnings_;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Digest.h"
+#include "MappedFile.h"
+
+// Метаданные файла, по которым кэшированный дайджест считается актуальным.
+// observed_ns - момент stat, в ключ не входит.
+struct FileIdentity {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    int64_t ctime_ns = 0;
+    int64_t observed_ns = 0;
+};
+
+// Кэш дайджестов между запусками: <path> - отсортированный по (device, inode)
+// индекс, читается через mmap; <path>.log - журнал новых записей, которые
+// дописываются в конец. Поверх индекса в памяти держится не больше
+// memory_records записей журнала, остальные видны lookup только после
+// сжатия. compact() сортирует журнал сериями по memory_records записей во
+// временные файлы и сливает их с индексом, так что память не растет с
+// размером тома. Запись с другими size/mtime/ctime считается устаревшей.
+class DLL_EXPORT DigestCache {
+public:
+    struct Record {
+        uint64_t device;
+        uint64_t inode;
+        uint64_t size;
+        int64_t mtime_ns;
+        int64_t ctime_ns;
+        uint32_t algorithms;
+        uint32_t checksum;
+        MD5Digest md5;
+        SHA1Digest sha1;
+        SHA256Digest sha256;
+        unsigned char padding[4];
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t count;
+        uint64_t reserved;
+    };
+
+private:
+    struct InodeKey {
+        uint64_t device;
+        uint64_t inode;
+        bool operator==(const InodeKey&) const = default;
+    };
+    struct InodeKeyHash {
+        size_t operator()(const InodeKey& key) const noexcept {
+            return static_cast<size_t>((key.inode * 0x9E3779B97F4A7C15ULL) ^ key.device);
+        }
+    };
+
+    struct PendingRecord {
+        Record record;
+        // Найдена lookup или сохранена с открытия кэша - для prune
+        mutable std::atomic<bool> seen{false};
+    };
+
+private:
+    std::string path_;
+    std::string log_path_;
+    std::chrono::nanoseconds racy_window_;
+    MappedFile index_;
+    const Record* index_records_ = nullptr;
+    size_t index_count_ = 0;
+    // Бит на запись индекса: найдена lookup с открытия кэша или прошлого сжатия
+    std::unique_ptr<std::atomic<uint64_t>[]> index_seen_;
+    std::unordered_map<InodeKey, PendingRecord, InodeKeyHash> pending_;
+    size_t memory_records_;
+    size_t log_records_ = 0;
+    // Записи журнала до этой позиции остались от прошлых запусков
+    size_t session_log_start_ = 0;
+    std::ofstream log_;
+    std::vector<std::string> warnings_;
+    mutable std::shared_mutex mutex_;
+private:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t COMPACT_MIN_LOG_RECORDS = 4096;
+private:
+    static uint32_t record_checksum(const Record& record) noexcept;
+    void load_index();
+    void load_log();
+    void open_log(bool truncate);
+    const Record* find_indexed(const InodeKey& key) const noexcept;
+    bool log_record_seen(const Record& record, size_t position) const noexcept;
+    void sort_log(std::vector<std::string>& runs) const;
+    size_t rewrite(const std::function<bool(const Record&)>& keep, bool prune);
+public:
+    // Файл, измененный незадолго до stat, не кэшируется: на ФС с грубыми
+    // метками времени следующая запись могла бы получить те же mtime/ctime.
+    static constexpr std::chrono::nanoseconds DEFAULT_RACY_WINDOW = std::chrono::seconds(2);
+    // Около 45 МБ записей журнала в памяти
+    static constexpr size_t DEFAULT_MEMORY_RECORDS = 1 << 18;
+
+    explicit DigestCache(const std::string& path, std::chrono::nanoseconds racy_window = DEFAULT_RACY_WINDOW,
+                         size_t memory_records = DEFAULT_MEMORY_RECORDS);
+    ~DigestCache() noexcept;
+
+    DigestCache(const DigestCache&) = delete;
+    DigestCache& operator=(const DigestCache&) = delete;
+
+    static std::optional<FileIdentity> identify(const std::filesystem::path& file_path) noexcept;
+    static void remove(const std::string& path);
+
+    // Дайджесты, если метаданные совпали и в записи есть все алгоритмы из маски
+    std::optional<FileDigests> lookup(const FileIdentity& identity, unsigned algorithms) const;
+    void store(const FileIdentity& identity, const FileDigests& digests);
+    void flush();
+    void compact();
+    // Сжатие, которое заодно удаляет записи, не найденные lookup и не
+    // сохраненные с открытия кэша или прошлого сжатия, - обычно записи
+    // удаленных файлов. Верно, только если с тех пор были проверены все
+    // файлы, попавшие в кэш. Возвращает число удаленных записей.
+    size_t prune();
+    size_t drop_device(uint64_t device);
+    bool needs_compaction() const;
+
+    size_t index_records() const;
+    size_t log_records() const;
+    const std::vector<std::string>& load_warnings() const noexcept;
+};
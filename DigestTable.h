@@ -0,0 +1,243 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include "Digest.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Открытая адресация с линейным пробированием: слот = бинарный дайджест
+// и индекс вердикта в общем пуле HashBase. Пустой слот помечен EMPTY_SLOT.
+// Таблица может ссылаться на чужую память (attach) - например, на секцию
+// скомпилированной базы, отображенную через mmap; вставка в такую таблицу
+// сначала копирует слоты к себе.
+template<size_t N>
+class DigestTable {
+public:
+    using Key = Digest<N>;
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    struct Slot {
+        Key digest;
+        uint32_t verdict;
+    };
+
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+    // Коэффициент заполнения не выше 7/10
+    static constexpr size_t MAX_LOAD_NUM = 7;
+    static constexpr size_t MAX_LOAD_DEN = 10;
+
+    std::vector<Slot> slots_;
+    const Slot* data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+
+private:
+    static uint64_t slot_hash(const Key& key) noexcept;
+    void rehash(size_t new_capacity);
+    void materialize();
+
+public:
+    DigestTable() = default;
+    DigestTable(const DigestTable& other);
+    DigestTable& operator=(const DigestTable& other);
+    DigestTable(DigestTable&&) noexcept = default;
+    DigestTable& operator=(DigestTable&&) noexcept = default;
+
+    void reserve(size_t count);
+    bool insert(const Key& key, uint32_t verdict);
+    void insert_or_assign(const Key& key, uint32_t verdict);
+    bool erase(const Key& key);
+    uint32_t find(const Key& key) const noexcept;
+    void clear() noexcept;
+    bool attach(const Slot* slots, size_t capacity, size_t size) noexcept;
+
+    const Slot* data() const noexcept { return data_; }
+    bool is_attached() const noexcept { return data_ != nullptr && data_ != slots_.data(); }
+    size_t size() const noexcept { return size_; }
+    size_t capacity() const noexcept { return capacity_; }
+    size_t memory_bytes() const noexcept { return slots_.size() * sizeof(Slot); }
+};
+
+// Копия всегда владеет своими слотами, даже если исходная таблица
+// ссылается на отображенный файл.
+template<size_t N>
+DigestTable<N>::DigestTable(const DigestTable& other)
+    : slots_(other.data_, other.data_ + other.capacity_),
+      data_(slots_.empty() ? nullptr : slots_.data()),
+      capacity_(other.capacity_),
+      mask_(other.mask_),
+      size_(other.size_) {}
+
+template<size_t N>
+DigestTable<N>& DigestTable<N>::operator=(const DigestTable& other) {
+    if (this != &other) {
+        DigestTable copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+template<size_t N>
+uint64_t DigestTable<N>::slot_hash(const Key& key) noexcept {
+    uint64_t word;
+    std::memcpy(&word, key.data(), sizeof(word));
+    return word * 0x9E3779B97F4A7C15ULL;
+}
+
+template<size_t N>
+void DigestTable<N>::rehash(size_t new_capacity) {
+    const Slot* old = data_;
+    const size_t old_capacity = capacity_;
+    std::vector<Slot> old_storage = std::move(slots_);
+    slots_.assign(new_capacity, Slot{Key{}, EMPTY_SLOT});
+    data_ = slots_.data();
+    capacity_ = new_capacity;
+    mask_ = new_capacity - 1;
+    for (size_t i = 0; i < old_capacity; ++i) {
+        const Slot& slot = old[i];
+        if (slot.verdict == EMPTY_SLOT) {
+            continue;
+        }
+        size_t idx = (slot_hash(slot.digest) >> 32) & mask_;
+        while (slots_[idx].verdict != EMPTY_SLOT) {
+            idx = (idx + 1) & mask_;
+        }
+        slots_[idx] = slot;
+    }
+}
+
+template<size_t N>
+void DigestTable<N>::materialize() {
+    if (is_attached()) {
+        slots_.assign(data_, data_ + capacity_);
+        data_ = slots_.data();
+    }
+}
+
+template<size_t N>
+void DigestTable<N>::reserve(size_t count) {
+    size_t capacity = capacity_ == 0 ? MIN_CAPACITY : capacity_;
+    while (count * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM) {
+        capacity <<= 1;
+    }
+    if (capacity != capacity_) {
+        rehash(capacity);
+    }
+}
+
+template<size_t N>
+bool DigestTable<N>::insert(const Key& key, uint32_t verdict) {
+    reserve(size_ + 1);
+    materialize();
+    size_t idx = (slot_hash(key) >> 32) & mask_;
+    while (slots_[idx].verdict != EMPTY_SLOT) {
+        if (slots_[idx].digest == key) {
+            return false;
+        }
+        idx = (idx + 1) & mask_;
+    }
+    slots_[idx] = Slot{key, verdict};
+    ++size_;
+    return true;
+}
+
+template<size_t N>
+void DigestTable<N>::insert_or_assign(const Key& key, uint32_t verdict) {
+    if (!insert(key, verdict)) {
+        size_t idx = (slot_hash(key) >> 32) & mask_;
+        while (slots_[idx].digest != key) {
+            idx = (idx + 1) & mask_;
+        }
+        slots_[idx].verdict = verdict;
+    }
+}
+
+// Удаление со сдвигом назад: последующие записи кластера переезжают в
+// освободившийся слот, поэтому "надгробия" не нужны.
+template<size_t N>
+bool DigestTable<N>::erase(const Key& key) {
+    if (size_ == 0) {
+        return false;
+    }
+    materialize();
+    size_t idx = (slot_hash(key) >> 32) & mask_;
+    while (slots_[idx].digest != key) {
+        if (slots_[idx].verdict == EMPTY_SLOT) {
+            return false;
+        }
+        idx = (idx + 1) & mask_;
+    }
+    if (slots_[idx].verdict == EMPTY_SLOT) {
+        return false;
+    }
+
+    size_t hole = idx;
+    size_t next = (idx + 1) & mask_;
+    while (slots_[next].verdict != EMPTY_SLOT) {
+        const size_t home = (slot_hash(slots_[next].digest) >> 32) & mask_;
+        // Запись можно сдвинуть в дыру, если ее домашний слот не лежит
+        // в циклическом интервале (hole, next]
+        if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+        next = (next + 1) & mask_;
+    }
+    slots_[hole] = Slot{Key{}, EMPTY_SLOT};
+    --size_;
+    return true;
+}
+
+template<size_t N>
+uint32_t DigestTable<N>::find(const Key& key) const noexcept {
+    if (size_ == 0) {
+        return EMPTY_SLOT;
+    }
+    size_t idx = (slot_hash(key) >> 32) & mask_;
+    for (size_t probe = 0; probe < capacity_; ++probe) {
+        const Slot& slot = data_[idx];
+        if (slot.verdict == EMPTY_SLOT) {
+            return EMPTY_SLOT;
+        }
+        if (slot.digest == key) {
+            return slot.verdict;
+        }
+        idx = (idx + 1) & mask_;
+    }
+    return EMPTY_SLOT;
+}
+
+template<size_t N>
+void DigestTable<N>::clear() noexcept {
+    slots_.clear();
+    slots_.shrink_to_fit();
+    data_ = nullptr;
+    capacity_ = 0;
+    mask_ = 0;
+    size_ = 0;
+}
+
+template<size_t N>
+bool DigestTable<N>::attach(const Slot* slots, size_t capacity, size_t size) noexcept {
+    // Емкость должна быть степенью двойки, а хотя бы один слот - пустым,
+    // иначе поиск отсутствующего ключа не завершится.
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || size >= capacity) {
+        return false;
+    }
+    clear();
+    data_ = slots;
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+    size_ = size;
+    return true;
+}
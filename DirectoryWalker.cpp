@@ -0,0 +1,168 @@
+#include "DirectoryWalker.h"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Раскладка записи getdents64 (в glibc нет обертки до 2.30)
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+constexpr size_t DIRENT_BUFFER_SIZE = 64 << 10;
+constexpr int DIR_OPEN_FLAGS = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+
+} // namespace
+
+DirectoryWalker::DirHandle::~DirHandle() {
+    if (fd >= 0) {
+        ::close(fd);
+        state->open_handles.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+DirectoryWalker::DirectoryWalker(Submit submit, FileCallback on_files, ErrorCallback on_error)
+    : submit_(std::move(submit)), on_files_(std::move(on_files)), on_error_(std::move(on_error)),
+      state_(std::make_shared<WalkState>()) {}
+
+std::shared_ptr<DirectoryWalker::DirHandle> DirectoryWalker::make_handle(int fd) const {
+    auto handle = std::make_shared<DirHandle>();
+    handle->fd = fd;
+    handle->state = state_;
+    state_->open_handles.fetch_add(1, std::memory_order_relaxed);
+    return handle;
+}
+
+void DirectoryWalker::Walk(const std::filesystem::path& root) {
+    const int fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Не удается открыть директорию " + root.string() + ": " + std::strerror(errno));
+    }
+    auto handle = make_handle(fd);
+
+    // Даже при ошибке дожидаемся уже запланированных задач: они ссылаются на this
+    std::exception_ptr error;
+    state_->pending.fetch_add(1, std::memory_order_relaxed);
+    try {
+        list_directory(handle, root);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    handle.reset();
+    finish_task(*state_);
+
+    std::unique_lock<std::mutex> lock(state_->done_mutex);
+    state_->done_cv.wait(lock, [this] { return state_->pending.load(std::memory_order_acquire) == 0; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void DirectoryWalker::finish_task(WalkState& state) {
+    if (state.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(state.done_mutex);
+        state.done_cv.notify_all();
+    }
+}
+
+void DirectoryWalker::schedule(std::shared_ptr<DirHandle> parent, std::filesystem::path path) {
+    state_->pending.fetch_add(1, std::memory_order_relaxed);
+    try {
+        submit_([this, state = state_, parent = std::move(parent), path = std::move(path)]() {
+            // finish_task выполняется и при исключении в колбэке; после него
+            // обходчик может быть уже уничтожен, поэтому this больше не трогаем
+            struct Finish {
+                WalkState& state;
+                ~Finish() { finish_task(state); }
+            } finish{*state};
+
+            const int fd = parent ? ::openat(parent->fd, path.filename().c_str(), DIR_OPEN_FLAGS)
+                                  : ::open(path.c_str(), DIR_OPEN_FLAGS);
+            if (fd < 0) {
+                on_error_(path, errno);
+                return;
+            }
+            list_directory(make_handle(fd), path);
+        });
+    } catch (...) {
+        finish_task(*state_);
+        throw;
+    }
+}
+
+void DirectoryWalker::list_directory(const std::shared_ptr<DirHandle>& handle, const std::filesystem::path& path) {
+    // Буфер свой у каждого вызова: submit может выполнить задачу сразу же
+    std::unique_ptr<char[]> buffer(new char[DIRENT_BUFFER_SIZE]);
+    std::vector<std::string> files;
+    auto flush_files = [&]() {
+        if (!files.empty()) {
+            on_files_(handle->fd, path, files);
+            files.clear();
+        }
+    };
+
+    while (true) {
+        const long bytes = ::syscall(SYS_getdents64, handle->fd, buffer.get(), DIRENT_BUFFER_SIZE);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            on_error_(path, errno);
+            flush_files();
+            return;
+        }
+        if (bytes == 0) {
+            flush_files();
+            return;
+        }
+
+        for (long offset = 0; offset < bytes;) {
+            const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer.get() + offset);
+            offset += entry->d_reclen;
+
+            const std::string_view name(entry->d_name);
+            if (name == "." || name == "..") {
+                continue;
+            }
+
+            unsigned char type = entry->d_type;
+            struct stat st {};
+            if (type == DT_UNKNOWN) {
+                // ФС не заполняет d_type (часть сетевых и старых ФС)
+                if (::fstatat(handle->fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                    on_error_(path / name, errno);
+                    continue;
+                }
+                type = S_ISREG(st.st_mode) ? DT_REG : S_ISDIR(st.st_mode) ? DT_DIR
+                     : S_ISLNK(st.st_mode) ? DT_LNK : DT_UNKNOWN;
+            }
+            if (type == DT_LNK) {
+                // Ссылку разыменовываем: файл по ссылке сканируется, директория - нет
+                const bool is_file = ::fstatat(handle->fd, entry->d_name, &st, 0) == 0 && S_ISREG(st.st_mode);
+                type = is_file ? DT_REG : DT_UNKNOWN;
+            }
+
+            if (type == DT_REG) {
+                files.emplace_back(name);
+                if (files.size() >= MAX_FILE_BATCH) {
+                    flush_files();
+                }
+            } else if (type == DT_DIR) {
+                const bool keep_parent = state_->open_handles.load(std::memory_order_relaxed) < MAX_OPEN_PARENTS;
+                schedule(keep_parent ? handle : nullptr, path / name);
+            }
+        }
+    }
+}
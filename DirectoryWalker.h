@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Параллельный обход дерева: каждая директория - отдельная задача, которая
+// открывается через openat относительно дескриптора родителя и читается
+// getdents64. Тип записи берется из d_type, stat нужен только для
+// DT_UNKNOWN и символических ссылок. Ссылки на файлы сканируются, ссылки
+// на директории не раскрываются - как у recursive_directory_iterator.
+class DLL_EXPORT DirectoryWalker {
+public:
+    // Планирует задачу обхода (обычно - в пул потоков сканера)
+    using Submit = std::function<void(std::function<void()>)>;
+    // Очередная пачка обычных файлов одной директории (не больше
+    // MAX_FILE_BATCH имен): dir_fd открыт на время вызова, имена можно забрать
+    using FileCallback = std::function<void(int dir_fd, const std::filesystem::path& directory,
+                                            std::vector<std::string>& names)>;
+    using ErrorCallback = std::function<void(const std::filesystem::path& path, int error)>;
+
+private:
+    // Счетчики живут отдельно от обходчика: последняя задача еще держит их
+    // после того, как Walk вернулся и обходчик уничтожен
+    struct WalkState {
+        std::atomic<size_t> pending{0};
+        std::atomic<size_t> open_handles{0};
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+    };
+    struct DirHandle {
+        int fd = -1;
+        std::shared_ptr<WalkState> state;
+        ~DirHandle();
+    };
+
+private:
+    Submit submit_;
+    FileCallback on_files_;
+    ErrorCallback on_error_;
+    std::shared_ptr<WalkState> state_;
+private:
+    // Сколько дескрипторов родителей можно держать открытыми ради openat;
+    // сверх этого дочерние директории открываются по полному пути
+    static constexpr size_t MAX_OPEN_PARENTS = 256;
+public:
+    static constexpr size_t MAX_FILE_BATCH = 256;
+private:
+    void schedule(std::shared_ptr<DirHandle> parent, std::filesystem::path path);
+    void list_directory(const std::shared_ptr<DirHandle>& parent, const std::filesystem::path& path);
+    std::shared_ptr<DirHandle> make_handle(int fd) const;
+    static void finish_task(WalkState& state);
+public:
+    DirectoryWalker(Submit submit, FileCallback on_files, ErrorCallback on_error);
+
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+    // Возвращается, когда все директории прочитаны; файлы к этому моменту
+    // уже переданы в on_files. Ошибка открытия корня - исключение.
+    void Walk(const std::filesystem::path& root);
+};
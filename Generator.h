@@ -0,0 +1,100 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+// Минимальный генератор на корутинах C++20 (std::generator появится только
+// в C++23): co_yield отдает значение, range-for забирает его и возобновляет
+// корутину. Исключение из тела корутины пробрасывается из operator++/begin.
+template<typename T>
+class Generator {
+public:
+    struct promise_type {
+        T* current = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object() noexcept {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        std::suspend_always yield_value(T&& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    class Iterator {
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() noexcept = default;
+        explicit Iterator(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+        T& operator*() const noexcept { return *handle_.promise().current; }
+        T* operator->() const noexcept { return handle_.promise().current; }
+        Iterator& operator++() {
+            resume(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const noexcept { return !handle_ || handle_.done(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+private:
+    static void resume(std::coroutine_handle<promise_type> handle) {
+        handle.resume();
+        if (handle.done() && handle.promise().error) {
+            std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+        }
+    }
+    explicit Generator(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+public:
+    Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Generator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Первый вызов запускает корутину до первого co_yield
+    Iterator begin() {
+        if (handle_) {
+            resume(handle_);
+        }
+        return Iterator(handle_);
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+};
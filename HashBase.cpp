@@ -1,63 +1,772 @@
 // HashBase.cpp
 #include "HashBase.h"
+#include "HashBaseImage.h"
 
 #include <fstream>
-#include <sstream>
 #include <cctype>
+#include <cstring>
 #include <stdexcept>
 #include <string>      
 #include <unordered_map>      
-#include <mutex>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <thread>
+#include <type_traits>
 
-void HashBase::trim(std::string& s) {
+namespace {
+
+constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+template<size_t N>
+struct ParsedRow {
+    Digest<N> digest;
+    uint32_t verdict;
+};
+
+struct MalformedLine {
+    size_t line_num;
+    std::string_view line;
+};
+
+struct ChunkResult {
+    std::vector<ParsedRow<MD5_DIGEST_SIZE>> md5_rows;
+    std::vector<ParsedRow<SHA1_DIGEST_SIZE>> sha1_rows;
+    std::vector<ParsedRow<SHA256_DIGEST_SIZE>> sha256_rows;
+    std::vector<std::string_view> verdicts;
+    std::vector<MalformedLine> malformed;
+    std::vector<uint64_t> sizes;
+    size_t unsized_rows = 0;
+    size_t line_count = 0;
+};
+
+} // namespace
+
+template<size_t N>
+DigestTable<N>& HashBase::table() noexcept {
+    if constexpr (N == MD5_DIGEST_SIZE) {
+        return md5_table_;
+    } else if constexpr (N == SHA1_DIGEST_SIZE) {
+        return sha1_table_;
+    } else {
+        static_assert(N == SHA256_DIGEST_SIZE, "unsupported digest size");
+        return sha256_table_;
+    }
+}
+
+template<size_t N>
+const DigestTable<N>& HashBase::table() const noexcept {
+    return const_cast<HashBase*>(this)->table<N>();
+}
+
+// Хеш в строке базы: "sha256:<hex>" или просто hex - тогда алгоритм
+// определяется по длине (32 - MD5, 40 - SHA-1, 64 - SHA-256).
+bool HashBase::split_tagged_hash(std::string_view hash, DigestAlgorithm& algorithm, std::string_view& hex) noexcept {
+    const auto colon = hash.find(':');
+    if (colon != std::string_view::npos) {
+        hex = trim(hash.substr(colon + 1));
+        return parse_digest_algorithm(trim(hash.substr(0, colon)), algorithm);
+    }
+    hex = hash;
+    switch (hash.size()) {
+        case 2 * MD5_DIGEST_SIZE: algorithm = DIGEST_MD5; return true;
+        case 2 * SHA1_DIGEST_SIZE: algorithm = DIGEST_SHA1; return true;
+        case 2 * SHA256_DIGEST_SIZE: algorithm = DIGEST_SHA256; return true;
+    }
+    return false;
+}
+
+// Необязательная третья колонка "hash;verdict;size" - размер файла в байтах.
+// Если последнее поле не число, оно остается частью вердикта.
+bool HashBase::split_size_column(std::string_view& verdict, uint64_t& size) noexcept {
+    const auto sep = verdict.rfind(';');
+    if (sep == std::string_view::npos) {
+        return false;
+    }
+    const auto column = trim(verdict.substr(sep + 1));
+    uint64_t value = 0;
+    const auto [end, ec] = std::from_chars(column.data(), column.data() + column.size(), value);
+    if (column.empty() || ec != std::errc{} || end != column.data() + column.size()) {
+        return false;
+    }
+    verdict = trim(verdict.substr(0, sep));
+    size = value;
+    return true;
+}
+
+std::string_view HashBase::trim(std::string_view s) {
     const char* ws = " \t\r\n";
     const auto from = s.find_first_not_of(ws);
-    if (from == std::string::npos) { s.clear(); return; }
+    if (from == std::string_view::npos) { return {}; }
     const auto to = s.find_last_not_of(ws);
-    s = s.substr(from, to - from + 1);
+    return s.substr(from, to - from + 1);
 }
-void HashBase::load_hashes(const std::string& csv_path) {
-    std::ifstream file(csv_path);
-    if (!file.is_open()) {
+
+// Разбор одного куска CSV, начинающегося с начала строки. Номера строк
+// локальные (с 1); вердикты интернируются в локальный пул куска.
+static void parse_chunk(std::string_view text, ChunkResult& out) {
+    std::unordered_map<std::string_view, uint32_t> local_ids;
+    out.md5_rows.reserve(text.size() / 48);
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        auto eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) {
+            eol = text.size();
+        }
+        const auto line = HashBase::trim(text.substr(pos, eol - pos));
+        pos = eol + 1;
+        const size_t line_num = ++out.line_count;
+
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        const auto sep = line.find(';');
+        if (sep == std::string_view::npos) {
+
+            continue;
+        }
+        const auto hash = HashBase::trim(line.substr(0, sep));
+        auto verdict = HashBase::trim(line.substr(sep + 1));
+        uint64_t file_size = 0;
+        const bool has_size = HashBase::split_size_column(verdict, file_size);
+
+        DigestAlgorithm algorithm;
+        std::string_view hex;
+        auto add_row = [&](auto& rows) {
+            typename std::remove_reference_t<decltype(rows)>::value_type row;
+            if (!parse_hex_digest(hex, row.digest)) {
+                return false;
+            }
+            auto [it, inserted] = local_ids.try_emplace(verdict, static_cast<uint32_t>(out.verdicts.size()));
+            if (inserted) {
+                out.verdicts.push_back(verdict);
+            }
+            row.verdict = it->second;
+            rows.push_back(row);
+            return true;
+        };
+
+        bool ok = !verdict.empty() && HashBase::split_tagged_hash(hash, algorithm, hex);
+        if (ok) {
+            switch (algorithm) {
+                case DIGEST_MD5: ok = add_row(out.md5_rows); break;
+                case DIGEST_SHA1: ok = add_row(out.sha1_rows); break;
+                case DIGEST_SHA256: ok = add_row(out.sha256_rows); break;
+            }
+        }
+        if (!ok) {
+            out.malformed.push_back(MalformedLine{line_num, line});
+        } else if (has_size) {
+            out.sizes.push_back(file_size);
+        } else {
+            ++out.unsized_rows;
+        }
+    }
+}
+
+void HashBase::load_hashes(const std::string& csv_path, size_t thread_count) {
+    MappedFile file;
+    try {
+        file = MappedFile(csv_path);
+    } catch (const std::runtime_error&) {
         throw std::runtime_error("Не удается открыть файл базы хешей: " + csv_path);
     }
-    std::string line;
+    file.advise_sequential();
+    const std::string_view text(reinterpret_cast<const char*>(file.data()), file.size());
+
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t chunk_count = std::max<size_t>(1, std::min(thread_count, text.size() / MIN_CHUNK_SIZE));
+
+    // Границы кусков сдвигаются к началу следующей строки
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < chunk_count; ++i) {
+        size_t bound = std::max(bounds.back(), text.size() * i / chunk_count);
+        const auto eol = text.find('\n', bound);
+        bound = (eol == std::string_view::npos) ? text.size() : eol + 1;
+        bounds.push_back(bound);
+    }
+    bounds.push_back(text.size());
+
+    std::vector<ChunkResult> chunks(chunk_count);
+    if (chunk_count == 1) {
+        parse_chunk(text, chunks[0]);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(chunk_count);
+        for (size_t i = 0; i < chunk_count; ++i) {
+            workers.emplace_back([&, i]() {
+                parse_chunk(text.substr(bounds[i], bounds[i + 1] - bounds[i]), chunks[i]);
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Слияние в порядке кусков: первая запись хеша побеждает, как и раньше
+    auto reserve_rows = [&](auto& table, auto rows_of) {
+        size_t total_rows = table.size();
+        for (const auto& chunk : chunks) {
+            total_rows += rows_of(chunk).size();
+        }
+        if (total_rows > table.size()) {
+            table.reserve(total_rows);
+        }
+    };
+    reserve_rows(md5_table_, [](const ChunkResult& chunk) -> const auto& { return chunk.md5_rows; });
+    reserve_rows(sha1_table_, [](const ChunkResult& chunk) -> const auto& { return chunk.sha1_rows; });
+    reserve_rows(sha256_table_, [](const ChunkResult& chunk) -> const auto& { return chunk.sha256_rows; });
+
+    auto insert_rows = [&](auto& table, const auto& rows, const std::vector<uint32_t>& ids) {
+        for (const auto& row : rows) {
+            table.insert(row.digest, ids[row.verdict]);
+        }
+    };
+
+    size_t line_base = 0;
+    std::vector<uint32_t> global_ids;
+    for (const auto& chunk : chunks) {
+        global_ids.clear();
+        for (const auto verdict : chunk.verdicts) {
+            global_ids.push_back(intern_verdict(verdict));
+        }
+        insert_rows(md5_table_, chunk.md5_rows, global_ids);
+        insert_rows(sha1_table_, chunk.sha1_rows, global_ids);
+        insert_rows(sha256_table_, chunk.sha256_rows, global_ids);
+        for (const auto& bad : chunk.malformed) {
+            ++malformed_lines_;
+            if (warnings_.size() < MAX_STORED_WARNINGS) {
+                warnings_.push_back("Предупреждение: некорректная строка " + std::to_string(line_base + bad.line_num) +
+                                    " в базе хешей: " + std::string(bad.line));
+            }
+        }
+        line_base += chunk.line_count;
+    }
+
+    // Индекс размеров годится, только если размер есть у каждой записи
+    std::vector<uint64_t> sizes;
+    for (auto& chunk : chunks) {
+        sizes.insert(sizes.end(), chunk.sizes.begin(), chunk.sizes.end());
+        if (chunk.unsized_rows > 0) {
+            sizes_complete_ = false;
+        }
+    }
+    if (sizes_complete_) {
+        sizes_.insert(sizes);
+    } else {
+        sizes_.clear();
+    }
+
+    if (has_prefilter()) {
+        build_prefilter(prefilter_bits_per_key_);
+    }
+}
+
+// Дельта: "+hash;verdict" добавляет или переопределяет запись,
+// "-hash" удаляет ее; строка без префикса считается добавлением.
+void HashBase::apply_delta(const std::string& delta_path) {
+    std::ifstream file(delta_path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удается открыть файл дельты базы хешей: " + delta_path);
+    }
+    std::string raw_line;
     size_t line_num = 0;
-    while (std::getline(file, line)) {
+    while (std::getline(file, raw_line)) {
         ++line_num;
-        trim(line);
-
-        if (line.empty() || line == "#") {
+        auto line = trim(raw_line);
+        if (line.empty() || line.front() == '#') {
             continue;
         }
-        const auto pos = line.find(';');
-        if (pos == std::string::npos) {
+        const bool remove = line.front() == '-';
+        if (remove || line.front() == '+') {
+            line.remove_prefix(1);
+        }
 
-            continue;
+        const auto sep = line.find(';');
+        const auto hash = trim(line.substr(0, sep));
+        auto verdict = (sep == std::string_view::npos) ? std::string_view{} : trim(line.substr(sep + 1));
+        uint64_t file_size = 0;
+        const bool has_size = !remove && split_size_column(verdict, file_size);
+
+        DigestAlgorithm algorithm;
+        std::string_view hex;
+        auto apply_row = [&](auto& table) {
+            typename std::remove_reference_t<decltype(table)>::Key digest;
+            if (!parse_hex_digest(hex, digest)) {
+                return false;
+            }
+            if (remove) {
+                table.erase(digest);
+            } else {
+                table.insert_or_assign(digest, intern_verdict(verdict));
+            }
+            return true;
+        };
+
+        bool ok = (remove || !verdict.empty()) && split_tagged_hash(hash, algorithm, hex);
+        if (ok) {
+            switch (algorithm) {
+                case DIGEST_MD5: ok = apply_row(md5_table_); break;
+                case DIGEST_SHA1: ok = apply_row(sha1_table_); break;
+                case DIGEST_SHA256: ok = apply_row(sha256_table_); break;
+            }
+        }
+        if (!ok) {
+            ++malformed_lines_;
+            if (warnings_.size() < MAX_STORED_WARNINGS) {
+                warnings_.push_back("Предупреждение: некорректная строка " + std::to_string(line_num) +
+                                    " в дельте базы хешей: " + std::string(line));
+            }
+        } else if (!remove) {
+            // Размеры удаленных записей остаются в индексе: лишний размер
+            // безопасен, он лишь не дает пропустить файл
+            if (has_size && sizes_complete_) {
+                sizes_.insert(file_size);
+            } else if (!has_size) {
+                sizes_complete_ = false;
+                sizes_.clear();
+            }
         }
-        std::string hash = line.substr(0, pos);
-        std::string verdict = line.substr(pos + 1);
-        trim(hash);
-        trim(verdict);
-        std::transform(hash.begin(), hash.end(), hash.begin(),
-                       [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    }
+
+    if (has_prefilter()) {
+        build_prefilter(prefilter_bits_per_key_);
+    }
+}
+
+std::unique_ptr<HashBase> HashBase::clone() const {
+    auto copy = std::make_unique<HashBase>();
+    copy->md5_table_ = md5_table_;
+    copy->sha1_table_ = sha1_table_;
+    copy->sha256_table_ = sha256_table_;
+    copy->verdicts_ = verdicts_;
+    copy->prefilter_ = prefilter_;
+    copy->prefilter_bits_per_key_ = prefilter_bits_per_key_;
+    copy->sizes_ = sizes_;
+    copy->sizes_complete_ = sizes_complete_;
+    return copy;
+}
 
-        if (hash.empty() || verdict.empty()) {
-            std::lock_guard<std::mutex> lock(log_mutex_);
-            log_file_ << "Предупреждение: некорректная строка " << line_num
-              << " в базе хешей: " << line << std::endl;
-        }else{
-            malicious_hashes_map_.emplace(std::move(hash), std::move(verdict));
+size_t HashBase::image_bytes() const noexcept {
+    return image_.size();
+}
+
+uint32_t HashBase::intern_verdict(std::string_view verdict) {
+    if (verdict_ids_.size() != verdicts_.size()) {
+        // Пул пришел из скомпилированной базы - восстанавливаем индекс
+        verdict_ids_.clear();
+        for (size_t i = 0; i < verdicts_.size(); ++i) {
+            verdict_ids_.emplace(verdicts_[i], static_cast<uint32_t>(i));
         }
     }
+    std::string key(verdict);
+    auto it = verdict_ids_.find(key);
+    if (it != verdict_ids_.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<uint32_t>(verdicts_.size());
+    verdicts_.push_back(key);
+    verdict_ids_.emplace(std::move(key), id);
+    return id;
 }
 
-const std::string* HashBase::get_verdict(const std::string& hash_hex_lower) const {
-    std::string hash_lower = hash_hex_lower;
-    std::transform(hash_lower.begin(), hash_lower.end(), hash_lower.begin(),
-        [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
-    
-    auto it = malicious_hashes_map_.find(hash_lower);
-    return (it == malicious_hashes_map_.end()) ? nullptr : &it->second;
+const std::string* HashBase::get_verdict(std::string_view hash_hex) const {
+    DigestAlgorithm algorithm;
+    std::string_view hex;
+    if (!split_tagged_hash(trim(hash_hex), algorithm, hex)) {
+        return nullptr;
+    }
+    auto lookup = [&](auto digest) -> const std::string* {
+        return parse_hex_digest(hex, digest) ? get_verdict(digest) : nullptr;
+    };
+    switch (algorithm) {
+        case DIGEST_MD5: return lookup(MD5Digest{});
+        case DIGEST_SHA1: return lookup(SHA1Digest{});
+        case DIGEST_SHA256: return lookup(SHA256Digest{});
+    }
+    return nullptr;
+}
+
+template<size_t N>
+const std::string* HashBase::find_verdict(const Digest<N>& digest) const noexcept {
+    const auto id = table<N>().find(digest);
+    return (id < verdicts_.size()) ? &verdicts_[id] : nullptr;
+}
+
+const std::string* HashBase::get_verdict(const MD5Digest& digest) const noexcept {
+    return find_verdict(digest);
+}
+
+const std::string* HashBase::get_verdict(const SHA1Digest& digest) const noexcept {
+    return find_verdict(digest);
+}
+
+const std::string* HashBase::get_verdict(const SHA256Digest& digest) const noexcept {
+    return find_verdict(digest);
+}
+
+const std::string* HashBase::get_verdict(const FileDigests& digests, DigestAlgorithm* matched) const noexcept {
+    const std::string* verdict = nullptr;
+    DigestAlgorithm algorithm = DIGEST_MD5;
+    if ((digests.algorithms & DIGEST_MD5) && (verdict = get_verdict(digests.md5)) != nullptr) {
+        algorithm = DIGEST_MD5;
+    } else if ((digests.algorithms & DIGEST_SHA1) && (verdict = get_verdict(digests.sha1)) != nullptr) {
+        algorithm = DIGEST_SHA1;
+    } else if ((digests.algorithms & DIGEST_SHA256) && (verdict = get_verdict(digests.sha256)) != nullptr) {
+        algorithm = DIGEST_SHA256;
+    }
+    if (verdict != nullptr && matched != nullptr) {
+        *matched = algorithm;
+    }
+    return verdict;
 }
 
+unsigned HashBase::algorithms() const noexcept {
+    return (md5_table_.size() > 0 ? DIGEST_MD5 : 0u) |
+           (sha1_table_.size() > 0 ? DIGEST_SHA1 : 0u) |
+           (sha256_table_.size() > 0 ? DIGEST_SHA256 : 0u);
+}
+
+template<size_t N>
+uint64_t HashBase::prefilter_hash(const Digest<N>& digest) noexcept {
+    // Таблица адресуется первыми 8 байтами дайджеста, фильтр - последними
+    uint64_t hash;
+    std::memcpy(&hash, digest.data() + N - sizeof(hash), sizeof(hash));
+    return hash;
+}
+
+// Один фильтр на все алгоритмы: ключи разных таблиц просто смешиваются
+void HashBase::build_prefilter(size_t bits_per_key) {
+    BloomFilter filter;
+    filter.init(size(), bits_per_key);
+    auto insert_table = [&filter](const auto& table) {
+        using Table = std::remove_cv_t<std::remove_reference_t<decltype(table)>>;
+        const typename Table::Slot* slots = table.data();
+        for (size_t i = 0; i < table.capacity(); ++i) {
+            if (slots[i].verdict != Table::EMPTY_SLOT) {
+                filter.insert(prefilter_hash(slots[i].digest));
+            }
+        }
+    };
+    insert_table(md5_table_);
+    insert_table(sha1_table_);
+    insert_table(sha256_table_);
+    prefilter_ = std::move(filter);
+    prefilter_bits_per_key_ = bits_per_key;
+}
+
+bool HashBase::has_prefilter() const noexcept {
+    return !prefilter_.empty();
+}
+
+bool HashBase::may_contain(const MD5Digest& digest) const noexcept {
+    return prefilter_.may_contain(prefilter_hash(digest));
+}
+
+bool HashBase::may_contain(const SHA1Digest& digest) const noexcept {
+    return prefilter_.may_contain(prefilter_hash(digest));
+}
+
+bool HashBase::may_contain(const SHA256Digest& digest) const noexcept {
+    return prefilter_.may_contain(prefilter_hash(digest));
+}
+
+bool HashBase::may_contain(const FileDigests& digests) const noexcept {
+    return ((digests.algorithms & DIGEST_MD5) && may_contain(digests.md5)) ||
+           ((digests.algorithms & DIGEST_SHA1) && may_contain(digests.sha1)) ||
+           ((digests.algorithms & DIGEST_SHA256) && may_contain(digests.sha256));
+}
+
+size_t HashBase::prefilter_bytes() const noexcept {
+    return prefilter_.size_bytes();
+}
+
+bool HashBase::has_size_index() const noexcept {
+    return sizes_complete_ && !sizes_.empty();
+}
+
+bool HashBase::may_have_size(uint64_t file_size) const noexcept {
+    return !has_size_index() || sizes_.contains(file_size);
+}
+
+size_t HashBase::size_index_count() const noexcept {
+    return has_size_index() ? sizes_.count() : 0;
+}
+
+const std::vector<std::string>& HashBase::load_warnings() const noexcept {
+    return warnings_;
+}
+
+size_t HashBase::malformed_lines() const noexcept {
+    return malformed_lines_;
+}
+
+size_t HashBase::size() const noexcept {
+    return md5_table_.size() + sha1_table_.size() + sha256_table_.size();
+}
+
+
+bool HashBase::is_image(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(hash_base_image::MAGIC)] = {};
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, hash_base_image::MAGIC, sizeof(magic)) == 0;
+}
+
+void HashBase::load(const std::string& path) {
+    if (is_image(path)) {
+        load_image(path);
+    } else {
+        load_hashes(path);
+    }
+}
+
+void HashBase::save_image(const std::string& image_path) const {
+    using namespace hash_base_image;
+
+    std::vector<uint32_t> pool_offsets;
+    pool_offsets.reserve(verdicts_.size() + 1);
+    std::string pool_chars;
+    for (const auto& verdict : verdicts_) {
+        pool_offsets.push_back(static_cast<uint32_t>(pool_chars.size()));
+        pool_chars += verdict;
+    }
+    pool_offsets.push_back(static_cast<uint32_t>(pool_chars.size()));
+
+    std::string pool;
+    pool.append(reinterpret_cast<const char*>(pool_offsets.data()), pool_offsets.size() * sizeof(uint32_t));
+    pool.append(pool_chars);
+
+    struct SectionData {
+        ImageSection section;
+        const void* data;
+    };
+    std::vector<SectionData> payload;
+    auto add_table = [&payload](uint32_t kind, const auto& table) {
+        using Slot = typename std::remove_reference_t<decltype(table)>::Slot;
+        payload.push_back({ImageSection{kind, sizeof(Slot), 0, table.capacity() * sizeof(Slot), table.size()},
+                           table.data()});
+    };
+    // Таблица MD5 пишется всегда, таблицы SHA - только непустые
+    add_table(MD5_TABLE, md5_table_);
+    if (sha1_table_.size() > 0) {
+        add_table(SHA1_TABLE, sha1_table_);
+    }
+    if (sha256_table_.size() > 0) {
+        add_table(SHA256_TABLE, sha256_table_);
+    }
+    payload.push_back({ImageSection{VERDICT_POOL, 0, 0, pool.size(), verdicts_.size()}, pool.data()});
+    if (has_size_index()) {
+        payload.push_back({ImageSection{SIZE_SET, sizeof(uint64_t), 0, sizes_.size_bytes(), sizes_.count()},
+                           sizes_.data()});
+    }
+    if (!prefilter_.empty()) {
+        payload.push_back({ImageSection{PREFILTER, sizeof(BloomFilter::Block), 0,
+                                        prefilter_.size_bytes(), prefilter_.block_count()},
+                           prefilter_.data()});
+    }
+
+    std::vector<ImageSection> sections;
+    uint64_t offset = align_up(sizeof(ImageHeader) + payload.size() * sizeof(ImageSection));
+    uint64_t payload_sum = 0xcbf29ce484222325ULL;
+    for (auto& item : payload) {
+        item.section.offset = offset;
+        offset = align_up(offset + item.section.size);
+        payload_sum = checksum(static_cast<const unsigned char*>(item.data), item.section.size, payload_sum);
+        sections.push_back(item.section);
+    }
+
+    ImageHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.section_count = static_cast<uint32_t>(sections.size());
+    header.file_size = sections.back().offset + sections.back().size;
+    header.payload_checksum = payload_sum;
+    header.header_checksum = checksum(reinterpret_cast<const unsigned char*>(sections.data()),
+                                      sections.size() * sizeof(ImageSection),
+                                      checksum(reinterpret_cast<const unsigned char*>(&header), sizeof(header)));
+
+    // Пишем во временный файл и атомарно подменяем: уже запущенные сканеры
+    // продолжают работать со старым отображением.
+    const std::string tmp_path = image_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Не удается создать файл скомпилированной базы: " + tmp_path);
+        }
+        const std::string padding(IMAGE_ALIGNMENT, '\0');
+        auto pad_to = [&](uint64_t offset) {
+            const auto pos = static_cast<uint64_t>(out.tellp());
+            out.write(padding.data(), static_cast<std::streamsize>(offset - pos));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(sections.data()),
+                  static_cast<std::streamsize>(sections.size() * sizeof(ImageSection)));
+        for (const auto& item : payload) {
+            pad_to(item.section.offset);
+            out.write(static_cast<const char*>(item.data), static_cast<std::streamsize>(item.section.size));
+        }
+        out.flush();
+        if (!out.good()) {
+            throw std::runtime_error("Ошибка записи скомпилированной базы: " + tmp_path);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, image_path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        throw std::runtime_error("Не удается сохранить скомпилированную базу: " + image_path);
+    }
+}
+
+void HashBase::load_image(const std::string& image_path, bool verify_checksum) {
+    using namespace hash_base_image;
+
+    const std::string bad_format = "Некорректный формат скомпилированной базы: " + image_path;
+
+    MappedFile image(image_path);
+    if (image.size() < sizeof(ImageHeader)) {
+        throw std::runtime_error(bad_format);
+    }
+
+    ImageHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error(bad_format);
+    }
+    if (header.version < MIN_VERSION || header.version > VERSION) {
+        throw std::runtime_error("Неподдерживаемая версия скомпилированной базы " +
+                                 std::to_string(header.version) + ": " + image_path);
+    }
+    const size_t table_bytes = sizeof(ImageHeader) + header.section_count * sizeof(ImageSection);
+    if (header.file_size != image.size() || header.section_count == 0 || table_bytes > image.size()) {
+        throw std::runtime_error(bad_format);
+    }
+
+    std::vector<ImageSection> sections(header.section_count);
+    std::memcpy(sections.data(), image.data() + sizeof(ImageHeader), sections.size() * sizeof(ImageSection));
+
+    ImageHeader unsigned_header = header;
+    unsigned_header.header_checksum = 0;
+    const uint64_t header_sum = checksum(reinterpret_cast<const unsigned char*>(sections.data()),
+                                         sections.size() * sizeof(ImageSection),
+                                         checksum(reinterpret_cast<const unsigned char*>(&unsigned_header),
+                                                  sizeof(unsigned_header)));
+    if (header_sum != header.header_checksum) {
+        throw std::runtime_error("Контрольная сумма заголовка не совпадает: " + image_path);
+    }
+
+    const ImageSection* table_section = nullptr;
+    const ImageSection* sha1_section = nullptr;
+    const ImageSection* sha256_section = nullptr;
+    const ImageSection* pool_section = nullptr;
+    const ImageSection* filter_section = nullptr;
+    const ImageSection* size_section = nullptr;
+    uint64_t payload_sum = 0xcbf29ce484222325ULL;
+    for (const auto& section : sections) {
+        if (section.offset % IMAGE_ALIGNMENT != 0 || section.offset > image.size() ||
+            section.size > image.size() - section.offset) {
+            throw std::runtime_error(bad_format);
+        }
+        if (verify_checksum) {
+            payload_sum = checksum(image.data() + section.offset, section.size, payload_sum);
+        }
+        if (section.kind == MD5_TABLE) {
+            table_section = &section;
+        } else if (section.kind == SHA1_TABLE) {
+            sha1_section = &section;
+        } else if (section.kind == SHA256_TABLE) {
+            sha256_section = &section;
+        } else if (section.kind == VERDICT_POOL) {
+            pool_section = &section;
+        } else if (section.kind == PREFILTER) {
+            filter_section = &section;
+        } else if (section.kind == SIZE_SET) {
+            size_section = &section;
+        }
+    }
+    if (verify_checksum && payload_sum != header.payload_checksum) {
+        throw std::runtime_error("Контрольная сумма скомпилированной базы не совпадает: " + image_path);
+    }
+    if (table_section == nullptr || pool_section == nullptr) {
+        throw std::runtime_error(bad_format);
+    }
+
+    const uint64_t verdict_count = pool_section->count;
+    const uint64_t offsets_bytes = (verdict_count + 1) * sizeof(uint32_t);
+    if (offsets_bytes > pool_section->size) {
+        throw std::runtime_error(bad_format);
+    }
+    const unsigned char* pool = image.data() + pool_section->offset;
+    const uint64_t chars_size = pool_section->size - offsets_bytes;
+    std::vector<std::string> verdicts;
+    verdicts.reserve(verdict_count);
+    for (uint64_t i = 0; i < verdict_count; ++i) {
+        uint32_t from, to;
+        std::memcpy(&from, pool + i * sizeof(uint32_t), sizeof(from));
+        std::memcpy(&to, pool + (i + 1) * sizeof(uint32_t), sizeof(to));
+        if (from > to || to > chars_size) {
+            throw std::runtime_error(bad_format);
+        }
+        verdicts.emplace_back(reinterpret_cast<const char*>(pool + offsets_bytes + from), to - from);
+    }
+
+    auto attach_table = [&](auto& table, const ImageSection* section) {
+        using Slot = typename std::remove_reference_t<decltype(table)>::Slot;
+        if (section == nullptr) {
+            return;
+        }
+        if (section->slot_size != sizeof(Slot) || section->size % sizeof(Slot) != 0) {
+            throw std::runtime_error(bad_format);
+        }
+        const size_t capacity = section->size / sizeof(Slot);
+        const auto* slots = reinterpret_cast<const Slot*>(image.data() + section->offset);
+        if (capacity > 0 && !table.attach(slots, capacity, section->count)) {
+            throw std::runtime_error(bad_format);
+        }
+    };
+    DigestTable<MD5_DIGEST_SIZE> md5_table;
+    DigestTable<SHA1_DIGEST_SIZE> sha1_table;
+    DigestTable<SHA256_DIGEST_SIZE> sha256_table;
+    attach_table(md5_table, table_section);
+    attach_table(sha1_table, sha1_section);
+    attach_table(sha256_table, sha256_section);
+
+    BloomFilter filter;
+    if (filter_section != nullptr) {
+        if (filter_section->slot_size != sizeof(BloomFilter::Block) ||
+            filter_section->size != filter_section->count * sizeof(BloomFilter::Block) ||
+            !filter.attach(reinterpret_cast<const BloomFilter::Block*>(image.data() + filter_section->offset),
+                           filter_section->count)) {
+            throw std::runtime_error(bad_format);
+        }
+    }
+
+    SizeSet sizes;
+    if (size_section != nullptr) {
+        if (size_section->slot_size != sizeof(uint64_t) ||
+            size_section->size != size_section->count * sizeof(uint64_t) ||
+            !sizes.attach(reinterpret_cast<const uint64_t*>(image.data() + size_section->offset),
+                          size_section->count)) {
+            throw std::runtime_error(bad_format);
+        }
+    }
+
+    md5_table_ = std::move(md5_table);
+    sha1_table_ = std::move(sha1_table);
+    sha256_table_ = std::move(sha256_table);
+    prefilter_ = std::move(filter);
+    sizes_ = std::move(sizes);
+    sizes_complete_ = size_section != nullptr || size() == 0;
+    verdicts_ = std::move(verdicts);
+    verdict_ids_.clear();
+    image_ = std::move(image);
+    image_.advise_random();
+}
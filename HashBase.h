@@ -8,22 +8,82 @@
 #  endif
 #endif
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <mutex>
-#include <fstream> 
+#include <vector>
+#include "Digest.h"
+#include "DigestTable.h"
+#include "MappedFile.h"
+#include "BloomFilter.h"
+#include "SizeSet.h"
 
 class DLL_EXPORT HashBase{
 private:
-    std::unordered_map<std::string, std::string> malicious_hashes_map_;
-    std::mutex log_mutex_;
-    std::ofstream log_file_;
+    DigestTable<MD5_DIGEST_SIZE> md5_table_;
+    DigestTable<SHA1_DIGEST_SIZE> sha1_table_;
+    DigestTable<SHA256_DIGEST_SIZE> sha256_table_;
+    std::vector<std::string> verdicts_;
+    std::unordered_map<std::string, uint32_t> verdict_ids_;
+    MappedFile image_;
+    BloomFilter prefilter_;
+    size_t prefilter_bits_per_key_ = BloomFilter::DEFAULT_BITS_PER_KEY;
+    SizeSet sizes_;
+    bool sizes_complete_ = true;
+    std::vector<std::string> warnings_;
+    size_t malformed_lines_ = 0;
 private:
-    static void trim(std::string& s);
+    static constexpr size_t MAX_STORED_WARNINGS = 1000;
+private:
+    uint32_t intern_verdict(std::string_view verdict);
+    template<size_t N>
+    DigestTable<N>& table() noexcept;
+    template<size_t N>
+    const DigestTable<N>& table() const noexcept;
+    template<size_t N>
+    const std::string* find_verdict(const Digest<N>& digest) const noexcept;
+    template<size_t N>
+    static uint64_t prefilter_hash(const Digest<N>& digest) noexcept;
 public:
-    void load_hashes(const std::string& csv_path);
-    const std::string* get_verdict(const std::string& hash_hex_lower) const;
+    static std::string_view trim(std::string_view s);
+    static bool split_size_column(std::string_view& verdict, uint64_t& size) noexcept;
+    static bool split_tagged_hash(std::string_view hash, DigestAlgorithm& algorithm, std::string_view& hex) noexcept;
+    static bool is_image(const std::string& path);
 
-};
+    void load(const std::string& path);
+    void load_hashes(const std::string& csv_path, size_t thread_count = 0);
+    void load_image(const std::string& image_path, bool verify_checksum = false);
+    void save_image(const std::string& image_path) const;
+    void apply_delta(const std::string& delta_path);
+    // Копия целиком в куче: таблицы скомпилированной базы копируются из
+    // отображения, общие с page cache страницы у копии уже не используются
+    std::unique_ptr<HashBase> clone() const;
+    // Размер отображенного образа compile_base; 0 - база собрана в куче
+    size_t image_bytes() const noexcept;
+    const std::string* get_verdict(std::string_view hash_hex) const;
+    const std::string* get_verdict(const MD5Digest& digest) const noexcept;
+    const std::string* get_verdict(const SHA1Digest& digest) const noexcept;
+    const std::string* get_verdict(const SHA256Digest& digest) const noexcept;
+    // Проверяет посчитанные дайджесты по порядку MD5, SHA-1, SHA-256
+    const std::string* get_verdict(const FileDigests& digests, DigestAlgorithm* matched = nullptr) const noexcept;
+    // Маска алгоритмов (DIGEST_*), для которых в базе есть записи
+    unsigned algorithms() const noexcept;
+    void build_prefilter(size_t bits_per_key = BloomFilter::DEFAULT_BITS_PER_KEY);
+    bool has_prefilter() const noexcept;
+    bool may_contain(const MD5Digest& digest) const noexcept;
+    bool may_contain(const SHA1Digest& digest) const noexcept;
+    bool may_contain(const SHA256Digest& digest) const noexcept;
+    bool may_contain(const FileDigests& digests) const noexcept;
+    size_t prefilter_bytes() const noexcept;
+    // Индекс размеров есть, только если размер указан у всех записей базы;
+    // без индекса may_have_size всегда true
+    bool has_size_index() const noexcept;
+    bool may_have_size(uint64_t file_size) const noexcept;
+    size_t size_index_count() const noexcept;
+    const std::vector<std::string>& load_warnings() const noexcept;
+    size_t malformed_lines() const noexcept;
+    size_t size() const noexcept;
 
+};
 
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Формат скомпилированной базы (compile_base):
+//
+//   ImageHeader | ImageSection[section_count] | секции, выровненные по IMAGE_ALIGNMENT
+//
+// Секция MD5_TABLE - массив слотов DigestTable<16> как есть (емкость =
+// size / slot_size, степень двойки; count - число записей), необязательные
+// SHA1_TABLE и SHA256_TABLE - так же для DigestTable<20> и <32>, VERDICT_POOL -
+// uint32 смещения [count + 1] и строки вердиктов подряд, необязательная
+// PREFILTER - блоки BloomFilter, необязательная SIZE_SET - отсортированные
+// uint64 размеры файлов (пишется, только если размер есть у всех записей).
+// Контрольная сумма данных считается цепочкой по секциям в порядке таблицы
+// секций. Числа хранятся в порядке байт хоста, что проверяется по полю
+// byte_order.
+namespace hash_base_image {
+
+inline constexpr char MAGIC[8] = {'S', 'C', 'N', 'B', 'A', 'S', 'E', '\0'};
+// Версия 2 добавила таблицы SHA-1/SHA-256; образы версии 1 читаются как есть
+inline constexpr uint32_t VERSION = 2;
+inline constexpr uint32_t MIN_VERSION = 1;
+inline constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+inline constexpr size_t IMAGE_ALIGNMENT = 64;
+
+enum SectionKind : uint32_t {
+    MD5_TABLE = 1,
+    VERDICT_POOL = 2,
+    PREFILTER = 3,
+    SHA1_TABLE = 4,
+    SHA256_TABLE = 5,
+    SIZE_SET = 6,
+};
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t section_count;
+    uint32_t reserved;
+    uint64_t file_size;
+    uint64_t payload_checksum;
+    uint64_t header_checksum;
+};
+
+struct ImageSection {
+    uint32_t kind;
+    uint32_t slot_size;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t count;
+};
+
+static_assert(sizeof(ImageHeader) == 48, "ImageHeader layout");
+static_assert(sizeof(ImageSection) == 32, "ImageSection layout");
+
+// FNV-1a по 64-битным словам; хвост короче слова дополняется нулями.
+inline uint64_t checksum(const unsigned char* data, size_t size,
+                         uint64_t seed = 0xcbf29ce484222325ULL) noexcept {
+    uint64_t hash = seed;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, size - i);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+inline size_t align_up(size_t value) noexcept {
+    return (value + IMAGE_ALIGNMENT - 1) & ~(IMAGE_ALIGNMENT - 1);
+}
+
+} // namespace hash_base_image
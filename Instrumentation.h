@@ -0,0 +1,147 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Внутренние счетчики очередей и пула. Включаются при сборке:
+// -DSCANNER_INSTRUMENTATION=1 (опция CMake SCANNER_INSTRUMENTATION) - и
+// только для всей сборки сразу (ядро, тесты, утилиты), иначе шаблоны
+// очередей разойдутся между единицами трансляции. Выключенные счетчики - пустые типы с пустыми методами:
+// члены классов не занимают места, вызовы исчезают при компиляции.
+#ifndef SCANNER_INSTRUMENTATION
+#define SCANNER_INSTRUMENTATION 0
+#endif
+
+namespace instrumentation {
+
+inline constexpr bool ENABLED = SCANNER_INSTRUMENTATION != 0;
+
+// Счетчик событий или наносекунд; пишут многие потоки
+class Counter {
+#if SCANNER_INSTRUMENTATION
+private:
+    std::atomic<uint64_t> value_{0};
+public:
+    void Add(uint64_t n = 1) noexcept { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Load() const noexcept { return value_.load(std::memory_order_relaxed); }
+#else
+public:
+    void Add(uint64_t = 1) const noexcept {}
+    uint64_t Load() const noexcept { return 0; }
+#endif
+};
+
+// Наибольшее из наблюдавшихся значений (пик заполненности очереди)
+class Maximum {
+#if SCANNER_INSTRUMENTATION
+private:
+    std::atomic<uint64_t> value_{0};
+public:
+    void Observe(uint64_t value) noexcept {
+        uint64_t current = value_.load(std::memory_order_relaxed);
+        while (value > current && !value_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+    uint64_t Load() const noexcept { return value_.load(std::memory_order_relaxed); }
+#else
+public:
+    void Observe(uint64_t) const noexcept {}
+    uint64_t Load() const noexcept { return 0; }
+#endif
+};
+
+// Засекает время от создания; без инструментирования часы не читаются
+class Stopwatch {
+#if SCANNER_INSTRUMENTATION
+private:
+    std::chrono::steady_clock::time_point started_ = std::chrono::steady_clock::now();
+public:
+    uint64_t ElapsedNs() const noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started_).count());
+    }
+#else
+public:
+    uint64_t ElapsedNs() const noexcept { return 0; }
+#endif
+};
+
+// Счетчики собраны в структуры, чтобы в классе был один член: пустые
+// члены одного типа не могут делить адрес и заняли бы место. Без
+// инструментирования счетчики - статические константы, структура пуста.
+#if SCANNER_INSTRUMENTATION
+#define SCANNER_COUNTER(name) Counter name
+#define SCANNER_MAXIMUM(name) Maximum name
+#else
+#define SCANNER_COUNTER(name) static constexpr Counter name{}
+#define SCANNER_MAXIMUM(name) static constexpr Maximum name{}
+#endif
+
+struct QueueCounters {
+    SCANNER_COUNTER(pushes);
+    SCANNER_COUNTER(pops);
+    SCANNER_COUNTER(lock_wait_ns);
+    SCANNER_COUNTER(push_wait_ns);
+    SCANNER_COUNTER(pop_wait_ns);
+    SCANNER_COUNTER(cas_retries);
+    SCANNER_MAXIMUM(high_water);
+};
+
+struct WorkerCounters {
+    SCANNER_COUNTER(busy_ns);
+    SCANNER_COUNTER(idle_ns);
+    SCANNER_COUNTER(tasks);
+    SCANNER_COUNTER(steals);
+    SCANNER_COUNTER(parks);
+};
+
+#undef SCANNER_COUNTER
+#undef SCANNER_MAXIMUM
+
+} // namespace instrumentation
+
+// Снимок счетчиков очереди. Время - суммарное по всем потокам.
+struct QueueStats {
+    bool enabled = instrumentation::ENABLED;
+    uint64_t pushes = 0;
+    uint64_t pops = 0;
+    // Захват мьютекса, который был занят (только у очередей с мьютексом)
+    std::chrono::nanoseconds lock_wait{0};
+    // Сон на полной очереди в Push и на пустой в Get
+    std::chrono::nanoseconds push_wait{0};
+    std::chrono::nanoseconds pop_wait{0};
+    // Проигранные CAS (только у lock-free очередей)
+    uint64_t cas_retries = 0;
+    uint64_t high_water = 0;
+    // Потоков, спящих в Get прямо сейчас
+    size_t waiting = 0;
+};
+
+struct WorkerStats {
+    std::chrono::nanoseconds busy{0};
+    // Поиск задачи, спин и сон
+    std::chrono::nanoseconds idle{0};
+    uint64_t tasks = 0;
+    uint64_t steals = 0;
+    uint64_t parks = 0;
+};
+
+struct PoolStats {
+    bool enabled = instrumentation::ENABLED;
+    std::vector<WorkerStats> workers;
+    // Исключения из задач, которые пул проглотил; считаются всегда
+    uint64_t swallowed_exceptions = 0;
+    // Общая очередь пула (в пачках задач)
+    QueueStats injection;
+};
@@ -0,0 +1,167 @@
+#include "IoUring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+template<typename T>
+T* ring_field(void* ring, uint32_t offset) noexcept {
+    return reinterpret_cast<T*>(static_cast<unsigned char*>(ring) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+    io_uring_params params {};
+    ring_fd_ = sys_io_uring_setup(entries, &params);
+    if (ring_fd_ < 0) {
+        throw std::runtime_error(std::string("Не удается создать io_uring: ") + std::strerror(errno));
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // С IORING_FEAT_SINGLE_MMAP оба кольца лежат в одном отображении
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        unmap();
+        throw std::runtime_error("Не удается отобразить кольцо отправки io_uring");
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            unmap();
+            throw std::runtime_error("Не удается отобразить кольцо завершений io_uring");
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        unmap();
+        throw std::runtime_error("Не удается отобразить массив SQE io_uring");
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = ring_field<unsigned>(sq_ring_, params.sq_off.head);
+    sq_tail_ = ring_field<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_array_ = ring_field<unsigned>(sq_ring_, params.sq_off.array);
+    sq_mask_ = *ring_field<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_entries_ = *ring_field<unsigned>(sq_ring_, params.sq_off.ring_entries);
+    cq_head_ = ring_field<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = ring_field<unsigned>(cq_ring_, params.cq_off.tail);
+    cqes_ = ring_field<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+    cq_mask_ = *ring_field<unsigned>(cq_ring_, params.cq_off.ring_mask);
+}
+
+IoUring::~IoUring() noexcept {
+    unmap();
+}
+
+void IoUring::unmap() noexcept {
+    if (sqes_ != nullptr) {
+        ::munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        ::munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_ != nullptr) {
+        ::munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+bool IoUring::available() noexcept {
+    io_uring_params params {};
+    const int fd = sys_io_uring_setup(2, &params);
+    if (fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+io_uring_sqe* IoUring::get_sqe() noexcept {
+    const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    const unsigned tail = *sq_tail_ + pending_;
+    if (tail - head >= sq_entries_) {
+        return nullptr;
+    }
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    ++pending_;
+    return sqe;
+}
+
+int IoUring::submit_and_wait(unsigned wait_nr) noexcept {
+    const unsigned to_submit = pending_;
+    if (to_submit > 0) {
+        __atomic_store_n(sq_tail_, *sq_tail_ + to_submit, __ATOMIC_RELEASE);
+        pending_ = 0;
+    }
+    if (to_submit == 0 && wait_nr == 0) {
+        return 0;
+    }
+    // Ядро забирает не больше SQE, чем лежит между head и tail, поэтому
+    // после EINTR вызов можно повторить с теми же аргументами
+    while (true) {
+        const int result = sys_io_uring_enter(ring_fd_, to_submit, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0);
+        if (result >= 0) {
+            return result;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+int IoUring::register_buffers(const iovec* buffers, unsigned count) noexcept {
+    return sys_io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, buffers, count) < 0 ? -errno : 0;
+}
+
+int IoUring::register_files(const int* fds, unsigned count) noexcept {
+    return sys_io_uring_register(ring_fd_, IORING_REGISTER_FILES, fds, count) < 0 ? -errno : 0;
+}
+
+int IoUring::update_file(unsigned slot, int fd) noexcept {
+    io_uring_files_update update {};
+    update.offset = slot;
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    return sys_io_uring_register(ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1) < 0 ? -errno : 0;
+}
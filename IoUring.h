@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+// Минимальная обертка io_uring на системных вызовах (без liburing): кольца
+// SQ/CQ отображаются в память, SQE заполняет вызывающий код. Не
+// потокобезопасна - каждым кольцом владеет один поток.
+class DLL_EXPORT IoUring {
+private:
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    // SQE, заполненные, но еще не переданные ядру
+    unsigned pending_ = 0;
+private:
+    void unmap() noexcept;
+public:
+    explicit IoUring(unsigned entries);
+    ~IoUring() noexcept;
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Ядро поддерживает io_uring и его не запретил seccomp
+    static bool available() noexcept;
+
+    // Обнуленный SQE или nullptr, если очередь отправки заполнена
+    io_uring_sqe* get_sqe() noexcept;
+    // Отправляет накопленные SQE и ждет wait_nr завершений; -errno при ошибке
+    int submit_and_wait(unsigned wait_nr) noexcept;
+
+    // Вызывает handle(cqe) для каждого готового завершения
+    template<typename Handle>
+    unsigned drain_completions(Handle&& handle);
+
+    // 0 или -errno. Таблица файлов может быть разреженной (-1).
+    int register_buffers(const iovec* buffers, unsigned count) noexcept;
+    int register_files(const int* fds, unsigned count) noexcept;
+    int update_file(unsigned slot, int fd) noexcept;
+
+    unsigned sq_entries() const noexcept { return sq_entries_; }
+};
+
+template<typename Handle>
+unsigned IoUring::drain_completions(Handle&& handle) {
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned count = 0;
+    for (; head != tail; ++head, ++count) {
+        handle(cqes_[head & cq_mask_]);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+}
@@ -0,0 +1,79 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+size_t LatencyHistogram::bucket_index(uint64_t ns) noexcept {
+    if (ns < SUB_BUCKETS) {
+        return static_cast<size_t>(ns);
+    }
+    const unsigned exponent = static_cast<unsigned>(std::bit_width(ns)) - 1;
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    // Старшие SUB_BUCKET_BITS бит после ведущей единицы - номер корзины внутри степени
+    const size_t sub = static_cast<size_t>(ns >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucket_lower(size_t index) noexcept {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const unsigned exponent = static_cast<unsigned>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    return (SUB_BUCKETS + index % SUB_BUCKETS) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t index) noexcept {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    if (index + 1 >= BUCKET_COUNT) {
+        return UINT64_MAX;
+    }
+    return bucket_lower(index + 1) - 1;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds value) noexcept {
+    const uint64_t ns = value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0;
+    ++counts_[bucket_index(ns)];
+    ++count_;
+    sum_ns_ += ns;
+    max_ns_ = std::max(max_ns_, ns);
+}
+
+void LatencyHistogram::AddBucket(size_t index, uint64_t count) noexcept {
+    counts_[index] += count;
+    count_ += count;
+}
+
+void LatencyHistogram::AddTotals(uint64_t sum_ns, uint64_t max_ns) noexcept {
+    sum_ns_ += sum_ns;
+    max_ns_ = std::max(max_ns_, max_ns);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) noexcept {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ns_ += other.sum_ns_;
+    max_ns_ = std::max(max_ns_, other.max_ns_);
+}
+
+std::chrono::nanoseconds LatencyHistogram::Percentile(double q) const noexcept {
+    if (count_ == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    q = std::clamp(q, 0.0, 1.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::chrono::nanoseconds(std::min(bucket_upper(i), max_ns_));
+        }
+    }
+    return std::chrono::nanoseconds(max_ns_);
+}
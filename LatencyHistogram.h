@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Гистограмма задержек в духе HDR: до 16 нс корзины по одной наносекунде,
+// дальше на каждую степень двойки 16 равных корзин, то есть погрешность
+// не больше 1/16 значения. Значения от 2^40 нс (~18 минут) попадают
+// в последнюю корзину. Сама гистограмма не потокобезопасна - это итоговый
+// снимок; для записи из многих потоков см. ScanMetrics.
+class DLL_EXPORT LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_EXPONENT = 39;
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ns_ = 0;
+    uint64_t max_ns_ = 0;
+public:
+    static size_t bucket_index(uint64_t ns) noexcept;
+    // Наименьшее и наибольшее значение, попадающее в корзину
+    static uint64_t bucket_lower(size_t index) noexcept;
+    static uint64_t bucket_upper(size_t index) noexcept;
+
+    void Record(std::chrono::nanoseconds value) noexcept;
+    // Для сборки снимка из счетчиков потоков
+    void AddBucket(size_t index, uint64_t count) noexcept;
+    void AddTotals(uint64_t sum_ns, uint64_t max_ns) noexcept;
+    void Merge(const LatencyHistogram& other) noexcept;
+
+    // Значение, не меньше которого доля q записей (q от 0 до 1); верхняя
+    // граница корзины, но не больше максимума
+    std::chrono::nanoseconds Percentile(double q) const noexcept;
+
+    uint64_t count() const noexcept { return count_; }
+    std::chrono::nanoseconds sum() const noexcept { return std::chrono::nanoseconds(sum_ns_); }
+    std::chrono::nanoseconds max() const noexcept { return std::chrono::nanoseconds(max_ns_); }
+    std::chrono::nanoseconds mean() const noexcept {
+        return std::chrono::nanoseconds(count_ == 0 ? 0 : sum_ns_ / count_);
+    }
+    uint64_t bucket_count(size_t index) const noexcept { return counts_[index]; }
+};
@@ -1,74 +1,297 @@
 #include "MD5Compute.h"
 #include <openssl/md5.h>
+#include <openssl/sha.h>
 #include <filesystem>
-#include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-std::optional<std::ifstream> MD5Compute::open_file_for_reading(const std::filesystem::path& file_path) const {
-    std::error_code ec;
-    if (!std::filesystem::is_regular_file(file_path, ec) || ec) {
-        return std::nullopt;
-    }
-    
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open() || !file.good()) {
-        return std::nullopt;
+namespace {
+
+struct FdGuard {
+    int fd;
+    ~FdGuard() { if (fd >= 0) ::close(fd); }
+};
+
+struct AlignedBuffer {
+    struct FreeDeleter {
+        void operator()(unsigned char* p) const noexcept { std::free(p); }
+    };
+    std::unique_ptr<unsigned char, FreeDeleter> data;
+    size_t size = 0;
+};
+
+constexpr size_t BUFFER_ALIGNMENT = 4096;
+
+// Буфер чтения живет в потоке и переиспользуется между файлами
+unsigned char* thread_buffer(size_t size) {
+    thread_local AlignedBuffer buffer;
+    if (buffer.size < size) {
+        auto* raw = static_cast<unsigned char*>(std::aligned_alloc(BUFFER_ALIGNMENT, size));
+        if (raw == nullptr) {
+            return nullptr;
+        }
+        buffer.data.reset(raw);
+        buffer.size = size;
     }
-    return file;
+    return buffer.data.get();
 }
 
-
-bool MD5Compute::compute_md5_digest(std::ifstream& file, unsigned char digest[MD5_DIGEST_LENGTH]) const {
-    MD5_CTX ctx;
-    if (MD5_Init(&ctx) != 1) {
+// update(data, size) получает каждый прочитанный кусок; false - ошибка
+template<typename Update>
+bool hash_with_pread(int fd, size_t buffer_size, Update&& update) {
+    unsigned char* buffer = thread_buffer(buffer_size);
+    if (buffer == nullptr) {
         return false;
     }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    char buffer[BUFFER_SIZE];
-    while (file.good()) {
-        file.read(buffer, BUFFER_SIZE);
-        const std::streamsize bytes_read = file.gcount();
-        if (bytes_read > 0) {
-            if (MD5_Update(&ctx, buffer, static_cast<size_t>(bytes_read)) != 1) {
-                return false;
+    off_t offset = 0;
+    while (true) {
+        const ssize_t bytes_read = ::pread(fd, buffer, buffer_size, offset);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            return false;
+        }
+        if (bytes_read == 0) {
+            return true;
+        }
+        if (!update(buffer, static_cast<size_t>(bytes_read))) {
+            return false;
         }
+        offset += bytes_read;
     }
-    if (file.bad()) {
-        return false;
+}
+
+template<typename Update>
+bool hash_with_mmap(int fd, size_t file_size, size_t chunk_size, Update&& update) {
+    void* addr = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        return hash_with_pread(fd, chunk_size, update);
     }
+    ::madvise(addr, file_size, MADV_SEQUENTIAL);
 
-    if (MD5_Final(digest, &ctx) != 1) {
-        return false;
+    const auto* data = static_cast<const unsigned char*>(addr);
+    bool ok = true;
+    for (size_t offset = 0; offset < file_size && ok; offset += chunk_size) {
+        const size_t chunk = std::min(chunk_size, file_size - offset);
+        ok = update(data + offset, chunk);
+    }
+    ::munmap(addr, file_size);
+    return ok;
+}
+
+} // namespace
+
+struct DigestAccumulator::Contexts {
+    MD5_CTX md5;
+    SHA_CTX sha1;
+    SHA256_CTX sha256;
+    bool ok = true;
+};
+
+DigestAccumulator::DigestAccumulator(unsigned algorithms)
+    : contexts_(std::make_unique<Contexts>()), algorithms_(algorithms & DIGEST_ALL) {
+    Contexts& c = *contexts_;
+    c.ok = (!(algorithms_ & DIGEST_MD5) || MD5_Init(&c.md5) == 1) &&
+           (!(algorithms_ & DIGEST_SHA1) || SHA1_Init(&c.sha1) == 1) &&
+           (!(algorithms_ & DIGEST_SHA256) || SHA256_Init(&c.sha256) == 1);
+}
+
+DigestAccumulator::~DigestAccumulator() = default;
+DigestAccumulator::DigestAccumulator(DigestAccumulator&&) noexcept = default;
+DigestAccumulator& DigestAccumulator::operator=(DigestAccumulator&&) noexcept = default;
+
+// Каждый кусок, пока он в кэше, проходит через все включенные контексты
+bool DigestAccumulator::update(const unsigned char* data, size_t size) noexcept {
+    Contexts& c = *contexts_;
+    c.ok = c.ok && (!(algorithms_ & DIGEST_MD5) || MD5_Update(&c.md5, data, size) == 1) &&
+           (!(algorithms_ & DIGEST_SHA1) || SHA1_Update(&c.sha1, data, size) == 1) &&
+           (!(algorithms_ & DIGEST_SHA256) || SHA256_Update(&c.sha256, data, size) == 1);
+    return c.ok;
+}
+
+std::optional<FileDigests> DigestAccumulator::finish() noexcept {
+    Contexts& c = *contexts_;
+    FileDigests digests;
+    digests.algorithms = algorithms_;
+    if (!c.ok || (algorithms_ & DIGEST_MD5 && MD5_Final(digests.md5.data(), &c.md5) != 1) ||
+        (algorithms_ & DIGEST_SHA1 && SHA1_Final(digests.sha1.data(), &c.sha1) != 1) ||
+        (algorithms_ & DIGEST_SHA256 && SHA256_Final(digests.sha256.data(), &c.sha256) != 1)) {
+        return std::nullopt;
+    }
+    return digests;
+}
+
+MD5Compute::MD5Compute(const ReadOptions& options) {
+    set_options(options);
+}
+
+void MD5Compute::set_options(const ReadOptions& options) {
+    options_ = options;
+    if (options_.buffer_size < MIN_BUFFER_SIZE) {
+        options_.buffer_size = MIN_BUFFER_SIZE;
+    }
+    options_.buffer_size = (options_.buffer_size + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+}
+
+int MD5Compute::openFileForReading(const std::filesystem::path& file_path, size_t& file_size) {
+    // O_NONBLOCK не дает зависнуть на FIFO; на обычные файлы не влияет
+    const int flags = O_RDONLY | O_CLOEXEC | O_NONBLOCK;
+    int fd = ::open(file_path.c_str(), flags | O_NOATIME);
+    if (fd < 0 && errno == EPERM) {
+        // O_NOATIME разрешен только владельцу файла
+        fd = ::open(file_path.c_str(), flags);
+    }
+    if (fd < 0) {
+        return -1;
     }
 
-    return true;
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return -1;
+    }
+    file_size = static_cast<size_t>(st.st_size);
+    return fd;
+}
+
+bool MD5Compute::use_mmap(size_t file_size) const noexcept {
+    switch (options_.strategy) {
+        case ReadStrategy::Mmap: return file_size > 0;
+        case ReadStrategy::Auto: return file_size > 0 && file_size >= options_.mmap_threshold;
+        case ReadStrategy::Pread:
+        case ReadStrategy::IoUring: break;
+    }
+    return false;
+}
+
+template<typename Update>
+bool MD5Compute::read_file(int fd, size_t file_size, Update&& update) const {
+    return use_mmap(file_size) ? hash_with_mmap(fd, file_size, options_.buffer_size, update)
+                               : hash_with_pread(fd, options_.buffer_size, update);
 }
 
-std::string MD5Compute::digest_to_hex_string(const unsigned char digest[MD5_DIGEST_LENGTH]) noexcept {
-    std::ostringstream hex_stream;
-    hex_stream << std::hex << std::setfill('0');
-    for (int i = 0; i < MD5_DIGEST_LENGTH; ++i) {
-        hex_stream << std::setw(2) << static_cast<unsigned int>(digest[i]);
+template<typename Update>
+bool MD5Compute::read_file(int fd, size_t file_size, Update&& update, ReadTimings* timings) const {
+    if (timings == nullptr) {
+        return read_file(fd, file_size, update);
     }
-    return hex_stream.str();
+    // Хеширование замеряется на каждом куске, чтение - остаток общего времени
+    const auto started = std::chrono::steady_clock::now();
+    std::chrono::nanoseconds hashing{0};
+    auto timed_update = [&](const unsigned char* data, size_t size) {
+        const auto chunk_started = std::chrono::steady_clock::now();
+        const bool ok = update(data, size);
+        hashing += std::chrono::steady_clock::now() - chunk_started;
+        timings->bytes += size;
+        return ok;
+    };
+    const bool ok = read_file(fd, file_size, timed_update);
+    timings->hash += hashing;
+    timings->read += std::chrono::steady_clock::now() - started - hashing;
+    return ok;
 }
 
 std::optional<std::string> MD5Compute::computeFileHashMD5(const std::filesystem::path& file_path) const {
-    try {
-        auto file_opt = open_file_for_reading(file_path);
-        if (!file_opt.has_value()) {
-            return std::nullopt;
-        }
+    auto digest_opt = computeFileDigestMD5(file_path);
+    if (!digest_opt.has_value()) {
+        return std::nullopt;
+    }
+    return digest_to_hex(*digest_opt);
+}
+
+std::optional<MD5Digest> MD5Compute::computeFileDigestMD5(const std::filesystem::path& file_path,
+                                                          ReadTimings* timings) const {
+    size_t file_size = 0;
+    const auto open_started = timings ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    FdGuard file{openFileForReading(file_path, file_size)};
+    if (timings) {
+        timings->open += std::chrono::steady_clock::now() - open_started;
+        timings->opened = file.fd >= 0;
+    }
+    if (file.fd < 0) {
+        return std::nullopt;
+    }
 
-        unsigned char digest[MD5_DIGEST_LENGTH];
-        if (!compute_md5_digest(file_opt.value(), digest)) {
+    MD5_CTX ctx;
+    if (MD5_Init(&ctx) != 1) {
+        return std::nullopt;
+    }
+    auto update = [&ctx](const unsigned char* data, size_t size) {
+        return MD5_Update(&ctx, data, size) == 1;
+    };
+    if (!read_file(file.fd, file_size, update, timings)) {
+        return std::nullopt;
+    }
+
+    MD5Digest digest;
+    if (MD5_Final(digest.data(), &ctx) != 1) {
+        return std::nullopt;
+    }
+    return digest;
+}
+
+std::optional<FileDigests> MD5Compute::computeFileDigests(const std::filesystem::path& file_path,
+                                                          unsigned algorithms,
+                                                          ReadTimings* timings) const {
+    algorithms &= DIGEST_ALL;
+    if (algorithms == DIGEST_MD5) {
+        auto md5 = computeFileDigestMD5(file_path, timings);
+        if (!md5.has_value()) {
             return std::nullopt;
         }
-        return digest_to_hex_string(digest);
+        return FileDigests{DIGEST_MD5, *md5, {}, {}};
+    }
+
+    size_t file_size = 0;
+    const auto open_started = timings ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    FdGuard file{openFileForReading(file_path, file_size)};
+    if (timings) {
+        timings->open += std::chrono::steady_clock::now() - open_started;
+        timings->opened = file.fd >= 0;
+    }
+    if (file.fd < 0) {
+        return std::nullopt;
+    }
 
-    } catch (const std::exception&) {
+    DigestAccumulator accumulator(algorithms);
+    auto update = [&accumulator](const unsigned char* data, size_t size) {
+        return accumulator.update(data, size);
+    };
+    if (!read_file(file.fd, file_size, update, timings)) {
         return std::nullopt;
     }
+    return accumulator.finish();
+}
+
+std::vector<std::optional<MD5Digest>> MD5Compute::computeBatchDigestMD5(
+    std::span<const std::filesystem::path> paths) const {
+    return computeBatchDigestMD5(paths, MD5MultiBuffer::detect_kernel());
+}
+
+std::vector<std::optional<MD5Digest>> MD5Compute::computeBatchDigestMD5(
+    std::span<const std::filesystem::path> paths, MD5Kernel kernel) const {
+    std::vector<std::optional<MD5Digest>> results;
+    if (!MD5MultiBuffer::kernel_supported(kernel)) {
+        kernel = MD5Kernel::Scalar;
+    }
+    // На полосу свой буфер, поэтому он меньше обычного
+    const size_t lane_buffer = std::min(options_.buffer_size, MAX_LANE_BUFFER_SIZE);
+    MD5MultiBuffer::run(kernel, paths.size(), [&](size_t index) {
+        size_t file_size = 0;
+        const int fd = openFileForReading(paths[index], file_size);
+        if (fd >= 0) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        return fd;
+    }, lane_buffer, results);
+    return results;
 }
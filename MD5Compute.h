@@ -8,20 +8,101 @@
 #  endif
 #endif
 
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
-#include <fstream>
+#include <vector>
+#include "Digest.h"
+#include "MD5MultiBuffer.h"
+
+enum class ReadStrategy {
+    Pread,
+    Mmap,
+    Auto,
+    // Асинхронное чтение через io_uring (AsyncDigestEngine); для
+    // синхронных вызовов MD5Compute равносильно Pread
+    IoUring
+};
+
+// Mmap и Auto (mmap для файлов от mmap_threshold) быстрее на больших файлах,
+// но если файл усекают во время чтения, процесс получит SIGBUS - поэтому
+// по умолчанию используется pread.
+struct ReadOptions {
+    ReadStrategy strategy = ReadStrategy::Pread;
+    size_t buffer_size = 1 << 20;
+    size_t mmap_threshold = 64 << 20;
+    // Для IoUring: чтений в полете на кольцо и число колец (потоков отправки)
+    unsigned io_queue_depth = 64;
+    unsigned io_submitters = 1;
+};
+
+// Куда ушло время на файл: read - чтение без хеширования (для mmap - ожидание
+// страниц). Заполняется только по запросу, иначе часы не опрашиваются.
+struct ReadTimings {
+    bool opened = false;
+    std::chrono::nanoseconds open{0};
+    std::chrono::nanoseconds read{0};
+    std::chrono::nanoseconds hash{0};
+    uint64_t bytes = 0;
+};
+
+// Инкрементальный подсчет всех дайджестов из маски за один проход по данным
+class DLL_EXPORT DigestAccumulator {
+private:
+    struct Contexts;
+    std::unique_ptr<Contexts> contexts_;
+    unsigned algorithms_ = 0;
+public:
+    explicit DigestAccumulator(unsigned algorithms);
+    ~DigestAccumulator();
+    DigestAccumulator(DigestAccumulator&&) noexcept;
+    DigestAccumulator& operator=(DigestAccumulator&&) noexcept;
+
+    unsigned algorithms() const noexcept { return algorithms_; }
+    bool update(const unsigned char* data, size_t size) noexcept;
+    std::optional<FileDigests> finish() noexcept;
+};
 
 class DLL_EXPORT MD5Compute {
 private:
-    static constexpr size_t BUFFER_SIZE = 8192;
-    static constexpr int MD5_DIGEST_LENGTH = 16;
+    static constexpr size_t MIN_BUFFER_SIZE = 4096;
+    static constexpr size_t MAX_LANE_BUFFER_SIZE = 256 << 10;
 private:
-    std::optional<std::ifstream> open_file_for_reading(const std::filesystem::path& file_path) const;
-    bool compute_md5_digest(std::ifstream& file, unsigned char digest[MD5_DIGEST_LENGTH]) const;
-    static std::string digest_to_hex_string(const unsigned char digest[MD5_DIGEST_LENGTH]) noexcept;
+    ReadOptions options_;
+private:
+    bool use_mmap(size_t file_size) const noexcept;
+    template<typename Update>
+    bool read_file(int fd, size_t file_size, Update&& update) const;
+    template<typename Update>
+    bool read_file(int fd, size_t file_size, Update&& update, ReadTimings* timings) const;
 public:
+    MD5Compute() = default;
+    explicit MD5Compute(const ReadOptions& options);
+
+    // Открывает обычный файл для чтения (O_NOATIME, если разрешено); -1 - ошибка
+    static int openFileForReading(const std::filesystem::path& file_path, size_t& file_size);
+
+    const ReadOptions& options() const noexcept { return options_; }
+    void set_options(const ReadOptions& options);
+
     std::optional<std::string> computeFileHashMD5(const std::filesystem::path& file_path) const;
+    std::optional<MD5Digest> computeFileDigestMD5(const std::filesystem::path& file_path,
+                                                  ReadTimings* timings = nullptr) const;
+
+    // Все алгоритмы из маски algorithms (DIGEST_*) за одно чтение файла
+    std::optional<FileDigests> computeFileDigests(const std::filesystem::path& file_path,
+                                                  unsigned algorithms,
+                                                  ReadTimings* timings = nullptr) const;
+
+    // Пакетное хеширование: файлы раскладываются по SIMD-полосам. Результат
+    // в порядке путей, nullopt - файл не открылся или не прочитался.
+    // Сканер отдает сюда мелкие файлы директории при batch_small_files.
+    std::vector<std::optional<MD5Digest>> computeBatchDigestMD5(std::span<const std::filesystem::path> paths) const;
+    std::vector<std::optional<MD5Digest>> computeBatchDigestMD5(std::span<const std::filesystem::path> paths,
+                                                                MD5Kernel kernel) const;
 };
 
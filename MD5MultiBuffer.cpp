@@ -0,0 +1,403 @@
+#include "MD5MultiBuffer.h"
+#include <openssl/md5.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t MD5_K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+constexpr int MD5_S[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+constexpr uint32_t MD5_INIT[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+constexpr size_t BLOCK_SIZE = 64;
+
+inline uint32_t load_le32(const unsigned char* p) noexcept {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Одна компрессия MD5 сразу для LANES блоков. Векторы живут только внутри
+// функции (наружу - массивы uint32), поэтому ее можно встраивать в обертки
+// с разными target-атрибутами без смены ABI.
+template<size_t LANES>
+__attribute__((always_inline)) inline void compress_lanes(uint32_t (*state)[LANES],
+                                                           const unsigned char* const* blocks) {
+    typedef uint32_t vec __attribute__((vector_size(LANES * sizeof(uint32_t))));
+
+    vec w[16];
+    for (size_t i = 0; i < 16; ++i) {
+        uint32_t column[LANES];
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            column[lane] = load_le32(blocks[lane] + 4 * i);
+        }
+        std::memcpy(&w[i], column, sizeof(column));
+    }
+
+    vec a, b, c, d;
+    std::memcpy(&a, state[0], sizeof(a));
+    std::memcpy(&b, state[1], sizeof(b));
+    std::memcpy(&c, state[2], sizeof(c));
+    std::memcpy(&d, state[3], sizeof(d));
+    const vec a0 = a, b0 = b, c0 = c, d0 = d;
+
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; ++i) {
+        vec f;
+        int g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) & 15;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) & 15;
+        }
+        const vec x = a + f + MD5_K[i] + w[g];
+        a = d;
+        d = c;
+        c = b;
+        b = b + ((x << MD5_S[i]) | (x >> (32 - MD5_S[i])));
+    }
+
+    a += a0;
+    b += b0;
+    c += c0;
+    d += d0;
+    std::memcpy(state[0], &a, sizeof(a));
+    std::memcpy(state[1], &b, sizeof(b));
+    std::memcpy(state[2], &c, sizeof(c));
+    std::memcpy(state[3], &d, sizeof(d));
+}
+
+template<size_t LANES>
+struct Compress;
+
+template<>
+struct Compress<4> {
+    static void run(uint32_t (*state)[4], const unsigned char* const* blocks) {
+        compress_lanes<4>(state, blocks);
+    }
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+template<>
+struct Compress<8> {
+    __attribute__((target("avx2")))
+    static void run(uint32_t (*state)[8], const unsigned char* const* blocks) {
+        compress_lanes<8>(state, blocks);
+    }
+};
+
+template<>
+struct Compress<16> {
+    __attribute__((target("avx512f")))
+    static void run(uint32_t (*state)[16], const unsigned char* const* blocks) {
+        compress_lanes<16>(state, blocks);
+    }
+};
+#else
+template<>
+struct Compress<8> {
+    static void run(uint32_t (*state)[8], const unsigned char* const* blocks) {
+        compress_lanes<8>(state, blocks);
+    }
+};
+
+template<>
+struct Compress<16> {
+    static void run(uint32_t (*state)[16], const unsigned char* const* blocks) {
+        compress_lanes<16>(state, blocks);
+    }
+};
+#endif
+
+struct Lane {
+    static constexpr size_t IDLE = SIZE_MAX;
+
+    size_t job = IDLE;
+    int fd = -1;
+    uint64_t total = 0;
+    std::unique_ptr<unsigned char[]> buffer;
+    const unsigned char* data = nullptr;
+    size_t avail = 0;
+    bool eof = false;
+    bool failed = false;
+    unsigned char tail[2 * BLOCK_SIZE];
+    size_t tail_blocks = 0;
+    size_t tail_pos = 0;
+    bool last_block = false;
+
+    void reset(size_t next_job, int next_fd) noexcept {
+        job = next_job;
+        fd = next_fd;
+        total = 0;
+        data = buffer.get();
+        avail = 0;
+        eof = false;
+        failed = false;
+        tail_blocks = 0;
+        tail_pos = 0;
+        last_block = false;
+    }
+
+    void release() noexcept {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        job = IDLE;
+    }
+
+    void build_tail() noexcept {
+        // Остаток (< 64 байт), 0x80, нули и длина в битах (LE) в конце
+        const size_t rest = avail;
+        total += rest;
+        std::memset(tail, 0, sizeof(tail));
+        std::memcpy(tail, data, rest);
+        tail[rest] = 0x80;
+        tail_blocks = (rest + 1 + 8 <= BLOCK_SIZE) ? 1 : 2;
+        const uint64_t bits = total * 8;
+        unsigned char* length = tail + tail_blocks * BLOCK_SIZE - 8;
+        for (int i = 0; i < 8; ++i) {
+            length[i] = static_cast<unsigned char>(bits >> (8 * i));
+        }
+        avail = 0;
+    }
+
+    // Следующий 64-байтный блок; nullptr - ошибка чтения
+    const unsigned char* next_block(size_t buffer_size) noexcept {
+        while (!eof && avail < BLOCK_SIZE) {
+            if (data != buffer.get() && avail > 0) {
+                std::memmove(buffer.get(), data, avail);
+            }
+            data = buffer.get();
+            const ssize_t n = ::read(fd, buffer.get() + avail, buffer_size - avail);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                failed = true;
+                return nullptr;
+            }
+            if (n == 0) {
+                eof = true;
+            } else {
+                avail += static_cast<size_t>(n);
+            }
+        }
+        if (avail >= BLOCK_SIZE) {
+            const unsigned char* block = data;
+            data += BLOCK_SIZE;
+            avail -= BLOCK_SIZE;
+            total += BLOCK_SIZE;
+            return block;
+        }
+        if (tail_blocks == 0) {
+            build_tail();
+        }
+        const unsigned char* block = tail + tail_pos * BLOCK_SIZE;
+        ++tail_pos;
+        last_block = (tail_pos == tail_blocks);
+        return block;
+    }
+};
+
+} // namespace
+
+template<size_t LANES>
+void MD5MultiBuffer::run_lanes(size_t job_count, const OpenJob& open_job, size_t lane_buffer_size,
+                               std::vector<std::optional<MD5Digest>>& results) {
+    static const unsigned char idle_block[BLOCK_SIZE] = {};
+
+    Lane lanes[LANES];
+    uint32_t state[4][LANES];
+    const unsigned char* blocks[LANES];
+    size_t next_job = 0;
+    size_t active = 0;
+
+    auto assign = [&](size_t lane_index) {
+        Lane& lane = lanes[lane_index];
+        while (next_job < job_count) {
+            const size_t job = next_job++;
+            const int fd = open_job(job);
+            if (fd < 0) {
+                results[job] = std::nullopt;
+                continue;
+            }
+            if (!lane.buffer) {
+                lane.buffer = std::make_unique<unsigned char[]>(lane_buffer_size);
+            }
+            lane.reset(job, fd);
+            for (int word = 0; word < 4; ++word) {
+                state[word][lane_index] = MD5_INIT[word];
+            }
+            ++active;
+            return;
+        }
+    };
+
+    for (size_t i = 0; i < LANES; ++i) {
+        assign(i);
+    }
+
+    while (active > 0) {
+        for (size_t i = 0; i < LANES; ++i) {
+            blocks[i] = idle_block;
+            Lane& lane = lanes[i];
+            // Полосы, где чтение упало, сразу получают следующее задание
+            while (lane.job != Lane::IDLE) {
+                const unsigned char* block = lane.next_block(lane_buffer_size);
+                if (block != nullptr) {
+                    blocks[i] = block;
+                    break;
+                }
+                results[lane.job] = std::nullopt;
+                lane.release();
+                --active;
+                assign(i);
+            }
+        }
+        if (active == 0) {
+            break;
+        }
+
+        Compress<LANES>::run(state, blocks);
+
+        for (size_t i = 0; i < LANES; ++i) {
+            Lane& lane = lanes[i];
+            if (lane.job == Lane::IDLE || !lane.last_block) {
+                continue;
+            }
+            MD5Digest digest;
+            for (int word = 0; word < 4; ++word) {
+                for (int byte = 0; byte < 4; ++byte) {
+                    digest[4 * word + byte] = static_cast<unsigned char>(state[word][i] >> (8 * byte));
+                }
+            }
+            results[lane.job] = digest;
+            lane.release();
+            --active;
+            assign(i);
+        }
+    }
+}
+
+MD5Kernel MD5MultiBuffer::detect_kernel() noexcept {
+    if (kernel_supported(MD5Kernel::Lanes16)) {
+        return MD5Kernel::Lanes16;
+    }
+    if (kernel_supported(MD5Kernel::Lanes8)) {
+        return MD5Kernel::Lanes8;
+    }
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    return MD5Kernel::Lanes4;
+#else
+    // Без SSE2/NEON векторные расширения GCC эмулируются по одной полосе
+    return MD5Kernel::Scalar;
+#endif
+}
+
+bool MD5MultiBuffer::kernel_supported(MD5Kernel kernel) noexcept {
+    switch (kernel) {
+        case MD5Kernel::Scalar:
+        case MD5Kernel::Lanes4:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case MD5Kernel::Lanes8:
+            return __builtin_cpu_supports("avx2");
+        case MD5Kernel::Lanes16:
+            return __builtin_cpu_supports("avx512f");
+#else
+        case MD5Kernel::Lanes8:
+        case MD5Kernel::Lanes16:
+            return false;
+#endif
+    }
+    return false;
+}
+
+size_t MD5MultiBuffer::lane_count(MD5Kernel kernel) noexcept {
+    switch (kernel) {
+        case MD5Kernel::Scalar: return 1;
+        case MD5Kernel::Lanes4: return 4;
+        case MD5Kernel::Lanes8: return 8;
+        case MD5Kernel::Lanes16: return 16;
+    }
+    return 1;
+}
+
+bool MD5MultiBuffer::run(MD5Kernel kernel, size_t job_count, const OpenJob& open_job, size_t lane_buffer_size,
+                         std::vector<std::optional<MD5Digest>>& results) {
+    if (!kernel_supported(kernel)) {
+        return false;
+    }
+    results.assign(job_count, std::nullopt);
+    lane_buffer_size = std::max(lane_buffer_size, MIN_LANE_BUFFER);
+
+    switch (kernel) {
+        case MD5Kernel::Scalar: {
+            // Эталонный путь через OpenSSL, по одному файлу
+            auto buffer = std::make_unique<unsigned char[]>(lane_buffer_size);
+            for (size_t job = 0; job < job_count; ++job) {
+                const int fd = open_job(job);
+                if (fd < 0) {
+                    continue;
+                }
+                MD5_CTX ctx;
+                bool ok = MD5_Init(&ctx) == 1;
+                while (ok) {
+                    const ssize_t n = ::read(fd, buffer.get(), lane_buffer_size);
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (n <= 0) {
+                        ok = (n == 0);
+                        break;
+                    }
+                    ok = MD5_Update(&ctx, buffer.get(), static_cast<size_t>(n)) == 1;
+                }
+                ::close(fd);
+                MD5Digest digest;
+                if (ok && MD5_Final(digest.data(), &ctx) == 1) {
+                    results[job] = digest;
+                }
+            }
+            break;
+        }
+        case MD5Kernel::Lanes4:
+            run_lanes<4>(job_count, open_job, lane_buffer_size, results);
+            break;
+        case MD5Kernel::Lanes8:
+            run_lanes<8>(job_count, open_job, lane_buffer_size, results);
+            break;
+        case MD5Kernel::Lanes16:
+            run_lanes<16>(job_count, open_job, lane_buffer_size, results);
+            break;
+    }
+    return true;
+}
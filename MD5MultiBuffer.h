@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "Digest.h"
+
+enum class MD5Kernel {
+    Scalar,
+    Lanes4,
+    Lanes8,
+    Lanes16
+};
+
+// Многобуферный MD5: один поток MD5 не векторизуется, поэтому независимые
+// файлы хешируются в SIMD-полосах (4 - SSE2/NEON, 8 - AVX2, 16 - AVX-512).
+// Когда файл в полосе заканчивается, в нее сразу загружается следующий.
+class DLL_EXPORT MD5MultiBuffer {
+public:
+    // Открывает задание с номером index и возвращает дескриптор или -1
+    using OpenJob = std::function<int(size_t index)>;
+
+private:
+    static constexpr size_t MIN_LANE_BUFFER = 4096;
+private:
+    template<size_t LANES>
+    static void run_lanes(size_t job_count, const OpenJob& open_job, size_t lane_buffer_size,
+                          std::vector<std::optional<MD5Digest>>& results);
+public:
+    // Лучшее ядро процессора; Scalar - векторных полос нет
+    static MD5Kernel detect_kernel() noexcept;
+    static bool kernel_supported(MD5Kernel kernel) noexcept;
+    static size_t lane_count(MD5Kernel kernel) noexcept;
+
+    // Возвращает false, если ядро не поддерживается процессором
+    static bool run(MD5Kernel kernel, size_t job_count, const OpenJob& open_job, size_t lane_buffer_size,
+                    std::vector<std::optional<MD5Digest>>& results);
+};
@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Не удается открыть файл: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Не удается получить размер файла: " + path + " (" + std::strerror(err) + ")");
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd);
+            size_ = 0;
+            throw std::runtime_error("Не удается отобразить файл в память: " + path + " (" + std::strerror(err) + ")");
+        }
+        data_ = addr;
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() noexcept {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void MappedFile::release() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+void MappedFile::advise_random() const noexcept {
+    if (data_ != nullptr) {
+        ::madvise(data_, size_, MADV_RANDOM);
+    }
+}
+
+void MappedFile::advise_sequential() const noexcept {
+    if (data_ != nullptr) {
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+}
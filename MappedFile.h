@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <string>
+
+// Read-only отображение файла в память (MAP_SHARED): несколько процессов
+// разделяют одну копию страниц из page cache.
+class DLL_EXPORT MappedFile {
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+private:
+    void release() noexcept;
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile() noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const unsigned char* data() const noexcept { return static_cast<const unsigned char*>(data_); }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    void advise_random() const noexcept;
+    void advise_sequential() const noexcept;
+};
@@ -0,0 +1,247 @@
+#include "MetricsExporter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Квантили, которые выводятся для каждой стадии
+constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+double to_seconds(std::chrono::nanoseconds value) {
+    return std::chrono::duration<double>(value).count();
+}
+
+double to_microseconds(std::chrono::nanoseconds value) {
+    return std::chrono::duration<double, std::micro>(value).count();
+}
+
+const char* const PIPELINE_STAGES[] = {"read", "hash", "report"};
+
+} // namespace
+
+MetricsExporter::MetricsExporter(const std::string& path, MetricsFormat format,
+                                 std::chrono::milliseconds interval, Source source)
+    : path_(path), format_(format), interval_(interval), source_(std::move(source)) {
+    if (interval_.count() <= 0) {
+        interval_ = DEFAULT_INTERVAL;
+    }
+    export_snapshot();
+    thread_ = std::thread([this] { loop(); });
+}
+
+MetricsExporter::~MetricsExporter() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MetricsExporter::loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        const bool stopping = cv_.wait_for(lock, interval_, [this] { return stopping_; });
+        lock.unlock();
+        try {
+            export_snapshot();
+        } catch (...) {
+            // Временная ошибка записи не должна останавливать экспорт
+        }
+        if (stopping) {
+            return;
+        }
+        lock.lock();
+    }
+}
+
+void MetricsExporter::export_snapshot() {
+    MetricsSnapshot snapshot = source_();
+    const MetricsSnapshot current = snapshot;
+    const double seconds = to_seconds(snapshot.uptime - previous_.uptime);
+    if (seconds > 0) {
+        snapshot.files_per_second = static_cast<double>(snapshot.files_checked - previous_.files_checked) / seconds;
+        snapshot.bytes_per_second = static_cast<double>(snapshot.bytes_read - previous_.bytes_read) / seconds;
+    }
+    WriteFile(path_, format_ == MetricsFormat::Json ? FormatJson(snapshot) : FormatPrometheus(snapshot));
+    previous_ = current;
+}
+
+void MetricsExporter::WriteFile(const std::string& path, const std::string& content) {
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Не удается записать файл метрик: " + path);
+        }
+        file << content;
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Ошибка записи файла метрик: " + path);
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("Не удается записать файл метрик: " + path);
+    }
+}
+
+std::string MetricsExporter::FormatPrometheus(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    out << std::setprecision(9);
+    auto metric = [&out](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << ' ' << help << '\n';
+        out << "# TYPE " << name << ' ' << type << '\n';
+    };
+
+    metric("scanner_uptime_seconds", "gauge", "Time since the scanner was created");
+    out << "scanner_uptime_seconds " << to_seconds(snapshot.uptime) << '\n';
+    metric("scanner_files_checked_total", "counter", "Files checked against the hash base");
+    out << "scanner_files_checked_total " << snapshot.files_checked << '\n';
+    metric("scanner_bytes_read_total", "counter", "Bytes read and hashed");
+    out << "scanner_bytes_read_total " << snapshot.bytes_read << '\n';
+    metric("scanner_files_per_second", "gauge", "Files checked per second");
+    out << "scanner_files_per_second " << snapshot.files_per_second << '\n';
+    metric("scanner_bytes_per_second", "gauge", "Bytes read per second");
+    out << "scanner_bytes_per_second " << snapshot.bytes_per_second << '\n';
+    metric("scanner_files_skipped_total", "counter", "Files not read or not read to the end, by reason");
+    for (size_t reason = 0; reason < SKIP_REASON_COUNT; ++reason) {
+        out << "scanner_files_skipped_total{reason=\"" << skip_reason_name(static_cast<SkipReason>(reason))
+            << "\"} " << snapshot.skipped[reason] << '\n';
+    }
+    metric("scanner_failed_completions_total", "counter", "File completions that threw; the file result may be lost");
+    out << "scanner_failed_completions_total " << snapshot.failed_completions << '\n';
+    metric("scanner_queued_files", "gauge", "Files waiting in the scanner thread pool");
+    out << "scanner_queued_files " << snapshot.queued_files << '\n';
+    metric("scanner_busy_workers", "gauge", "Pool threads processing a file");
+    out << "scanner_busy_workers " << snapshot.busy_workers << '\n';
+    metric("scanner_worker_threads", "gauge", "Pool threads");
+    out << "scanner_worker_threads " << snapshot.worker_threads << '\n';
+    metric("scanner_pipeline_queue_depth", "gauge", "Items waiting in pipeline stage queues");
+    for (size_t stage = 0; stage < snapshot.pipeline_queue_depth.size(); ++stage) {
+        out << "scanner_pipeline_queue_depth{stage=\"" << PIPELINE_STAGES[stage] << "\"} "
+            << snapshot.pipeline_queue_depth[stage] << '\n';
+    }
+    metric("scanner_io_in_flight", "gauge", "Files in flight in the io_uring engine");
+    out << "scanner_io_in_flight " << snapshot.io_in_flight << '\n';
+    metric("scanner_cpu_seconds_total", "counter", "User and system CPU time of the process");
+    out << "scanner_cpu_seconds_total " << snapshot.cpu_seconds << '\n';
+    metric("scanner_context_switches_total", "counter", "Context switches of the process");
+    out << "scanner_context_switches_total{kind=\"voluntary\"} " << snapshot.voluntary_switches << '\n';
+    out << "scanner_context_switches_total{kind=\"involuntary\"} " << snapshot.involuntary_switches << '\n';
+
+    metric("scanner_pool_swallowed_exceptions_total", "counter", "Task exceptions caught by the thread pool");
+    out << "scanner_pool_swallowed_exceptions_total " << snapshot.pool.swallowed_exceptions << '\n';
+    if (snapshot.pool.enabled) {
+        const QueueStats& queue = snapshot.pool.injection;
+        metric("scanner_pool_queue_operations_total", "counter", "Batches pushed to and popped from the pool queue");
+        out << "scanner_pool_queue_operations_total{op=\"push\"} " << queue.pushes << '\n';
+        out << "scanner_pool_queue_operations_total{op=\"pop\"} " << queue.pops << '\n';
+        metric("scanner_pool_queue_wait_seconds_total", "counter", "Time blocked on a full or empty pool queue");
+        out << "scanner_pool_queue_wait_seconds_total{op=\"push\"} " << to_seconds(queue.push_wait) << '\n';
+        out << "scanner_pool_queue_wait_seconds_total{op=\"pop\"} " << to_seconds(queue.pop_wait) << '\n';
+        metric("scanner_pool_queue_cas_retries_total", "counter", "Lost compare-and-swap races on the pool queue");
+        out << "scanner_pool_queue_cas_retries_total " << queue.cas_retries << '\n';
+        metric("scanner_pool_queue_high_water", "gauge", "Largest pool queue depth seen");
+        out << "scanner_pool_queue_high_water " << queue.high_water << '\n';
+        metric("scanner_pool_worker_seconds_total", "counter", "Pool thread time running tasks or looking for them");
+        for (size_t i = 0; i < snapshot.pool.workers.size(); ++i) {
+            const WorkerStats& worker = snapshot.pool.workers[i];
+            out << "scanner_pool_worker_seconds_total{worker=\"" << i << "\",state=\"busy\"} "
+                << to_seconds(worker.busy) << '\n';
+            out << "scanner_pool_worker_seconds_total{worker=\"" << i << "\",state=\"idle\"} "
+                << to_seconds(worker.idle) << '\n';
+        }
+        metric("scanner_pool_worker_events_total", "counter", "Tasks run, batches stolen and sleeps per pool thread");
+        for (size_t i = 0; i < snapshot.pool.workers.size(); ++i) {
+            const WorkerStats& worker = snapshot.pool.workers[i];
+            out << "scanner_pool_worker_events_total{worker=\"" << i << "\",event=\"task\"} " << worker.tasks << '\n';
+            out << "scanner_pool_worker_events_total{worker=\"" << i << "\",event=\"steal\"} " << worker.steals << '\n';
+            out << "scanner_pool_worker_events_total{worker=\"" << i << "\",event=\"park\"} " << worker.parks << '\n';
+        }
+    }
+
+    metric("scanner_stage_latency_seconds", "summary", "Per-file time spent in a processing stage");
+    for (size_t stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+        const char* name = scan_stage_name(static_cast<ScanStage>(stage));
+        const LatencyHistogram& histogram = snapshot.stages[stage];
+        for (double q : QUANTILES) {
+            out << "scanner_stage_latency_seconds{stage=\"" << name << "\",quantile=\"" << q << "\"} "
+                << to_seconds(histogram.Percentile(q)) << '\n';
+        }
+        out << "scanner_stage_latency_seconds_sum{stage=\"" << name << "\"} "
+            << to_seconds(histogram.sum()) << '\n';
+        out << "scanner_stage_latency_seconds_count{stage=\"" << name << "\"} " << histogram.count() << '\n';
+    }
+    metric("scanner_stage_latency_max_seconds", "gauge", "Longest per-file time in a processing stage");
+    for (size_t stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+        out << "scanner_stage_latency_max_seconds{stage=\"" << scan_stage_name(static_cast<ScanStage>(stage))
+            << "\"} " << to_seconds(snapshot.stages[stage].max()) << '\n';
+    }
+    return out.str();
+}
+
+std::string MetricsExporter::FormatJson(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"uptime_s\":" << to_seconds(snapshot.uptime)
+        << ",\"files_checked\":" << snapshot.files_checked
+        << ",\"bytes_read\":" << snapshot.bytes_read
+        << ",\"files_per_second\":" << snapshot.files_per_second
+        << ",\"mb_per_second\":" << snapshot.bytes_per_second / (1024.0 * 1024.0);
+    out << ",\"skipped\":{";
+    for (size_t reason = 0; reason < SKIP_REASON_COUNT; ++reason) {
+        out << (reason == 0 ? "" : ",") << '"' << skip_reason_name(static_cast<SkipReason>(reason)) << "\":"
+            << snapshot.skipped[reason];
+    }
+    out << "},\"failed_completions\":" << snapshot.failed_completions
+        << ",\"queued_files\":" << snapshot.queued_files
+        << ",\"busy_workers\":" << snapshot.busy_workers
+        << ",\"worker_threads\":" << snapshot.worker_threads;
+    out << ",\"pipeline_queue_depth\":{";
+    for (size_t stage = 0; stage < snapshot.pipeline_queue_depth.size(); ++stage) {
+        out << (stage == 0 ? "" : ",") << '"' << PIPELINE_STAGES[stage] << "\":"
+            << snapshot.pipeline_queue_depth[stage];
+    }
+    out << "},\"io_in_flight\":" << snapshot.io_in_flight
+        << ",\"cpu_seconds\":" << snapshot.cpu_seconds
+        << ",\"voluntary_switches\":" << snapshot.voluntary_switches
+        << ",\"involuntary_switches\":" << snapshot.involuntary_switches;
+    out << ",\"pool\":{\"swallowed_exceptions\":" << snapshot.pool.swallowed_exceptions;
+    if (snapshot.pool.enabled) {
+        const QueueStats& queue = snapshot.pool.injection;
+        out << ",\"queue\":{\"pushes\":" << queue.pushes << ",\"pops\":" << queue.pops
+            << ",\"push_wait_ms\":" << to_microseconds(queue.push_wait) / 1000.0
+            << ",\"pop_wait_ms\":" << to_microseconds(queue.pop_wait) / 1000.0
+            << ",\"cas_retries\":" << queue.cas_retries << ",\"high_water\":" << queue.high_water << '}';
+        out << ",\"workers\":[";
+        for (size_t i = 0; i < snapshot.pool.workers.size(); ++i) {
+            const WorkerStats& worker = snapshot.pool.workers[i];
+            out << (i == 0 ? "" : ",") << "{\"busy_ms\":" << to_microseconds(worker.busy) / 1000.0
+                << ",\"idle_ms\":" << to_microseconds(worker.idle) / 1000.0
+                << ",\"tasks\":" << worker.tasks << ",\"steals\":" << worker.steals
+                << ",\"parks\":" << worker.parks << '}';
+        }
+        out << ']';
+    }
+    out << '}';
+    out << ",\"stages\":{";
+    for (size_t stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& histogram = snapshot.stages[stage];
+        out << (stage == 0 ? "" : ",") << '"' << scan_stage_name(static_cast<ScanStage>(stage)) << "\":{"
+            << "\"count\":" << histogram.count()
+            << ",\"mean_us\":" << to_microseconds(histogram.mean())
+            << ",\"p50_us\":" << to_microseconds(histogram.Percentile(0.5))
+            << ",\"p90_us\":" << to_microseconds(histogram.Percentile(0.9))
+            << ",\"p99_us\":" << to_microseconds(histogram.Percentile(0.99))
+            << ",\"max_us\":" << to_microseconds(histogram.max()) << '}';
+    }
+    out << "}}\n";
+    return out.str();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "ScanMetrics.h"
+
+enum class MetricsFormat {
+    // Текстовый формат Prometheus, для textfile collector node_exporter
+    Prometheus,
+    Json
+};
+
+// Периодический сброс метрик в файл из своего потока. Файл заменяется
+// целиком через rename, поэтому читатель не увидит его наполовину
+// записанным. Скорости files/s и bytes/s в файле - за последний интервал.
+class DLL_EXPORT MetricsExporter {
+public:
+    using Source = std::function<MetricsSnapshot()>;
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{1000};
+
+private:
+    std::string path_;
+    MetricsFormat format_;
+    std::chrono::milliseconds interval_;
+    Source source_;
+    // Предыдущий снимок - для скорости за интервал; только поток экспорта
+    MetricsSnapshot previous_;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+private:
+    void loop();
+    void export_snapshot();
+public:
+    // Первый сброс - в конструкторе: недоступный путь сразу дает исключение
+    MetricsExporter(const std::string& path, MetricsFormat format,
+                    std::chrono::milliseconds interval, Source source);
+    // Последний сброс - при остановке
+    ~MetricsExporter() noexcept;
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    static std::string FormatPrometheus(const MetricsSnapshot& snapshot);
+    static std::string FormatJson(const MetricsSnapshot& snapshot);
+    static void WriteFile(const std::string& path, const std::string& content);
+};
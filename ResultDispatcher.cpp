@@ -0,0 +1,52 @@
+#include "ResultDispatcher.h"
+
+ResultDispatcher::ResultDispatcher(ResultSink& sink, size_t capacity)
+    : sink_(sink), queue_(capacity) {
+    thread_ = std::thread([this] { deliver_loop(); });
+}
+
+ResultDispatcher::~ResultDispatcher() noexcept {
+    queue_.Lock();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ResultDispatcher::Push(ScanRecord record) {
+    queue_.Push(std::move(record));
+}
+
+void ResultDispatcher::deliver_loop() {
+    std::vector<ScanRecord> batch;
+    batch.reserve(MAX_BATCH);
+    while (auto record = queue_.Get()) {
+        batch.clear();
+        batch.push_back(std::move(*record));
+        while (batch.size() < MAX_BATCH) {
+            auto next = queue_.TryGet();
+            if (!next.has_value()) {
+                break;
+            }
+            batch.push_back(std::move(*next));
+        }
+        if (error_) {
+            continue;
+        }
+        try {
+            sink_.OnResults(batch);
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+}
+
+void ResultDispatcher::Finish() {
+    queue_.Lock();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    sink_.OnScanFinished();
+}
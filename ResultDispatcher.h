@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "RingBlockQueue.h"
+#include "ResultSink.h"
+
+// Доставка результатов приемнику из отдельного потока: рабочие потоки
+// кладут записи в ограниченную очередь, поток доставки забирает их пачками.
+// Если приемник не успевает, очередь заполняется и Push ждет - так
+// медленный потребитель притормаживает сканирование, а не копит память.
+class DLL_EXPORT ResultDispatcher {
+private:
+    ResultSink& sink_;
+    RingBlockQueue<ScanRecord> queue_;
+    std::thread thread_;
+    // Первое исключение приемника; остальные записи после него отбрасываются
+    std::exception_ptr error_;
+private:
+    void deliver_loop();
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+    static constexpr size_t MAX_BATCH = 256;
+
+    explicit ResultDispatcher(ResultSink& sink, size_t capacity = DEFAULT_CAPACITY);
+    ~ResultDispatcher() noexcept;
+
+    ResultDispatcher(const ResultDispatcher&) = delete;
+    ResultDispatcher& operator=(const ResultDispatcher&) = delete;
+
+    void Push(ScanRecord record);
+    // Доставляет остаток, вызывает OnScanFinished и пробрасывает ошибку приемника
+    void Finish();
+};
@@ -0,0 +1,184 @@
+#include "ResultSink.h"
+
+#include <cstring>
+#include <stdexcept>
+
+void append_json_string(std::string& out, std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (const char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += HEX[(c >> 4) & 0x0f];
+                    out += HEX[c & 0x0f];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+namespace {
+
+constexpr char RESULTS_MAGIC[8] = {'S', 'C', 'N', 'R', 'S', 'L', 'T', '\0'};
+
+template<size_t N>
+void append_raw(std::string& out, const Digest<N>& digest) {
+    out.append(reinterpret_cast<const char*>(digest.data()), N);
+}
+
+template<typename T>
+void append_pod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::ofstream open_results_file(const std::string& path, std::ios::openmode mode) {
+    std::ofstream file(path, mode);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удается открыть файл результатов: " + path);
+    }
+    return file;
+}
+
+} // namespace
+
+JsonlResultSink::JsonlResultSink(const std::string& path)
+    : file_(open_results_file(path, std::ios::out | std::ios::trunc)), out_(file_) {}
+
+JsonlResultSink::JsonlResultSink(std::ostream& out) : out_(out) {}
+
+void JsonlResultSink::append_record(std::string& out, const ScanRecord& record) {
+    out += "{\"path\":";
+    append_json_string(out, record.path.native());
+    out += ",\"size\":";
+    out += std::to_string(record.size);
+    out += ",\"malicious\":";
+    out += record.malicious ? "true" : "false";
+    if (record.malicious) {
+        out += ",\"verdict\":";
+        append_json_string(out, record.verdict);
+        out += ",\"algorithm\":\"";
+        out += digest_algorithm_name(record.algorithm);
+        out += '"';
+    }
+    if (record.digests.algorithms & DIGEST_MD5) {
+        out += ",\"md5\":\"" + digest_to_hex(record.digests.md5) + '"';
+    }
+    if (record.digests.algorithms & DIGEST_SHA1) {
+        out += ",\"sha1\":\"" + digest_to_hex(record.digests.sha1) + '"';
+    }
+    if (record.digests.algorithms & DIGEST_SHA256) {
+        out += ",\"sha256\":\"" + digest_to_hex(record.digests.sha256) + '"';
+    }
+    out += ",\"cached\":";
+    out += record.from_cache ? "true" : "false";
+    out += ",\"hash_us\":";
+    out += std::to_string(record.hash_time.count());
+    out += "}\n";
+}
+
+void JsonlResultSink::OnResults(std::span<const ScanRecord> records) {
+    // Пачка собирается в одну строку и уходит в поток одной записью
+    line_.clear();
+    for (const auto& record : records) {
+        append_record(line_, record);
+    }
+    out_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
+}
+
+void JsonlResultSink::OnScanFinished() {
+    out_.flush();
+}
+
+BinaryResultSink::BinaryResultSink(const std::string& path)
+    : file_(open_results_file(path, std::ios::out | std::ios::trunc | std::ios::binary)), out_(file_) {
+    write_header();
+}
+
+BinaryResultSink::BinaryResultSink(std::ostream& out) : out_(out) {
+    write_header();
+}
+
+void BinaryResultSink::write_header() {
+    FileHeader header {};
+    std::memcpy(header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+    header.version = VERSION;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void BinaryResultSink::OnResults(std::span<const ScanRecord> records) {
+    buffer_.clear();
+    for (const auto& record : records) {
+        const std::string& path = record.path.native();
+        RecordHeader header {};
+        header.size = record.size;
+        header.hash_time_us = static_cast<uint64_t>(record.hash_time.count());
+        header.path_size = static_cast<uint32_t>(path.size());
+        header.verdict_size = static_cast<uint32_t>(record.verdict.size());
+        header.flags = static_cast<uint8_t>((record.malicious ? FLAG_MALICIOUS : 0) |
+                                           (record.from_cache ? FLAG_FROM_CACHE : 0));
+        header.algorithm = static_cast<uint8_t>(record.algorithm);
+        header.algorithms = static_cast<uint8_t>(record.digests.algorithms & DIGEST_ALL);
+        append_pod(buffer_, header);
+        if (header.algorithms & DIGEST_MD5) append_raw(buffer_, record.digests.md5);
+        if (header.algorithms & DIGEST_SHA1) append_raw(buffer_, record.digests.sha1);
+        if (header.algorithms & DIGEST_SHA256) append_raw(buffer_, record.digests.sha256);
+        buffer_ += path;
+        buffer_ += record.verdict;
+    }
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+}
+
+void BinaryResultSink::OnScanFinished() {
+    out_.flush();
+}
+
+std::vector<ScanRecord> BinaryResultSink::ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удается открыть файл результатов: " + path);
+    }
+    FileHeader header {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC)) != 0 || header.version != VERSION) {
+        throw std::runtime_error("Неверный формат файла результатов: " + path);
+    }
+
+    auto read_exact = [&file, &path](void* data, size_t size) {
+        if (!file.read(static_cast<char*>(data), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("Файл результатов обрезан: " + path);
+        }
+    };
+    std::vector<ScanRecord> records;
+    RecordHeader record_header {};
+    while (file.read(reinterpret_cast<char*>(&record_header), sizeof(record_header))) {
+        ScanRecord record;
+        record.size = record_header.size;
+        record.hash_time = std::chrono::microseconds(record_header.hash_time_us);
+        record.malicious = (record_header.flags & FLAG_MALICIOUS) != 0;
+        record.from_cache = (record_header.flags & FLAG_FROM_CACHE) != 0;
+        record.algorithm = static_cast<DigestAlgorithm>(record_header.algorithm);
+        record.digests.algorithms = record_header.algorithms & DIGEST_ALL;
+        if (record.digests.algorithms & DIGEST_MD5) read_exact(record.digests.md5.data(), MD5_DIGEST_SIZE);
+        if (record.digests.algorithms & DIGEST_SHA1) read_exact(record.digests.sha1.data(), SHA1_DIGEST_SIZE);
+        if (record.digests.algorithms & DIGEST_SHA256) read_exact(record.digests.sha256.data(), SHA256_DIGEST_SIZE);
+        std::string record_path(record_header.path_size, '\0');
+        read_exact(record_path.data(), record_path.size());
+        record.path = std::move(record_path);
+        record.verdict.resize(record_header.verdict_size);
+        read_exact(record.verdict.data(), record.verdict.size());
+        records.push_back(std::move(record));
+    }
+    if (file.gcount() != 0) {
+        throw std::runtime_error("Файл результатов обрезан: " + path);
+    }
+    return records;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Digest.h"
+
+// Дописывает text в out строкой JSON в кавычках; байты не-ASCII - как есть
+void append_json_string(std::string& out, std::string_view text);
+
+// Результат проверки одного файла. Чистые файлы попадают в поток
+// результатов только при ScannerOptions::report_clean_files.
+struct ScanRecord {
+    std::filesystem::path path;
+    uint64_t size = 0;
+    bool malicious = false;
+    bool from_cache = false;
+    // Для находки - алгоритм совпавшего дайджеста и вердикт базы
+    DigestAlgorithm algorithm = DIGEST_MD5;
+    std::string verdict;
+    FileDigests digests;
+    // От начала обработки файла до готовых дайджестов
+    std::chrono::microseconds hash_time{0};
+};
+
+// Приемник результатов. Вызовы идут из одного потока доставки по очереди,
+// пачками до ResultDispatcher::MAX_BATCH записей; пока приемник занят,
+// очередь доставки заполняется и сканирование притормаживает.
+class DLL_EXPORT ResultSink {
+public:
+    virtual ~ResultSink() = default;
+    virtual void OnResults(std::span<const ScanRecord> records) = 0;
+    // Сканирование закончено, все результаты доставлены
+    virtual void OnScanFinished() {}
+};
+
+// Одна JSON-строка на файл:
+// {"path":"...","size":N,"malicious":true,"verdict":"...","algorithm":"MD5",
+//  "md5":"...","sha1":"...","sha256":"...","cached":false,"hash_us":N}
+// Отсутствующие алгоритмы пропускаются, путь пишется байтами как есть.
+class DLL_EXPORT JsonlResultSink : public ResultSink {
+private:
+    std::ofstream file_;
+    std::ostream& out_;
+    std::string line_;
+public:
+    explicit JsonlResultSink(const std::string& path);
+    explicit JsonlResultSink(std::ostream& out);
+
+    void OnResults(std::span<const ScanRecord> records) override;
+    void OnScanFinished() override;
+
+    static void append_record(std::string& out, const ScanRecord& record);
+};
+
+// Компактный двоичный поток: FileHeader, затем на запись RecordHeader,
+// дайджесты из маски algorithms (MD5, SHA1, SHA256 по порядку), байты пути
+// и вердикта. Порядок байт - как у хоста.
+class DLL_EXPORT BinaryResultSink : public ResultSink {
+public:
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+    struct RecordHeader {
+        uint64_t size;
+        uint64_t hash_time_us;
+        uint32_t path_size;
+        uint32_t verdict_size;
+        uint8_t flags;
+        uint8_t algorithm;
+        uint8_t algorithms;
+        uint8_t reserved[5];
+    };
+    static constexpr uint8_t FLAG_MALICIOUS = 1u << 0;
+    static constexpr uint8_t FLAG_FROM_CACHE = 1u << 1;
+    static constexpr uint32_t VERSION = 1;
+
+private:
+    std::ofstream file_;
+    std::ostream& out_;
+    std::string buffer_;
+private:
+    void write_header();
+public:
+    explicit BinaryResultSink(const std::string& path);
+    explicit BinaryResultSink(std::ostream& out);
+
+    void OnResults(std::span<const ScanRecord> records) override;
+    void OnScanFinished() override;
+
+    // Читает файл, записанный BinaryResultSink; runtime_error при порче
+    static std::vector<ScanRecord> ReadFile(const std::string& path);
+};
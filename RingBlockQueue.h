@@ -0,0 +1,288 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "Instrumentation.h"
+
+// Ограниченная MPMC-очередь на кольцевом буфере (схема Вьюкова): у каждой
+// ячейки свой счетчик последовательности, Push и Get обходятся одним CAS без
+// мьютекса. Интерфейс как у BlockQueue: полная очередь блокирует Push,
+// пустая - Get. Ожидание - короткий спин, затем atomic::wait (futex).
+// После Lock() Push отклоняет значения, а Get отдает остаток и nullopt.
+template<typename T>
+class DLL_EXPORT RingBlockQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr size_t SPIN_ROUNDS = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+private:
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    // Эпохи и счетчики ждущих: счетчик читается после каждой операции,
+    // эпоха меняется и будит только когда кто-то действительно спит
+    alignas(CACHE_LINE) std::atomic<uint32_t> not_empty_epoch_{0};
+    std::atomic<uint32_t> consumers_waiting_{0};
+    alignas(CACHE_LINE) std::atomic<uint32_t> not_full_epoch_{0};
+    std::atomic<uint32_t> producers_waiting_{0};
+    std::atomic<bool> open_{true};
+    // Пусты, если инструментирование выключено (см. Instrumentation.h)
+    [[no_unique_address]] instrumentation::QueueCounters counters_;
+private:
+    bool try_enqueue(T& val);
+    std::optional<T> try_dequeue();
+    static void wake(std::atomic<uint32_t>& epoch, std::atomic<uint32_t>& waiting) noexcept;
+    static void cpu_relax() noexcept;
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16384;
+
+    explicit RingBlockQueue(size_t capacity = DEFAULT_CAPACITY);
+    ~RingBlockQueue();
+
+    RingBlockQueue(const RingBlockQueue&) = delete;
+    RingBlockQueue& operator=(const RingBlockQueue&) = delete;
+
+    void Lock();
+    // false - очередь закрыта, значение не принято
+    bool Push(T val);
+    // Неблокирующие варианты: false/nullopt, если очередь полна/пуста
+    bool TryPush(T& val);
+    std::optional<T> Get();
+    std::optional<T> TryGet();
+
+    bool Empty() const noexcept;
+    size_t Size() const noexcept;
+    size_t Capacity() const noexcept { return mask_ + 1; }
+    QueueStats Stats() const noexcept;
+};
+
+template<typename T>
+RingBlockQueue<T>::RingBlockQueue(size_t capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("RingBlockQueue: capacity > 0");
+    }
+    // С одной ячейкой занятая ячейка неотличима от свободной для следующего Push
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    cells_.reset(new Cell[rounded]);
+    for (size_t i = 0; i < rounded; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = rounded - 1;
+}
+
+template<typename T>
+RingBlockQueue<T>::~RingBlockQueue() {
+    while (try_dequeue()) {
+    }
+}
+
+template<typename T>
+void RingBlockQueue<T>::cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+template<typename T>
+void RingBlockQueue<T>::wake(std::atomic<uint32_t>& epoch, std::atomic<uint32_t>& waiting) noexcept {
+    if (waiting.load(std::memory_order_seq_cst) > 0) {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        epoch.notify_all();
+    }
+}
+
+template<typename T>
+bool RingBlockQueue<T>::try_enqueue(T& val) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells_[pos & mask_];
+        const size_t sequence = cell->sequence.load(std::memory_order_seq_cst);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+            counters_.cas_retries.Add();
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+    new (cell->storage) T(std::move(val));
+    cell->sequence.store(pos + 1, std::memory_order_seq_cst);
+    counters_.pushes.Add();
+    if constexpr (instrumentation::ENABLED) {
+        counters_.high_water.Observe(Size());
+    }
+    return true;
+}
+
+template<typename T>
+std::optional<T> RingBlockQueue<T>::try_dequeue() {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells_[pos & mask_];
+        const size_t sequence = cell->sequence.load(std::memory_order_seq_cst);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+            counters_.cas_retries.Add();
+        } else if (diff < 0) {
+            return std::nullopt;
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+    std::optional<T> val(std::move(*cell->value()));
+    cell->value()->~T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_seq_cst);
+    counters_.pops.Add();
+    return val;
+}
+
+template<typename T>
+void RingBlockQueue<T>::Lock() {
+    open_.store(false, std::memory_order_seq_cst);
+    not_empty_epoch_.fetch_add(1, std::memory_order_seq_cst);
+    not_empty_epoch_.notify_all();
+    not_full_epoch_.fetch_add(1, std::memory_order_seq_cst);
+    not_full_epoch_.notify_all();
+}
+
+template<typename T>
+bool RingBlockQueue<T>::TryPush(T& val) {
+    if (!open_.load(std::memory_order_acquire) || !try_enqueue(val)) {
+        return false;
+    }
+    wake(not_empty_epoch_, consumers_waiting_);
+    return true;
+}
+
+template<typename T>
+bool RingBlockQueue<T>::Push(T val) {
+    for (size_t spin = 0;; ++spin) {
+        if (!open_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (try_enqueue(val)) {
+            wake(not_empty_epoch_, consumers_waiting_);
+            return true;
+        }
+        if (spin < SPIN_ROUNDS) {
+            cpu_relax();
+            continue;
+        }
+        // Эпоха читается до повторной попытки: освобождение места после
+        // нее сменит эпоху, и wait не уснет
+        const uint32_t epoch = not_full_epoch_.load(std::memory_order_seq_cst);
+        producers_waiting_.fetch_add(1, std::memory_order_seq_cst);
+        if (open_.load(std::memory_order_seq_cst) && try_enqueue(val)) {
+            producers_waiting_.fetch_sub(1, std::memory_order_relaxed);
+            wake(not_empty_epoch_, consumers_waiting_);
+            return true;
+        }
+        if (open_.load(std::memory_order_seq_cst)) {
+            instrumentation::Stopwatch watch;
+            not_full_epoch_.wait(epoch, std::memory_order_seq_cst);
+            counters_.push_wait_ns.Add(watch.ElapsedNs());
+        }
+        producers_waiting_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+std::optional<T> RingBlockQueue<T>::TryGet() {
+    auto val = try_dequeue();
+    if (val) {
+        wake(not_full_epoch_, producers_waiting_);
+    }
+    return val;
+}
+
+template<typename T>
+std::optional<T> RingBlockQueue<T>::Get() {
+    for (size_t spin = 0;; ++spin) {
+        if (auto val = TryGet()) {
+            return val;
+        }
+        if (!open_.load(std::memory_order_seq_cst)) {
+            // Закрыта: забираем то, что успели положить до Lock
+            return TryGet();
+        }
+        if (spin < SPIN_ROUNDS) {
+            cpu_relax();
+            continue;
+        }
+        const uint32_t epoch = not_empty_epoch_.load(std::memory_order_seq_cst);
+        consumers_waiting_.fetch_add(1, std::memory_order_seq_cst);
+        if (auto val = TryGet()) {
+            consumers_waiting_.fetch_sub(1, std::memory_order_relaxed);
+            return val;
+        }
+        if (open_.load(std::memory_order_seq_cst)) {
+            instrumentation::Stopwatch watch;
+            not_empty_epoch_.wait(epoch, std::memory_order_seq_cst);
+            counters_.pop_wait_ns.Add(watch.ElapsedNs());
+        }
+        consumers_waiting_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// Смотрит на ячейку головы (seq_cst), поэтому годится для проверки перед
+// засыпанием: значение, положенное до проверки, будет замечено
+template<typename T>
+bool RingBlockQueue<T>::Empty() const noexcept {
+    const size_t head = head_.load(std::memory_order_seq_cst);
+    return cells_[head & mask_].sequence.load(std::memory_order_seq_cst) != head + 1;
+}
+
+template<typename T>
+size_t RingBlockQueue<T>::Size() const noexcept {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+}
+
+template<typename T>
+QueueStats RingBlockQueue<T>::Stats() const noexcept {
+    QueueStats stats;
+    stats.pushes = counters_.pushes.Load();
+    stats.pops = counters_.pops.Load();
+    stats.push_wait = std::chrono::nanoseconds(counters_.push_wait_ns.Load());
+    stats.pop_wait = std::chrono::nanoseconds(counters_.pop_wait_ns.Load());
+    stats.cas_retries = counters_.cas_retries.Load();
+    stats.high_water = counters_.high_water.Load();
+    stats.waiting = consumers_waiting_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,121 @@
+#include "ScanMetrics.h"
+
+#include <algorithm>
+#include <sys/resource.h>
+
+const char* scan_stage_name(ScanStage stage) noexcept {
+    switch (stage) {
+        case ScanStage::Open: return "open";
+        case ScanStage::Read: return "read";
+        case ScanStage::Hash: return "hash";
+        case ScanStage::Lookup: return "lookup";
+    }
+    return "unknown";
+}
+
+const char* skip_reason_name(SkipReason reason) noexcept {
+    switch (reason) {
+        case SkipReason::SizeFilter: return "size_filter";
+        case SkipReason::CacheHit: return "cache_hit";
+        case SkipReason::OpenFailed: return "open_failed";
+        case SkipReason::ReadFailed: return "read_failed";
+    }
+    return "unknown";
+}
+
+ScanMetrics::ScanMetrics()
+    : shards_(std::make_unique<Shard[]>(SHARD_COUNT)), started_(std::chrono::steady_clock::now()) {}
+
+ScanMetrics::~ScanMetrics() = default;
+
+ScanMetrics::Shard& ScanMetrics::local() noexcept {
+    // Шард закрепляется за потоком при первой записи и общий для всех ScanMetrics
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+    return shards_[shard];
+}
+
+void ScanMetrics::AddFile() noexcept {
+    local().files.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ScanMetrics::AddBytes(uint64_t bytes) noexcept {
+    local().bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ScanMetrics::AddSkipped(SkipReason reason) noexcept {
+    local().skipped[static_cast<size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ScanMetrics::AddFailedCompletion() noexcept {
+    local().failed_completions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ScanMetrics::AddQueued(int64_t files) noexcept {
+    local().queued_files.fetch_add(files, std::memory_order_relaxed);
+}
+
+void ScanMetrics::Record(ScanStage stage, std::chrono::nanoseconds value) noexcept {
+    const uint64_t ns = value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0;
+    StageCounters& counters = local().stages[static_cast<size_t>(stage)];
+    counters.buckets[LatencyHistogram::bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+    counters.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = counters.max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !counters.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+ScanMetrics::BusyScope::BusyScope(ScanMetrics& metrics) noexcept : metrics_(metrics) {
+    metrics_.local().busy_workers.fetch_add(1, std::memory_order_relaxed);
+}
+
+ScanMetrics::BusyScope::~BusyScope() {
+    metrics_.local().busy_workers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+MetricsSnapshot ScanMetrics::Snapshot() const {
+    MetricsSnapshot snapshot;
+    snapshot.uptime = std::chrono::steady_clock::now() - started_;
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        const Shard& shard = shards_[i];
+        snapshot.files_checked += shard.files.load(std::memory_order_relaxed);
+        snapshot.bytes_read += shard.bytes.load(std::memory_order_relaxed);
+        for (size_t reason = 0; reason < SKIP_REASON_COUNT; ++reason) {
+            snapshot.skipped[reason] += shard.skipped[reason].load(std::memory_order_relaxed);
+        }
+        snapshot.failed_completions += shard.failed_completions.load(std::memory_order_relaxed);
+        snapshot.queued_files += shard.queued_files.load(std::memory_order_relaxed);
+        snapshot.busy_workers += shard.busy_workers.load(std::memory_order_relaxed);
+        for (size_t stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+            const StageCounters& counters = shard.stages[stage];
+            LatencyHistogram& histogram = snapshot.stages[stage];
+            for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+                const uint64_t count = counters.buckets[bucket].load(std::memory_order_relaxed);
+                if (count != 0) {
+                    histogram.AddBucket(bucket, count);
+                }
+            }
+            histogram.AddTotals(counters.sum_ns.load(std::memory_order_relaxed),
+                                counters.max_ns.load(std::memory_order_relaxed));
+        }
+    }
+    // Счетчики разных шардов читаются не одновременно - разность может
+    // ненадолго уйти в минус
+    snapshot.queued_files = std::max<int64_t>(0, snapshot.queued_files);
+    snapshot.busy_workers = std::max<int64_t>(0, snapshot.busy_workers);
+
+    const double seconds = std::chrono::duration<double>(snapshot.uptime).count();
+    if (seconds > 0) {
+        snapshot.files_per_second = static_cast<double>(snapshot.files_checked) / seconds;
+        snapshot.bytes_per_second = static_cast<double>(snapshot.bytes_read) / seconds;
+    }
+
+    struct rusage usage {};
+    if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+        snapshot.cpu_seconds = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                               static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        snapshot.voluntary_switches = static_cast<uint64_t>(usage.ru_nvcsw);
+        snapshot.involuntary_switches = static_cast<uint64_t>(usage.ru_nivcsw);
+    }
+    return snapshot;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Instrumentation.h"
+#include "LatencyHistogram.h"
+
+// Стадии обработки файла, по которым ведутся гистограммы задержек; время
+// стадии - на весь файл, а не на отдельное чтение
+enum class ScanStage : unsigned {
+    Open,
+    Read,
+    Hash,
+    Lookup
+};
+inline constexpr size_t SCAN_STAGE_COUNT = 4;
+
+// Почему файл не читался (или не дочитался)
+enum class SkipReason : unsigned {
+    SizeFilter,
+    CacheHit,
+    OpenFailed,
+    ReadFailed
+};
+inline constexpr size_t SKIP_REASON_COUNT = 4;
+
+const char* scan_stage_name(ScanStage stage) noexcept;
+const char* skip_reason_name(SkipReason reason) noexcept;
+
+// Сводка метрик на момент вызова ScanMetrics::Snapshot. Поля очередей
+// конвейера и io_uring заполняет Scanner.
+struct MetricsSnapshot {
+    std::chrono::nanoseconds uptime{0};
+    uint64_t files_checked = 0;
+    uint64_t bytes_read = 0;
+    // Средние с начала работы; MetricsExporter пишет вместо них скорость
+    // за последний интервал
+    double files_per_second = 0.0;
+    double bytes_per_second = 0.0;
+    std::array<uint64_t, SKIP_REASON_COUNT> skipped{};
+    // Завершения движка и конвейера, выбросившие исключение: итог файла
+    // мог потеряться
+    uint64_t failed_completions = 0;
+    // Файлы в очереди пула и потоки пула, занятые файлом
+    int64_t queued_files = 0;
+    int64_t busy_workers = 0;
+    size_t worker_threads = 0;
+    // Очереди стадий конвейера: чтение, хеширование, отчет
+    std::array<size_t, 3> pipeline_queue_depth{};
+    size_t io_in_flight = 0;
+    // Процессорное время процесса и переключения контекста: ждущие на
+    // блокировках потоки дают много добровольных переключений при низкой
+    // загрузке процессора
+    double cpu_seconds = 0.0;
+    uint64_t voluntary_switches = 0;
+    uint64_t involuntary_switches = 0;
+    std::array<LatencyHistogram, SCAN_STAGE_COUNT> stages{};
+    // Пул сканера: по потокам и общая очередь (с SCANNER_INSTRUMENTATION)
+    PoolStats pool;
+};
+
+// Счетчики сканирования, которые пишут рабочие потоки. Запись идет
+// в шард, закрепленный за потоком: потоки почти не делят кэш-линии,
+// а сложение по шардам делается только в Snapshot.
+class DLL_EXPORT ScanMetrics {
+public:
+    static constexpr size_t SHARD_COUNT = 16;
+
+private:
+    struct StageCounters {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> files{0};
+        std::atomic<uint64_t> bytes{0};
+        std::array<std::atomic<uint64_t>, SKIP_REASON_COUNT> skipped{};
+        std::atomic<uint64_t> failed_completions{0};
+        // Разности: поток может прибавлять в одном шарде, а вычитать в другом
+        std::atomic<int64_t> queued_files{0};
+        std::atomic<int64_t> busy_workers{0};
+        std::array<StageCounters, SCAN_STAGE_COUNT> stages;
+    };
+
+private:
+    std::unique_ptr<Shard[]> shards_;
+    std::chrono::steady_clock::time_point started_;
+private:
+    Shard& local() noexcept;
+public:
+    ScanMetrics();
+    ~ScanMetrics();
+
+    ScanMetrics(const ScanMetrics&) = delete;
+    ScanMetrics& operator=(const ScanMetrics&) = delete;
+
+    void AddFile() noexcept;
+    void AddBytes(uint64_t bytes) noexcept;
+    void AddSkipped(SkipReason reason) noexcept;
+    void AddFailedCompletion() noexcept;
+    void AddQueued(int64_t files) noexcept;
+    void Record(ScanStage stage, std::chrono::nanoseconds value) noexcept;
+
+    // Поток пула занят файлом, пока жив объект
+    class BusyScope {
+    private:
+        ScanMetrics& metrics_;
+    public:
+        explicit BusyScope(ScanMetrics& metrics) noexcept;
+        ~BusyScope();
+        BusyScope(const BusyScope&) = delete;
+        BusyScope& operator=(const BusyScope&) = delete;
+    };
+
+    MetricsSnapshot Snapshot() const;
+};
@@ -0,0 +1,193 @@
+#include "ScanPipeline.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+ScanPipeline::ScanPipeline(const PipelineOptions& options, size_t default_hash_threads,
+                           ScanMetrics* metrics)
+    : metrics_(metrics),
+      buffers_(std::max<size_t>(1, options.buffer_count), options.buffer_size),
+      read_queue_(std::max<size_t>(1, options.read_queue_depth)),
+      report_queue_(std::max<size_t>(1, options.report_queue_depth)) {
+    const size_t hash_threads = std::max<size_t>(1, options.hash_threads != 0 ? options.hash_threads
+                                                                              : default_hash_threads);
+    for (size_t i = 0; i < hash_threads; ++i) {
+        hash_queues_.push_back(std::make_unique<RingBlockQueue<Chunk>>(std::max<size_t>(1, options.hash_queue_depth)));
+    }
+
+    try {
+        for (auto& queue : hash_queues_) {
+            hashers_.emplace_back([this, &queue = *queue] { hash_loop(queue); });
+        }
+        for (unsigned i = 0; i < std::max(1u, options.read_threads); ++i) {
+            readers_.emplace_back([this] { read_loop(); });
+        }
+        for (unsigned i = 0; i < std::max(1u, options.report_threads); ++i) {
+            reporters_.emplace_back([this] { report_loop(); });
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+ScanPipeline::~ScanPipeline() noexcept {
+    Drain();
+    stop();
+}
+
+void ScanPipeline::stop() noexcept {
+    // Стадии закрываются по порядку: каждая дорабатывает остаток своей
+    // очереди, пока следующая еще принимает результаты
+    read_queue_.Lock();
+    for (auto& thread : readers_) {
+        thread.join();
+    }
+    for (auto& queue : hash_queues_) {
+        queue->Lock();
+    }
+    for (auto& thread : hashers_) {
+        thread.join();
+    }
+    report_queue_.Lock();
+    for (auto& thread : reporters_) {
+        thread.join();
+    }
+    readers_.clear();
+    hashers_.clear();
+    reporters_.clear();
+}
+
+void ScanPipeline::Submit(const std::filesystem::path& file_path, unsigned algorithms, Completion done) {
+    auto job = std::make_unique<FileJob>(file_path, algorithms, std::move(done));
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    if (!read_queue_.Push(job.get())) {
+        file_done();
+        throw std::runtime_error("Конвейер сканирования остановлен");
+    }
+    job.release();
+}
+
+void ScanPipeline::file_done() noexcept {
+    if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        drain_cv_.notify_all();
+    }
+}
+
+void ScanPipeline::Drain() {
+    std::unique_lock<std::mutex> lock(drain_mutex_);
+    drain_cv_.wait(lock, [this] { return in_flight_.load(std::memory_order_acquire) == 0; });
+}
+
+std::array<size_t, 3> ScanPipeline::queue_depths() const noexcept {
+    size_t hash_depth = 0;
+    for (const auto& queue : hash_queues_) {
+        hash_depth += queue->Size();
+    }
+    return {read_queue_.Size(), hash_depth, report_queue_.Size()};
+}
+
+void ScanPipeline::read_loop() {
+    while (auto job = read_queue_.Get()) {
+        // Файл целиком уходит одному потоку хеширования - куски не перемешиваются
+        const size_t index = next_hasher_.fetch_add(1, std::memory_order_relaxed) % hash_queues_.size();
+        read_file(*job, *hash_queues_[index]);
+    }
+}
+
+void ScanPipeline::read_file(FileJob* job, RingBlockQueue<Chunk>& hasher) {
+    size_t file_size = 0;
+    const auto open_started = std::chrono::steady_clock::now();
+    const int fd = MD5Compute::openFileForReading(job->path, file_size);
+    if (metrics_ != nullptr) {
+        metrics_->Record(ScanStage::Open, std::chrono::steady_clock::now() - open_started);
+    }
+    if (fd < 0) {
+        if (metrics_ != nullptr) {
+            metrics_->AddSkipped(SkipReason::OpenFailed);
+        }
+        hasher.Push(Chunk{job, nullptr, 0, true, true});
+        return;
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    const size_t buffer_size = buffers_.buffer_size();
+    off_t offset = 0;
+    while (true) {
+        unsigned char* buffer = buffers_.Acquire();
+        // Ожидание свободного буфера в чтение не входит - это давление хеширования
+        const auto read_started = std::chrono::steady_clock::now();
+        ssize_t bytes_read;
+        do {
+            bytes_read = ::pread(fd, buffer, buffer_size, offset);
+        } while (bytes_read < 0 && errno == EINTR);
+        job->read_time += std::chrono::steady_clock::now() - read_started;
+
+        if (bytes_read <= 0) {
+            if (bytes_read < 0 && metrics_ != nullptr) {
+                metrics_->AddSkipped(SkipReason::ReadFailed);
+            }
+            buffers_.Release(buffer);
+            hasher.Push(Chunk{job, nullptr, 0, true, bytes_read < 0});
+            break;
+        }
+        offset += bytes_read;
+        job->bytes += static_cast<uint64_t>(bytes_read);
+        // Короткое чтение до размера из fstat - конец файла, лишний pread не нужен
+        const bool last = static_cast<size_t>(bytes_read) < buffer_size &&
+                          static_cast<uint64_t>(offset) >= file_size;
+        hasher.Push(Chunk{job, buffer, static_cast<size_t>(bytes_read), last, false});
+        if (last) {
+            break;
+        }
+    }
+    ::close(fd);
+}
+
+void ScanPipeline::hash_loop(RingBlockQueue<Chunk>& queue) {
+    while (auto chunk = queue.Get()) {
+        FileJob* job = chunk->job;
+        if (chunk->buffer != nullptr) {
+            const auto hash_started = std::chrono::steady_clock::now();
+            if (!job->failed && !job->digests.update(chunk->buffer, chunk->size)) {
+                job->failed = true;
+            }
+            job->hash_time += std::chrono::steady_clock::now() - hash_started;
+            buffers_.Release(chunk->buffer);
+        }
+        job->failed = job->failed || chunk->failed;
+        if (chunk->last) {
+            if (!job->failed) {
+                job->result = job->digests.finish();
+            }
+            if (metrics_ != nullptr && job->result.has_value()) {
+                metrics_->Record(ScanStage::Read, job->read_time);
+                metrics_->Record(ScanStage::Hash, job->hash_time);
+                metrics_->AddBytes(job->bytes);
+            }
+            report_queue_.Push(job);
+        }
+    }
+}
+
+void ScanPipeline::report_loop() {
+    while (auto next = report_queue_.Get()) {
+        std::unique_ptr<FileJob> job(*next);
+        try {
+            job->done(std::move(job->result));
+        } catch (...) {
+            // Завершение отвечает за свои ошибки; поток отчета не
+            // останавливаем, но потерянный итог файла виден в метриках
+            if (metrics_ != nullptr) {
+                metrics_->AddFailedCompletion();
+            }
+        }
+        job.reset();
+        file_done();
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "BufferPool.h"
+#include "Digest.h"
+#include "MD5Compute.h"
+#include "RingBlockQueue.h"
+#include "ScanMetrics.h"
+#include "UniqueFunction.h"
+
+// Размеры стадий конвейера; у каждой стадии свои потоки и своя очередь
+struct PipelineOptions {
+    unsigned read_threads = 2;
+    // 0 - по числу потоков сканера
+    unsigned hash_threads = 0;
+    unsigned report_threads = 1;
+    // Файлов, ждущих чтения
+    size_t read_queue_depth = 1024;
+    // Кусков, ждущих хеширования, на поток хеширования
+    size_t hash_queue_depth = 64;
+    // Файлов, ждущих проверки по базе
+    size_t report_queue_depth = 1024;
+    // Общий пул буферов: buffer_count * buffer_size байт прочитанных,
+    // но не захешированных данных
+    size_t buffer_count = 64;
+    size_t buffer_size = 256 << 10;
+};
+
+// Конвейер обработки файла из трех стадий: потоки чтения заполняют буферы
+// общего пула, потоки хеширования считают дайджесты и возвращают буферы,
+// потоки отчета вызывают завершение (проверка по базе и лог). Стадии
+// связаны ограниченными очередями, поэтому медленный диск и быстрый
+// процессор (и наоборот) друг друга не тормозят. Все куски одного файла
+// попадают к одному потоку хеширования по порядку.
+class DLL_EXPORT ScanPipeline {
+public:
+    // Вызывается в потоке отчета; nullopt - файл не открылся или не прочитался
+    using Completion = UniqueFunction<void(std::optional<FileDigests>)>;
+
+private:
+    struct FileJob {
+        std::filesystem::path path;
+        DigestAccumulator digests;
+        Completion done;
+        bool failed = false;
+        std::optional<FileDigests> result;
+        // Пишет поток чтения до отправки куска, читает поток хеширования
+        std::chrono::nanoseconds read_time{0};
+        uint64_t bytes = 0;
+        std::chrono::nanoseconds hash_time{0};
+
+        FileJob(const std::filesystem::path& file_path, unsigned algorithms, Completion completion)
+            : path(file_path), digests(algorithms), done(std::move(completion)) {}
+    };
+    struct Chunk {
+        FileJob* job = nullptr;
+        unsigned char* buffer = nullptr;
+        size_t size = 0;
+        bool last = false;
+        bool failed = false;
+    };
+
+private:
+    ScanMetrics* metrics_;
+    BufferPool buffers_;
+    RingBlockQueue<FileJob*> read_queue_;
+    std::vector<std::unique_ptr<RingBlockQueue<Chunk>>> hash_queues_;
+    RingBlockQueue<FileJob*> report_queue_;
+    std::vector<std::thread> readers_;
+    std::vector<std::thread> hashers_;
+    std::vector<std::thread> reporters_;
+    std::atomic<size_t> next_hasher_{0};
+    std::atomic<size_t> in_flight_{0};
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+private:
+    void read_loop();
+    void hash_loop(RingBlockQueue<Chunk>& queue);
+    void report_loop();
+    void read_file(FileJob* job, RingBlockQueue<Chunk>& hasher);
+    void file_done() noexcept;
+    void stop() noexcept;
+public:
+    // hash_threads == 0 в options заменяется на default_hash_threads;
+    // metrics, если задан, должен пережить конвейер
+    ScanPipeline(const PipelineOptions& options, size_t default_hash_threads,
+                 ScanMetrics* metrics = nullptr);
+    ~ScanPipeline() noexcept;
+
+    ScanPipeline(const ScanPipeline&) = delete;
+    ScanPipeline& operator=(const ScanPipeline&) = delete;
+
+    // Ставит файл в очередь чтения; ждет, если она заполнена
+    void Submit(const std::filesystem::path& file_path, unsigned algorithms, Completion done);
+    // Ждет завершения всех поставленных файлов
+    void Drain();
+
+    size_t buffer_size() const noexcept { return buffers_.buffer_size(); }
+    // Заполненность очередей стадий: чтение, хеширование (сумма), отчет
+    std::array<size_t, 3> queue_depths() const noexcept;
+};
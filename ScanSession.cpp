@@ -0,0 +1,52 @@
+#include "ScanSession.h"
+
+ScanSession::ScanSession(Scanner& scanner, ResultSink* sink)
+    : scanner_(scanner), start_time_(std::chrono::steady_clock::now()) {
+    if (sink != nullptr) {
+        results_ = std::make_unique<ResultDispatcher>(*sink, scanner.options_.result_queue_capacity);
+    }
+}
+
+ScanSession::~ScanSession() noexcept {
+    try {
+        Wait();
+    } catch (...) {
+    }
+}
+
+void ScanSession::AddRoot(const std::filesystem::path& root_path) {
+    scanner_.scan_root(*this, root_path);
+}
+
+Scanner::ScanResult ScanSession::Wait() {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    if (!finished_) {
+        finished_ = true;
+        try {
+            result_ = scanner_.finish_session(*this);
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    return *result_;
+}
+
+Scanner::ScanResult ScanSession::GetCurrentStats() const noexcept {
+    return Scanner::ScanResult{
+        .total_files = total_files_.load(),
+        .malicious_files = malicious_files_.load(),
+        .errors = errors_.load(),
+        .duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time_),
+        .prefilter_checks = prefilter_checks_.load(),
+        .prefilter_false_positives = prefilter_false_positives_.load(),
+        .skipped_by_size = skipped_by_size_.load(),
+        .cache_hits = cache_hits_.load(),
+        .cache_misses = cache_misses_.load(),
+        .archive_members = archive_members_.load(),
+        .archive_members_skipped = archive_members_skipped_.load()
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include "ResultDispatcher.h"
+#include "Scanner.h"
+#include "TaskGroup.h"
+
+// Одно сканирование на общем Scanner: своя статистика, свой приемник
+// результатов и своя группа задач в общем пуле. Сессий на одном сканере
+// может идти несколько одновременно - база хешей, пул, движок чтения и кэш
+// у них общие. Создается через Scanner::CreateSession.
+class DLL_EXPORT ScanSession {
+private:
+    friend class Scanner;
+
+    Scanner& scanner_;
+    std::unique_ptr<ResultDispatcher> results_;
+    // Задачи файлов этой сессии, включая ушедшие в движок или конвейер
+    TaskGroup tasks_;
+    std::chrono::steady_clock::time_point start_time_;
+private:
+    std::mutex wait_mutex_;
+    bool finished_ = false;
+    std::optional<Scanner::ScanResult> result_;
+    std::exception_ptr error_;
+private:
+    std::atomic<size_t> total_files_{0};
+    std::atomic<size_t> malicious_files_{0};
+    std::atomic<size_t> errors_{0};
+    std::atomic<size_t> prefilter_checks_{0};
+    std::atomic<size_t> prefilter_false_positives_{0};
+    std::atomic<size_t> skipped_by_size_{0};
+    std::atomic<size_t> cache_hits_{0};
+    std::atomic<size_t> cache_misses_{0};
+    std::atomic<size_t> archive_members_{0};
+    std::atomic<size_t> archive_members_skipped_{0};
+private:
+    ScanSession(Scanner& scanner, ResultSink* sink);
+public:
+    ScanSession(const ScanSession&) = delete;
+    ScanSession& operator=(const ScanSession&) = delete;
+    // Брошенная сессия дожидается своих задач; ошибки приемника теряются
+    ~ScanSession() noexcept;
+
+    // Обходит директорию в вызывающем потоке и ставит ее файлы в пул, не
+    // дожидаясь их проверки. Можно вызывать несколько раз до Wait.
+    void AddRoot(const std::filesystem::path& root_path);
+    // Ждет все файлы сессии, пишет статистику в лог и пробрасывает ошибку
+    // приемника. Повторный вызов возвращает тот же итог.
+    Scanner::ScanResult Wait();
+    Scanner::ScanResult GetCurrentStats() const noexcept;
+};
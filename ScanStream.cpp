@@ -0,0 +1,80 @@
+#include "ScanStream.h"
+
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include "RingBlockQueue.h"
+
+struct ScanStream::State : ResultSink {
+    RingBlockQueue<ScanRecord> queue;
+    std::optional<Scanner::ScanResult> result;
+    std::exception_ptr error;
+    std::thread thread;
+
+    explicit State(size_t capacity) : queue(capacity) {}
+
+    void OnResults(std::span<const ScanRecord> records) override {
+        for (const auto& record : records) {
+            // После закрытия потребителем записи просто отбрасываются
+            if (!queue.Push(record)) {
+                return;
+            }
+        }
+    }
+
+    void join() noexcept {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
+ScanStream::ScanStream(Scanner& scanner, const std::filesystem::path& root_path, size_t capacity)
+    : state_(std::make_unique<State>(capacity)) {
+    State* state = state_.get();
+    state->thread = std::thread([state, &scanner, root_path] {
+        try {
+            state->result = scanner.Scan(root_path, *state);
+        } catch (...) {
+            state->error = std::current_exception();
+        }
+        state->queue.Lock();
+    });
+}
+
+ScanStream::~ScanStream() noexcept {
+    if (state_) {
+        state_->queue.Lock();
+        state_->join();
+    }
+}
+
+ScanStream::ScanStream(ScanStream&&) noexcept = default;
+
+ScanStream& ScanStream::operator=(ScanStream&& other) noexcept {
+    if (this != &other) {
+        if (state_) {
+            state_->queue.Lock();
+            state_->join();
+        }
+        state_ = std::move(other.state_);
+    }
+    return *this;
+}
+
+std::optional<ScanRecord> ScanStream::Next() {
+    return state_ ? state_->queue.Get() : std::nullopt;
+}
+
+Scanner::ScanResult ScanStream::Wait() {
+    if (!state_) {
+        throw std::logic_error("ScanStream: поток уже перемещен");
+    }
+    while (state_->queue.Get().has_value()) {
+    }
+    state_->join();
+    if (state_->error) {
+        std::rethrow_exception(state_->error);
+    }
+    return *state_->result;
+}
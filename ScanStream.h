@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include "ResultSink.h"
+#include "Scanner.h"
+
+// Сканирование в фоновом потоке с выдачей результатов по запросу. Между
+// сканером и потребителем - ограниченная очередь: пока потребитель не
+// забирает записи, рабочие потоки сканера ждут - и вместе с ними другие
+// сессии этого Scanner, которым достался тот же пул.
+class DLL_EXPORT ScanStream {
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    ScanStream(Scanner& scanner, const std::filesystem::path& root_path,
+               size_t capacity = DEFAULT_CAPACITY);
+    // Брошенный поток дожидается конца сканирования, оставшиеся записи отбрасываются
+    ~ScanStream() noexcept;
+
+    ScanStream(ScanStream&&) noexcept;
+    ScanStream& operator=(ScanStream&&) noexcept;
+
+    // Следующий результат; nullopt - сканирование закончено
+    std::optional<ScanRecord> Next();
+    // Дочитывает остаток, ждет конца сканирования и пробрасывает его ошибку
+    Scanner::ScanResult Wait();
+};
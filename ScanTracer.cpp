@@ -0,0 +1,205 @@
+#include "ScanTracer.h"
+#include "ResultSink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+
+std::atomic<uint64_t> next_tracer_id{1};
+
+// Микросекунды с дробной частью - единица ts/dur в Chrome trace
+void append_us(std::string& out, uint64_t ns) {
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+                                     static_cast<unsigned long long>(ns / 1000),
+                                     static_cast<unsigned long long>(ns % 1000));
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+} // namespace
+
+ScanTracer::ScanTracer(double sample_rate, size_t max_events)
+    : tracer_id_(next_tracer_id.fetch_add(1, std::memory_order_relaxed)),
+      origin_(std::chrono::steady_clock::now()),
+      period_(sample_rate > 0 && sample_rate <= 1 ? static_cast<uint64_t>(std::llround(1.0 / sample_rate)) : 0),
+      max_events_(max_events) {
+    if (period_ == 0) {
+        throw std::runtime_error("Доля трассируемых файлов должна быть в (0, 1]");
+    }
+}
+
+ScanTracer::~ScanTracer() = default;
+
+uint64_t ScanTracer::Now() const noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin_).count()) + 1;
+}
+
+uint64_t ScanTracer::ReserveFiles(size_t count) noexcept {
+    return next_file_.fetch_add(count, std::memory_order_relaxed);
+}
+
+bool ScanTracer::SampleDirectory() noexcept {
+    return next_directory_.fetch_add(1, std::memory_order_relaxed) % period_ == 0;
+}
+
+ScanTracer::ThreadBuffer& ScanTracer::local() {
+    // Последний буфер потока; поток пишет чаще всего в один трассировщик
+    struct Cached {
+        uint64_t tracer_id = 0;
+        ThreadBuffer* buffer = nullptr;
+    };
+    thread_local Cached cached;
+    if (cached.tracer_id == tracer_id_) {
+        return *cached.buffer;
+    }
+    const auto self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    auto it = std::find_if(buffers_.begin(), buffers_.end(),
+                           [&self](const auto& buffer) { return buffer->owner == self; });
+    if (it == buffers_.end()) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->owner = self;
+        buffer->tid = static_cast<long>(::syscall(SYS_gettid));
+        buffers_.push_back(std::move(buffer));
+        it = std::prev(buffers_.end());
+    }
+    cached = Cached{tracer_id_, it->get()};
+    return **it;
+}
+
+void ScanTracer::record(const char* name, uint64_t start, uint64_t end, uint64_t id, std::string detail) {
+    ThreadBuffer& buffer = local();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= max_events_) {
+        ++buffer.dropped;
+        return;
+    }
+    buffer.events.push_back(Event{name, start, std::max(start, end), id, std::move(detail)});
+}
+
+void ScanTracer::Span(const char* name, uint64_t start, uint64_t end, std::string detail) {
+    record(name, start, end, 0, std::move(detail));
+}
+
+void ScanTracer::FileSpan(const char* name, const FileTrace& trace, uint64_t start, uint64_t end,
+                          std::string detail) {
+    record(name, start, end, trace.id, std::move(detail));
+}
+
+ScanTracer::Scope::Scope(ScanTracer* tracer, const char* name) : tracer_(tracer), name_(name) {
+    if (tracer_ != nullptr) {
+        start_ = tracer_->Now();
+        parent_ = current_;
+        current_ = this;
+    }
+}
+
+ScanTracer::Scope::~Scope() {
+    if (tracer_ == nullptr) {
+        return;
+    }
+    current_ = parent_;
+    try {
+        tracer_->Span(name_, start_, tracer_->Now(), std::move(detail_));
+    } catch (...) {
+    }
+}
+
+void ScanTracer::Scope::Annotate(std::string_view detail) {
+    if (current_ != nullptr) {
+        current_->detail_.assign(detail);
+    }
+}
+
+size_t ScanTracer::Write(const std::string& path) {
+    struct Drained {
+        long tid;
+        std::vector<Event> events;
+    };
+    std::vector<Drained> drained;
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (const auto& buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            drained.push_back(Drained{buffer->tid, std::move(buffer->events)});
+            buffer->events.clear();
+            dropped += std::exchange(buffer->dropped, 0);
+        }
+    }
+
+    const std::string pid = std::to_string(::getpid());
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"sample_period\":" +
+                      std::to_string(period_) + ",\"dropped_events\":" + std::to_string(dropped) +
+                      "},\"traceEvents\":[";
+    size_t written = 0;
+    bool first = true;
+    auto begin_event = [&](const char* name, char phase, long tid, uint64_t ts) {
+        out += first ? "\n{" : ",\n{";
+        first = false;
+        out += "\"name\":";
+        append_json_string(out, name);
+        out += ",\"ph\":\"";
+        out += phase;
+        out += "\",\"pid\":" + pid + ",\"tid\":" + std::to_string(tid) + ",\"ts\":";
+        append_us(out, ts);
+    };
+    auto append_detail = [&out](const Event& event) {
+        if (!event.detail.empty()) {
+            out += ",\"args\":{\"path\":";
+            append_json_string(out, event.detail);
+            out += '}';
+        }
+    };
+    for (const auto& thread : drained) {
+        begin_event("thread_name", 'M', thread.tid, 0);
+        out += ",\"args\":{\"name\":\"scanner " + std::to_string(thread.tid) + "\"}}";
+        for (const Event& event : thread.events) {
+            if (event.id == 0) {
+                begin_event(event.name, 'X', thread.tid, event.start);
+                out += ",\"dur\":";
+                append_us(out, event.end - event.start);
+                append_detail(event);
+                out += '}';
+            } else {
+                // Асинхронная пара b/e: отрезки с одним id складываются в
+                // одну дорожку файла по вложенности времени
+                const std::string id = ",\"cat\":\"file\",\"id\":\"" + std::to_string(event.id) + "\"";
+                begin_event(event.name, 'b', thread.tid, event.start);
+                out += id;
+                append_detail(event);
+                out += '}';
+                begin_event(event.name, 'e', thread.tid, event.end);
+                out += id + '}';
+            }
+            ++written;
+        }
+    }
+    out += "\n]}\n";
+
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Не удается записать файл трассы: " + path);
+        }
+        file << out;
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Ошибка записи файла трассы: " + path);
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("Не удается записать файл трассы: " + path);
+    }
+    return written;
+}
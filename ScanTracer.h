@@ -0,0 +1,116 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Трассируемый файл: номер его дорожки и время постановки в очередь.
+// id == 0 - файл не попал в выборку.
+struct FileTrace {
+    uint64_t id = 0;
+    uint64_t queued = 0;
+};
+
+// Трасса сканирования в формате Chrome trace JSON (открывается в
+// ui.perfetto.dev и chrome://tracing). Отрезки копятся в буфере своего
+// потока и собираются только в Write. Трассируется каждый N-й файл и
+// каждая N-я директория (N = 1 / sample_rate), так что трассу можно
+// держать включенной в работе.
+// Отрезки потока (walk, open, read, hash, lookup, log) лежат на дорожке
+// потока, а путь файла от очереди до вердикта (file, queue, digest) - на
+// отдельной дорожке файла: он проходит через несколько потоков.
+class DLL_EXPORT ScanTracer {
+public:
+    static constexpr size_t DEFAULT_MAX_EVENTS = 1 << 20;
+
+private:
+    struct Event {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        // 0 - отрезок потока, иначе - дорожка файла FileTrace::id
+        uint64_t id;
+        std::string detail;
+    };
+    struct ThreadBuffer {
+        std::thread::id owner;
+        long tid = 0;
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t dropped = 0;
+    };
+
+private:
+    // Отличает трассировщики для кэша буфера в thread_local: адрес может
+    // достаться новому объекту
+    const uint64_t tracer_id_;
+    const std::chrono::steady_clock::time_point origin_;
+    const uint64_t period_;
+    const size_t max_events_;
+    std::atomic<uint64_t> next_file_{0};
+    std::atomic<uint64_t> next_directory_{0};
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+private:
+    ThreadBuffer& local();
+    void record(const char* name, uint64_t start, uint64_t end, uint64_t id, std::string detail);
+public:
+    // sample_rate из (0, 1]; max_events - предел отрезков на поток между
+    // вызовами Write, лишние отбрасываются и считаются
+    explicit ScanTracer(double sample_rate = 1.0, size_t max_events = DEFAULT_MAX_EVENTS);
+    ~ScanTracer();
+
+    ScanTracer(const ScanTracer&) = delete;
+    ScanTracer& operator=(const ScanTracer&) = delete;
+
+    // Наносекунды от создания трассировщика; не бывает 0
+    uint64_t Now() const noexcept;
+
+    // Номера для пачки из count файлов: файл first + i трассируется, если
+    // SampledFile(first + i)
+    uint64_t ReserveFiles(size_t count) noexcept;
+    bool SampledFile(uint64_t index) const noexcept { return index % period_ == 0; }
+    FileTrace StartFile(uint64_t index) const noexcept { return FileTrace{index + 1, Now()}; }
+    bool SampleDirectory() noexcept;
+
+    void Span(const char* name, uint64_t start, uint64_t end, std::string detail = {});
+    void FileSpan(const char* name, const FileTrace& trace, uint64_t start, uint64_t end, std::string detail = {});
+
+    // Отрезок потока на время жизни объекта; tracer == nullptr - ничего не
+    // пишет. Annotate дописывает подпись к самому вложенному открытому.
+    class DLL_EXPORT Scope {
+    private:
+        ScanTracer* tracer_;
+        const char* name_;
+        uint64_t start_ = 0;
+        std::string detail_;
+        Scope* parent_ = nullptr;
+        static inline thread_local Scope* current_ = nullptr;
+    public:
+        Scope(ScanTracer* tracer, const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        static void Annotate(std::string_view detail);
+    };
+
+    // Забирает накопленные отрезки и атомарно (через .tmp) переписывает
+    // файл трассы; возвращает число записанных отрезков
+    size_t Write(const std::string& path);
+};
@@ -1,13 +1,23 @@
 #include "Scanner.h"
 #include "ValidatePath.h"
+#include "DirectoryWalker.h"
+#include "AsyncDigestEngine.h"
+#include "AsyncLogger.h"
+#include "ScanStream.h"
+#include "ScanSession.h"
+#include "MD5MultiBuffer.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <future>
+#include <cstring>
+#include <sys/stat.h>
 
 Scanner::Scanner(const std::string& csv_path,
                 const std::string& log_path,
-                size_t thread_count) {
+                size_t thread_count,
+                const ScannerOptions& options)
+    : options_(options) {
 
     if (thread_count == 0) {
         thread_count = std::thread::hardware_concurrency();
@@ -18,179 +28,819 @@ Scanner::Scanner(const std::string& csv_path,
 
     PathChecker::validate_paths(csv_path, log_path, "");
 
-    hash_base_ = std::make_unique<HashBase>();
-    hash_base_->load_hashes(csv_path);
+    auto hash_base = std::make_shared<HashBase>();
+    hash_base->load(csv_path);
+    if (options_.use_prefilter && !hash_base->has_prefilter()) {
+        hash_base->build_prefilter(options_.prefilter_bits_per_key);
+    }
+
+    md5_compute_ = std::make_unique<MD5Compute>(options_.read_options);
+    bool io_uring_fallback = false;
+    // С проверкой архивов каждый файл читается одним проходом ArchiveReader
+    // в потоке пула - движок и конвейер не нужны
+    if (options_.read_options.strategy == ReadStrategy::IoUring && !options_.scan_archives) {
+        if (AsyncDigestEngine::available()) {
+            async_engine_ = std::make_unique<AsyncDigestEngine>(options_.read_options, thread_count, &metrics_);
+        } else {
+            io_uring_fallback = true;
+        }
+    }
+    if (!async_engine_ && options_.use_pipeline && !options_.scan_archives) {
+        pipeline_ = std::make_unique<ScanPipeline>(options_.pipeline, thread_count, &metrics_);
+    }
+    if (!options_.digest_cache_path.empty()) {
+        digest_cache_ = std::make_unique<DigestCache>(options_.digest_cache_path,
+                                                      options_.digest_cache_racy_window);
+    }
 
-    md5_compute_ = std::make_unique<MD5Compute>();
+    // Без векторных полос пачка - те же вызовы OpenSSL по одному файлу
+    batch_md5_ = options_.batch_small_files && !async_engine_ && !pipeline_ && !digest_cache_ &&
+                 !options_.scan_archives && MD5MultiBuffer::detect_kernel() != MD5Kernel::Scalar;
 
-    thread_pool_ = std::make_unique<ThreadPool<std::function<void()>>>(thread_count);
+    thread_pool_ = std::make_unique<ThreadPool<UniqueFunction<void()>>>(thread_count, options_.task_queue_capacity);
 
-    log_file_.open(log_path, std::ios::out | std::ios::app);
-    if (!log_file_.is_open()) {
-        throw std::runtime_error("Не удается открыть файл лога: " + log_path);
+    logger_ = std::make_unique<AsyncLogger>(log_path);
+
+    if (!options_.trace_path.empty()) {
+        tracer_ = std::make_unique<ScanTracer>(options_.trace_sample_rate);
+        // Пустая трасса сразу: недоступный путь - ошибка конструктора, а не
+        // потерянная в конце сканирования трасса
+        tracer_->Write(options_.trace_path);
     }
 
     {
-        std::lock_guard<std::mutex> lock(log_mutex_);
+        // Заголовок сессии - одна запись, чтобы не перемешался с другими
+        std::ostringstream header;
         auto now = std::chrono::system_clock::now();
         auto time_t_now = std::chrono::system_clock::to_time_t(now);
 
-        log_file_ << "\n=== НОВАЯ СЕССИЯ СКАНИРОВАНИЯ НАЧАТА " 
-                  << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S") 
-                  << " ===" << std::endl;
-        log_file_ << "Количество рабочих потоков: " << thread_count << std::endl;
-        log_file_.flush();
+        header << "\n=== НОВАЯ СЕССИЯ СКАНИРОВАНИЯ НАЧАТА " 
+               << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S") 
+                  << " ===" << '\n';
+        header << "Количество рабочих потоков: " << thread_count << '\n';
+        if (options_.use_prefilter) {
+            header << "Префильтр базы хешей: " << hash_base->prefilter_bytes() << " байт" << '\n';
+        }
+        if (async_engine_) {
+            header << "Асинхронное чтение io_uring: глубина " << options_.read_options.io_queue_depth
+                      << ", потоков отправки " << options_.read_options.io_submitters << '\n';
+        } else if (io_uring_fallback) {
+            header << "ПРЕДУПРЕЖДЕНИЕ: io_uring недоступен, используется обычное чтение" << '\n';
+        }
+        if (options_.scan_archives &&
+            (options_.read_options.strategy == ReadStrategy::IoUring || options_.use_pipeline)) {
+            header << "ПРЕДУПРЕЖДЕНИЕ: с проверкой архивов файлы читаются в потоках пула, "
+                      "io_uring и конвейер не используются" << '\n';
+        }
+        if (pipeline_) {
+            const auto& stages = options_.pipeline;
+            header << "Конвейер: потоков чтения " << stages.read_threads
+                      << ", хеширования " << (stages.hash_threads != 0 ? stages.hash_threads : thread_count)
+                      << ", отчета " << stages.report_threads
+                      << ", буферов " << stages.buffer_count << " x " << pipeline_->buffer_size() << " байт"
+                      << '\n';
+        }
+        if (tracer_) {
+            header << "Трасса сканирования: " << options_.trace_path
+                   << ", доля файлов " << options_.trace_sample_rate << '\n';
+        }
+        log_base_warnings(header, *hash_base);
+        log_size_filter_state(header, *hash_base);
+        if (digest_cache_) {
+            header << "Кэш дайджестов: " << options_.digest_cache_path << ", записей: "
+                      << digest_cache_->index_records() + digest_cache_->log_records() << '\n';
+            for (const auto& warning : digest_cache_->load_warnings()) {
+                header << warning << '\n';
+            }
+        }
+        logger_->Write(header.str());
+    }
+
+    hash_base_.publish(std::move(hash_base));
+
+    if (!options_.metrics_path.empty()) {
+        metrics_exporter_ = std::make_unique<MetricsExporter>(
+            options_.metrics_path, options_.metrics_format, options_.metrics_interval,
+            [this] { return GetMetrics(); });
+    }
+}
+
+void Scanner::log_base_warnings(std::ostream& out, const HashBase& hash_base) {
+    for (const auto& warning : hash_base.load_warnings()) {
+        out << warning << '\n';
+    }
+    if (hash_base.malformed_lines() > hash_base.load_warnings().size()) {
+        out << "Предупреждение: всего некорректных строк в базе хешей: "
+            << hash_base.malformed_lines() << '\n';
+    }
+}
+
+void Scanner::log_size_filter_state(std::ostream& out, const HashBase& hash_base) {
+    if (!options_.use_size_filter) {
+        return;
     }
+    if (hash_base.has_size_index()) {
+        out << "Фильтр по размеру: различных размеров в базе: " << hash_base.size_index_count() << '\n';
+    } else {
+        out << "Предупреждение: не у всех записей базы указан размер, фильтр по размеру отключен" << '\n';
+    }
+}
+
+void Scanner::publish_base(std::shared_ptr<HashBase> hash_base, const std::string& source) {
+    if (options_.use_prefilter && !hash_base->has_prefilter()) {
+        hash_base->build_prefilter(options_.prefilter_bits_per_key);
+    }
+    {
+        std::ostringstream record;
+        record << "База хешей обновлена из " << source << ", записей: " << hash_base->size() << '\n';
+        log_base_warnings(record, *hash_base);
+        log_size_filter_state(record, *hash_base);
+        logger_->Write(record.str());
+        logger_->Flush();
+    }
+    hash_base_.publish(std::move(hash_base));
+}
+
+void Scanner::ReloadBase(const std::string& path) {
+    std::lock_guard<std::mutex> reload_lock(reload_mutex_);
+    auto hash_base = std::make_shared<HashBase>();
+    hash_base->load(path);
+    publish_base(std::move(hash_base), path);
+}
+
+void Scanner::ApplyBaseDelta(const std::string& delta_path) {
+    std::lock_guard<std::mutex> reload_lock(reload_mutex_);
+    const auto current = hash_base_.snapshot();
+    if (current->image_bytes() > options_.max_delta_image_bytes) {
+        throw std::runtime_error("Скомпилированная база слишком велика для дельты (" +
+                                 std::to_string(current->image_bytes()) +
+                                 " байт), перекомпилируйте ее и загрузите через ReloadBase");
+    }
+    std::shared_ptr<HashBase> hash_base = current->clone();
+    hash_base->apply_delta(delta_path);
+    publish_base(std::move(hash_base), delta_path);
 }
 
 
 Scanner::~Scanner() noexcept {
     try {
-        if (log_file_.is_open()) {
-            std::lock_guard<std::mutex> lock(log_mutex_);
-            log_file_ << "=== СЕССИЯ СКАНИРОВАНИЯ ЗАВЕРШЕНА ===" << std::endl;
-            log_file_.close();
+        // Экспорт читает состояние пула, движка и конвейера - он уходит первым,
+        // сбросив итоговые метрики
+        metrics_exporter_.reset();
+        // Завершения движка пишут в лог и кэш - останавливаем его первым
+        thread_pool_.reset();
+        async_engine_.reset();
+        pipeline_.reset();
+        if (logger_) {
+            logger_->Record() << "=== СЕССИЯ СКАНИРОВАНИЯ ЗАВЕРШЕНА ===";
+            // Деструктор логгера дописывает очередь до конца
+            logger_.reset();
         }
         
     } catch (...) {
     }
 }
 
+std::unique_ptr<ScanSession> Scanner::CreateSession(ResultSink* sink) {
+    std::unique_ptr<ScanSession> session(new ScanSession(*this, sink));
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    ++active_sessions_;
+    current_session_ = session.get();
+    return session;
+}
+
 Scanner::ScanResult Scanner::Scan(const std::filesystem::path& root_path) {
-    auto start_time = std::chrono::steady_clock::now();
-    
+    return Scan(std::vector<std::filesystem::path>{root_path}, nullptr);
+}
+
+Scanner::ScanResult Scanner::Scan(const std::filesystem::path& root_path, ResultSink& sink) {
+    return Scan(std::vector<std::filesystem::path>{root_path}, &sink);
+}
+
+Scanner::ScanResult Scanner::Scan(const std::vector<std::filesystem::path>& root_paths, ResultSink* sink) {
+    auto session = CreateSession(sink);
     try {
-        if (!std::filesystem::exists(root_path)) {
-    throw std::runtime_error("Директория для сканирования не найдена: " + root_path.string());
+        for (const auto& root_path : root_paths) {
+            session->AddRoot(root_path);
         }
-        if (!std::filesystem::is_directory(root_path)) {
-            throw std::runtime_error("Указанный путь не является директорией: " + root_path.string());
-        }
-        
-        {
-            std::lock_guard<std::mutex> lock(log_mutex_);
-            log_file_ << "Начинаем сканирование директории: " << root_path << std::endl;
-            log_file_.flush();
-        }
-        
-        enqueue_scan_tasks(root_path);
-        
-        thread_pool_.reset();
-        
-        thread_pool_ = std::make_unique<ThreadPool<std::function<void()>>>(DEFAULT_THREAD_COUNT);
-        
     } catch (const std::exception& e) {
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        log_file_ << "ОШИБКА при сканировании: " << e.what() << std::endl;
+        // Уже поставленные задачи дорабатывают до выхода: они обращаются к
+        // состоянию сессии, в том числе к приемнику результатов
+        try {
+            session->Wait();
+        } catch (...) {
+        }
+        logger_->Record() << "ОШИБКА при сканировании: " << e.what();
+        logger_->Flush();
         throw;
     }
-    
-    auto end_time = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-    
-    ScanResult result{
-        .total_files = total_files_.load(),
-        .malicious_files = malicious_files_.load(), 
-        .errors = errors_.load(),
-        .duration = duration
-    };
-    
+    return session->Wait();
+}
+
+void Scanner::scan_root(ScanSession& session, const std::filesystem::path& root_path) {
+    if (!std::filesystem::exists(root_path)) {
+        throw std::runtime_error("Директория для сканирования не найдена: " + root_path.string());
+    }
+    if (!std::filesystem::is_directory(root_path)) {
+        throw std::runtime_error("Указанный путь не является директорией: " + root_path.string());
+    }
+
+    logger_->Record() << "Начинаем сканирование директории: " << root_path;
+
+    enqueue_scan_tasks(session, root_path);
+}
+
+Scanner::ScanResult Scanner::finish_session(ScanSession& session) {
+    session.tasks_.Wait();
+
+    bool last_session = false;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        last_session = --active_sessions_ == 0;
+    }
+    ScanResult result = session.GetCurrentStats();
     {
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        log_file_ << "\n=== СТАТИСТИКА СКАНИРОВАНИЯ ===" << std::endl;
-        log_file_ << "Всего файлов обработано: " << result.total_files << std::endl;
-        log_file_ << "Вредоносных файлов найдено: " << result.malicious_files << std::endl;
-        log_file_ << "Ошибок обработки: " << result.errors << std::endl;
-        log_file_ << "Время выполнения: " << duration.count() << " мс" << std::endl;
-        log_file_.flush();
-    }
-    
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        if (current_session_ == &session) {
+            current_session_ = nullptr;
+            last_result_ = result;
+        }
+    }
+
+    if (digest_cache_) {
+        digest_cache_->flush();
+        // Сжатие берет кэш целиком - откладываем до последней идущей сессии
+        if (last_session && digest_cache_->needs_compaction()) {
+            if (options_.digest_cache_prune) {
+                digest_cache_->prune();
+            } else {
+                digest_cache_->compact();
+            }
+        }
+    }
+
+    // Трасса - общая для сессий сканера, пишет ее последняя из идущих
+    std::string trace_state;
+    if (tracer_ && last_session) {
+        try {
+            const size_t spans = tracer_->Write(options_.trace_path);
+            trace_state = "Трасса записана: " + options_.trace_path + ", отрезков: " + std::to_string(spans);
+        } catch (const std::exception& e) {
+            trace_state = std::string("ОШИБКА записи трассы: ") + e.what();
+        }
+    }
+
+    {
+        std::ostringstream stats;
+        stats << "\n=== СТАТИСТИКА СКАНИРОВАНИЯ ===" << '\n';
+        stats << "Всего файлов обработано: " << result.total_files << '\n';
+        stats << "Вредоносных файлов найдено: " << result.malicious_files << '\n';
+        stats << "Ошибок обработки: " << result.errors << '\n';
+        stats << "Время выполнения: " << result.duration.count() << " мс" << '\n';
+        if (options_.use_size_filter) {
+            stats << "Пропущено по размеру: " << result.skipped_by_size << '\n';
+        }
+        if (options_.scan_archives) {
+            stats << "Членов архивов проверено: "
+                  << result.archive_members - result.archive_members_skipped
+                  << ", пропущено: " << result.archive_members_skipped << '\n';
+        }
+        if (digest_cache_) {
+            stats << "Кэш дайджестов: попаданий " << result.cache_hits
+                  << ", промахов " << result.cache_misses << '\n';
+        }
+        if (options_.use_prefilter) {
+            const size_t misses = result.prefilter_checks - std::min(result.prefilter_checks, result.malicious_files);
+            const double fp_rate = misses == 0 ? 0.0 : 100.0 * result.prefilter_false_positives / misses;
+            stats << "Ложных срабатываний префильтра: " << result.prefilter_false_positives
+                  << " (" << std::fixed << std::setprecision(3) << fp_rate << "%)" << '\n';
+        }
+        if (!trace_state.empty()) {
+            stats << trace_state << '\n';
+        }
+        logger_->Write(stats.str());
+        // Отчет сканирования должен лежать в файле к возврату из Scan
+        logger_->Flush();
+    }
+
+    if (session.results_) {
+        session.results_->Finish();
+    }
     return result;
 }
 
-void Scanner::enqueue_scan_tasks(const std::filesystem::path& root_path) {
-    try {
-        std::error_code ec;
-        
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(root_path, ec)) {
-            if (ec) {
-                errors_.fetch_add(1);
-                std::lock_guard<std::mutex> lock(log_mutex_);
-                log_file_ << "ОШИБКА при обходе директории: " << ec.message() << std::endl;
-                continue;
-            }
-            
-            if (entry.is_regular_file(ec) && !ec) {
-                auto task = [this, file_path = entry.path()]() {
-                    this->process_file(file_path);
-                };
-                
+Generator<ScanRecord> Scanner::ScanResults(std::filesystem::path root_path) {
+    ScanStream stream(*this, root_path);
+    while (auto record = stream.Next()) {
+        co_yield std::move(*record);
+    }
+    stream.Wait();
+}
+
+void Scanner::enqueue_scan_tasks(ScanSession& session, const std::filesystem::path& root_path) {
+    // Директории обходятся задачами в том же пуле; файлы директории уходят
+    // в пул одной пачкой, задача на файл хранит только имя и общий путь
+    DirectoryWalker walker(
+        [this](std::function<void()> task) {
+            if (!tracer_) {
                 thread_pool_->Add(std::move(task));
+                return;
             }
-        }
-        
-    } catch (const std::filesystem::filesystem_error& e) {
+            thread_pool_->Add([this, task = std::move(task)] {
+                ScanTracer::Scope span(tracer_->SampleDirectory() ? tracer_.get() : nullptr, "walk");
+                task();
+            });
+        },
+        [this, &session](int dir_fd, const std::filesystem::path& directory, std::vector<std::string>& names) {
+            auto shared_directory = std::make_shared<const std::filesystem::path>(directory);
+            std::vector<UniqueFunction<void()>> tasks;
+            tasks.reserve(names.size());
+            uint64_t trace_index = 0;
+            if (tracer_) {
+                ScanTracer::Scope::Annotate(directory.native());
+                trace_index = tracer_->ReserveFiles(names.size());
+            }
+            // Мелкие файлы копятся в пачку для SIMD-хеширования (batch_md5_)
+            std::vector<BatchFile> batch;
+            size_t queued_files = 0;
+            auto flush_batch = [&] {
+                if (batch.empty()) {
+                    return;
+                }
+                queued_files += batch.size();
+                tasks.emplace_back([session = &session, shared_directory, files = std::move(batch)]() {
+                    session->scanner_.process_batch(*session, *shared_directory, files);
+                });
+                batch = {};
+            };
+            for (auto& name : names) {
+                const uint64_t file_index = trace_index++;
+                struct stat st {};
+                const bool have_stat = (options_.use_size_filter || batch_md5_) &&
+                                       ::fstatat(dir_fd, name.c_str(), &st, 0) == 0;
+                // Файл, чьего размера нет в базе, не может совпасть - его даже не открываем.
+                // С проверкой архивов он открывается ради членов, но читаются
+                // только первые байты (см. scan_archive).
+                const bool size_rejected = options_.use_size_filter && have_stat &&
+                    !hash_base_.read()->may_have_size(static_cast<uint64_t>(st.st_size));
+                if (size_rejected && !options_.scan_archives) {
+                    session.skipped_by_size_.fetch_add(1, std::memory_order_relaxed);
+                    metrics_.AddSkipped(SkipReason::SizeFilter);
+                    continue;
+                }
+                if (tracer_ && tracer_->SampledFile(file_index)) {
+                    // С трассой замыкание не помещается в UniqueFunction и
+                    // уходит в кучу - только у файлов из выборки
+                    tasks.emplace_back([session = &session, shared_directory, name = std::move(name),
+                                        trace = tracer_->StartFile(file_index), size_rejected]() {
+                        session->scanner_.process_file(*session, *shared_directory / name, trace, size_rejected);
+                    });
+                    ++queued_files;
+                    continue;
+                }
+                if (batch_md5_ && have_stat && S_ISREG(st.st_mode) &&
+                    static_cast<uint64_t>(st.st_size) <= BATCH_FILE_SIZE_LIMIT) {
+                    batch.push_back(BatchFile{std::move(name), static_cast<uint64_t>(st.st_size)});
+                    if (batch.size() == BATCH_SIZE) {
+                        flush_batch();
+                    }
+                    continue;
+                }
+                if (size_rejected) {
+                    // Флаг - отдельной лямбдой: лишнее поле не влезло бы в UniqueFunction
+                    tasks.emplace_back([session = &session, shared_directory, name = std::move(name)]() {
+                        session->scanner_.process_file(*session, *shared_directory / name, {}, true);
+                    });
+                } else {
+                    tasks.emplace_back([session = &session, shared_directory, name = std::move(name)]() {
+                        session->scanner_.process_file(*session, *shared_directory / name);
+                    });
+                }
+                ++queued_files;
+            }
+            flush_batch();
+            // Add до постановки: задачи могут завершиться раньше, чем AddBatch
+            // вернется. Непринятая пачка откатывает счетчики, иначе Wait
+            // сессии ждал бы ее вечно.
+            session.tasks_.Add(tasks.size());
+            metrics_.AddQueued(static_cast<int64_t>(queued_files));
+            bool accepted = false;
+            std::string failure = "пул остановлен";
+            try {
+                accepted = thread_pool_->AddBatch(tasks);
+            } catch (const std::exception& e) {
+                failure = e.what();
+            }
+            if (!accepted) {
+                session.tasks_.Cancel(tasks.size());
+                metrics_.AddQueued(-static_cast<int64_t>(queued_files));
+                session.errors_.fetch_add(1);
+                logger_->Record() << "ОШИБКА: файлы директории не поставлены в очередь (" << queued_files
+                                  << "): " << directory << ": " << failure;
+            }
+        },
+        [this, &session](const std::filesystem::path& path, int error) {
+            session.errors_.fetch_add(1);
+            logger_->Record() << "ОШИБКА при обходе директории: " << path << ": " << std::strerror(error);
+        });
+
+    try {
+        // Корень читается в вызывающем потоке, и Walk ждет весь обход: отрезок
+        // корня покрывает обход целиком
+        ScanTracer::Scope span(tracer_ && tracer_->SampleDirectory() ? tracer_.get() : nullptr, "walk");
+        walker.Walk(root_path);
+    } catch (const std::exception& e) {
         throw std::runtime_error("Ошибка при сканировании директории " + 
                                 root_path.string() + ": " + e.what());
     }
 }
 
-void Scanner::process_file(const std::filesystem::path& file_path) {
+void Scanner::process_file(ScanSession& session, const std::filesystem::path& file_path,
+                           const FileTrace& trace, bool size_rejected) {
+    // Задача файла снимается с группы сессии на любом выходе
+    TaskGroup::Task task(session.tasks_);
+    metrics_.AddQueued(-1);
+    ScanMetrics::BusyScope busy(metrics_);
+
+    FileContext context;
+    context.started = std::chrono::steady_clock::now();
+    context.trace = trace;
     try {
-        auto hash_opt = md5_compute_->computeFileHashMD5(file_path);
+        if (context.trace.id != 0) {
+            tracer_->FileSpan("queue", context.trace, context.trace.queued, tracer_->Now());
+        }
+        // Считаем только алгоритмы, которые есть в базе, - все за одно чтение
+        unsigned algorithms = hash_base_.read()->algorithms();
+        if (algorithms == 0) {
+            algorithms = DIGEST_MD5;
+        }
+        if (options_.scan_archives) {
+            scan_archive(session, file_path, algorithms, context, size_rejected);
+            return;
+        }
+        std::optional<FileDigests> digests_opt;
+        if (digest_cache_) {
+            context.identity = DigestCache::identify(file_path);
+            if (context.identity.has_value()) {
+                digests_opt = digest_cache_->lookup(*context.identity, algorithms);
+            }
+            context.from_cache = digests_opt.has_value();
+            if (context.from_cache) {
+                metrics_.AddSkipped(SkipReason::CacheHit);
+            }
+            (digests_opt.has_value() ? session.cache_hits_ : session.cache_misses_)
+                .fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!digests_opt.has_value() && context.trace.id != 0 && (async_engine_ || pipeline_)) {
+            context.submitted = tracer_->Now();
+        }
+        if (!digests_opt.has_value() && async_engine_) {
+            // Чтение и хеширование уходят в движок, проверка - в его потоке хеширования
+            if (!async_engine_->Submit(file_path, algorithms, digest_completion(session, file_path, context))) {
+                finish_file(session, file_path, std::nullopt, context);
+            }
+            return;
+        }
+        if (!digests_opt.has_value() && pipeline_) {
+            // Дальше файл идет по стадиям конвейера, проверка - в потоке отчета
+            pipeline_->Submit(file_path, algorithms, digest_completion(session, file_path, context));
+            return;
+        }
+        if (!digests_opt.has_value()) {
+            ReadTimings timings;
+            const uint64_t digest_started = context.trace.id != 0 ? tracer_->Now() : 0;
+            digests_opt = md5_compute_->computeFileDigests(file_path, algorithms, &timings);
+            record_read_timings(timings, digests_opt.has_value());
+            if (context.trace.id != 0) {
+                trace_digest(timings, digest_started, tracer_->Now());
+            }
+            if (digests_opt.has_value() && context.identity.has_value()) {
+                digest_cache_->store(*context.identity, *digests_opt);
+            }
+        }
+        finish_file(session, file_path, digests_opt, context);
+        
+    } catch (const std::exception& e) {
+        session.errors_.fetch_add(1);
         
-        if (!hash_opt.has_value()) {
-            errors_.fetch_add(1);
+        logger_->Record() << "ИСКЛЮЧЕНИЕ при обработке файла " << file_path 
+                          << ": " << e.what();
+    } catch (...) {
+        session.errors_.fetch_add(1);
+        
+        logger_->Record() << "НЕИЗВЕСТНОЕ ИСКЛЮЧЕНИЕ при обработке файла: " << file_path;
+    }
+}
+
+void Scanner::process_batch(ScanSession& session, const std::filesystem::path& directory,
+                            const std::vector<BatchFile>& files) {
+    TaskGroup::Task task(session.tasks_);
+    metrics_.AddQueued(-static_cast<int64_t>(files.size()));
+    ScanMetrics::BusyScope busy(metrics_);
+
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(files.size());
+    for (const BatchFile& file : files) {
+        paths.push_back(directory / file.name);
+    }
+    try {
+        if (hash_base_.read()->algorithms() & ~static_cast<unsigned>(DIGEST_MD5)) {
+            // База перезагружена с другими алгоритмами - по одному файлу
+            session.tasks_.Add(paths.size());
+            metrics_.AddQueued(static_cast<int64_t>(paths.size()));
+            for (const auto& path : paths) {
+                process_file(session, path);
+            }
+            return;
+        }
+        const auto started = std::chrono::steady_clock::now();
+        const auto digests = md5_compute_->computeBatchDigestMD5(paths);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            FileContext context;
+            context.started = started;
+            context.size = files[i].size;
+            std::optional<FileDigests> file_digests;
+            if (digests[i].has_value()) {
+                file_digests.emplace();
+                file_digests->algorithms = DIGEST_MD5;
+                file_digests->md5 = *digests[i];
+                metrics_.AddBytes(files[i].size);
+            } else {
+                metrics_.AddSkipped(SkipReason::ReadFailed);
+            }
+            finish_file(session, paths[i], file_digests, context);
+        }
+    } catch (const std::exception& e) {
+        session.errors_.fetch_add(1);
+
+        logger_->Record() << "ИСКЛЮЧЕНИЕ при обработке пачки файлов в " << directory
+                          << ": " << e.what();
+    } catch (...) {
+        session.errors_.fetch_add(1);
+
+        logger_->Record() << "НЕИЗВЕСТНОЕ ИСКЛЮЧЕНИЕ при обработке пачки файлов в " << directory;
+    }
+}
+
+void Scanner::scan_archive(ScanSession& session, const std::filesystem::path& file_path,
+                           unsigned algorithms, FileContext& context, bool size_rejected) {
+    // Кэш хранит только не-архивы: попадание значит, что содержимое уже
+    // хешировано, и файл читается лишь до распознавания формата
+    std::optional<FileDigests> cached;
+    if (digest_cache_ && !size_rejected) {
+        context.identity = DigestCache::identify(file_path);
+        if (context.identity.has_value()) {
+            cached = digest_cache_->lookup(*context.identity, algorithms);
+        }
+    }
+    const bool archives_only = size_rejected || cached.has_value();
+    const ArchiveReader reader(options_.archives, algorithms, md5_compute_->options().buffer_size);
+    ReadTimings timings;
+    const uint64_t digest_started = context.trace.id != 0 ? tracer_->Now() : 0;
+    const ArchiveScanResult result = reader.ScanFile(file_path, [&](const ArchiveMember& member) {
+        session.archive_members_.fetch_add(1, std::memory_order_relaxed);
+        std::filesystem::path member_path = file_path.native() + "!" + member.path;
+        if (!member.error.empty()) {
+            session.errors_.fetch_add(1);
+            logger_->Record() << "ОШИБКА во вложенном архиве " << member_path << ": " << member.error;
+        }
+        if (!member.digests.has_value()) {
+            session.archive_members_skipped_.fetch_add(1, std::memory_order_relaxed);
+            logger_->Record() << "Член архива пропущен (" << member.skip_reason << "): " << member_path;
+            return;
+        }
+        if (options_.use_size_filter && !hash_base_.read()->may_have_size(member.size)) {
+            session.skipped_by_size_.fetch_add(1, std::memory_order_relaxed);
+            metrics_.AddSkipped(SkipReason::SizeFilter);
+            return;
+        }
+        FileContext member_context;
+        member_context.started = std::chrono::steady_clock::now();
+        member_context.size = member.size;
+        finish_file(session, member_path, member.digests, member_context);
+    }, &timings, archives_only);
+    const bool not_archive = result.format == ArchiveFormat::None;
+    record_read_timings(timings, result.digests.has_value() || (archives_only && not_archive));
+    if (context.trace.id != 0) {
+        trace_digest(timings, digest_started, tracer_->Now());
+    }
+    if (!result.error.empty()) {
+        session.errors_.fetch_add(1);
+        logger_->Record() << "ОШИБКА в архиве " << file_path << " (проверено членов: "
+                          << result.members << "): " << result.error;
+    }
+    if (not_archive && size_rejected) {
+        session.skipped_by_size_.fetch_add(1, std::memory_order_relaxed);
+        metrics_.AddSkipped(SkipReason::SizeFilter);
+        if (context.trace.id != 0) {
+            tracer_->FileSpan("file", context.trace, context.trace.queued, tracer_->Now(), file_path.native());
+        }
+        return;
+    }
+    if (digest_cache_ && !size_rejected) {
+        // Архив каждый раз читается заново ради членов - для кэша это промах
+        context.from_cache = not_archive && cached.has_value();
+        if (context.from_cache) {
+            metrics_.AddSkipped(SkipReason::CacheHit);
+        }
+        (context.from_cache ? session.cache_hits_ : session.cache_misses_)
+            .fetch_add(1, std::memory_order_relaxed);
+    }
+    if (context.from_cache) {
+        finish_file(session, file_path, cached, context);
+        return;
+    }
+    if (not_archive && result.digests.has_value() && context.identity.has_value()) {
+        digest_cache_->store(*context.identity, *result.digests);
+    }
+    finish_file(session, file_path, result.digests, context);
+}
+
+UniqueFunction<void(std::optional<FileDigests>)> Scanner::digest_completion(
+    ScanSession& session, const std::filesystem::path& file_path, const FileContext& context) {
+    // Завершение держит сессию открытой, пока его не вызовут или не уничтожат
+    // (движок не смог открыть файл, конвейер остановлен)
+    session.tasks_.Add();
+    return [this, &session, file_path, context,
+            task = TaskGroup::Task(session.tasks_)](std::optional<FileDigests> digests) mutable {
+        const TaskGroup::Task finished = std::move(task);
+        if (context.trace.id != 0) {
+            // Очередь движка или конвейера, чтение и хеширование - одним отрезком
+            tracer_->FileSpan("digest", context.trace, context.submitted, tracer_->Now());
+        }
+        if (digests.has_value() && context.identity.has_value()) {
+            digest_cache_->store(*context.identity, *digests);
+        }
+        finish_file(session, file_path, digests, context);
+    };
+}
+
+void Scanner::finish_file(ScanSession& session,
+                          const std::filesystem::path& file_path,
+                          const std::optional<FileDigests>& digests_opt,
+                          const FileContext& context) {
+    try {
+        if (!digests_opt.has_value()) {
+            session.errors_.fetch_add(1);
             
-            std::lock_guard<std::mutex> lock(log_mutex_);
-            log_file_ << "ОШИБКА: не удалось вычислить MD5 для файла: " << file_path << std::endl;
+            logger_->Record() << "ОШИБКА: не удалось вычислить хеш для файла: " << file_path;
+            if (context.trace.id != 0) {
+                tracer_->FileSpan("file", context.trace, context.trace.queued, tracer_->Now(), file_path.native());
+            }
             return;
         }
         
-        std::string hash = hash_opt.value();
-        
-        const std::string* verdict = hash_base_->get_verdict(hash);
+        const uint64_t trace_lookup = context.trace.id != 0 ? tracer_->Now() : 0;
+        const auto lookup_started = std::chrono::steady_clock::now();
+        // Вердикт копируется, и снимок базы отпускается до журнала и отчета:
+        // они ждут места в очередях, а publish ждет ушедших читателей
+        std::optional<std::string> verdict_copy;
+        DigestAlgorithm matched = DIGEST_MD5;
+        {
+            auto hash_base = hash_base_.read();
+            const std::string* found = nullptr;
+            if (options_.use_prefilter) {
+                session.prefilter_checks_.fetch_add(1, std::memory_order_relaxed);
+                if (hash_base->may_contain(*digests_opt)) {
+                    found = hash_base->get_verdict(*digests_opt, &matched);
+                    if (found == nullptr) {
+                        session.prefilter_false_positives_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            } else {
+                found = hash_base->get_verdict(*digests_opt, &matched);
+            }
+            if (found != nullptr) {
+                verdict_copy = *found;
+            }
+        }
+        const std::string* verdict = verdict_copy ? &*verdict_copy : nullptr;
+        metrics_.Record(ScanStage::Lookup, std::chrono::steady_clock::now() - lookup_started);
+        metrics_.AddFile();
+        const uint64_t trace_log = context.trace.id != 0 ? tracer_->Now() : 0;
+        if (context.trace.id != 0) {
+            tracer_->Span("lookup", trace_lookup, trace_log);
+        }
         
         if (verdict != nullptr) {
-            malicious_files_.fetch_add(1);
-            log_malicious_file(file_path, hash, *verdict);
+            session.malicious_files_.fetch_add(1);
+            std::string hash;
+            switch (matched) {
+                case DIGEST_MD5: hash = digest_to_hex(digests_opt->md5); break;
+                case DIGEST_SHA1: hash = digest_to_hex(digests_opt->sha1); break;
+                case DIGEST_SHA256: hash = digest_to_hex(digests_opt->sha256); break;
+            }
+            log_malicious_file(file_path, matched, hash, *verdict);
+        }
+        if (session.results_ && (verdict != nullptr || options_.report_clean_files)) {
+            report_result(session, file_path, *digests_opt, context, verdict, matched);
+        }
+        if (context.trace.id != 0) {
+            const uint64_t finished = tracer_->Now();
+            tracer_->Span("log", trace_log, finished);
+            tracer_->FileSpan("file", context.trace, context.trace.queued, finished, file_path.native());
         }
         
-        total_files_.fetch_add(1);
+        session.total_files_.fetch_add(1);
         
     } catch (const std::exception& e) {
-        errors_.fetch_add(1);
+        session.errors_.fetch_add(1);
         
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        log_file_ << "ИСКЛЮЧЕНИЕ при обработке файла " << file_path 
-                 << ": " << e.what() << std::endl;
+        logger_->Record() << "ИСКЛЮЧЕНИЕ при обработке файла " << file_path 
+                          << ": " << e.what();
     } catch (...) {
-        errors_.fetch_add(1);
+        session.errors_.fetch_add(1);
         
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        log_file_ << "НЕИЗВЕСТНОЕ ИСКЛЮЧЕНИЕ при обработке файла: " << file_path << std::endl;
+        logger_->Record() << "НЕИЗВЕСТНОЕ ИСКЛЮЧЕНИЕ при обработке файла: " << file_path;
+    }
+}
+
+void Scanner::report_result(ScanSession& session,
+                            const std::filesystem::path& file_path,
+                            const FileDigests& digests,
+                            const FileContext& context,
+                            const std::string* verdict,
+                            DigestAlgorithm matched) {
+    ScanRecord record;
+    record.path = file_path;
+    record.digests = digests;
+    record.from_cache = context.from_cache;
+    record.hash_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - context.started);
+    if (context.size.has_value()) {
+        record.size = *context.size;
+    } else if (context.identity.has_value()) {
+        record.size = context.identity->size;
+    } else {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(file_path, ec);
+        record.size = ec ? 0 : static_cast<uint64_t>(size);
     }
+    if (verdict != nullptr) {
+        record.malicious = true;
+        record.algorithm = matched;
+        record.verdict = *verdict;
+    }
+    session.results_->Push(std::move(record));
 }
 
 void Scanner::log_malicious_file(const std::filesystem::path& file_path, 
+                                 DigestAlgorithm algorithm,
                                  const std::string& hash, 
                                  const std::string& verdict) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    
-    log_file_ << " ВРЕДОНОСНЫЙ ФАЙЛ ОБНАРУЖЕН:" << std::endl;
-    log_file_ << "   Путь: " << file_path << std::endl;
-    log_file_ << "   MD5:  " << hash << std::endl;
-    log_file_ << "   Тип:  " << verdict << std::endl;
-    log_file_ << "   ---" << std::endl;
-    
-    log_file_.flush();
+    // Одна запись на находку: строки разных потоков не перемешиваются
+    logger_->Record() << " ВРЕДОНОСНЫЙ ФАЙЛ ОБНАРУЖЕН:\n"
+                      << "   Путь: " << file_path << '\n'
+                      << "   " << digest_algorithm_name(algorithm) << ":  " << hash << '\n'
+                      << "   Тип:  " << verdict << '\n'
+                      << "   ---";
+}
+
+void Scanner::record_read_timings(const ReadTimings& timings, bool succeeded) noexcept {
+    metrics_.Record(ScanStage::Open, timings.open);
+    if (!timings.opened) {
+        metrics_.AddSkipped(SkipReason::OpenFailed);
+        return;
+    }
+    if (!succeeded) {
+        metrics_.AddSkipped(SkipReason::ReadFailed);
+        return;
+    }
+    metrics_.Record(ScanStage::Read, timings.read);
+    metrics_.Record(ScanStage::Hash, timings.hash);
+    metrics_.AddBytes(timings.bytes);
+}
+
+void Scanner::trace_digest(const ReadTimings& timings, uint64_t started, uint64_t finished) {
+    // Чтение и хеширование чередуются по кускам файла: внутри digest отрезки
+    // open, read и hash идут подряд, каждый длиной в сумму своих кусков
+    tracer_->Span("digest", started, finished);
+    uint64_t at = started;
+    const std::pair<const char*, std::chrono::nanoseconds> parts[] = {
+        {"open", timings.open}, {"read", timings.read}, {"hash", timings.hash}};
+    for (const auto& [name, duration] : parts) {
+        const uint64_t end = at + static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+        tracer_->Span(name, at, std::min(end, finished));
+        at = std::min(end, finished);
+    }
+}
+
+MetricsSnapshot Scanner::GetMetrics() const {
+    MetricsSnapshot snapshot = metrics_.Snapshot();
+    if (thread_pool_) {
+        snapshot.worker_threads = thread_pool_->thread_count();
+        snapshot.pool = thread_pool_->Stats();
+    }
+    if (pipeline_) {
+        snapshot.pipeline_queue_depth = pipeline_->queue_depths();
+    }
+    if (async_engine_) {
+        snapshot.io_in_flight = async_engine_->in_flight();
+    }
+    return snapshot;
 }
 
 Scanner::ScanResult Scanner::GetCurrentStats() const noexcept {
-    return ScanResult{
-        .total_files = total_files_.load(),
-        .malicious_files = malicious_files_.load(),
-        .errors = errors_.load(),
-        .duration = std::chrono::milliseconds(0)
-    };
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    return current_session_ != nullptr ? current_session_->GetCurrentStats() : last_result_;
 }
@@ -16,45 +16,214 @@
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <vector>
 #include "ThreadPool.h"
+#include "UniqueFunction.h"
+#include "SnapshotPtr.h"
 #include "HashBase.h"
 #include "MD5Compute.h"
+#include "DigestCache.h"
+#include "ScanPipeline.h"
+#include "ResultDispatcher.h"
+#include "ResultSink.h"
+#include "Generator.h"
+#include "ScanMetrics.h"
+#include "MetricsExporter.h"
+#include "ScanTracer.h"
+#include "ArchiveReader.h"
 
+class AsyncDigestEngine;
+class AsyncLogger;
+class ScanSession;
+
+struct ScannerOptions {
+  bool use_prefilter = false;
+  size_t prefilter_bits_per_key = BloomFilter::DEFAULT_BITS_PER_KEY;
+  // Пропускать файлы, чьего размера нет в базе (нужен размер у всех записей)
+  bool use_size_filter = false;
+  // Кэш дайджестов между запусками; пустой путь - без кэша
+  std::string digest_cache_path;
+  std::chrono::nanoseconds digest_cache_racy_window = DigestCache::DEFAULT_RACY_WINDOW;
+  // Сжатие кэша удаляет записи файлов, не встреченных с его открытия или
+  // прошлого сжатия (DigestCache::prune). Только если каждое сканирование
+  // обходит все файлы кэша, иначе пропадут записи других деревьев.
+  bool digest_cache_prune = false;
+  ReadOptions read_options;
+  // Емкость общей очереди задач пула: ограничивает память, пока обход
+  // директорий опережает хеширование
+  size_t task_queue_capacity = ThreadPool<UniqueFunction<void()>>::DEFAULT_QUEUE_CAPACITY;
+  // Конвейер: пул сканера только обходит директории, файлы читают, хешируют
+  // и проверяют отдельные стадии со своими потоками и очередями. С io_uring
+  // не сочетается - там чтение и хеширование уже разделены движком.
+  bool use_pipeline = false;
+  PipelineOptions pipeline;
+  // Отдавать приемнику результатов и чистые файлы, а не только находки
+  bool report_clean_files = false;
+  // Очередь между потоками сканирования и приемником результатов
+  size_t result_queue_capacity = ResultDispatcher::DEFAULT_CAPACITY;
+  // Периодический сброс метрик (GetMetrics) в файл; пустой путь - без сброса
+  std::string metrics_path;
+  MetricsFormat metrics_format = MetricsFormat::Prometheus;
+  std::chrono::milliseconds metrics_interval = MetricsExporter::DEFAULT_INTERVAL;
+  // Трасса по файлам и стадиям (Chrome trace JSON), переписывается в конце
+  // каждого сканирования; пустой путь - без трассы
+  std::string trace_path;
+  // Доля трассируемых файлов и директорий, (0, 1]
+  double trace_sample_rate = 1.0;
+  // Проверять и члены архивов (tar, tar.gz, gzip, zip) - потоково, без
+  // распаковки на диск; находки идут с путями вида "архив!член". Каждый
+  // файл открывается один раз и читается в потоке пула мимо движка и
+  // конвейера: архив распознается по первому буферу, не-архив хешируется
+  // тем же проходом. Кэш дайджестов - только для не-архивов.
+  bool scan_archives = false;
+  ArchiveOptions archives;
+  // Мелкие файлы директории хешируются пачками по SIMD-полосам
+  // (MD5Compute::computeBatchDigestMD5). Только когда в базе один MD5 и нет
+  // кэша, конвейера, io_uring и проверки архивов; без векторного ядра
+  // выключено. Стадии open/read/hash у таких файлов в метрики не пишутся.
+  bool batch_small_files = false;
+  // ApplyBaseDelta копирует базу в кучу, и образ compile_base после этого
+  // занимает память заново вместо общего отображения. Образ больше этого
+  // дельтой не обновляется: нужен ReloadBase с перекомпилированным образом.
+  uint64_t max_delta_image_bytes = 512ull << 20;
+};
 
 class DLL_EXPORT Scanner {
 private:
-  std::unique_ptr<HashBase> hash_base_;         
+  // Раньше всех, кто в него пишет: движок и конвейер держат указатель
+  ScanMetrics metrics_;
+  SnapshotPtr<HashBase> hash_base_;
+  std::mutex reload_mutex_;
   std::unique_ptr<MD5Compute> md5_compute_; 
-  std::unique_ptr<ThreadPool<std::function<void()>>> thread_pool_; 
+  std::unique_ptr<DigestCache> digest_cache_;
+  // Живет столько же, сколько сканер, и общий для всех сессий
+  std::unique_ptr<ThreadPool<UniqueFunction<void()>>> thread_pool_; 
+  // Только при ReadStrategy::IoUring и доступном io_uring
+  std::unique_ptr<AsyncDigestEngine> async_engine_;
+  // Только при use_pipeline: чтение, хеширование и проверка - отдельные стадии
+  std::unique_ptr<ScanPipeline> pipeline_;
+  // batch_small_files с учетом режима чтения и ядра MD5
+  bool batch_md5_ = false;
 private:
-  std::ofstream log_file_;                
+  ScannerOptions options_;
+  // Записи ставятся в очередь, в файл их пишет поток логгера
+  std::unique_ptr<AsyncLogger> logger_;
+  std::unique_ptr<MetricsExporter> metrics_exporter_;
+  std::unique_ptr<ScanTracer> tracer_;
 private:
-  std::atomic<size_t> total_files_{0};   
-  std::atomic<size_t> malicious_files_{0};      
-  std::atomic<size_t> errors_{0};   
-  mutable std::mutex log_mutex_;     
+  // Идущие сессии; GetCurrentStats показывает последнюю начатую
+  mutable std::mutex sessions_mutex_;
+  size_t active_sessions_ = 0;
+  const ScanSession* current_session_ = nullptr;
 private:
   static constexpr size_t DEFAULT_THREAD_COUNT = 4;
+  // Пачка - полосы самого широкого ядра; файлы крупнее идут по одному
+  static constexpr size_t BATCH_SIZE = 16;
+  static constexpr uint64_t BATCH_FILE_SIZE_LIMIT = 256 << 10;
+
+private:
+    // Что известно о файле до дайджестов; путешествует вместе с задачей
+    struct FileContext {
+        std::chrono::steady_clock::time_point started;
+        std::optional<FileIdentity> identity;
+        bool from_cache = false;
+        FileTrace trace;
+        // Передача в движок или конвейер, по часам трассы
+        uint64_t submitted = 0;
+        // Размер члена архива: по его пути файла нет
+        std::optional<uint64_t> size;
+    };
+
+    struct BatchFile {
+        std::string name;
+        uint64_t size;
+    };
 
 private:
-    void process_file(const std::filesystem::path& file_path);
-    void enqueue_scan_tasks(const std::filesystem::path& root_path);
+    friend class ScanSession;
+
+    // size_rejected - размера файла нет в базе, он нужен только ради членов архива
+    void process_file(ScanSession& session, const std::filesystem::path& file_path,
+                      const FileTrace& trace = {}, bool size_rejected = false);
+    void process_batch(ScanSession& session, const std::filesystem::path& directory,
+                       const std::vector<BatchFile>& files);
+    void scan_archive(ScanSession& session, const std::filesystem::path& file_path,
+                      unsigned algorithms, FileContext& context, bool size_rejected);
+    UniqueFunction<void(std::optional<FileDigests>)> digest_completion(
+        ScanSession& session, const std::filesystem::path& file_path, const FileContext& context);
+    void finish_file(ScanSession& session, const std::filesystem::path& file_path,
+                     const std::optional<FileDigests>& digests_opt, const FileContext& context);
+    void report_result(ScanSession& session,
+                       const std::filesystem::path& file_path,
+                       const FileDigests& digests,
+                       const FileContext& context,
+                       const std::string* verdict,
+                       DigestAlgorithm matched);
+    void scan_root(ScanSession& session, const std::filesystem::path& root_path);
+    void enqueue_scan_tasks(ScanSession& session, const std::filesystem::path& root_path);
+    void log_base_warnings(std::ostream& out, const HashBase& hash_base);
+    void log_size_filter_state(std::ostream& out, const HashBase& hash_base);
+    void publish_base(std::shared_ptr<HashBase> hash_base, const std::string& source);
+    void record_read_timings(const ReadTimings& timings, bool succeeded) noexcept;
+    void trace_digest(const ReadTimings& timings, uint64_t started, uint64_t finished);
     void log_malicious_file(const std::filesystem::path& file_path, 
+                           DigestAlgorithm algorithm,
                            const std::string& hash, 
                            const std::string& verdict);
 
 public:
   explicit Scanner(const std::string& csv_path, 
                      const std::string& log_path,
-                     size_t thread_count = DEFAULT_THREAD_COUNT);
+                     size_t thread_count = DEFAULT_THREAD_COUNT,
+                     const ScannerOptions& options = ScannerOptions{});
     ~Scanner() noexcept;
   struct ScanResult {
     size_t total_files;          
     size_t malicious_files;
     size_t errors; 
     std::chrono::milliseconds duration;
+    size_t prefilter_checks = 0;
+    size_t prefilter_false_positives = 0;
+    size_t skipped_by_size = 0;
+    size_t cache_hits = 0;
+    size_t cache_misses = 0;
+    // Члены архивов, уже вошедшие в total_files, и пропущенные по лимиту,
+    // шифрованию или методу сжатия
+    size_t archive_members = 0;
+    size_t archive_members_skipped = 0;
     };
     
+  // Сессия для нескольких корней или сканирования параллельно с другими
+  // сессиями; sink, если задан, должен пережить сессию
+  std::unique_ptr<ScanSession> CreateSession(ResultSink* sink = nullptr);
+
   ScanResult Scan(const std::filesystem::path& root_path);
+  // То же, но каждая находка (и чистый файл при report_clean_files) уходит
+  // в sink пачками по ходу сканирования, из отдельного потока доставки
+  ScanResult Scan(const std::filesystem::path& root_path, ResultSink& sink);
+  // Несколько корней одной сессией: общая статистика и общий sink
+  ScanResult Scan(const std::vector<std::filesystem::path>& root_paths, ResultSink* sink = nullptr);
+  // Результаты по одному через co_yield; сканирование идет в фоне и ждет,
+  // пока потребитель не заберет записи (см. ScanStream)
+  Generator<ScanRecord> ScanResults(std::filesystem::path root_path);
+  // Статистика последней начатой сессии: по ходу сканирования - текущая,
+  // после него - итоговая
   ScanResult GetCurrentStats() const noexcept;
+  // Счетчики, скорости, очереди и гистограммы задержек по стадиям за все
+  // время жизни сканера; собираются из счетчиков потоков при вызове
+  MetricsSnapshot GetMetrics() const;
+
+  // Новая база собирается в вызывающем потоке и публикуется атомарно;
+  // идущее сканирование не останавливается, начатые проверки файлов
+  // завершаются на старом снимке.
+  void ReloadBase(const std::string& path);
+  // Дельта применяется к копии текущей базы; для образа больше
+  // max_delta_image_bytes - std::runtime_error, база не меняется
+  void ApplyBaseDelta(const std::string& delta_path);
+
+private:
+    // Итог последней завершенной сессии, пока не началась следующая
+    ScanResult last_result_{};
+private:
+    ScanResult finish_session(ScanSession& session);
 };
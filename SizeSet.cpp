@@ -0,0 +1,72 @@
+#include "SizeSet.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+SizeSet::SizeSet(const SizeSet& other)
+    : owned_(other.sizes_, other.sizes_ + other.count_),
+      sizes_(owned_.empty() ? nullptr : owned_.data()),
+      count_(other.count_) {}
+
+SizeSet& SizeSet::operator=(const SizeSet& other) {
+    if (this != &other) {
+        SizeSet copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+void SizeSet::materialize() {
+    if (sizes_ != nullptr && sizes_ != owned_.data()) {
+        owned_.assign(sizes_, sizes_ + count_);
+    }
+}
+
+void SizeSet::insert(uint64_t size) {
+    materialize();
+    const auto it = std::lower_bound(owned_.begin(), owned_.end(), size);
+    if (it == owned_.end() || *it != size) {
+        owned_.insert(it, size);
+    }
+    sizes_ = owned_.data();
+    count_ = owned_.size();
+}
+
+void SizeSet::insert(std::vector<uint64_t>& values) {
+    if (values.empty()) {
+        return;
+    }
+    materialize();
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    std::vector<uint64_t> merged;
+    merged.reserve(owned_.size() + values.size());
+    std::set_union(owned_.begin(), owned_.end(), values.begin(), values.end(), std::back_inserter(merged));
+    owned_ = std::move(merged);
+    sizes_ = owned_.data();
+    count_ = owned_.size();
+}
+
+bool SizeSet::contains(uint64_t size) const noexcept {
+    return std::binary_search(sizes_, sizes_ + count_, size);
+}
+
+bool SizeSet::attach(const uint64_t* sizes, size_t count) noexcept {
+    if (sizes == nullptr || count == 0 || !std::is_sorted(sizes, sizes + count)) {
+        return false;
+    }
+    owned_.clear();
+    owned_.shrink_to_fit();
+    sizes_ = sizes;
+    count_ = count;
+    return true;
+}
+
+void SizeSet::clear() noexcept {
+    owned_.clear();
+    owned_.shrink_to_fit();
+    sizes_ = nullptr;
+    count_ = 0;
+}
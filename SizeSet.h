@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Множество размеров файлов из базы: отсортированный массив uint64 без
+// повторов, поиск - бинарный. Как и BloomFilter, может ссылаться на
+// секцию скомпилированной базы (attach); вставка сначала копирует данные.
+class DLL_EXPORT SizeSet {
+private:
+    std::vector<uint64_t> owned_;
+    const uint64_t* sizes_ = nullptr;
+    size_t count_ = 0;
+private:
+    void materialize();
+public:
+    SizeSet() = default;
+    SizeSet(const SizeSet& other);
+    SizeSet& operator=(const SizeSet& other);
+    SizeSet(SizeSet&&) noexcept = default;
+    SizeSet& operator=(SizeSet&&) noexcept = default;
+
+    void insert(uint64_t size);
+    // Пакетная вставка: values сортируется и сливается с текущим набором
+    void insert(std::vector<uint64_t>& values);
+    bool contains(uint64_t size) const noexcept;
+    bool attach(const uint64_t* sizes, size_t count) noexcept;
+    void clear() noexcept;
+
+    bool empty() const noexcept { return count_ == 0; }
+    const uint64_t* data() const noexcept { return sizes_; }
+    size_t count() const noexcept { return count_; }
+    size_t size_bytes() const noexcept { return count_ * sizeof(uint64_t); }
+};
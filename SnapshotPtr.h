@@ -0,0 +1,146 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Указатель на неизменяемый снимок с RCU-подобной публикацией.
+// Читатель (read) не берет блокировок: отмечается в счетчике своей эпохи
+// и читает текущий указатель. Писатель (publish) подменяет указатель,
+// переключает эпоху и ждет, пока уйдут читатели прошлой эпохи, после чего
+// старый снимок освобождается. Счетчики разнесены по кэш-линиям, чтобы
+// рабочие потоки не конкурировали за одну линию. Писатель недолго крутится
+// на счетчике, а затем засыпает на нем (atomic::wait); последний уходящий
+// читатель будит его.
+template<typename T>
+class DLL_EXPORT SnapshotPtr {
+private:
+    static constexpr size_t SLOT_COUNT = 16;
+    static constexpr size_t SPIN_ROUNDS = 64;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<size_t> count{0};
+    };
+
+    std::atomic<const T*> current_{nullptr};
+    std::shared_ptr<const T> owner_;
+    std::atomic<unsigned> epoch_{0};
+    ReaderSlot readers_[2][SLOT_COUNT];
+    mutable std::mutex writer_mutex_;
+
+private:
+    static size_t thread_slot() noexcept;
+    static void leave(std::atomic<size_t>& counter) noexcept;
+    static void cpu_relax() noexcept;
+    void wait_for_readers(unsigned parity) const noexcept;
+
+public:
+    class ReadGuard {
+    private:
+        const T* ptr_;
+        std::atomic<size_t>* counter_;
+    public:
+        ReadGuard(const T* ptr, std::atomic<size_t>* counter) noexcept : ptr_(ptr), counter_(counter) {}
+        ~ReadGuard() noexcept { leave(*counter_); }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const T* get() const noexcept { return ptr_; }
+        const T* operator->() const noexcept { return ptr_; }
+        const T& operator*() const noexcept { return *ptr_; }
+        explicit operator bool() const noexcept { return ptr_ != nullptr; }
+    };
+
+    SnapshotPtr() = default;
+    explicit SnapshotPtr(std::shared_ptr<const T> initial) { publish(std::move(initial)); }
+    SnapshotPtr(const SnapshotPtr&) = delete;
+    SnapshotPtr& operator=(const SnapshotPtr&) = delete;
+
+    ReadGuard read() noexcept;
+    std::shared_ptr<const T> snapshot() const;
+    void publish(std::shared_ptr<const T> next);
+};
+
+template<typename T>
+size_t SnapshotPtr<T>::thread_slot() noexcept {
+    static std::atomic<size_t> next_slot{0};
+    thread_local const size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % SLOT_COUNT;
+    return slot;
+}
+
+template<typename T>
+void SnapshotPtr<T>::leave(std::atomic<size_t>& counter) noexcept {
+    // Без ждущих notify_all не делает системного вызова
+    if (counter.fetch_sub(1) == 1) {
+        counter.notify_all();
+    }
+}
+
+template<typename T>
+void SnapshotPtr<T>::cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+template<typename T>
+typename SnapshotPtr<T>::ReadGuard SnapshotPtr<T>::read() noexcept {
+    // Все операции seq_cst: если писатель увидел нулевой счетчик до нашего
+    // инкремента, то и новый указатель он опубликовал раньше нашего чтения.
+    // Эпоха перечитывается после инкремента: читатель, застрявший между
+    // чтением эпохи и инкрементом, иначе отметился бы в счетчике, которого
+    // уже никто не ждет, и следующая публикация освободила бы его снимок.
+    const size_t slot = thread_slot();
+    for (;;) {
+        const unsigned epoch = epoch_.load();
+        auto& counter = readers_[epoch & 1][slot].count;
+        counter.fetch_add(1);
+        if (epoch_.load() == epoch) {
+            return ReadGuard(current_.load(), &counter);
+        }
+        leave(counter);
+    }
+}
+
+template<typename T>
+std::shared_ptr<const T> SnapshotPtr<T>::snapshot() const {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    return owner_;
+}
+
+template<typename T>
+void SnapshotPtr<T>::wait_for_readers(unsigned parity) const noexcept {
+    for (const auto& slot : readers_[parity]) {
+        size_t count = slot.count.load();
+        for (size_t spin = 0; count != 0 && spin < SPIN_ROUNDS; ++spin) {
+            cpu_relax();
+            count = slot.count.load();
+        }
+        // Медленный читатель (например, ждущий места в очереди результатов)
+        // не держит ядро писателя: тот спит до смены счетчика
+        while (count != 0) {
+            slot.count.wait(count);
+            count = slot.count.load();
+        }
+    }
+}
+
+template<typename T>
+void SnapshotPtr<T>::publish(std::shared_ptr<const T> next) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    current_.store(next.get());
+    const unsigned old_parity = epoch_.fetch_add(1) & 1;
+    wait_for_readers(old_parity);
+    owner_ = std::move(next);
+}
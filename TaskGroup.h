@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Барьер завершения для группы задач в общем пуле: Add до постановки
+// задачи, Done в ее конце, Wait ждет, пока счетчик не обнулится. В отличие
+// от std::latch счетчик можно наращивать по ходу - задачи группы порождают
+// новые. Пул при этом не останавливается и может обслуживать другие группы.
+class DLL_EXPORT TaskGroup {
+private:
+    std::atomic<size_t> pending_{0};
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Add(size_t count = 1) noexcept {
+        pending_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Откат Add для задач, которые так и не попали в пул (постановка
+    // бросила исключение или пул останавливается)
+    void Cancel(size_t count) noexcept {
+        if (count != 0 && pending_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            pending_.notify_all();
+        }
+    }
+
+    // Последний Done будит ждущих через atomic::notify_all, как std::latch:
+    // группу можно уничтожить сразу после Wait, пока Done еще не вернулся
+    void Done() noexcept {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pending_.notify_all();
+        }
+    }
+
+    // Нельзя вызывать из задачи этой же группы - дождется сама себя
+    void Wait() const noexcept {
+        size_t pending = pending_.load(std::memory_order_acquire);
+        while (pending != 0) {
+            pending_.wait(pending, std::memory_order_acquire);
+            pending = pending_.load(std::memory_order_acquire);
+        }
+    }
+
+    // Одна уже учтенная через Add задача группы: Done в деструкторе, в том
+    // числе если задачу уничтожили, так и не выполнив
+    class Task {
+    private:
+        TaskGroup* group_;
+    public:
+        explicit Task(TaskGroup& group) noexcept : group_(&group) {}
+        Task(Task&& other) noexcept : group_(std::exchange(other.group_, nullptr)) {}
+        Task& operator=(Task&&) = delete;
+        ~Task() {
+            if (group_ != nullptr) {
+                group_->Done();
+            }
+        }
+    };
+
+    size_t Pending() const noexcept { return pending_.load(std::memory_order_relaxed); }
+};
@@ -8,7 +8,17 @@
 #  endif
 #endif
 
-#include "BlockQueue.h"
+#include "Instrumentation.h"
+#include "RingBlockQueue.h"
+#include "WorkStealingDeque.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
 #include <vector>
 #include <thread>
 #include <functional>
@@ -16,69 +26,355 @@
 
 
 
+// Пул с перехватом работы: у каждого потока свой дек Chase-Lev, задачи от
+// внешних потоков идут в общую очередь. Поток без работы сначала крадет у
+// соседей, недолго крутится и только потом засыпает. Деструктор дожидается
+// всех задач, в том числе добавленных самими задачами.
+// Очереди ограничены: внешний Add ждет места в общей очереди, а поток пула,
+// у которого заполнены и дек, и общая очередь, выполняет задачу сам. Так
+// быстрый производитель (обход директорий) не раздувает память задачами.
+// Единица очереди - пачка задач в одном блоке памяти: Add кладет пачку из
+// одной задачи, AddBatch - сразу много за одну операцию с очередью.
 template<typename Task>
 class DLL_EXPORT ThreadPool {
 private:
-    BlockQueue<Task> tasks_;
+    // Заголовок блока, задачи лежат сразу за ним. Задачи разбираются по
+    // одной через next; взявший пачку поток оставляет ссылку на нее в своем
+    // деке, чтобы остаток могли украсть соседи. Блок освобождает последний
+    // из держателей ссылок.
+    struct Batch {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> refs{1};
+        size_t count = 0;
+        Task* tasks() noexcept {
+            return std::launder(reinterpret_cast<Task*>(reinterpret_cast<unsigned char*>(this) + TASKS_OFFSET));
+        }
+    };
+    static constexpr size_t TASKS_OFFSET = (sizeof(Batch) + alignof(Task) - 1) / alignof(Task) * alignof(Task);
+    static_assert(alignof(Task) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "ThreadPool: overaligned Task");
+
+    struct Worker {
+        WorkStealingDeque<Batch> deque;
+        // Пишет только сам поток; пусты без инструментирования
+        [[no_unique_address]] instrumentation::WorkerCounters counters;
+    };
+    // Поток пула, в котором идет выполнение (nullptr - внешний поток)
+    struct WorkerContext {
+        ThreadPool* pool = nullptr;
+        size_t index = 0;
+        uint64_t rng = 0;
+    };
+    static inline thread_local WorkerContext context_;
+private:
+    static constexpr size_t SPIN_ROUNDS = 64;
+private:
+    std::vector<std::unique_ptr<Worker>> queues_;
+    RingBlockQueue<Batch*> injection_;
     std::vector<std::thread> workers_;
-    void worker_loop();
-    
+    // Ссылки на пачки, которые положены в очереди, но еще никем не взяты
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> sleeping_{0};
+    std::atomic<uint64_t> wake_epoch_{0};
+    std::atomic<bool> stopping_{false};
+    // Исключения задач пул глотает, но считает - всегда, это не горячий путь
+    std::atomic<uint64_t> swallowed_exceptions_{0};
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    void worker_loop(size_t index);
+    Batch* find_task(size_t index);
+    void submit(Batch* batch);
+    bool push_local(Batch* batch);
+    void run(Batch* batch) noexcept;
+    void wake_one();
+    void stop() noexcept;
+    template<typename Fill>
+    static Batch* make_batch(size_t count, Fill&& fill);
+    static void release(Batch* batch) noexcept;
+    static void cpu_relax() noexcept;
+
 public:
-    explicit ThreadPool(size_t count_thread);
+    // Емкость общей очереди - в пачках
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = RingBlockQueue<Batch*>::DEFAULT_CAPACITY;
+
+    explicit ThreadPool(size_t count_thread, size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
     ~ThreadPool() noexcept;
     template<typename U>
     void Add(U&& task);
+    // Задачи перемещаются из tasks; сами элементы остаются в moved-from состоянии.
+    // false - пул останавливается и задачи не приняты (tasks не тронуты)
+    bool AddBatch(std::span<Task> tasks);
+
+    size_t thread_count() const noexcept { return workers_.size(); }
+    // Счетчики потоков и общей очереди; без SCANNER_INSTRUMENTATION в них
+    // только число проглоченных исключений
+    PoolStats Stats() const;
 };
 
 template<typename Task>
-void ThreadPool<Task>::worker_loop() {
-    while (true) {
-        auto opt_task = tasks_.Get();
-        if (!opt_task.has_value()) {
-            break; 
+void ThreadPool<Task>::cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+template<typename Task>
+template<typename Fill>
+typename ThreadPool<Task>::Batch* ThreadPool<Task>::make_batch(size_t count, Fill&& fill) {
+    void* memory = ::operator new(TASKS_OFFSET + count * sizeof(Task));
+    Batch* batch = ::new (memory) Batch();
+    size_t built = 0;
+    try {
+        for (; built < count; ++built) {
+            fill(static_cast<void*>(batch->tasks() + built), built);
         }
+    } catch (...) {
+        for (size_t i = 0; i < built; ++i) {
+            batch->tasks()[i].~Task();
+        }
+        batch->~Batch();
+        ::operator delete(memory);
+        throw;
+    }
+    batch->count = count;
+    return batch;
+}
+
+template<typename Task>
+void ThreadPool<Task>::release(Batch* batch) noexcept {
+    if (batch->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    // Выполненные задачи уже разрушены; остаются только невзятые (при остановке)
+    for (size_t i = std::min(batch->next.load(std::memory_order_relaxed), batch->count); i < batch->count; ++i) {
+        batch->tasks()[i].~Task();
+    }
+    batch->~Batch();
+    ::operator delete(static_cast<void*>(batch));
+}
+
+template<typename Task>
+bool ThreadPool<Task>::push_local(Batch* batch) {
+    return queues_[context_.index]->deque.push(batch) || injection_.TryPush(batch);
+}
+
+template<typename Task>
+void ThreadPool<Task>::run(Batch* batch) noexcept {
+    const size_t count = batch->count;
+    if (count - std::min(batch->next.load(std::memory_order_relaxed), count) > 1) {
+        batch->refs.fetch_add(1, std::memory_order_relaxed);
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        if (push_local(batch)) {
+            wake_one();
+        } else {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            batch->refs.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    size_t i;
+    while ((i = batch->next.fetch_add(1, std::memory_order_relaxed)) < count) {
+        Task& task = batch->tasks()[i];
         try {
-            (*opt_task)();
+            task();
         } catch (...) {
+            swallowed_exceptions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        task.~Task();
+        queues_[context_.index]->counters.tasks.Add();
+    }
+    release(batch);
+}
 
+template<typename Task>
+typename ThreadPool<Task>::Batch* ThreadPool<Task>::find_task(size_t index) {
+    Batch* task = queues_[index]->deque.pop();
+    if (task == nullptr) {
+        if (auto injected = injection_.TryGet()) {
+            task = *injected;
+        }
+    }
+    if (task == nullptr && queues_.size() > 1) {
+        // Жертва выбирается случайно, чтобы воры не толпились у одного дека
+        uint64_t& rng = context_.rng;
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        const size_t start = static_cast<size_t>(rng % queues_.size());
+        for (size_t i = 0; i < queues_.size() && task == nullptr; ++i) {
+            const size_t victim = (start + i) % queues_.size();
+            if (victim != index) {
+                task = queues_[victim]->deque.steal();
+            }
         }
+        if (task != nullptr) {
+            queues_[index]->counters.steals.Add();
+        }
+    }
+    if (task != nullptr) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
     }
+    return task;
 }
 
 template<typename Task>
-ThreadPool<Task>::ThreadPool(size_t count_thread) {
+void ThreadPool<Task>::worker_loop(size_t index) {
+    context_ = WorkerContext{this, index, 0x9E3779B97F4A7C15ULL * (index + 1)};
+    Worker& worker = *queues_[index];
+    auto run_timed = [&worker, this](Batch* batch, const instrumentation::Stopwatch& idle) {
+        worker.counters.idle_ns.Add(idle.ElapsedNs());
+        instrumentation::Stopwatch busy;
+        run(batch);
+        worker.counters.busy_ns.Add(busy.ElapsedNs());
+    };
+    while (true) {
+        instrumentation::Stopwatch idle;
+        Batch* task = find_task(index);
+        for (size_t spin = 0; task == nullptr && spin < SPIN_ROUNDS; ++spin) {
+            cpu_relax();
+            task = find_task(index);
+        }
+        if (task != nullptr) {
+            run_timed(task, idle);
+            continue;
+        }
+        if (stopping_.load(std::memory_order_acquire) && queued_.load(std::memory_order_acquire) == 0) {
+            worker.counters.idle_ns.Add(idle.ElapsedNs());
+            break;
+        }
+
+        // Засыпание: эпоху читаем до повторной проверки очередей, тогда
+        // задача, добавленная после проверки, гарантированно сменит эпоху
+        const uint64_t epoch = wake_epoch_.load(std::memory_order_seq_cst);
+        sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        task = find_task(index);
+        if (task == nullptr) {
+            worker.counters.parks.Add();
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            park_cv_.wait(lock, [this, epoch] {
+                return wake_epoch_.load(std::memory_order_seq_cst) != epoch || stopping_.load(std::memory_order_acquire);
+            });
+        }
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        if (task != nullptr) {
+            run_timed(task, idle);
+        } else {
+            worker.counters.idle_ns.Add(idle.ElapsedNs());
+        }
+    }
+    context_ = WorkerContext{};
+}
+
+template<typename Task>
+void ThreadPool<Task>::wake_one() {
+    wake_epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+template<typename Task>
+void ThreadPool<Task>::stop() noexcept {
+    stopping_.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        wake_epoch_.fetch_add(1, std::memory_order_seq_cst);
+        park_cv_.notify_all();
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    // Задачи, добавленные извне уже после остановки, не выполняются
+    while (auto task = injection_.TryGet()) {
+        release(*task);
+    }
+}
+
+template<typename Task>
+ThreadPool<Task>::ThreadPool(size_t count_thread, size_t queue_capacity)
+    : injection_(queue_capacity) {
     if (count_thread == 0) {
-        throw std::invalid_argument("ThreadPool: thread_count > 0"); 
+        throw std::invalid_argument("ThreadPool: thread_count > 0");
+    }
+
+    queues_.reserve(count_thread);
+    for (std::size_t i = 0; i < count_thread; ++i) {
+        queues_.push_back(std::make_unique<Worker>());
     }
-    
     workers_.reserve(count_thread);
-    
+
     try {
         for (std::size_t i = 0; i < count_thread; ++i) {
-            workers_.emplace_back([this]() {
-                worker_loop();
+            workers_.emplace_back([this, i]() {
+                worker_loop(i);
             });
         }
     } catch (...) {
-        tasks_.Lock();
-        for (auto& worker : workers_) {
-            worker.join();
-        }
+        stop();
         throw;
     }
 }
 
 template<typename Task>
-ThreadPool<Task>::~ThreadPool() noexcept { 
-    tasks_.Lock();
-    for (auto& worker : workers_) {
-        worker.join();
+ThreadPool<Task>::~ThreadPool() noexcept {
+    stop();
+}
+
+template<typename Task>
+void ThreadPool<Task>::submit(Batch* batch) {
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    // Пачка от своего потока - в его дек, при переполнении - в общую очередь
+    if (context_.pool == this) {
+        if (!push_local(batch)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            run(batch);
+            return;
+        }
+    } else {
+        injection_.Push(batch);
     }
+    wake_one();
 }
 
 template<typename Task>
 template<typename U>
-void ThreadPool<Task>::Add(U&& task) { 
-  tasks_.Push(std::forward<U>(task));
+void ThreadPool<Task>::Add(U&& task) {
+    if (context_.pool != this && stopping_.load(std::memory_order_acquire)) {
+        return;
+    }
+    submit(make_batch(1, [&task](void* place, size_t) {
+        ::new (place) Task(std::forward<U>(task));
+    }));
+}
+
+template<typename Task>
+PoolStats ThreadPool<Task>::Stats() const {
+    PoolStats stats;
+    stats.workers.reserve(queues_.size());
+    for (const auto& worker : queues_) {
+        WorkerStats worker_stats;
+        worker_stats.busy = std::chrono::nanoseconds(worker->counters.busy_ns.Load());
+        worker_stats.idle = std::chrono::nanoseconds(worker->counters.idle_ns.Load());
+        worker_stats.tasks = worker->counters.tasks.Load();
+        worker_stats.steals = worker->counters.steals.Load();
+        worker_stats.parks = worker->counters.parks.Load();
+        stats.workers.push_back(worker_stats);
+    }
+    stats.swallowed_exceptions = swallowed_exceptions_.load(std::memory_order_relaxed);
+    stats.injection = injection_.Stats();
+    return stats;
 }
 
+template<typename Task>
+bool ThreadPool<Task>::AddBatch(std::span<Task> tasks) {
+    if (context_.pool != this && stopping_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (!tasks.empty()) {
+        submit(make_batch(tasks.size(), [&tasks](void* place, size_t i) {
+            ::new (place) Task(std::move(tasks[i]));
+        }));
+    }
+    return true;
+}
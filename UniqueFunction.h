@@ -0,0 +1,136 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature>
+class UniqueFunction;
+
+// Перемещаемая обертка вызываемого объекта, замена std::function для задач
+// пула: не требует копируемости и хранит объекты до INLINE_SIZE байт внутри
+// себя, без выделения памяти. Этого хватает на замыкание
+// [this, shared_ptr, std::string]; более крупные объекты уходят в кучу.
+template<typename R, typename... Args>
+class DLL_EXPORT UniqueFunction<R(Args...)> {
+public:
+    static constexpr size_t INLINE_SIZE = 7 * sizeof(void*);
+
+private:
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        // Переносит объект в to и разрушает исходный
+        void (*relocate)(void* from, void* to) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename F>
+    static constexpr bool stored_inline = sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(void*) &&
+                                          std::is_nothrow_move_constructible_v<F>;
+
+    template<typename F>
+    struct InlineOps {
+        static R invoke(void* storage, Args&&... args) {
+            return std::invoke(*static_cast<F*>(storage), std::forward<Args>(args)...);
+        }
+        static void relocate(void* from, void* to) noexcept {
+            F* source = static_cast<F*>(from);
+            ::new (to) F(std::move(*source));
+            source->~F();
+        }
+        static void destroy(void* storage) noexcept {
+            static_cast<F*>(storage)->~F();
+        }
+        static constexpr Ops ops{&invoke, &relocate, &destroy};
+    };
+
+    template<typename F>
+    struct HeapOps {
+        static F*& target(void* storage) noexcept {
+            return *static_cast<F**>(storage);
+        }
+        static R invoke(void* storage, Args&&... args) {
+            return std::invoke(*target(storage), std::forward<Args>(args)...);
+        }
+        static void relocate(void* from, void* to) noexcept {
+            ::new (to) F*(target(from));
+        }
+        static void destroy(void* storage) noexcept {
+            delete target(storage);
+        }
+        static constexpr Ops ops{&invoke, &relocate, &destroy};
+    };
+
+private:
+    alignas(void*) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+
+public:
+    UniqueFunction() noexcept = default;
+    UniqueFunction(std::nullptr_t) noexcept {}
+
+    template<typename F, typename D = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same_v<D, UniqueFunction> &&
+                                         std::is_invocable_r_v<R, D&, Args...>>>
+    UniqueFunction(F&& f) {
+        if constexpr (stored_inline<D>) {
+            ::new (static_cast<void*>(storage_)) D(std::forward<F>(f));
+            ops_ = &InlineOps<D>::ops;
+        } else {
+            ::new (static_cast<void*>(storage_)) D*(new D(std::forward<F>(f)));
+            ops_ = &HeapOps<D>::ops;
+        }
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept : ops_(other.ops_) {
+        if (ops_ != nullptr) {
+            ops_->relocate(other.storage_, storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops_ != nullptr) {
+                other.ops_->relocate(other.storage_, storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    ~UniqueFunction() {
+        reset();
+    }
+
+    void reset() noexcept {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    R operator()(Args... args) {
+        if (ops_ == nullptr) {
+            throw std::bad_function_call();
+        }
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+};
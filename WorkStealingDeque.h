@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef DLL_EXPORT
+#  ifdef _WIN32
+#    define DLL_EXPORT __declspec(dllexport)
+#  else
+#    define DLL_EXPORT
+#  endif
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Дек Chase-Lev фиксированной емкости (вариант Lê и др., 2013): владелец
+// кладет и забирает с низа без блокировок, остальные потоки крадут сверху.
+// Хранит указатели; при переполнении push возвращает false, и задача
+// уходит в общую очередь пула.
+template<typename T>
+class DLL_EXPORT WorkStealingDeque {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+private:
+    alignas(CACHE_LINE) std::atomic<int64_t> top_{0};
+    alignas(CACHE_LINE) std::atomic<int64_t> bottom_{0};
+    alignas(CACHE_LINE) std::unique_ptr<std::atomic<T*>[]> buffer_;
+    size_t mask_;
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit WorkStealingDeque(size_t capacity = DEFAULT_CAPACITY);
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Только поток-владелец
+    bool push(T* item) noexcept;
+    T* pop() noexcept;
+    // Любой поток; nullptr - пусто или проиграна гонка
+    T* steal() noexcept;
+
+    bool empty() const noexcept;
+    size_t capacity() const noexcept { return mask_ + 1; }
+};
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    buffer_ = std::make_unique<std::atomic<T*>[]>(rounded);
+    mask_ = rounded - 1;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::push(T* item) noexcept {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top > static_cast<int64_t>(mask_)) {
+        return false;
+    }
+    buffer_[bottom & mask_].store(item, std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+T* WorkStealingDeque<T>::pop() noexcept {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    // seq_cst: запись bottom должна быть видна ворам раньше чтения top
+    bottom_.store(bottom, std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_seq_cst);
+    if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    T* item = buffer_[bottom & mask_].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Последний элемент: соревнуемся с ворами за top
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template<typename T>
+T* WorkStealingDeque<T>::steal() noexcept {
+    int64_t top = top_.load(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    T* item = buffer_[top & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::empty() const noexcept {
+    return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+}
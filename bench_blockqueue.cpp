@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "BlockQueue.h"
+#include "RingBlockQueue.h"
+
+namespace {
+
+constexpr int64_t ITEMS = 1 << 20;
+
+// Производители делят ITEMS элементов поровну, последний закрывает
+// очередь; потребители читают до закрытия. В замер входит запуск потоков,
+// поэтому элементов много.
+template<typename Queue>
+void run_throughput(benchmark::State& state) {
+    const int producers = static_cast<int>(state.range(0));
+    const int consumers = static_cast<int>(state.range(1));
+    const int64_t per_producer = ITEMS / producers;
+
+    for (auto _ : state) {
+        Queue queue;
+        std::atomic<int> producers_left{producers};
+        std::atomic<int64_t> consumed{0};
+        std::vector<std::thread> threads;
+        threads.reserve(producers + consumers);
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&] {
+                int64_t count = 0;
+                while (auto item = queue.Get()) {
+                    benchmark::DoNotOptimize(*item);
+                    ++count;
+                }
+                consumed.fetch_add(count, std::memory_order_relaxed);
+            });
+        }
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (int64_t i = 0; i < per_producer; ++i) {
+                    queue.Push(p * per_producer + i);
+                }
+                if (producers_left.fetch_sub(1) == 1) {
+                    queue.Lock();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (consumed.load() != per_producer * producers) {
+            state.SkipWithError("потеряны элементы");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * per_producer * producers);
+}
+
+void queue_args(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"producers", "consumers"})
+        ->ArgsProduct({{1, 2, 4, 8}, {1, 2, 4, 8}})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+}
+
+} // namespace
+
+static void BM_BlockQueueThroughput(benchmark::State& state) {
+    run_throughput<BlockQueue<int64_t>>(state);
+}
+BENCHMARK(BM_BlockQueueThroughput)->Apply(queue_args);
+
+static void BM_RingBlockQueueThroughput(benchmark::State& state) {
+    run_throughput<RingBlockQueue<int64_t>>(state);
+}
+BENCHMARK(BM_RingBlockQueueThroughput)->Apply(queue_args);
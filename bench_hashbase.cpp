@@ -0,0 +1,142 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HashBase.h"
+
+namespace {
+
+constexpr size_t QUERY_COUNT = 1 << 16;
+
+uint64_t splitmix64(uint64_t& state) noexcept {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Дайджест записи с номером index: базу и запросы к ней можно строить
+// независимо. Номера от rows и выше в базе размера rows отсутствуют.
+MD5Digest make_digest(uint64_t index) noexcept {
+    uint64_t state = index;
+    MD5Digest digest;
+    const uint64_t words[2] = {splitmix64(state), splitmix64(state)};
+    std::memcpy(digest.data(), words, digest.size());
+    return digest;
+}
+
+std::filesystem::path csv_path(size_t rows) {
+    return std::filesystem::temp_directory_path() /
+           ("scanner_bench_base_" + std::to_string(getpid()) + "_" + std::to_string(rows) + ".csv");
+}
+
+// Строки вида "<md5>;VerdictN", как в боевой базе
+std::filesystem::path write_csv(size_t rows) {
+    const auto path = csv_path(rows);
+    std::ofstream file(path);
+    std::string line;
+    for (size_t i = 0; i < rows; ++i) {
+        line = digest_to_hex(make_digest(i));
+        line += ";Verdict";
+        line += std::to_string(i % 64);
+        line += '\n';
+        file << line;
+    }
+    return path;
+}
+
+// Загруженная база последнего запрошенного размера. Держится одна: база
+// на 50M записей занимает несколько гигабайт.
+const HashBase& bench_base(size_t rows, bool prefilter) {
+    static std::unique_ptr<HashBase> base;
+    static size_t base_rows = 0;
+    if (!base || base_rows != rows) {
+        base.reset();
+        const auto path = write_csv(rows);
+        base = std::make_unique<HashBase>();
+        base->load_hashes(path.string());
+        std::filesystem::remove(path);
+        base_rows = rows;
+    }
+    if (prefilter && !base->has_prefilter()) {
+        base->build_prefilter();
+    }
+    return *base;
+}
+
+std::vector<MD5Digest> make_queries(size_t rows, bool hits) {
+    std::vector<MD5Digest> queries(QUERY_COUNT);
+    uint64_t state = 42;
+    for (MD5Digest& query : queries) {
+        const uint64_t index = splitmix64(state) % rows;
+        query = make_digest(hits ? index : rows + index);
+    }
+    return queries;
+}
+
+// Аргументы: записей в базе, проверка фильтром Блума перед таблицей (как
+// в сканере при prefilter)
+void run_lookups(benchmark::State& state, bool hits) {
+    const size_t rows = static_cast<size_t>(state.range(0));
+    const bool prefilter = state.range(1) != 0;
+    const HashBase& base = bench_base(rows, prefilter);
+    const auto queries = make_queries(rows, hits);
+
+    size_t i = 0;
+    size_t found = 0;
+    for (auto _ : state) {
+        const MD5Digest& query = queries[i++ & (QUERY_COUNT - 1)];
+        const std::string* verdict = (!prefilter || base.may_contain(query)) ? base.get_verdict(query) : nullptr;
+        benchmark::DoNotOptimize(verdict);
+        found += verdict != nullptr;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.counters["hit_ratio"] = state.iterations() ? static_cast<double>(found) / state.iterations() : 0;
+}
+
+} // namespace
+
+static void BM_GetVerdictHit(benchmark::State& state) {
+    run_lookups(state, true);
+}
+BENCHMARK(BM_GetVerdictHit)
+    ->ArgNames({"rows", "prefilter"})
+    ->ArgsProduct({{1'000'000, 10'000'000, 50'000'000}, {0, 1}});
+
+static void BM_GetVerdictMiss(benchmark::State& state) {
+    run_lookups(state, false);
+}
+BENCHMARK(BM_GetVerdictMiss)
+    ->ArgNames({"rows", "prefilter"})
+    ->ArgsProduct({{1'000'000, 10'000'000, 50'000'000}, {0, 1}});
+
+// Разбор CSV; аргументы: строк в файле, потоков разбора (0 - по числу ядер)
+static void BM_LoadHashes(benchmark::State& state) {
+    const size_t rows = static_cast<size_t>(state.range(0));
+    const size_t threads = static_cast<size_t>(state.range(1));
+    const auto path = write_csv(rows);
+    const auto file_size = std::filesystem::file_size(path);
+
+    for (auto _ : state) {
+        auto base = std::make_unique<HashBase>();
+        base->load_hashes(path.string(), threads);
+        benchmark::DoNotOptimize(base->size());
+        // Освобождение таблиц - не часть загрузки
+        state.PauseTiming();
+        base.reset();
+        state.ResumeTiming();
+    }
+    std::filesystem::remove(path);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rows));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * file_size));
+}
+BENCHMARK(BM_LoadHashes)
+    ->ArgNames({"rows", "threads"})
+    ->ArgsProduct({{1'000'000, 10'000'000}, {1, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,118 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "MD5Compute.h"
+
+namespace {
+
+// Файлы с псевдослучайным содержимым, по одному на размер. Создаются при
+// первом обращении и удаляются при выходе. Файлы горячие (в page cache):
+// меряется чтение из памяти и хеширование, а не диск.
+class BenchFiles {
+private:
+    std::filesystem::path dir_;
+    std::map<size_t, std::filesystem::path> files_;
+public:
+    BenchFiles()
+        : dir_(std::filesystem::temp_directory_path() / ("scanner_bench_md5_" + std::to_string(getpid()))) {
+        std::filesystem::create_directories(dir_);
+    }
+    ~BenchFiles() {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    const std::filesystem::path& Get(size_t size) {
+        auto it = files_.find(size);
+        if (it != files_.end()) {
+            return it->second;
+        }
+        const auto path = dir_ / (std::to_string(size) + ".bin");
+        std::ofstream file(path, std::ios::binary);
+        std::vector<uint64_t> block(1 << 13);
+        uint64_t state = size;
+        for (size_t written = 0; written < size;) {
+            for (uint64_t& word : block) {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                word = state;
+            }
+            const size_t chunk = std::min(size - written, block.size() * sizeof(uint64_t));
+            file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(chunk));
+            written += chunk;
+        }
+        return files_.emplace(size, path).first->second;
+    }
+};
+
+BenchFiles& bench_files() {
+    static BenchFiles files;
+    return files;
+}
+
+const char* strategy_name(ReadStrategy strategy) {
+    return strategy == ReadStrategy::Mmap ? "mmap" : "pread";
+}
+
+} // namespace
+
+// Аргументы: размер файла, стратегия чтения
+static void BM_ComputeFileHashMD5(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    ReadOptions options;
+    options.strategy = static_cast<ReadStrategy>(state.range(1));
+    const MD5Compute compute(options);
+    const auto& path = bench_files().Get(size);
+
+    for (auto _ : state) {
+        auto hash = compute.computeFileHashMD5(path);
+        if (!hash) {
+            state.SkipWithError("файл не прочитался");
+            break;
+        }
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(size));
+    state.SetLabel(strategy_name(options.strategy));
+}
+BENCHMARK(BM_ComputeFileHashMD5)
+    ->ArgNames({"size", "strategy"})
+    ->ArgsProduct({{4 << 10, 64 << 10, 1 << 20, 16 << 20, 64 << 20},
+                   {static_cast<int64_t>(ReadStrategy::Pread), static_cast<int64_t>(ReadStrategy::Mmap)}});
+
+// Все три алгоритма за одно чтение - путь сканера с SHA-записями в базе
+static void BM_ComputeFileDigestsAll(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const MD5Compute compute;
+    const auto& path = bench_files().Get(size);
+
+    for (auto _ : state) {
+        auto digests = compute.computeFileDigests(path, DIGEST_ALL);
+        if (!digests) {
+            state.SkipWithError("файл не прочитался");
+            break;
+        }
+        benchmark::DoNotOptimize(digests);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(size));
+}
+BENCHMARK(BM_ComputeFileDigestsAll)->ArgName("size")->Arg(64 << 10)->Arg(16 << 20);
+
+// Пакет мелких файлов по SIMD-полосам против поштучного хеширования
+static void BM_ComputeBatchDigestMD5(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const MD5Compute compute;
+    const std::vector<std::filesystem::path> paths(64, bench_files().Get(size));
+
+    for (auto _ : state) {
+        auto digests = compute.computeBatchDigestMD5(paths);
+        benchmark::DoNotOptimize(digests);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * paths.size() * size));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * paths.size()));
+}
+BENCHMARK(BM_ComputeBatchDigestMD5)->ArgName("size")->Arg(4 << 10)->Arg(64 << 10);
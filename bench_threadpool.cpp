@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "TaskGroup.h"
+#include "ThreadPool.h"
+#include "UniqueFunction.h"
+
+namespace {
+
+using Pool = ThreadPool<UniqueFunction<void()>>;
+
+constexpr size_t TASKS = 1 << 18;
+
+// Пустая по объему задача: меряются сами очереди пула
+UniqueFunction<void()> make_task(TaskGroup& group, std::atomic<uint64_t>& sum, uint64_t value) {
+    return [&group, &sum, value] {
+        sum.fetch_add(value, std::memory_order_relaxed);
+        group.Done();
+    };
+}
+
+} // namespace
+
+// Аргументы: потоков пула, внешних потоков-производителей, размер пачки
+// AddBatch (1 - поштучный Add)
+static void BM_ThreadPoolThroughput(benchmark::State& state) {
+    const size_t workers = static_cast<size_t>(state.range(0));
+    const size_t producers = static_cast<size_t>(state.range(1));
+    const size_t batch = static_cast<size_t>(state.range(2));
+    const size_t per_producer = TASKS / producers / batch * batch;
+    Pool pool(workers);
+
+    for (auto _ : state) {
+        TaskGroup group;
+        std::atomic<uint64_t> sum{0};
+        group.Add(per_producer * producers);
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                if (batch == 1) {
+                    for (size_t i = 0; i < per_producer; ++i) {
+                        pool.Add(make_task(group, sum, i));
+                    }
+                    return;
+                }
+                std::vector<UniqueFunction<void()>> tasks;
+                tasks.reserve(batch);
+                for (size_t i = 0; i < per_producer; i += batch) {
+                    tasks.clear();
+                    for (size_t j = 0; j < batch; ++j) {
+                        tasks.push_back(make_task(group, sum, i + j));
+                    }
+                    pool.AddBatch(tasks);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        group.Wait();
+        benchmark::DoNotOptimize(sum.load());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * per_producer * producers));
+}
+BENCHMARK(BM_ThreadPoolThroughput)
+    ->ArgNames({"workers", "producers", "batch"})
+    ->ArgsProduct({{1, 2, 4, 8}, {1, 2, 4}, {1, 64}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Задачи, порожденные задачами пула: идут в локальный дек потока и
+// расходятся по соседям кражей
+static void BM_ThreadPoolFanOut(benchmark::State& state) {
+    const size_t workers = static_cast<size_t>(state.range(0));
+    const size_t fan_out = static_cast<size_t>(state.range(1));
+    const size_t roots = TASKS / fan_out;
+    Pool pool(workers);
+
+    for (auto _ : state) {
+        TaskGroup group;
+        std::atomic<uint64_t> sum{0};
+        group.Add(roots);
+        for (size_t r = 0; r < roots; ++r) {
+            pool.Add([&, r] {
+                group.Add(fan_out);
+                for (size_t i = 0; i < fan_out; ++i) {
+                    pool.Add(make_task(group, sum, r + i));
+                }
+                group.Done();
+            });
+        }
+        group.Wait();
+        benchmark::DoNotOptimize(sum.load());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * roots * (fan_out + 1)));
+}
+BENCHMARK(BM_ThreadPoolFanOut)
+    ->ArgNames({"workers", "fan_out"})
+    ->ArgsProduct({{1, 2, 4, 8}, {16, 256}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,106 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include "DigestCache.h"
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " --cache <file> [options]\n"
+              << "  --cache <file>   Digest cache path (required)\n"
+              << "  --stats          Show record counts\n"
+              << "  --compact        Merge the journal into the index\n"
+              << "  --prune <dir>    Drop entries of files not found under <dir> (must cover the whole cached tree)\n"
+              << "  --drop-device <num>  Invalidate all entries of a device (st_dev)\n"
+              << "  --clear          Remove the cache completely\n"
+              << "  -h, --help       Show help\n"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string cache_file;
+    bool stats = false, compact = false, clear = false;
+    bool drop = false;
+    uint64_t drop_device = 0;
+    std::string prune_root;
+
+    const option long_options[] = {
+        {"cache", required_argument, nullptr, 'c'},
+        {"stats", no_argument, nullptr, 's'},
+        {"compact", no_argument, nullptr, 'C'},
+        {"prune", required_argument, nullptr, 'p'},
+        {"drop-device", required_argument, nullptr, 'd'},
+        {"clear", no_argument, nullptr, 'x'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    while (true) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "c:sCp:d:xh", long_options, &option_index);
+        if (c == -1) break;
+        switch (c) {
+            case 'c': cache_file = optarg; break;
+            case 's': stats = true; break;
+            case 'C': compact = true; break;
+            case 'p': prune_root = optarg; break;
+            case 'd': drop = true; drop_device = std::stoull(optarg); break;
+            case 'x': clear = true; break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    if (cache_file.empty() || !(stats || compact || clear || drop || !prune_root.empty())) {
+        std::cerr << "Error: --cache and at least one action are required.\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        if (clear) {
+            DigestCache::remove(cache_file);
+            std::cout << "Removed " << cache_file << "\n";
+            return 0;
+        }
+
+        DigestCache cache(cache_file);
+        for (const auto& warning : cache.load_warnings()) {
+            std::cerr << warning << "\n";
+        }
+        if (drop) {
+            std::cout << "Dropped " << cache.drop_device(drop_device) << " entries of device "
+                      << drop_device << "\n";
+        }
+        if (!prune_root.empty()) {
+            // Найденные lookup записи помечаются встреченными, остальные prune удалит
+            size_t files = 0;
+            std::error_code ec;
+            const auto walk_options = std::filesystem::directory_options::skip_permission_denied;
+            for (std::filesystem::recursive_directory_iterator it(prune_root, walk_options, ec), end;
+                 !ec && it != end; it.increment(ec)) {
+                if (auto identity = DigestCache::identify(it->path())) {
+                    cache.lookup(*identity, 0);
+                    ++files;
+                }
+            }
+            if (ec) {
+                std::cerr << "Error: cannot walk " << prune_root << ": " << ec.message() << "\n";
+                return 1;
+            }
+            std::cout << "Pruned " << cache.prune() << " entries (" << files << " files under "
+                      << prune_root << ")\n";
+        }
+        if (compact) {
+            cache.compact();
+            std::cout << "Compacted " << cache_file << "\n";
+        }
+        if (stats) {
+            std::cout << "Index records: " << cache.index_records() << "\n"
+                      << "Journal records: " << cache.log_records() << "\n";
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <getopt.h>
+#include "HashBase.h"
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n"
+              << "  --base <file>    Base CSV file path\n"
+              << "  --out <file>     Compiled base output path\n"
+              << "  --verify <file>  Verify checksums of a compiled base\n"
+              << "  --prefilter-bits <num>  Embed a Bloom prefilter (0: none, default: 0)\n"
+              << "  -h, --help       Show help\n"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string base_file, out_file, verify_file;
+    size_t prefilter_bits = 0;
+
+    const option long_options[] = {
+        {"base", required_argument, nullptr, 'b'},
+        {"out", required_argument, nullptr, 'o'},
+        {"verify", required_argument, nullptr, 'v'},
+        {"prefilter-bits", required_argument, nullptr, 'F'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    while (true) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "b:o:v:F:h", long_options, &option_index);
+        if (c == -1) break;
+        switch (c) {
+            case 'b': base_file = optarg; break;
+            case 'o': out_file = optarg; break;
+            case 'v': verify_file = optarg; break;
+            case 'F': prefilter_bits = std::stoul(optarg); break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    if (verify_file.empty() && (base_file.empty() || out_file.empty())) {
+        std::cerr << "Error: --base and --out (or --verify) are required.\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        if (!base_file.empty()) {
+            auto start = std::chrono::steady_clock::now();
+
+            HashBase hash_base;
+            hash_base.load_hashes(base_file);
+            if (prefilter_bits > 0) {
+                hash_base.build_prefilter(prefilter_bits);
+            }
+            hash_base.save_image(out_file);
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            std::cout << "Compiled " << hash_base.size() << " hashes into " << out_file
+                      << " (" << elapsed.count() << " ms)\n";
+        }
+
+        if (!verify_file.empty()) {
+            HashBase hash_base;
+            hash_base.load_image(verify_file, true);
+            std::cout << "Verified " << verify_file << ": " << hash_base.size() << " hashes\n";
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
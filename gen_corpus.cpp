@@ -0,0 +1,223 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+#include <getopt.h>
+#include "MD5Compute.h"
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " --out <dir> --base <file> [options]\n"
+              << "  --out <dir>            Corpus root (created, must be empty)\n"
+              << "  --base <file>          Hash base CSV to write\n"
+              << "  --files <num>          Number of files (default: 10000)\n"
+              << "  --median-size <bytes>  Median file size (default: 16384)\n"
+              << "  --size-sigma <num>     Log-normal spread of sizes, 0 for equal sizes (default: 1.5)\n"
+              << "  --max-size <bytes>     Size cap (default: 67108864)\n"
+              << "  --depth <num>          Directory depth (default: 3)\n"
+              << "  --fanout <num>         Subdirectories per directory (default: 8)\n"
+              << "  --malicious <fraction> Fraction of files listed in the base (default: 0.01)\n"
+              << "  --decoys <num>         Extra base rows that match no file (default: 100000)\n"
+              << "  --with-sizes           Write the size column (enables --size-filter)\n"
+              << "  --seed <num>           Random seed (default: 1)\n"
+              << "  -h, --help             Show help\n"
+              << std::endl;
+}
+
+namespace {
+
+struct CorpusOptions {
+    std::filesystem::path out_dir;
+    std::string base_file;
+    size_t files = 10000;
+    double median_size = 16384;
+    double size_sigma = 1.5;
+    uint64_t max_size = 64ull << 20;
+    unsigned depth = 3;
+    unsigned fanout = 8;
+    double malicious = 0.01;
+    size_t decoys = 100000;
+    bool with_sizes = false;
+    uint64_t seed = 1;
+};
+
+// Все директории дерева глубины depth, корень первым
+std::vector<std::filesystem::path> make_tree(const CorpusOptions& options) {
+    std::vector<std::filesystem::path> dirs = {options.out_dir};
+    size_t level_begin = 0;
+    for (unsigned level = 0; level < options.depth; ++level) {
+        const size_t level_end = dirs.size();
+        for (size_t i = level_begin; i < level_end; ++i) {
+            for (unsigned child = 0; child < options.fanout; ++child) {
+                dirs.push_back(dirs[i] / ("d" + std::to_string(child)));
+                std::filesystem::create_directory(dirs.back());
+            }
+        }
+        level_begin = level_end;
+    }
+    return dirs;
+}
+
+// Псевдослучайное содержимое, свое у каждого файла: дубликаты дайджестов
+// не искажают число находок
+MD5Digest write_file(const std::filesystem::path& path, uint64_t size, uint64_t seed,
+                     std::vector<uint64_t>& buffer) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot create " + path.string());
+    }
+    DigestAccumulator accumulator(DIGEST_MD5);
+    uint64_t state = seed;
+    for (uint64_t written = 0; written < size;) {
+        for (uint64_t& word : buffer) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            word = state;
+        }
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(size - written, buffer.size() * sizeof(uint64_t)));
+        const auto* data = reinterpret_cast<const unsigned char*>(buffer.data());
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(chunk));
+        accumulator.update(data, chunk);
+        written += chunk;
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write " + path.string());
+    }
+    return accumulator.finish()->md5;
+}
+
+void write_base_row(std::ofstream& base, const MD5Digest& digest, const std::string& verdict,
+                    uint64_t size, bool with_size) {
+    base << digest_to_hex(digest) << ';' << verdict;
+    if (with_size) {
+        base << ';' << size;
+    }
+    base << '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    CorpusOptions options;
+
+    const option long_options[] = {
+        {"out", required_argument, nullptr, 'o'},
+        {"base", required_argument, nullptr, 'b'},
+        {"files", required_argument, nullptr, 'n'},
+        {"median-size", required_argument, nullptr, 's'},
+        {"size-sigma", required_argument, nullptr, 'g'},
+        {"max-size", required_argument, nullptr, 'S'},
+        {"depth", required_argument, nullptr, 'd'},
+        {"fanout", required_argument, nullptr, 'f'},
+        {"malicious", required_argument, nullptr, 'm'},
+        {"decoys", required_argument, nullptr, 'x'},
+        {"with-sizes", no_argument, nullptr, 'z'},
+        {"seed", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    while (true) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "o:b:n:s:g:S:d:f:m:x:zr:h", long_options, &option_index);
+        if (c == -1) break;
+        switch (c) {
+            case 'o': options.out_dir = optarg; break;
+            case 'b': options.base_file = optarg; break;
+            case 'n': options.files = std::stoul(optarg); break;
+            case 's': options.median_size = std::stod(optarg); break;
+            case 'g': options.size_sigma = std::stod(optarg); break;
+            case 'S': options.max_size = std::stoull(optarg); break;
+            case 'd': options.depth = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'f': options.fanout = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'm': options.malicious = std::stod(optarg); break;
+            case 'x': options.decoys = std::stoul(optarg); break;
+            case 'z': options.with_sizes = true; break;
+            case 'r': options.seed = std::stoull(optarg); break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    if (options.out_dir.empty() || options.base_file.empty()) {
+        std::cerr << "Error: --out and --base are required.\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (options.malicious < 0 || options.malicious > 1 || options.median_size < 1 || options.size_sigma < 0) {
+        std::cerr << "Error: invalid size distribution or malicious fraction.\n";
+        return 1;
+    }
+
+    try {
+        if (std::filesystem::exists(options.out_dir) && !std::filesystem::is_empty(options.out_dir)) {
+            throw std::runtime_error(options.out_dir.string() + " is not empty");
+        }
+        std::filesystem::create_directories(options.out_dir);
+        auto start = std::chrono::steady_clock::now();
+
+        std::mt19937_64 rng(options.seed);
+        // lognormal_distribution требует sigma > 0
+        std::lognormal_distribution<double> size_dist(std::log(options.median_size),
+                                                      std::max(options.size_sigma, 1e-9));
+        auto next_size = [&] {
+            const double size = options.size_sigma > 0 ? size_dist(rng) : options.median_size;
+            return std::min<uint64_t>(options.max_size, static_cast<uint64_t>(size));
+        };
+
+        const auto dirs = make_tree(options);
+        // Ровно round(files * malicious) находок на случайных местах
+        std::vector<char> planted(options.files, 0);
+        const size_t malicious_count = static_cast<size_t>(std::llround(options.files * options.malicious));
+        std::fill_n(planted.begin(), malicious_count, 1);
+        std::shuffle(planted.begin(), planted.end(), rng);
+
+        std::ofstream base(options.base_file);
+        if (!base) {
+            throw std::runtime_error("Cannot create " + options.base_file);
+        }
+        std::vector<uint64_t> buffer(1 << 14);
+        uint64_t total_bytes = 0;
+        for (size_t i = 0; i < options.files; ++i) {
+            const uint64_t size = next_size();
+            const auto& dir = dirs[rng() % dirs.size()];
+            const auto path = dir / ("f" + std::to_string(i) + ".bin");
+            const MD5Digest digest = write_file(path, size, rng() | 1, buffer);
+            total_bytes += size;
+            if (planted[i]) {
+                write_base_row(base, digest, "Planted.Malware", size, options.with_sizes);
+            }
+        }
+        for (size_t i = 0; i < options.decoys; ++i) {
+            MD5Digest digest;
+            for (size_t byte = 0; byte < digest.size(); byte += sizeof(uint64_t)) {
+                const uint64_t word = rng();
+                std::memcpy(digest.data() + byte, &word, sizeof(word));
+            }
+            write_base_row(base, digest, "Decoy.Entry", next_size(), options.with_sizes);
+        }
+        base.close();
+        if (!base) {
+            throw std::runtime_error("Cannot write " + options.base_file);
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        std::cout << "Generated " << options.files << " files (" << total_bytes / (1024 * 1024) << " MB) in "
+                  << dirs.size() << " directories under " << options.out_dir.string() << "\n"
+                  << "Planted " << malicious_count << " malicious files, base " << options.base_file
+                  << " has " << malicious_count + options.decoys << " rows"
+                  << " (" << elapsed.count() << " ms)\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -2,6 +2,7 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <getopt.h>
 #include <iomanip>
 #include "Scanner.h"
@@ -10,44 +11,162 @@ void print_usage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options]\n"
               << "  --base <file>    Base CSV file path (required)\n"
               << "  --log <file>     Log file path (required)\n"
-              << "  --path <dir>     Directory to scan (required)\n"
+              << "  --path <dir>     Directory to scan (required, repeat for several roots)\n"
               << "  --threads <num>  Number of threads (default: auto)\n"
+              << "  --prefilter      Check a Bloom prefilter before the hash table\n"
+              << "  --prefilter-bits <num>  Prefilter bits per hash (default: 8)\n"
+              << "  --read-mode <mode>      File read mode: pread, mmap, auto, io_uring (default: pread)\n"
+              << "  --io-depth <num>        Reads in flight per ring for io_uring (default: 64)\n"
+              << "  --io-rings <num>        io_uring submission threads (default: 1)\n"
+              << "  --read-buffer <KiB>     Read buffer size (default: 1024)\n"
+              << "  --pipeline       Read, hash and report in separate stages\n"
+              << "  --read-threads <num>    Pipeline reader threads (default: 2)\n"
+              << "  --hash-threads <num>    Pipeline hasher threads (default: --threads)\n"
+              << "  --report-threads <num>  Pipeline report threads (default: 1)\n"
+              << "  --stage-queue <num>     Pipeline queue depth between stages (default: 1024)\n"
+              << "  --buffers <num>         Pipeline read buffers of 256 KiB (default: 64)\n"
+              << "  --results <file>        Write scan results while scanning\n"
+              << "  --results-format <fmt>  Results format: jsonl, binary (default: jsonl)\n"
+              << "  --report-clean   Include clean files in the results\n"
+              << "  --metrics <file>        Dump live metrics to a file while scanning\n"
+              << "  --metrics-format <fmt>  Metrics format: prometheus, json (default: prometheus)\n"
+              << "  --metrics-interval <ms> Metrics dump interval (default: 1000)\n"
+              << "  --trace <file>          Write a Chrome/Perfetto trace of files and stages\n"
+              << "  --trace-sample <rate>   Fraction of files and directories to trace (default: 1)\n"
+              << "  --archives       Also scan members of tar, tar.gz, gzip and zip archives\n"
+              << "  --archive-depth <num>   Archive nesting levels to open (default: 3)\n"
+              << "  --archive-member-limit <MiB>  Skip archive members larger than this (default: 256)\n"
+              << "  --archive-total-limit <MiB>   Stop an archive after this much unpacked data (default: 4096)\n"
+              << "  --batch-md5      Hash small files in SIMD batches (MD5-only bases, plain reads)\n"
+              << "  --size-filter    Skip files whose size is not in the base\n"
+              << "  --cache <file>   Digest cache for incremental rescans\n"
+              << "  --cache-prune    Drop cache entries of files the scan did not see (needs a single --path covering the cached tree)\n"
+              << "  --queue-capacity <num>  Max queued scan tasks (default: 16384)\n"
               << "  -h, --help       Show help\n"
               << std::endl;
 }
 
 int main(int argc, char* argv[]) {
-    std::string base_file, log_file, scan_path;
+    std::string base_file, log_file;
+    std::vector<std::filesystem::path> scan_paths;
+    std::string results_file, results_format = "jsonl";
     size_t threads = 0;
+    ScannerOptions options;
 
     const option long_options[] = {
         {"base", required_argument, nullptr, 'b'},
         {"log", required_argument, nullptr, 'l'},
         {"path", required_argument, nullptr, 'p'},
         {"threads", required_argument, nullptr, 't'},
+        {"prefilter", no_argument, nullptr, 'f'},
+        {"prefilter-bits", required_argument, nullptr, 'F'},
+        {"read-mode", required_argument, nullptr, 'r'},
+        {"read-buffer", required_argument, nullptr, 'B'},
+        {"io-depth", required_argument, nullptr, 'D'},
+        {"io-rings", required_argument, nullptr, 'R'},
+        {"pipeline", no_argument, nullptr, 'P'},
+        {"read-threads", required_argument, nullptr, 'e'},
+        {"hash-threads", required_argument, nullptr, 'H'},
+        {"report-threads", required_argument, nullptr, 'o'},
+        {"stage-queue", required_argument, nullptr, 'Q'},
+        {"buffers", required_argument, nullptr, 'n'},
+        {"results", required_argument, nullptr, 'O'},
+        {"results-format", required_argument, nullptr, 'j'},
+        {"report-clean", no_argument, nullptr, 'C'},
+        {"metrics", required_argument, nullptr, 'm'},
+        {"metrics-format", required_argument, nullptr, 'M'},
+        {"metrics-interval", required_argument, nullptr, 'i'},
+        {"trace", required_argument, nullptr, 'T'},
+        {"trace-sample", required_argument, nullptr, 'S'},
+        {"archives", no_argument, nullptr, 'a'},
+        {"archive-depth", required_argument, nullptr, 'A'},
+        {"archive-member-limit", required_argument, nullptr, 'L'},
+        {"archive-total-limit", required_argument, nullptr, 'U'},
+        {"batch-md5", no_argument, nullptr, 'k'},
+        {"size-filter", no_argument, nullptr, 's'},
+        {"cache", required_argument, nullptr, 'c'},
+        {"cache-prune", no_argument, nullptr, 'X'},
+        {"queue-capacity", required_argument, nullptr, 'q'},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0}
     };
 
     while (true) {
         int option_index = 0;
-        int c = getopt_long(argc, argv, "b:l:p:t:h", long_options, &option_index);
+        int c = getopt_long(argc, argv, "b:l:p:t:fF:r:B:D:R:Pe:H:o:Q:n:O:j:Cm:M:i:T:S:aA:L:U:ksc:Xq:h", long_options, &option_index);
         if (c == -1) break;
         switch (c) {
             case 'b': base_file = optarg; break;
             case 'l': log_file = optarg; break;
-            case 'p': scan_path = optarg; break;
+            case 'p': scan_paths.emplace_back(optarg); break;
             case 't': threads = std::stoul(optarg); break;
+            case 'f': options.use_prefilter = true; break;
+            case 'F': options.use_prefilter = true; options.prefilter_bits_per_key = std::stoul(optarg); break;
+            case 'r': {
+                const std::string mode = optarg;
+                if (mode == "pread") options.read_options.strategy = ReadStrategy::Pread;
+                else if (mode == "mmap") options.read_options.strategy = ReadStrategy::Mmap;
+                else if (mode == "auto") options.read_options.strategy = ReadStrategy::Auto;
+                else if (mode == "io_uring") options.read_options.strategy = ReadStrategy::IoUring;
+                else { print_usage(argv[0]); return 1; }
+                break;
+            }
+            case 'B': options.read_options.buffer_size = std::stoul(optarg) * 1024; break;
+            case 'D': options.read_options.io_queue_depth = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'R': options.read_options.io_submitters = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'P': options.use_pipeline = true; break;
+            case 'e': options.use_pipeline = true; options.pipeline.read_threads = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'H': options.use_pipeline = true; options.pipeline.hash_threads = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'o': options.use_pipeline = true; options.pipeline.report_threads = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'Q': {
+                options.use_pipeline = true;
+                const size_t depth = std::stoul(optarg);
+                options.pipeline.read_queue_depth = depth;
+                options.pipeline.report_queue_depth = depth;
+                break;
+            }
+            case 'n': options.use_pipeline = true; options.pipeline.buffer_count = std::stoul(optarg); break;
+            case 'O': results_file = optarg; break;
+            case 'j': {
+                results_format = optarg;
+                if (results_format != "jsonl" && results_format != "binary") { print_usage(argv[0]); return 1; }
+                break;
+            }
+            case 'C': options.report_clean_files = true; break;
+            case 'm': options.metrics_path = optarg; break;
+            case 'M': {
+                const std::string format = optarg;
+                if (format == "prometheus") options.metrics_format = MetricsFormat::Prometheus;
+                else if (format == "json") options.metrics_format = MetricsFormat::Json;
+                else { print_usage(argv[0]); return 1; }
+                break;
+            }
+            case 'i': options.metrics_interval = std::chrono::milliseconds(std::stoul(optarg)); break;
+            case 'T': options.trace_path = optarg; break;
+            case 'S': options.trace_sample_rate = std::stod(optarg); break;
+            case 'a': options.scan_archives = true; break;
+            case 'A': options.scan_archives = true; options.archives.max_depth = static_cast<unsigned>(std::stoul(optarg)); break;
+            case 'L': options.scan_archives = true; options.archives.max_member_size = std::stoull(optarg) << 20; break;
+            case 'U': options.scan_archives = true; options.archives.max_expanded_size = std::stoull(optarg) << 20; break;
+            case 'k': options.batch_small_files = true; break;
+            case 's': options.use_size_filter = true; break;
+            case 'c': options.digest_cache_path = optarg; break;
+            case 'X': options.digest_cache_prune = true; break;
+            case 'q': options.task_queue_capacity = std::stoul(optarg); break;
             case 'h': print_usage(argv[0]); return 0;
             default: print_usage(argv[0]); return 1;
         }
     }
 
-    if (base_file.empty() || log_file.empty() || scan_path.empty()) {
+    if (base_file.empty() || log_file.empty() || scan_paths.empty()) {
         std::cerr << "Error: --base, --log, and --path are required.\n";
         print_usage(argv[0]);
         return 1;
     }
+    if (options.digest_cache_prune && (options.digest_cache_path.empty() || scan_paths.size() != 1)) {
+        std::cerr << "Error: --cache-prune requires --cache and a single --path.\n";
+        return 1;
+    }
 
     if (threads == 0) {
         threads = std::thread::hardware_concurrency();
@@ -58,13 +177,24 @@ int main(int argc, char* argv[]) {
         std::cout << "=== Scanner Started ===\n";
         std::cout << "Base file: " << base_file << "\n";
         std::cout << "Log file: " << log_file << "\n";
-        std::cout << "Scanning path: " << scan_path << "\n";
+        for (const auto& scan_path : scan_paths) {
+            std::cout << "Scanning path: " << scan_path.string() << "\n";
+        }
         std::cout << "Threads: " << threads << "\n\n";
 
-        Scanner scanner(base_file, log_file, threads);
+        Scanner scanner(base_file, log_file, threads, options);
 
         auto start = std::chrono::steady_clock::now();
-        auto result = scanner.Scan(scan_path);
+        Scanner::ScanResult result;
+        if (results_file.empty()) {
+            result = scanner.Scan(scan_paths);
+        } else if (results_format == "binary") {
+            BinaryResultSink sink(results_file);
+            result = scanner.Scan(scan_paths, &sink);
+        } else {
+            JsonlResultSink sink(results_file);
+            result = scanner.Scan(scan_paths, &sink);
+        }
         auto end = std::chrono::steady_clock::now();
 
         std::cout << "\n=== Scan Report ===\n";
@@ -72,6 +202,21 @@ int main(int argc, char* argv[]) {
         std::cout << "Malicious files found: " << result.malicious_files << "\n";
         std::cout << "Processing errors: " << result.errors << "\n";
         std::cout << "Execution time (ms): " << result.duration.count() << "\n";
+        if (options.use_prefilter) {
+            std::cout << "Prefilter false positives: " << result.prefilter_false_positives
+                      << " of " << result.prefilter_checks << " checks\n";
+        }
+        if (!options.digest_cache_path.empty()) {
+            std::cout << "Digest cache hits: " << result.cache_hits
+                      << ", misses: " << result.cache_misses << "\n";
+        }
+        if (options.scan_archives) {
+            std::cout << "Archive members: " << result.archive_members
+                      << ", skipped: " << result.archive_members_skipped << "\n";
+        }
+        if (options.use_size_filter) {
+            std::cout << "Skipped by size: " << result.skipped_by_size << "\n";
+        }
         std::cout << "====================\n";
 
         return (result.errors > 0) ? 2 : 0;
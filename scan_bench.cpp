@@ -0,0 +1,306 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <optional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <getopt.h>
+#include "Scanner.h"
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " --path <dir> --base <file> [options]\n"
+              << "  --path <dir>     Corpus to scan (required), see gen_corpus\n"
+              << "  --base <file>    Base CSV or compiled base (required)\n"
+              << "  --threads <list> Comma-separated thread counts (default: 1,2,4,...,cores)\n"
+              << "  --mode <mode>    Page cache: warm, cold, both (default: warm)\n"
+              << "  --runs <num>     Timed scans per configuration (default: 3)\n"
+              << "  --read-mode <mode>  File read mode: pread, mmap, auto, io_uring (default: pread)\n"
+              << "  --pipeline       Read, hash and report in separate stages\n"
+              << "  --prefilter      Check a Bloom prefilter before the hash table\n"
+              << "  --size-filter    Skip files whose size is not in the base\n"
+              << "  --json <file>    Write every run as JSON\n"
+              << "  -h, --help       Show help\n"
+              << std::endl;
+}
+
+namespace {
+
+struct RunResult {
+    std::string mode;
+    size_t threads = 0;
+    // Проверенные и пропущенные фильтром размеров - все файлы корпуса
+    size_t files = 0;
+    size_t skipped = 0;
+    size_t malicious = 0;
+    size_t errors = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+    double cpu_seconds = 0;
+    uint64_t peak_rss_kb = 0;
+};
+
+std::vector<size_t> parse_threads(const std::string& list) {
+    std::vector<size_t> threads;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        threads.push_back(std::stoul(item));
+    }
+    return threads;
+}
+
+std::vector<size_t> default_threads() {
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threads;
+    for (size_t count = 1; count < cores; count *= 2) {
+        threads.push_back(count);
+    }
+    threads.push_back(cores);
+    return threads;
+}
+
+double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval& tv) { return tv.tv_sec + tv.tv_usec / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+// Пик RSS с последнего сброса: "5" в clear_refs обнуляет VmHWM (Linux 4.0+).
+// Без сброса VmHWM - пик за всю жизнь процесса, как ru_maxrss.
+void reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5" << std::flush;
+}
+
+uint64_t peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(6));
+        }
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss);
+}
+
+// Выгоняет корпус из page cache. drop_caches (нужен root) сбрасывает и
+// страницы, и dentry/inode; без прав - POSIX_FADV_DONTNEED по каждому
+// файлу: чистые страницы уходят, метаданные остаются в кэше.
+std::string evict_corpus(const std::filesystem::path& root) {
+    sync();
+    {
+        std::ofstream drop("/proc/sys/vm/drop_caches");
+        if (drop && (drop << "3" << std::flush)) {
+            return "drop_caches";
+        }
+    }
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(
+             root, std::filesystem::directory_options::skip_permission_denied)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        const int fd = open(entry.path().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+    return "fadvise";
+}
+
+RunResult timed_scan(Scanner& scanner, const std::filesystem::path& root, const std::string& mode, size_t threads) {
+    reset_peak_rss();
+    const uint64_t bytes_before = scanner.GetMetrics().bytes_read;
+    const double cpu_before = cpu_seconds();
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = scanner.Scan(root);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    RunResult run;
+    run.mode = mode;
+    run.threads = threads;
+    run.files = result.total_files + result.skipped_by_size;
+    run.skipped = result.skipped_by_size;
+    run.malicious = result.malicious_files;
+    run.errors = result.errors;
+    run.bytes = scanner.GetMetrics().bytes_read - bytes_before;
+    run.seconds = std::chrono::duration<double>(elapsed).count();
+    run.cpu_seconds = cpu_seconds() - cpu_before;
+    run.peak_rss_kb = peak_rss_kb();
+    return run;
+}
+
+double files_per_second(const RunResult& run) {
+    return run.seconds > 0 ? run.files / run.seconds : 0;
+}
+
+double mb_per_second(const RunResult& run) {
+    return run.seconds > 0 ? run.bytes / run.seconds / (1024 * 1024) : 0;
+}
+
+void print_header() {
+    std::cout << std::left << std::setw(6) << "mode" << std::right
+              << std::setw(8) << "threads" << std::setw(10) << "files" << std::setw(12) << "files/s"
+              << std::setw(10) << "MB/s" << std::setw(8) << "cpu" << std::setw(10) << "rss MB"
+              << std::setw(9) << "speedup" << std::setw(7) << "eff" << "\n";
+}
+
+// Медианный по времени прогон; speedup и eff - относительно первого числа
+// потоков того же режима
+void print_row(const RunResult& run, const RunResult* baseline) {
+    const double speedup = baseline && run.seconds > 0 ? baseline->seconds / run.seconds : 1.0;
+    const double ideal = baseline ? static_cast<double>(run.threads) / baseline->threads : 1.0;
+    std::cout << std::left << std::setw(6) << run.mode << std::right << std::fixed
+              << std::setw(8) << run.threads << std::setw(10) << run.files
+              << std::setw(12) << std::setprecision(0) << files_per_second(run)
+              << std::setw(10) << std::setprecision(1) << mb_per_second(run)
+              << std::setw(8) << std::setprecision(2) << (run.seconds > 0 ? run.cpu_seconds / run.seconds : 0)
+              << std::setw(10) << std::setprecision(1) << run.peak_rss_kb / 1024.0
+              << std::setw(9) << std::setprecision(2) << speedup
+              << std::setw(7) << std::setprecision(2) << speedup / ideal << "\n";
+}
+
+void write_json(const std::string& path, const std::vector<RunResult>& runs, const std::string& eviction) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    out << "{\"cores\":" << std::thread::hardware_concurrency() << ",\"eviction\":\"" << eviction
+        << "\",\"runs\":[";
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const RunResult& run = runs[i];
+        out << (i ? "," : "") << "{\"mode\":\"" << run.mode << "\",\"threads\":" << run.threads
+            << ",\"files\":" << run.files << ",\"skipped\":" << run.skipped << ",\"malicious\":" << run.malicious << ",\"errors\":" << run.errors
+            << ",\"bytes\":" << run.bytes << ",\"seconds\":" << run.seconds
+            << ",\"files_per_second\":" << files_per_second(run) << ",\"mb_per_second\":" << mb_per_second(run)
+            << ",\"cpu_seconds\":" << run.cpu_seconds << ",\"peak_rss_kb\":" << run.peak_rss_kb << "}";
+    }
+    out << "]}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string base_file, json_file, mode = "warm";
+    std::filesystem::path scan_path;
+    std::vector<size_t> thread_counts = default_threads();
+    size_t runs = 3;
+    ScannerOptions options;
+
+    const option long_options[] = {
+        {"path", required_argument, nullptr, 'p'},
+        {"base", required_argument, nullptr, 'b'},
+        {"threads", required_argument, nullptr, 't'},
+        {"mode", required_argument, nullptr, 'c'},
+        {"runs", required_argument, nullptr, 'n'},
+        {"read-mode", required_argument, nullptr, 'r'},
+        {"pipeline", no_argument, nullptr, 'P'},
+        {"prefilter", no_argument, nullptr, 'f'},
+        {"size-filter", no_argument, nullptr, 's'},
+        {"json", required_argument, nullptr, 'j'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    while (true) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "p:b:t:c:n:r:Pfsj:h", long_options, &option_index);
+        if (c == -1) break;
+        switch (c) {
+            case 'p': scan_path = optarg; break;
+            case 'b': base_file = optarg; break;
+            case 't': thread_counts = parse_threads(optarg); break;
+            case 'c': mode = optarg; break;
+            case 'n': runs = std::max<size_t>(1, std::stoul(optarg)); break;
+            case 'r': {
+                const std::string read_mode = optarg;
+                if (read_mode == "pread") options.read_options.strategy = ReadStrategy::Pread;
+                else if (read_mode == "mmap") options.read_options.strategy = ReadStrategy::Mmap;
+                else if (read_mode == "auto") options.read_options.strategy = ReadStrategy::Auto;
+                else if (read_mode == "io_uring") options.read_options.strategy = ReadStrategy::IoUring;
+                else { print_usage(argv[0]); return 1; }
+                break;
+            }
+            case 'P': options.use_pipeline = true; break;
+            case 'f': options.use_prefilter = true; break;
+            case 's': options.use_size_filter = true; break;
+            case 'j': json_file = optarg; break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    if (scan_path.empty() || base_file.empty() || thread_counts.empty()) {
+        std::cerr << "Error: --path and --base are required.\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (mode != "warm" && mode != "cold" && mode != "both") {
+        std::cerr << "Error: --mode must be warm, cold or both.\n";
+        return 1;
+    }
+
+    const auto log_path = std::filesystem::temp_directory_path() /
+                          ("scan_bench_" + std::to_string(getpid()) + ".log");
+    try {
+        std::vector<std::string> modes;
+        if (mode != "cold") modes.push_back("warm");
+        if (mode != "warm") modes.push_back("cold");
+
+        std::vector<RunResult> all_runs;
+        std::string eviction = "none";
+        print_header();
+        for (const auto& cache_mode : modes) {
+            std::optional<RunResult> baseline;
+            for (size_t threads : thread_counts) {
+                // База грузится до замеров; пул создается сканером один раз
+                Scanner scanner(base_file, log_path.string(), threads, options);
+                if (cache_mode == "warm") {
+                    scanner.Scan(scan_path);
+                }
+                std::vector<RunResult> config_runs;
+                for (size_t run = 0; run < runs; ++run) {
+                    if (cache_mode == "cold") {
+                        eviction = evict_corpus(scan_path);
+                    }
+                    config_runs.push_back(timed_scan(scanner, scan_path, cache_mode, threads));
+                    all_runs.push_back(config_runs.back());
+                }
+                std::sort(config_runs.begin(), config_runs.end(),
+                          [](const RunResult& a, const RunResult& b) { return a.seconds < b.seconds; });
+                const RunResult& median = config_runs[config_runs.size() / 2];
+                print_row(median, baseline ? &*baseline : nullptr);
+                if (!baseline) {
+                    baseline = median;
+                }
+            }
+        }
+        std::cout << "Malicious files found: " << all_runs.back().malicious
+                  << ", errors: " << all_runs.back().errors;
+        if (eviction != "none") {
+            std::cout << ", cold cache via " << eviction;
+        }
+        std::cout << "\n";
+
+        if (!json_file.empty()) {
+            write_json(json_file, all_runs, eviction);
+        }
+        std::filesystem::remove(log_path);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        std::filesystem::remove(log_path);
+        return 1;
+    }
+}
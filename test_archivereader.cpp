@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "ArchiveReader.h"
+
+namespace {
+
+using Bytes = std::string;
+
+Bytes tar_entry(const std::string& name, const Bytes& content, char type = '0') {
+    Bytes header(512, '\0');
+    std::memcpy(header.data(), name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(header.data() + 100, 8, "%07o", 0644);
+    std::snprintf(header.data() + 124, 12, "%011zo", content.size());
+    std::snprintf(header.data() + 136, 12, "%011o", 0);
+    header[156] = type;
+    std::memcpy(header.data() + 257, "ustar\0" "00", 8);
+    std::memset(header.data() + 148, ' ', 8);
+    unsigned sum = 0;
+    for (unsigned char byte : header) {
+        sum += byte;
+    }
+    std::snprintf(header.data() + 148, 8, "%06o", sum);
+    Bytes padding((512 - content.size() % 512) % 512, '\0');
+    return header + content + padding;
+}
+
+Bytes tar_end() {
+    return Bytes(1024, '\0');
+}
+
+Bytes deflate_bytes(const Bytes& data, int window_bits) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+    Bytes out(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+Bytes gzip_bytes(const Bytes& data) {
+    return deflate_bytes(data, 16 + MAX_WBITS);
+}
+
+void put_le(Bytes& out, uint64_t value, int size) {
+    for (int i = 0; i < size; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+// Член zip; с descriptor размеры и CRC идут после данных, как при записи в поток
+Bytes zip_entry(const std::string& name, const Bytes& content, bool deflated, bool descriptor) {
+    const Bytes data = deflated ? deflate_bytes(content, -MAX_WBITS) : content;
+    const uint32_t crc = static_cast<uint32_t>(
+        crc32(0, reinterpret_cast<const Bytef*>(content.data()), static_cast<uInt>(content.size())));
+    Bytes out;
+    put_le(out, 0x04034b50, 4);
+    put_le(out, 20, 2);
+    put_le(out, descriptor ? 0x0008 : 0, 2);
+    put_le(out, deflated ? 8 : 0, 2);
+    put_le(out, 0, 4);
+    put_le(out, descriptor ? 0 : crc, 4);
+    put_le(out, descriptor ? 0 : data.size(), 4);
+    put_le(out, descriptor ? 0 : content.size(), 4);
+    put_le(out, name.size(), 2);
+    put_le(out, 0, 2);
+    out += name + data;
+    if (descriptor) {
+        put_le(out, 0x08074b50, 4);
+        put_le(out, crc, 4);
+        put_le(out, data.size(), 4);
+        put_le(out, content.size(), 4);
+    }
+    return out;
+}
+
+// Центральный каталог читателю не нужен: только сигнатура и конец архива
+Bytes zip_end() {
+    Bytes out;
+    put_le(out, 0x06054b50, 4);
+    out += Bytes(18, '\0');
+    return out;
+}
+
+std::string md5_of(const Bytes& data) {
+    DigestAccumulator accumulator(DIGEST_MD5);
+    accumulator.update(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+    return digest_to_hex(accumulator.finish()->md5);
+}
+
+} // namespace
+
+class ArchiveReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "archive_reader_test";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(test_dir, ec);
+    }
+
+    std::filesystem::path Write(const std::string& name, const Bytes& content) {
+        const auto path = test_dir / name;
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    // Путь члена -> MD5 (или "skipped: причина")
+    std::map<std::string, std::string> Scan(const std::filesystem::path& path,
+                                            const ArchiveOptions& options = {}) {
+        members.clear();
+        member_errors.clear();
+        const ArchiveReader reader(options, DIGEST_MD5, 4096);
+        result = reader.ScanFile(path, [this](const ArchiveMember& member) {
+            if (!member.error.empty()) {
+                member_errors[member.path] = member.error;
+            }
+            members[member.path] = member.digests ? digest_to_hex(member.digests->md5)
+                                                  : std::string("skipped: ") + member.skip_reason;
+        });
+        return members;
+    }
+
+    std::string FileMD5(const std::filesystem::path& path) {
+        return digest_to_hex(MD5Compute().computeFileDigests(path, DIGEST_MD5)->md5);
+    }
+
+    std::filesystem::path test_dir;
+    std::map<std::string, std::string> members;
+    std::map<std::string, std::string> member_errors;
+    ArchiveScanResult result;
+};
+
+TEST_F(ArchiveReaderTest, ReadsTarMembersInOnePass) {
+    const Bytes big(5000, 'x');
+    const auto path = Write("data.tar", tar_entry("dir/", "", '5') + tar_entry("dir/a.txt", "hello") +
+                                        tar_entry("big.bin", big) + tar_end());
+    EXPECT_EQ(ArchiveReader::DetectFile(path), ArchiveFormat::Tar);
+
+    const auto found = Scan(path);
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_EQ(found.at("dir/a.txt"), md5_of("hello"));
+    EXPECT_EQ(found.at("big.bin"), md5_of(big));
+    EXPECT_EQ(result.members, 2u);
+    EXPECT_TRUE(result.error.empty());
+    ASSERT_TRUE(result.digests.has_value());
+    EXPECT_EQ(digest_to_hex(result.digests->md5), FileMD5(path));
+}
+
+TEST_F(ArchiveReaderTest, ArchivesOnlyStopsAtPlainFile) {
+    const ArchiveReader reader({}, DIGEST_MD5, 4096);
+    size_t calls = 0;
+    const auto plain = Write("plain.bin", Bytes(10000, 'p'));
+    ReadTimings timings;
+    auto plain_result = reader.ScanFile(plain, [&](const ArchiveMember&) { ++calls; }, &timings, true);
+    EXPECT_EQ(plain_result.format, ArchiveFormat::None);
+    EXPECT_FALSE(plain_result.digests.has_value());
+    EXPECT_TRUE(timings.opened);
+    EXPECT_EQ(timings.bytes, 0u);
+
+    // Архив все равно читается целиком: члены и дайджест самого файла
+    const auto tar = Write("data.tar", tar_entry("a.txt", "hello") + tar_end());
+    auto tar_result = reader.ScanFile(tar, [&](const ArchiveMember&) { ++calls; }, nullptr, true);
+    EXPECT_EQ(tar_result.format, ArchiveFormat::Tar);
+    EXPECT_EQ(calls, 1u);
+    ASSERT_TRUE(tar_result.digests.has_value());
+    EXPECT_EQ(digest_to_hex(tar_result.digests->md5), FileMD5(tar));
+}
+
+TEST_F(ArchiveReaderTest, ReadsTarGzGzipAndZip) {
+    const auto tgz = Write("data.tgz", gzip_bytes(tar_entry("a.txt", "hello") + tar_end()));
+    EXPECT_EQ(Scan(tgz), (std::map<std::string, std::string>{{"a.txt", md5_of("hello")}}));
+
+    const auto gz = Write("note.txt.gz", gzip_bytes("plain text"));
+    EXPECT_EQ(Scan(gz), (std::map<std::string, std::string>{{"note.txt", md5_of("plain text")}}));
+
+    const Bytes text(3000, 'z');
+    const auto zip = Write("data.zip", zip_entry("stored.txt", "stored", false, false) +
+                                       zip_entry("dir/", "", false, false) +
+                                       zip_entry("deflated.txt", text, true, false) +
+                                       zip_entry("streamed.txt", text + "!", true, true) + zip_end());
+    const auto found = Scan(zip);
+    ASSERT_EQ(found.size(), 3u);
+    EXPECT_EQ(found.at("stored.txt"), md5_of("stored"));
+    EXPECT_EQ(found.at("deflated.txt"), md5_of(text));
+    EXPECT_EQ(found.at("streamed.txt"), md5_of(text + "!"));
+    EXPECT_TRUE(result.error.empty());
+    EXPECT_EQ(digest_to_hex(result.digests->md5), FileMD5(zip));
+}
+
+TEST_F(ArchiveReaderTest, OpensNestedArchivesUpToDepth) {
+    const Bytes inner = zip_entry("evil.exe", "malicious content", true, true) + zip_end();
+    const auto path = Write("outer.tar.gz", gzip_bytes(tar_entry("inner.zip", inner) + tar_end()));
+
+    ArchiveOptions options;
+    options.max_depth = 2;
+    auto found = Scan(path, options);
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_EQ(found.at("inner.zip!evil.exe"), md5_of("malicious content"));
+    // Вложенный архив проверяется и сам, как обычный член
+    EXPECT_EQ(found.at("inner.zip"), md5_of(inner));
+
+    options.max_depth = 1;
+    found = Scan(path, options);
+    EXPECT_EQ(found.size(), 1u);
+    EXPECT_EQ(found.count("inner.zip"), 1u);
+
+    options.max_depth = 0;
+    EXPECT_TRUE(Scan(path, options).empty());
+    EXPECT_TRUE(result.digests.has_value());
+}
+
+TEST_F(ArchiveReaderTest, EnforcesSizeLimits) {
+    const auto path = Write("data.tar", tar_entry("small.txt", "small") + tar_entry("large.bin", Bytes(4096, 'l')) +
+                                        tar_end());
+    ArchiveOptions options;
+    options.max_member_size = 1024;
+    auto found = Scan(path, options);
+    EXPECT_EQ(found.at("small.txt"), md5_of("small"));
+    EXPECT_EQ(found.at("large.bin").rfind("skipped: ", 0), 0u);
+
+    // Сжатое в сотни раз: разбор обрывается на пределе распакованного
+    const auto bomb = Write("bomb.gz", gzip_bytes(Bytes(8 << 20, '\0')));
+    options = ArchiveOptions{};
+    options.max_expanded_size = 1 << 20;
+    EXPECT_TRUE(Scan(bomb, options).empty());
+    EXPECT_FALSE(result.error.empty());
+    ASSERT_TRUE(result.digests.has_value());
+    EXPECT_EQ(digest_to_hex(result.digests->md5), FileMD5(bomb));
+
+    options = ArchiveOptions{};
+    options.max_members = 1;
+    EXPECT_EQ(Scan(path, options).size(), 1u);
+    EXPECT_FALSE(result.error.empty());
+}
+
+TEST_F(ArchiveReaderTest, CorruptArchiveStillHashesFile) {
+    // Заголовок обещает больше данных, чем есть в файле
+    const Bytes truncated = tar_entry("first.txt", "first") + tar_entry("cut.bin", Bytes(2048, 'c')).substr(0, 600);
+    const auto path = Write("cut.tar", truncated);
+    const auto found = Scan(path);
+    EXPECT_EQ(found.size(), 1u);
+    EXPECT_FALSE(result.error.empty());
+    ASSERT_TRUE(result.digests.has_value());
+    EXPECT_EQ(digest_to_hex(result.digests->md5), FileMD5(path));
+
+    const auto plain = Write("plain.txt", "not an archive");
+    EXPECT_EQ(ArchiveReader::DetectFile(plain), ArchiveFormat::None);
+    EXPECT_EQ(ArchiveReader::DetectFile(test_dir / "missing"), ArchiveFormat::None);
+    EXPECT_FALSE(ArchiveReader(ArchiveOptions{}, DIGEST_MD5).ScanFile(test_dir / "missing", {}).digests);
+}
+
+TEST_F(ArchiveReaderTest, CorruptNestedArchiveDoesNotHideMembers) {
+    // gzip с целым заголовком и мусором вместо сжатых данных
+    Bytes bad = gzip_bytes(Bytes(4096, 'g'));
+    std::fill(bad.begin() + 10, bad.end(), '\xff');
+    // Zip обрезан посреди несжатых данных члена
+    const Bytes cut_zip = (zip_entry("inner.txt", Bytes(2000, 'i'), false, false) + zip_end()).substr(0, 60);
+    const auto path = Write("outer.tar", tar_entry("bad.gz", bad) + tar_entry("cut.zip", cut_zip) +
+                                         tar_entry("evil.txt", "malicious content") + tar_end());
+
+    const auto found = Scan(path);
+    EXPECT_TRUE(result.error.empty()) << result.error;
+    ASSERT_EQ(found.size(), 3u);
+    // Сам член - с дайджестом, как в базе, ошибка - отдельно
+    EXPECT_EQ(found.at("bad.gz"), md5_of(bad));
+    EXPECT_EQ(found.at("cut.zip"), md5_of(cut_zip));
+    EXPECT_EQ(found.at("evil.txt"), md5_of("malicious content"));
+    EXPECT_EQ(member_errors.size(), 2u);
+    EXPECT_EQ(member_errors.count("bad.gz"), 1u);
+    EXPECT_EQ(member_errors.count("cut.zip"), 1u);
+
+    // Лимиты по-прежнему обрывают весь файл, даже из вложенного архива
+    const auto bomb = Write("bomb.tar", tar_entry("inner.gz", gzip_bytes(Bytes(4 << 20, '\0'))) +
+                                        tar_entry("after.txt", "after") + tar_end());
+    ArchiveOptions options;
+    options.max_expanded_size = 1 << 20;
+    EXPECT_EQ(Scan(bomb, options).count("after.txt"), 0u);
+    EXPECT_FALSE(result.error.empty());
+}
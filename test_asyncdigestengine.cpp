@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "AsyncDigestEngine.h"
+
+class AsyncDigestEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!AsyncDigestEngine::available()) {
+            GTEST_SKIP() << "io_uring недоступен";
+        }
+        test_dir = std::filesystem::temp_directory_path() / "async_digest_test";
+        std::filesystem::create_directories(test_dir);
+        options.strategy = ReadStrategy::IoUring;
+        options.buffer_size = 64 << 10;
+        options.io_queue_depth = 8;
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(test_dir, ec);
+    }
+
+    std::filesystem::path CreateTestFile(const std::string& filename, size_t size) {
+        std::string content(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            content[i] = static_cast<char>((i * 131 + size) % 251);
+        }
+        const auto file_path = test_dir / filename;
+        std::ofstream file(file_path, std::ios::binary);
+        file.write(content.data(), content.size());
+        return file_path;
+    }
+
+    static void ExpectSameDigests(const FileDigests& actual, const FileDigests& expected) {
+        EXPECT_EQ(actual.algorithms, expected.algorithms);
+        EXPECT_EQ(actual.md5, expected.md5);
+        EXPECT_EQ(actual.sha1, expected.sha1);
+        EXPECT_EQ(actual.sha256, expected.sha256);
+    }
+
+    std::filesystem::path test_dir;
+    ReadOptions options;
+};
+
+TEST_F(AsyncDigestEngineTest, MatchesBlockingDigestsAtBufferBoundaries) {
+    AsyncDigestEngine engine(options, 2);
+    const size_t buffer = engine.lane_buffer_size();
+    const std::vector<size_t> sizes = {0, 1, buffer - 1, buffer, buffer + 1, 3 * buffer + 17, 5 << 20};
+
+    MD5Compute reference;
+    for (unsigned algorithms : {static_cast<unsigned>(DIGEST_MD5), DIGEST_ALL}) {
+        std::vector<std::optional<FileDigests>> results(sizes.size());
+        std::vector<std::filesystem::path> files;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            files.push_back(CreateTestFile("file_" + std::to_string(i), sizes[i]));
+            ASSERT_TRUE(engine.Submit(files.back(), algorithms,
+                                      [&results, i](std::optional<FileDigests> digests) {
+                                          results[i] = std::move(digests);
+                                      }));
+        }
+        engine.Drain();
+
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            SCOPED_TRACE("size " + std::to_string(sizes[i]));
+            auto expected = reference.computeFileDigests(files[i], algorithms);
+            ASSERT_TRUE(expected.has_value());
+            ASSERT_TRUE(results[i].has_value());
+            ExpectSameDigests(*results[i], *expected);
+        }
+    }
+}
+
+TEST_F(AsyncDigestEngineTest, SubmitFailsForMissingFile) {
+    AsyncDigestEngine engine(options, 1);
+    bool called = false;
+    EXPECT_FALSE(engine.Submit(test_dir / "missing.bin", DIGEST_MD5,
+                               [&called](std::optional<FileDigests>) { called = true; }));
+    engine.Drain();
+    EXPECT_FALSE(called);
+}
+
+TEST_F(AsyncDigestEngineTest, ThrowingCompletionIsCounted) {
+    ScanMetrics metrics;
+    AsyncDigestEngine engine(options, 1, &metrics);
+    ASSERT_TRUE(engine.Submit(CreateTestFile("one", 100), DIGEST_MD5, [](std::optional<FileDigests>) {
+        throw std::runtime_error("completion");
+    }));
+    std::atomic<int> calls{0};
+    ASSERT_TRUE(engine.Submit(CreateTestFile("two", 100), DIGEST_MD5,
+                              [&](std::optional<FileDigests>) { calls.fetch_add(1); }));
+    engine.Drain();
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_EQ(metrics.Snapshot().failed_completions, 1u);
+}
+
+TEST_F(AsyncDigestEngineTest, ManyFilesAcrossSubmitters) {
+    // Файлов больше глубины очереди: Submit ждет освобождения дорожек
+    options.io_submitters = 2;
+    options.io_queue_depth = 4;
+    const int files = 200;
+    std::vector<std::filesystem::path> paths;
+    for (int i = 0; i < files; ++i) {
+        paths.push_back(CreateTestFile("many_" + std::to_string(i), static_cast<size_t>(i) * 997));
+    }
+
+    MD5Compute reference;
+    std::mutex results_mutex;
+    std::vector<std::optional<FileDigests>> results(files);
+    std::atomic<int> completed{0};
+    {
+        AsyncDigestEngine engine(options, 3);
+        for (int i = 0; i < files; ++i) {
+            ASSERT_TRUE(engine.Submit(paths[i], DIGEST_ALL,
+                                      [&, i](std::optional<FileDigests> digests) {
+                                          std::lock_guard<std::mutex> lock(results_mutex);
+                                          results[i] = std::move(digests);
+                                          completed.fetch_add(1);
+                                      }));
+        }
+        // Деструктор дожидается всех отправленных файлов
+    }
+    ASSERT_EQ(completed.load(), files);
+    for (int i = 0; i < files; ++i) {
+        auto expected = reference.computeFileDigests(paths[i], DIGEST_ALL);
+        ASSERT_TRUE(results[i].has_value());
+        ExpectSameDigests(*results[i], *expected);
+    }
+}
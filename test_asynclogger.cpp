@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AsyncLogger.h"
+
+class AsyncLoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "async_logger_test";
+        std::filesystem::create_directories(test_dir);
+        log_path = test_dir / "scan.log";
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(test_dir, ec);
+    }
+
+    std::vector<std::string> ReadLines() const {
+        std::ifstream log(log_path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(log, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    std::filesystem::path test_dir;
+    std::filesystem::path log_path;
+};
+
+TEST_F(AsyncLoggerTest, FlushMakesRecordsVisibleInOrder) {
+    AsyncLogger logger(log_path.string());
+    for (int i = 0; i < 100; ++i) {
+        logger.Record() << "запись " << i;
+    }
+    logger.Flush();
+
+    const auto lines = ReadLines();
+    ASSERT_EQ(lines.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(lines[i], "запись " + std::to_string(i));
+    }
+}
+
+TEST_F(AsyncLoggerTest, AppendsToExistingFile) {
+    {
+        std::ofstream log(log_path);
+        log << "старая строка\n";
+    }
+    {
+        AsyncLogger logger(log_path.string());
+        logger.Write("новая строка\n");
+    }
+    const auto lines = ReadLines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "старая строка");
+    EXPECT_EQ(lines[1], "новая строка");
+}
+
+TEST_F(AsyncLoggerTest, DestructorDrainsQueue) {
+    {
+        // Маленькая очередь: писатели ждут поток логгера, но ничего не теряется
+        AsyncLogger logger(log_path.string(), AsyncLogger::DEFAULT_FLUSH_INTERVAL, 4);
+        for (int i = 0; i < 5000; ++i) {
+            logger.Record() << i;
+        }
+    }
+    EXPECT_EQ(ReadLines().size(), 5000u);
+}
+
+TEST_F(AsyncLoggerTest, MultiLineRecordsFromManyThreadsStayWhole) {
+    const int threads = 8;
+    const int records = 500;
+    {
+        AsyncLogger logger(log_path.string());
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&logger, t] {
+                for (int i = 0; i < records; ++i) {
+                    logger.Record() << "начало " << t << '\n' << "конец " << t;
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+    }
+
+    const auto lines = ReadLines();
+    ASSERT_EQ(lines.size(), static_cast<size_t>(threads * records * 2));
+    const std::string begin = "начало ";
+    const std::string end = "конец ";
+    for (size_t i = 0; i < lines.size(); i += 2) {
+        ASSERT_EQ(lines[i].compare(0, begin.size(), begin), 0);
+        ASSERT_EQ(lines[i + 1].compare(0, end.size(), end), 0);
+        EXPECT_EQ(lines[i].substr(begin.size()), lines[i + 1].substr(end.size()));
+    }
+}
+
+TEST_F(AsyncLoggerTest, ThrowsWhenFileCannotBeOpened) {
+    EXPECT_THROW(AsyncLogger((test_dir / "missing" / "scan.log").string()), std::runtime_error);
+}
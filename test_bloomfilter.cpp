@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include "BloomFilter.h"
+
+class BloomFilterTest : public ::testing::Test {
+protected:
+    static std::vector<uint64_t> RandomKeys(size_t count, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::vector<uint64_t> keys(count);
+        for (auto& key : keys) {
+            key = rng();
+        }
+        return keys;
+    }
+};
+
+TEST_F(BloomFilterTest, EmptyFilterPassesEverything) {
+    BloomFilter filter;
+    EXPECT_TRUE(filter.empty());
+    EXPECT_TRUE(filter.may_contain(0x1234567890abcdefULL));
+}
+
+TEST_F(BloomFilterTest, NoFalseNegatives) {
+    const auto keys = RandomKeys(50000, 1);
+    
+    BloomFilter filter;
+    filter.init(keys.size());
+    for (auto key : keys) {
+        filter.insert(key);
+    }
+    
+    for (auto key : keys) {
+        ASSERT_TRUE(filter.may_contain(key));
+    }
+}
+
+TEST_F(BloomFilterTest, FalsePositiveRateIsBounded) {
+    const auto keys = RandomKeys(100000, 2);
+    const auto probes = RandomKeys(200000, 3);
+    
+    BloomFilter filter;
+    filter.init(keys.size(), 8);
+    for (auto key : keys) {
+        filter.insert(key);
+    }
+    EXPECT_EQ(filter.size_bytes(), keys.size() * 8 / 8);
+    
+    size_t false_positives = 0;
+    for (auto probe : probes) {
+        false_positives += filter.may_contain(probe) ? 1 : 0;
+    }
+    // Для 8 бит на ключ ожидается около 2-3%
+    EXPECT_LT(static_cast<double>(false_positives) / probes.size(), 0.05);
+}
+
+TEST_F(BloomFilterTest, AttachedFilterMatchesOwned) {
+    const auto keys = RandomKeys(1000, 4);
+    
+    BloomFilter owned;
+    owned.init(keys.size());
+    for (auto key : keys) {
+        owned.insert(key);
+    }
+    
+    BloomFilter attached;
+    ASSERT_TRUE(attached.attach(owned.data(), owned.block_count()));
+    for (auto key : RandomKeys(5000, 5)) {
+        EXPECT_EQ(owned.may_contain(key), attached.may_contain(key));
+    }
+    for (auto key : keys) {
+        EXPECT_TRUE(attached.may_contain(key));
+    }
+}
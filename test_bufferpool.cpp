@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+#include "BufferPool.h"
+
+TEST(BufferPoolTest, BuffersAreAlignedAndDistinct) {
+    BufferPool pool(4, 1000);
+    EXPECT_EQ(pool.buffer_size(), BufferPool::ALIGNMENT);
+    EXPECT_EQ(pool.count(), 4u);
+
+    std::set<unsigned char*> seen;
+    for (int i = 0; i < 4; ++i) {
+        unsigned char* buffer = pool.TryAcquire();
+        ASSERT_NE(buffer, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer) % BufferPool::ALIGNMENT, 0u);
+        seen.insert(buffer);
+    }
+    EXPECT_EQ(seen.size(), 4u);
+    EXPECT_EQ(pool.TryAcquire(), nullptr);
+    EXPECT_EQ(pool.available(), 0u);
+
+    for (unsigned char* buffer : seen) {
+        pool.Release(buffer);
+    }
+    EXPECT_EQ(pool.available(), 4u);
+}
+
+TEST(BufferPoolTest, BuffersAreRecycled) {
+    BufferPool pool(1, 4096);
+    unsigned char* first = pool.Acquire();
+    pool.Release(first);
+    EXPECT_EQ(pool.Acquire(), first);
+}
+
+TEST(BufferPoolTest, AcquireWaitsForRelease) {
+    BufferPool pool(1, 4096);
+    unsigned char* held = pool.Acquire();
+    std::atomic<bool> acquired{false};
+
+    std::thread waiter([&] {
+        unsigned char* buffer = pool.Acquire();
+        acquired = true;
+        pool.Release(buffer);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(acquired.load());
+
+    pool.Release(held);
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+}
+
+TEST(BufferPoolTest, RejectsEmptyPool) {
+    EXPECT_THROW(BufferPool(0, 4096), std::invalid_argument);
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "DigestCache.h"
+
+class DigestCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "digest_cache_test";
+        std::filesystem::create_directories(test_dir);
+        cache_path = (test_dir / "digests.cache").string();
+    }
+    
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(test_dir, ec);
+    }
+    
+    static FileIdentity MakeIdentity(uint64_t inode, int64_t mtime_ns = 1000) {
+        FileIdentity identity;
+        identity.device = 7;
+        identity.inode = inode;
+        identity.size = 100 + inode;
+        identity.mtime_ns = mtime_ns;
+        identity.ctime_ns = mtime_ns;
+        identity.observed_ns = mtime_ns + 10'000'000'000;
+        return identity;
+    }
+    
+    static FileDigests MakeDigests(unsigned char seed) {
+        FileDigests digests;
+        digests.algorithms = DIGEST_MD5 | DIGEST_SHA256;
+        digests.md5.fill(seed);
+        digests.sha256.fill(static_cast<unsigned char>(seed + 1));
+        return digests;
+    }
+    
+    std::filesystem::path test_dir;
+    std::string cache_path;
+};
+
+TEST_F(DigestCacheTest, LookupRequiresMatchingMetadata) {
+    DigestCache cache(cache_path);
+    cache.store(MakeIdentity(1), MakeDigests(0x11));
+    
+    auto hit = cache.lookup(MakeIdentity(1), DIGEST_MD5);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->md5, MakeDigests(0x11).md5);
+    
+    // Изменились mtime или размер, либо нужен алгоритм, которого нет в записи
+    EXPECT_FALSE(cache.lookup(MakeIdentity(1, 2000), DIGEST_MD5).has_value());
+    auto resized = MakeIdentity(1);
+    resized.size += 1;
+    EXPECT_FALSE(cache.lookup(resized, DIGEST_MD5).has_value());
+    EXPECT_FALSE(cache.lookup(MakeIdentity(1), DIGEST_SHA1).has_value());
+    EXPECT_FALSE(cache.lookup(MakeIdentity(2), DIGEST_MD5).has_value());
+}
+
+TEST_F(DigestCacheTest, RecentlyModifiedFilesAreNotCached) {
+    DigestCache cache(cache_path);
+    auto identity = MakeIdentity(1);
+    identity.observed_ns = identity.ctime_ns + 1'000'000;
+    cache.store(identity, MakeDigests(0x11));
+    EXPECT_FALSE(cache.lookup(identity, DIGEST_MD5).has_value());
+    EXPECT_EQ(cache.log_records(), 0);
+}
+
+TEST_F(DigestCacheTest, SurvivesReopenAndCompaction) {
+    {
+        DigestCache cache(cache_path);
+        for (uint64_t inode = 1; inode <= 100; ++inode) {
+            cache.store(MakeIdentity(inode), MakeDigests(static_cast<unsigned char>(inode)));
+        }
+    }
+    {
+        DigestCache cache(cache_path);
+        EXPECT_EQ(cache.log_records(), 100);
+        EXPECT_EQ(cache.index_records(), 0);
+        cache.compact();
+        EXPECT_EQ(cache.log_records(), 0);
+        EXPECT_EQ(cache.index_records(), 100);
+        
+        // Новая запись в журнале перекрывает запись индекса
+        cache.store(MakeIdentity(5, 5000), MakeDigests(0xee));
+        cache.store(MakeIdentity(500), MakeDigests(0x50));
+    }
+    
+    DigestCache cache(cache_path);
+    EXPECT_TRUE(cache.load_warnings().empty());
+    EXPECT_FALSE(cache.lookup(MakeIdentity(5), DIGEST_MD5).has_value());
+    EXPECT_EQ(cache.lookup(MakeIdentity(5, 5000), DIGEST_MD5)->md5, MakeDigests(0xee).md5);
+    EXPECT_EQ(cache.lookup(MakeIdentity(42), DIGEST_SHA256)->sha256, MakeDigests(42).sha256);
+    
+    cache.compact();
+    EXPECT_EQ(cache.index_records(), 101);
+    EXPECT_EQ(cache.lookup(MakeIdentity(5, 5000), DIGEST_MD5)->md5, MakeDigests(0xee).md5);
+    EXPECT_EQ(cache.lookup(MakeIdentity(500), DIGEST_MD5)->md5, MakeDigests(0x50).md5);
+}
+
+TEST_F(DigestCacheTest, TornJournalTailIsDropped) {
+    {
+        DigestCache cache(cache_path);
+        cache.store(MakeIdentity(1), MakeDigests(0x11));
+        cache.store(MakeIdentity(2), MakeDigests(0x22));
+    }
+    const auto log_size = std::filesystem::file_size(cache_path + ".log");
+    std::filesystem::resize_file(cache_path + ".log", log_size - 10);
+    
+    {
+        DigestCache cache(cache_path);
+        EXPECT_FALSE(cache.load_warnings().empty());
+        EXPECT_TRUE(cache.lookup(MakeIdentity(1), DIGEST_MD5).has_value());
+        EXPECT_FALSE(cache.lookup(MakeIdentity(2), DIGEST_MD5).has_value());
+        cache.store(MakeIdentity(3), MakeDigests(0x33));
+    }
+    
+    DigestCache cache(cache_path);
+    EXPECT_TRUE(cache.load_warnings().empty());
+    EXPECT_TRUE(cache.lookup(MakeIdentity(3), DIGEST_MD5).has_value());
+}
+
+TEST_F(DigestCacheTest, DropDeviceAndRemove) {
+    {
+        DigestCache cache(cache_path);
+        cache.store(MakeIdentity(1), MakeDigests(0x11));
+        auto other_device = MakeIdentity(2);
+        other_device.device = 8;
+        cache.store(other_device, MakeDigests(0x22));
+        cache.compact();
+        
+        EXPECT_EQ(cache.drop_device(7), 1);
+        EXPECT_FALSE(cache.lookup(MakeIdentity(1), DIGEST_MD5).has_value());
+        EXPECT_TRUE(cache.lookup(other_device, DIGEST_MD5).has_value());
+    }
+    
+    DigestCache::remove(cache_path);
+    EXPECT_FALSE(std::filesystem::exists(cache_path));
+    EXPECT_FALSE(std::filesystem::exists(cache_path + ".log"));
+}
+
+TEST_F(DigestCacheTest, JournalBeyondMemoryLimitStaysOnDisk) {
+    constexpr size_t memory_records = 8;
+    {
+        DigestCache cache(cache_path, DigestCache::DEFAULT_RACY_WINDOW, memory_records);
+        for (uint64_t inode = 1; inode <= 50; ++inode) {
+            cache.store(MakeIdentity(inode), MakeDigests(static_cast<unsigned char>(inode)));
+        }
+        // Новая версия записи в другой серии сортировки перекрывает старую
+        cache.store(MakeIdentity(3, 3000), MakeDigests(0x33));
+        EXPECT_EQ(cache.log_records(), 51);
+        EXPECT_TRUE(cache.lookup(MakeIdentity(1), DIGEST_MD5).has_value());
+        // Сверх лимита запись видна только после сжатия
+        EXPECT_FALSE(cache.lookup(MakeIdentity(40), DIGEST_MD5).has_value());
+    }
+
+    // Журнал больше лимита сжимается при открытии
+    DigestCache cache(cache_path, DigestCache::DEFAULT_RACY_WINDOW, memory_records);
+    EXPECT_EQ(cache.log_records(), 0);
+    EXPECT_EQ(cache.index_records(), 50);
+    for (uint64_t inode = 1; inode <= 50; ++inode) {
+        if (inode != 3) {
+            EXPECT_EQ(cache.lookup(MakeIdentity(inode), DIGEST_MD5)->md5,
+                      MakeDigests(static_cast<unsigned char>(inode)).md5);
+        }
+    }
+    EXPECT_FALSE(cache.lookup(MakeIdentity(3), DIGEST_MD5).has_value());
+    EXPECT_EQ(cache.lookup(MakeIdentity(3, 3000), DIGEST_MD5)->md5, MakeDigests(0x33).md5);
+    EXPECT_FALSE(std::filesystem::exists(cache_path + ".run0"));
+}
+
+TEST_F(DigestCacheTest, PruneDropsUnseenRecords) {
+    {
+        DigestCache cache(cache_path);
+        for (uint64_t inode = 1; inode <= 10; ++inode) {
+            cache.store(MakeIdentity(inode), MakeDigests(static_cast<unsigned char>(inode)));
+        }
+        cache.compact();
+        cache.store(MakeIdentity(30), MakeDigests(0x30));
+        cache.store(MakeIdentity(31), MakeDigests(0x31));
+    }
+
+    DigestCache cache(cache_path);
+    for (uint64_t inode = 1; inode <= 5; ++inode) {
+        EXPECT_TRUE(cache.lookup(MakeIdentity(inode), DIGEST_MD5).has_value());
+    }
+    EXPECT_TRUE(cache.lookup(MakeIdentity(30), DIGEST_MD5).has_value());
+    // Запись с другими метаданными - не встреча, файл изменился
+    EXPECT_FALSE(cache.lookup(MakeIdentity(6, 6000), DIGEST_MD5).has_value());
+    cache.store(MakeIdentity(20), MakeDigests(0x20));
+
+    // Не встречены 6..10 из индекса и 31 из журнала прошлого запуска
+    EXPECT_EQ(cache.prune(), 6u);
+    EXPECT_EQ(cache.index_records(), 7);
+    EXPECT_TRUE(cache.lookup(MakeIdentity(1), DIGEST_MD5).has_value());
+    EXPECT_TRUE(cache.lookup(MakeIdentity(20), DIGEST_MD5).has_value());
+    EXPECT_TRUE(cache.lookup(MakeIdentity(30), DIGEST_MD5).has_value());
+    EXPECT_FALSE(cache.lookup(MakeIdentity(6), DIGEST_MD5).has_value());
+    EXPECT_FALSE(cache.lookup(MakeIdentity(31), DIGEST_MD5).has_value());
+
+    // Сжатие сбрасывает отметки: остаются только найденные после него 1, 20, 30
+    EXPECT_EQ(cache.prune(), 4u);
+    EXPECT_EQ(cache.index_records(), 3);
+}
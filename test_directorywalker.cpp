@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "DirectoryWalker.h"
+#include "ThreadPool.h"
+
+class DirectoryWalkerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "walker_test";
+        std::filesystem::remove_all(test_dir);
+        std::filesystem::create_directories(test_dir);
+    }
+    
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(test_dir, ec);
+    }
+    
+    void CreateFile(const std::filesystem::path& path) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << path.filename().string();
+    }
+    
+    std::set<std::string> Walk(size_t thread_count) {
+        std::set<std::string> files;
+        std::mutex mutex;
+        ThreadPool<std::function<void()>> pool(thread_count);
+        DirectoryWalker walker(
+            [&pool](std::function<void()> task) { pool.Add(std::move(task)); },
+            [&](int, const std::filesystem::path& directory, std::vector<std::string>& names) {
+                EXPECT_LE(names.size(), DirectoryWalker::MAX_FILE_BATCH);
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& name : names) {
+                    files.insert((directory / name).lexically_relative(test_dir).string());
+                }
+            },
+            [](const std::filesystem::path&, int) {});
+        walker.Walk(test_dir);
+        return files;
+    }
+    
+    std::filesystem::path test_dir;
+};
+
+TEST_F(DirectoryWalkerTest, FindsSameFilesAsRecursiveIterator) {
+    for (int dir = 0; dir < 20; ++dir) {
+        for (int file = 0; file < 30; ++file) {
+            CreateFile(test_dir / ("d" + std::to_string(dir)) / ("sub" + std::to_string(file % 3)) /
+                       ("f" + std::to_string(file)));
+        }
+    }
+    CreateFile(test_dir / "top.txt");
+    std::filesystem::create_directories(test_dir / "empty" / "deeper");
+    
+    std::set<std::string> expected;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(test_dir)) {
+        if (entry.is_regular_file()) {
+            expected.insert(entry.path().lexically_relative(test_dir).string());
+        }
+    }
+    ASSERT_EQ(expected.size(), 601);
+    
+    EXPECT_EQ(Walk(1), expected);
+    EXPECT_EQ(Walk(8), expected);
+}
+
+TEST_F(DirectoryWalkerTest, LargeDirectoryIsSplitIntoBatches) {
+    const size_t count = DirectoryWalker::MAX_FILE_BATCH * 2 + 17;
+    for (size_t i = 0; i < count; ++i) {
+        CreateFile(test_dir / "big" / ("f" + std::to_string(i)));
+    }
+    EXPECT_EQ(Walk(4).size(), count);
+}
+
+TEST_F(DirectoryWalkerTest, SymlinksToFilesOnly) {
+    CreateFile(test_dir / "real" / "a.txt");
+    std::filesystem::create_symlink(test_dir / "real" / "a.txt", test_dir / "link_to_file");
+    std::filesystem::create_directory_symlink(test_dir / "real", test_dir / "link_to_dir");
+    std::filesystem::create_symlink(test_dir / "missing", test_dir / "broken_link");
+    
+    const std::set<std::string> expected{"real/a.txt", "link_to_file"};
+    EXPECT_EQ(Walk(4), expected);
+}
+
+TEST_F(DirectoryWalkerTest, MissingRootThrows) {
+    ThreadPool<std::function<void()>> pool(2);
+    DirectoryWalker walker(
+        [&pool](std::function<void()> task) { pool.Add(std::move(task)); },
+        [](int, const std::filesystem::path&, std::vector<std::string>&) {},
+        [](const std::filesystem::path&, int) {});
+    EXPECT_THROW(walker.Walk(test_dir / "missing"), std::runtime_error);
+}
@@ -1,7 +1,8 @@
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <fstream>
-#include <cstdio>     
+#include <cstdio>
+#include <cstring>
 #include <filesystem>   
 #include "HashBase.h"
 
@@ -97,4 +98,453 @@ TEST_F(HashBaseTest, EmptyFile) {
     
     std::error_code ec;
     std::filesystem::remove(empty_csv_path, ec);
-}
\ No newline at end of file
+}
+
+TEST_F(HashBaseTest, BinaryDigestLookup) {
+    HashBase hash_base;
+    hash_base.load_hashes(temp_csv_path.string());
+    
+    MD5Digest digest;
+    ASSERT_TRUE(parse_hex_digest("ac6204ffeb36d2320e52f1d551cfa370", digest));
+    
+    auto verdict = hash_base.get_verdict(digest);
+    ASSERT_NE(verdict, nullptr);
+    EXPECT_EQ(*verdict, "Dropper");
+    EXPECT_EQ(hash_base.size(), 3);
+    
+    // Строки неправильной длины и не-hex символы не совпадают ни с чем
+    EXPECT_EQ(hash_base.get_verdict("ac6204ffeb36d2320e52f1d551cfa37"), nullptr);
+    EXPECT_EQ(hash_base.get_verdict("zc6204ffeb36d2320e52f1d551cfa370"), nullptr);
+}
+
+TEST_F(HashBaseTest, SharedVerdictPoolAndInvalidRows) {
+    auto csv_path = std::filesystem::temp_directory_path() / "test_hashes_pool.csv";
+    {
+        std::ofstream csv_file(csv_path);
+        csv_file << "00000000000000000000000000000001;Trojan\n";
+        csv_file << "00000000000000000000000000000002;Trojan\n";
+        csv_file << "00000000000000000000000000000001;Duplicate\n";  // первая запись побеждает
+        csv_file << "not_a_hex_hash;Worm\n";
+        csv_file << "# комментарий; с разделителем\n";
+    }
+    
+    HashBase hash_base;
+    hash_base.load_hashes(csv_path.string());
+    
+    EXPECT_EQ(hash_base.size(), 2);
+    auto verdict1 = hash_base.get_verdict("00000000000000000000000000000001");
+    auto verdict2 = hash_base.get_verdict("00000000000000000000000000000002");
+    ASSERT_NE(verdict1, nullptr);
+    ASSERT_NE(verdict2, nullptr);
+    EXPECT_EQ(*verdict1, "Trojan");
+    // Одинаковые вердикты хранятся в пуле один раз
+    EXPECT_EQ(verdict1, verdict2);
+    
+    std::error_code ec;
+    std::filesystem::remove(csv_path, ec);
+}
+
+TEST_F(HashBaseTest, ManyEntriesGrowTable) {
+    auto csv_path = std::filesystem::temp_directory_path() / "test_hashes_many.csv";
+    {
+        std::ofstream csv_file(csv_path);
+        for (int i = 0; i < 10000; ++i) {
+            MD5Digest digest{};
+            digest[0] = static_cast<unsigned char>(i & 0xff);
+            digest[15] = static_cast<unsigned char>(i >> 8);
+            csv_file << digest_to_hex(digest) << ";Verdict" << (i % 7) << "\n";
+        }
+    }
+    
+    HashBase hash_base;
+    hash_base.load_hashes(csv_path.string());
+    EXPECT_EQ(hash_base.size(), 10000);
+    
+    for (int i = 0; i < 10000; i += 97) {
+        MD5Digest digest{};
+        digest[0] = static_cast<unsigned char>(i & 0xff);
+        digest[15] = static_cast<unsigned char>(i >> 8);
+        auto verdict = hash_base.get_verdict(digest);
+        ASSERT_NE(verdict, nullptr);
+        EXPECT_EQ(*verdict, "Verdict" + std::to_string(i % 7));
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove(csv_path, ec);
+}
+
+TEST_F(HashBaseTest, CompiledImageRoundTrip) {
+    auto image_path = std::filesystem::temp_directory_path() / "test_hashes.img";
+    
+    HashBase source;
+    source.load_hashes(temp_csv_path.string());
+    source.save_image(image_path.string());
+    
+    EXPECT_TRUE(HashBase::is_image(image_path.string()));
+    EXPECT_FALSE(HashBase::is_image(temp_csv_path.string()));
+    
+    HashBase hash_base;
+    EXPECT_NO_THROW(hash_base.load_image(image_path.string(), true));
+    EXPECT_EQ(hash_base.size(), 3);
+    
+    auto verdict = hash_base.get_verdict("8EE70903F43B227EEB971262268AF5A8");
+    ASSERT_NE(verdict, nullptr);
+    EXPECT_EQ(*verdict, "Downloader");
+    EXPECT_EQ(hash_base.get_verdict("deadbeefdeadbeefdeadbeefdeadbeef"), nullptr);
+    
+    // load() сам определяет формат по сигнатуре
+    HashBase auto_base;
+    auto_base.load(image_path.string());
+    EXPECT_NE(auto_base.get_verdict("a9963513d093ffb2bc7ceb9807771ad4"), nullptr);
+    
+    std::error_code ec;
+    std::filesystem::remove(image_path, ec);
+}
+
+TEST_F(HashBaseTest, CompiledImageCorruption) {
+    auto image_path = std::filesystem::temp_directory_path() / "test_hashes_corrupt.img";
+    
+    HashBase source;
+    source.load_hashes(temp_csv_path.string());
+    source.save_image(image_path.string());
+    
+    // Портим байт в области данных: заголовок цел, полная проверка падает
+    {
+        std::fstream image(image_path, std::ios::in | std::ios::out | std::ios::binary);
+        image.seekp(-1, std::ios::end);
+        image.put('X');
+    }
+    
+    HashBase fast_base;
+    EXPECT_NO_THROW(fast_base.load_image(image_path.string()));
+    
+    HashBase verified_base;
+    EXPECT_THROW(verified_base.load_image(image_path.string(), true), std::runtime_error);
+    
+    // Обрезанный файл отвергается сразу
+    std::filesystem::resize_file(image_path, 20);
+    HashBase truncated_base;
+    EXPECT_THROW(truncated_base.load_image(image_path.string()), std::runtime_error);
+    
+    std::error_code ec;
+    std::filesystem::remove(image_path, ec);
+}
+
+TEST_F(HashBaseTest, CompiledImageAcceptsNewRows) {
+    auto image_path = std::filesystem::temp_directory_path() / "test_hashes_extend.img";
+    auto extra_csv = std::filesystem::temp_directory_path() / "test_hashes_extra.csv";
+    
+    HashBase source;
+    source.load_hashes(temp_csv_path.string());
+    source.save_image(image_path.string());
+    {
+        std::ofstream csv_file(extra_csv);
+        csv_file << "00000000000000000000000000000042;Exploit\n";
+    }
+    
+    HashBase hash_base;
+    hash_base.load_image(image_path.string());
+    hash_base.load_hashes(extra_csv.string());
+    
+    EXPECT_EQ(hash_base.size(), 4);
+    auto added = hash_base.get_verdict("00000000000000000000000000000042");
+    auto existing = hash_base.get_verdict("a9963513d093ffb2bc7ceb9807771ad4");
+    ASSERT_NE(added, nullptr);
+    ASSERT_NE(existing, nullptr);
+    EXPECT_EQ(added, existing);
+    
+    std::error_code ec;
+    std::filesystem::remove(image_path, ec);
+    std::filesystem::remove(extra_csv, ec);
+}
+
+TEST_F(HashBaseTest, MalformedLineWarnings) {
+    HashBase hash_base;
+    hash_base.load_hashes(temp_csv_path.string());
+    
+    // Строка без ';' пропускается молча, как и раньше
+    EXPECT_EQ(hash_base.malformed_lines(), 0);
+    
+    auto csv_path = std::filesystem::temp_directory_path() / "test_hashes_warnings.csv";
+    {
+        std::ofstream csv_file(csv_path);
+        csv_file << "a9963513d093ffb2bc7ceb9807771ad4;Exploit\n";
+        csv_file << "bad_hash;Worm\n";
+        csv_file << "\r\n";
+        csv_file << "ac6204ffeb36d2320e52f1d551cfa370;  \n";
+    }
+    HashBase warned_base;
+    warned_base.load_hashes(csv_path.string());
+    
+    ASSERT_EQ(warned_base.malformed_lines(), 2);
+    ASSERT_EQ(warned_base.load_warnings().size(), 2);
+    EXPECT_NE(warned_base.load_warnings()[0].find("строка 2 "), std::string::npos);
+    EXPECT_NE(warned_base.load_warnings()[1].find("строка 4 "), std::string::npos);
+    
+    std::error_code ec;
+    std::filesystem::remove(csv_path, ec);
+}
+
+TEST_F(HashBaseTest, ParallelLoadMatchesSingleThread) {
+    // Файл больше нескольких минимальных кусков, чтобы загрузка шла параллельно
+    auto csv_path = std::filesystem::temp_directory_path() / "test_hashes_parallel.csv";
+    const int rows = 120000;
+    {
+        std::ofstream csv_file(csv_path);
+        for (int i = 0; i < rows; ++i) {
+            if (i % 10007 == 0) {
+                csv_file << "broken row " << i << ";Virus\n";
+                continue;
+            }
+            MD5Digest digest{};
+            std::memcpy(digest.data(), &i, sizeof(i));
+            csv_file << digest_to_hex(digest) << " ; Family" << (i % 13) << "\r\n";
+        }
+    }
+    
+    HashBase single;
+    single.load_hashes(csv_path.string(), 1);
+    HashBase parallel;
+    parallel.load_hashes(csv_path.string(), 8);
+    
+    EXPECT_EQ(single.size(), parallel.size());
+    EXPECT_EQ(parallel.size(), rows - 12);
+    EXPECT_EQ(single.load_warnings(), parallel.load_warnings());
+    ASSERT_EQ(parallel.malformed_lines(), 12);
+    EXPECT_NE(parallel.load_warnings()[11].find("строка 110078 "), std::string::npos);
+    
+    for (int i = 1; i < rows; i += 331) {
+        if (i % 10007 == 0) continue;
+        MD5Digest digest{};
+        std::memcpy(digest.data(), &i, sizeof(i));
+        auto verdict = parallel.get_verdict(digest);
+        ASSERT_NE(verdict, nullptr);
+        EXPECT_EQ(*verdict, "Family" + std::to_string(i % 13));
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove(csv_path, ec);
+}
+
+TEST_F(HashBaseTest, PrefilterHasNoFalseNegatives) {
+    HashBase hash_base;
+    hash_base.load_hashes(temp_csv_path.string());
+    EXPECT_FALSE(hash_base.has_prefilter());
+    
+    hash_base.build_prefilter();
+    ASSERT_TRUE(hash_base.has_prefilter());
+    EXPECT_GT(hash_base.prefilter_bytes(), 0);
+    
+    for (const char* hex : {"a9963513d093ffb2bc7ceb9807771ad4",
+                            "ac6204ffeb36d2320e52f1d551cfa370",
+                            "8ee70903f43b227eeb971262268af5a8"}) {
+        MD5Digest digest;
+        ASSERT_TRUE(parse_hex_digest(hex, digest));
+        EXPECT_TRUE(hash_base.may_contain(digest));
+    }
+}
+
+TEST_F(HashBaseTest, PrefilterStoredInCompiledImage) {
+    auto image_path = std::filesystem::temp_directory_path() / "test_hashes_prefilter.img";
+    
+    HashBase source;
+    source.load_hashes(temp_csv_path.string());
+    source.build_prefilter(16);
+    source.save_image(image_path.string());
+    
+    HashBase hash_base;
+    hash_base.load_image(image_path.string(), true);
+    ASSERT_TRUE(hash_base.has_prefilter());
+    EXPECT_EQ(hash_base.prefilter_bytes(), source.prefilter_bytes());
+    
+    MD5Digest digest;
+    ASSERT_TRUE(parse_hex_digest("8ee70903f43b227eeb971262268af5a8", digest));
+    EXPECT_TRUE(hash_base.may_contain(digest));
+    
+    std::error_code ec;
+    std::filesystem::remove(image_path, ec);
+}
+
+TEST_F(HashBaseTest, ApplyDeltaAddsAndRemoves) {
+    auto delta_path = std::filesystem::temp_directory_path() / "test_hashes.delta";
+    {
+        std::ofstream delta(delta_path);
+        delta << "# дельта\n";
+        delta << "-a9963513d093ffb2bc7ceb9807771ad4\n";
+        delta << "+00000000000000000000000000000042;Ransomware\n";
+        delta << "+ac6204ffeb36d2320e52f1d551cfa370;Backdoor\n";
+        delta << "-deadbeefdeadbeefdeadbeefdeadbeef\n";
+        delta << "+not_a_hash;Worm\n";
+    }
+    
+    HashBase original;
+    original.load_hashes(temp_csv_path.string());
+    auto hash_base = original.clone();
+    hash_base->apply_delta(delta_path.string());
+    
+    EXPECT_EQ(hash_base->size(), 3);
+    EXPECT_EQ(hash_base->get_verdict("a9963513d093ffb2bc7ceb9807771ad4"), nullptr);
+    ASSERT_NE(hash_base->get_verdict("00000000000000000000000000000042"), nullptr);
+    EXPECT_EQ(*hash_base->get_verdict("00000000000000000000000000000042"), "Ransomware");
+    EXPECT_EQ(*hash_base->get_verdict("ac6204ffeb36d2320e52f1d551cfa370"), "Backdoor");
+    EXPECT_EQ(*hash_base->get_verdict("8ee70903f43b227eeb971262268af5a8"), "Downloader");
+    EXPECT_EQ(hash_base->malformed_lines(), 1);
+    
+    // Исходная база не изменилась
+    EXPECT_EQ(original.size(), 3);
+    EXPECT_NE(original.get_verdict("a9963513d093ffb2bc7ceb9807771ad4"), nullptr);
+    
+    std::error_code ec;
+    std::filesystem::remove(delta_path, ec);
+}
+
+TEST_F(HashBaseTest, EraseKeepsProbeChainsIntact) {
+    auto csv_path = std::filesystem::temp_directory_path() / "test_hashes_erase.csv";
+    auto delta_path = std::filesystem::temp_directory_path() / "test_hashes_erase.delta";
+    const int rows = 5000;
+    auto make_digest = [](int i) {
+        MD5Digest digest{};
+        std::memcpy(digest.data(), &i, sizeof(i));
+        return digest;
+    };
+    {
+        std::ofstream csv_file(csv_path);
+        std::ofstream delta(delta_path);
+        for (int i = 0; i < rows; ++i) {
+            csv_file << digest_to_hex(make_digest(i)) << ";V" << i % 3 << "\n";
+            if (i % 3 == 0) {
+                delta << "-" << digest_to_hex(make_digest(i)) << "\n";
+            }
+        }
+    }
+    
+    HashBase hash_base;
+    hash_base.load_hashes(csv_path.string());
+    hash_base.apply_delta(delta_path.string());
+    
+    EXPECT_EQ(hash_base.size(), rows - (rows + 2) / 3);
+    for (int i = 0; i < rows; ++i) {
+        const bool removed = (i % 3 == 0);
+        EXPECT_EQ(hash_base.get_verdict(make_digest(i)) == nullptr, removed) << i;
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove(csv_path, ec);
+    std::filesystem::remove(delta_path, ec);
+}
+
+TEST_F(HashBaseTest, AlgorithmTaggedRows) {
+    {
+        std::ofstream csv_file(temp_csv_path, std::ios::app);
+        // Метка алгоритма явная или выводится из длины hex
+        csv_file << "sha1:cb74f840da07ec3af03cada028e5952850184a3f;Trojan\n";
+        csv_file << "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3;Trojan\n";
+        csv_file << "SHA256 : 0000000000000000000000000000000000000000000000000000000000000001;Worm\n";
+        csv_file << "sha1:a9963513d093ffb2bc7ceb9807771ad4;Broken\n";
+        csv_file << "crc32:deadbeef;Broken\n";
+    }
+    
+    HashBase hash_base;
+    hash_base.load_hashes(temp_csv_path.string());
+    EXPECT_EQ(hash_base.size(), 6);
+    EXPECT_EQ(hash_base.malformed_lines(), 2);
+    EXPECT_EQ(hash_base.algorithms(), DIGEST_MD5 | DIGEST_SHA1 | DIGEST_SHA256);
+    
+    ASSERT_NE(hash_base.get_verdict("cb74f840da07ec3af03cada028e5952850184a3f"), nullptr);
+    EXPECT_EQ(*hash_base.get_verdict("sha256:e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3"), "Trojan");
+    EXPECT_EQ(*hash_base.get_verdict("md5:a9963513d093ffb2bc7ceb9807771ad4"), "Exploit");
+    EXPECT_EQ(hash_base.get_verdict("sha256:a9963513d093ffb2bc7ceb9807771ad4"), nullptr);
+    
+    // Один набор дайджестов файла проверяется по всем таблицам
+    FileDigests digests;
+    digests.algorithms = DIGEST_MD5 | DIGEST_SHA256;
+    ASSERT_TRUE(parse_hex_digest("0000000000000000000000000000000000000000000000000000000000000001", digests.sha256));
+    DigestAlgorithm matched = DIGEST_MD5;
+    auto verdict = hash_base.get_verdict(digests, &matched);
+    ASSERT_NE(verdict, nullptr);
+    EXPECT_EQ(*verdict, "Worm");
+    EXPECT_EQ(matched, DIGEST_SHA256);
+    
+    digests.algorithms = DIGEST_MD5;
+    EXPECT_EQ(hash_base.get_verdict(digests), nullptr);
+    
+    hash_base.build_prefilter();
+    digests.algorithms = DIGEST_SHA256;
+    EXPECT_TRUE(hash_base.may_contain(digests));
+}
+
+TEST_F(HashBaseTest, AlgorithmTablesInCompiledImageAndDelta) {
+    auto image_path = std::filesystem::temp_directory_path() / "test_hashes_multi.img";
+    auto delta_path = std::filesystem::temp_directory_path() / "test_hashes_multi.delta";
+    {
+        std::ofstream csv_file(temp_csv_path, std::ios::app);
+        csv_file << "cb74f840da07ec3af03cada028e5952850184a3f;Trojan\n";
+        csv_file << "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3;Worm\n";
+    }
+    {
+        std::ofstream delta(delta_path);
+        delta << "-sha1:cb74f840da07ec3af03cada028e5952850184a3f\n";
+        delta << "+sha256:e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3;Ransomware\n";
+    }
+    
+    HashBase source;
+    source.load_hashes(temp_csv_path.string());
+    source.save_image(image_path.string());
+    
+    HashBase hash_base;
+    hash_base.load_image(image_path.string(), true);
+    EXPECT_EQ(hash_base.size(), 5);
+    EXPECT_EQ(*hash_base.get_verdict("cb74f840da07ec3af03cada028e5952850184a3f"), "Trojan");
+    
+    hash_base.apply_delta(delta_path.string());
+    EXPECT_EQ(hash_base.size(), 4);
+    EXPECT_EQ(hash_base.get_verdict("cb74f840da07ec3af03cada028e5952850184a3f"), nullptr);
+    EXPECT_EQ(*hash_base.get_verdict("e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3"), "Ransomware");
+    EXPECT_EQ(hash_base.algorithms(), DIGEST_MD5 | DIGEST_SHA256);
+    
+    std::error_code ec;
+    std::filesystem::remove(image_path, ec);
+    std::filesystem::remove(delta_path, ec);
+}
+
+TEST_F(HashBaseTest, SizeColumnBuildsSizeIndex) {
+    auto sized_csv = std::filesystem::temp_directory_path() / "test_hashes_sized.csv";
+    auto image_path = std::filesystem::temp_directory_path() / "test_hashes_sized.img";
+    {
+        std::ofstream csv_file(sized_csv);
+        csv_file << "a9963513d093ffb2bc7ceb9807771ad4;Exploit;1024\n";
+        csv_file << "ac6204ffeb36d2320e52f1d551cfa370;Dropper; 17 \n";
+        csv_file << "8ee70903f43b227eeb971262268af5a8;Downloader;1024\n";
+    }
+    
+    HashBase hash_base;
+    hash_base.load_hashes(sized_csv.string());
+    ASSERT_TRUE(hash_base.has_size_index());
+    EXPECT_EQ(hash_base.size_index_count(), 2);
+    EXPECT_TRUE(hash_base.may_have_size(17));
+    EXPECT_TRUE(hash_base.may_have_size(1024));
+    EXPECT_FALSE(hash_base.may_have_size(18));
+    // Колонка размера не попадает в вердикт
+    EXPECT_EQ(*hash_base.get_verdict("ac6204ffeb36d2320e52f1d551cfa370"), "Dropper");
+    
+    hash_base.save_image(image_path.string());
+    HashBase image_base;
+    image_base.load_image(image_path.string(), true);
+    ASSERT_TRUE(image_base.has_size_index());
+    EXPECT_FALSE(image_base.may_have_size(18));
+    EXPECT_TRUE(image_base.may_have_size(17));
+    
+    // Одна запись без размера отключает индекс: файл любого размера может совпасть
+    image_base.load_hashes(temp_csv_path.string());
+    EXPECT_FALSE(image_base.has_size_index());
+    EXPECT_TRUE(image_base.may_have_size(18));
+    
+    // Базы без колонки размера индекса не имеют
+    HashBase plain_base;
+    plain_base.load_hashes(temp_csv_path.string());
+    EXPECT_FALSE(plain_base.has_size_index());
+    
+    std::error_code ec;
+    std::filesystem::remove(sized_csv, ec);
+    std::filesystem::remove(image_path, ec);
+}
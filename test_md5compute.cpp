@@ -2,6 +2,8 @@
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <sys/stat.h>
 #include "MD5Compute.h"
 
 class MD5ComputeTest : public ::testing::Test {
@@ -113,4 +115,145 @@ TEST_F(MD5ComputeTest, MultipleFilesConsistent) {
     ASSERT_TRUE(hash1.has_value());
     ASSERT_TRUE(hash2.has_value());
     EXPECT_EQ(*hash1, *hash2);
-}
\ No newline at end of file
+}
+
+TEST_F(MD5ComputeTest, BinaryDigestMatchesHex) {
+    CreateTestFile("digest.txt", "hello world");
+    
+    MD5Compute calculator;
+    auto digest = calculator.computeFileDigestMD5(test_dir / "digest.txt");
+    
+    ASSERT_TRUE(digest.has_value());
+    EXPECT_EQ(digest_to_hex(*digest), "5eb63bbbe01eeed093cb22bb8f5acdc3");
+}
+
+TEST_F(MD5ComputeTest, ReadStrategiesAgree) {
+    std::string content;
+    for (int i = 0; i < 300000; ++i) {
+        content += static_cast<char>((i * 31) & 0xff);
+    }
+    CreateTestFile("strategies.bin", content);
+    
+    MD5Compute reference;
+    auto expected = reference.computeFileHashMD5(test_dir / "strategies.bin");
+    ASSERT_TRUE(expected.has_value());
+    
+    // Маленький буфер заставляет читать файл многими кусками
+    MD5Compute small_buffer(ReadOptions{ReadStrategy::Pread, 5000, 0});
+    EXPECT_EQ(small_buffer.options().buffer_size, 8192);
+    EXPECT_EQ(small_buffer.computeFileHashMD5(test_dir / "strategies.bin"), expected);
+    
+    MD5Compute mmap_reader(ReadOptions{ReadStrategy::Mmap, 64 * 1024, 0});
+    EXPECT_EQ(mmap_reader.computeFileHashMD5(test_dir / "strategies.bin"), expected);
+    
+    MD5Compute auto_reader(ReadOptions{ReadStrategy::Auto, 64 * 1024, 100000});
+    EXPECT_EQ(auto_reader.computeFileHashMD5(test_dir / "strategies.bin"), expected);
+    
+    CreateTestFile("empty_mmap.txt", "");
+    auto empty = mmap_reader.computeFileHashMD5(test_dir / "empty_mmap.txt");
+    ASSERT_TRUE(empty.has_value());
+    EXPECT_EQ(*empty, "d41d8cd98f00b204e9800998ecf8427e");
+}
+
+TEST_F(MD5ComputeTest, FifoIsRejectedWithoutBlocking) {
+    auto fifo_path = test_dir / "fifo";
+    ASSERT_EQ(mkfifo(fifo_path.c_str(), 0600), 0);
+    
+    MD5Compute calculator;
+    EXPECT_FALSE(calculator.computeFileHashMD5(fifo_path).has_value());
+}
+
+TEST_F(MD5ComputeTest, BatchKernelsMatchScalar) {
+    // Длины вокруг границы дополнения (55/56/63/64/65) и файлы в несколько буферов полосы
+    std::vector<size_t> lengths;
+    for (size_t length = 0; length <= 200; ++length) {
+        lengths.push_back(length);
+    }
+    for (size_t length : {4095, 4096, 4097, 70000, 300001}) {
+        lengths.push_back(length);
+    }
+    
+    std::vector<std::filesystem::path> paths;
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        std::string content(lengths[i], '\0');
+        for (size_t j = 0; j < content.size(); ++j) {
+            content[j] = static_cast<char>((j * 131 + i) & 0xff);
+        }
+        auto name = "batch_" + std::to_string(i) + ".bin";
+        CreateTestFile(name, content);
+        paths.push_back(test_dir / name);
+        // Несуществующий файл посреди пакета не должен сдвигать результаты
+        if (i == 57) {
+            paths.push_back(test_dir / "missing.bin");
+        }
+    }
+    
+    MD5Compute calculator(ReadOptions{ReadStrategy::Pread, 4096, 0});
+    std::vector<std::optional<MD5Digest>> expected;
+    for (const auto& path : paths) {
+        expected.push_back(calculator.computeFileDigestMD5(path));
+    }
+    
+    for (MD5Kernel kernel : {MD5Kernel::Scalar, MD5Kernel::Lanes4, MD5Kernel::Lanes8, MD5Kernel::Lanes16}) {
+        if (!MD5MultiBuffer::kernel_supported(kernel)) {
+            continue;
+        }
+        auto results = calculator.computeBatchDigestMD5(paths, kernel);
+        ASSERT_EQ(results.size(), paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            EXPECT_EQ(results[i], expected[i]) << "kernel " << static_cast<int>(kernel) << ", " << paths[i];
+        }
+    }
+    
+    auto detected = calculator.computeBatchDigestMD5(paths);
+    EXPECT_EQ(detected, expected);
+    EXPECT_FALSE(detected[58].has_value());
+}
+
+TEST_F(MD5ComputeTest, DetectedKernelIsSupported) {
+    const MD5Kernel kernel = MD5MultiBuffer::detect_kernel();
+    EXPECT_TRUE(MD5MultiBuffer::kernel_supported(kernel));
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    EXPECT_NE(kernel, MD5Kernel::Scalar);
+#else
+    EXPECT_EQ(kernel, MD5Kernel::Scalar);
+#endif
+}
+
+TEST_F(MD5ComputeTest, BatchEmptyInput) {
+    MD5Compute calculator;
+    EXPECT_TRUE(calculator.computeBatchDigestMD5({}).empty());
+}
+
+TEST_F(MD5ComputeTest, SinglePassDigests) {
+    CreateTestFile("abc.txt", "abc");
+    
+    MD5Compute calculator;
+    auto digests = calculator.computeFileDigests(test_dir / "abc.txt", DIGEST_ALL);
+    ASSERT_TRUE(digests.has_value());
+    EXPECT_EQ(digests->algorithms, DIGEST_ALL);
+    EXPECT_EQ(digest_to_hex(digests->md5), "900150983cd24fb0d6963f7d28e17f72");
+    EXPECT_EQ(digest_to_hex(digests->sha1), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    EXPECT_EQ(digest_to_hex(digests->sha256), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    
+    // Большой файл через mmap читается кусками, результат тот же
+    std::string content(300000, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>((i * 7) & 0xff);
+    }
+    CreateTestFile("large_multi.bin", content);
+    auto pread_digests = calculator.computeFileDigests(test_dir / "large_multi.bin", DIGEST_SHA1 | DIGEST_SHA256);
+    MD5Compute mmap_reader(ReadOptions{ReadStrategy::Mmap, 64 * 1024, 0});
+    auto mmap_digests = mmap_reader.computeFileDigests(test_dir / "large_multi.bin", DIGEST_SHA1 | DIGEST_SHA256);
+    ASSERT_TRUE(pread_digests.has_value());
+    ASSERT_TRUE(mmap_digests.has_value());
+    EXPECT_EQ(pread_digests->algorithms, DIGEST_SHA1 | DIGEST_SHA256);
+    EXPECT_EQ(pread_digests->sha1, mmap_digests->sha1);
+    EXPECT_EQ(pread_digests->sha256, mmap_digests->sha256);
+    
+    auto md5_only = calculator.computeFileDigests(test_dir / "large_multi.bin", DIGEST_MD5);
+    ASSERT_TRUE(md5_only.has_value());
+    EXPECT_EQ(md5_only->md5, calculator.computeFileDigestMD5(test_dir / "large_multi.bin"));
+    
+    EXPECT_FALSE(calculator.computeFileDigests(test_dir / "missing.txt", DIGEST_ALL).has_value());
+}
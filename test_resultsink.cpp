@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ResultSink.h"
+
+namespace {
+
+ScanRecord MakeFinding() {
+    ScanRecord record;
+    record.path = "/data/dir \"x\"/evil\tfile.exe";
+    record.size = 17;
+    record.malicious = true;
+    record.algorithm = DIGEST_SHA1;
+    record.verdict = "Trojan\\Generic";
+    record.digests.algorithms = DIGEST_MD5 | DIGEST_SHA1;
+    parse_hex_digest("d5708d67cee304cde1a69dae5a463a9e", record.digests.md5);
+    parse_hex_digest("0f1c2f5ae1e07e3a5a0ee3f5ff3b0c4c6e61b4b6", record.digests.sha1);
+    record.hash_time = std::chrono::microseconds(42);
+    return record;
+}
+
+} // namespace
+
+TEST(ResultSinkTest, JsonlEscapesAndSkipsMissingDigests) {
+    std::ostringstream out;
+    JsonlResultSink sink(out);
+    ScanRecord clean;
+    clean.path = "/data/clean.txt";
+    clean.size = 5;
+    clean.from_cache = true;
+    clean.digests.algorithms = DIGEST_MD5;
+    const std::vector<ScanRecord> records = {MakeFinding(), clean};
+    sink.OnResults(records);
+    sink.OnScanFinished();
+
+    std::istringstream lines(out.str());
+    std::string first, second, extra;
+    ASSERT_TRUE(std::getline(lines, first));
+    ASSERT_TRUE(std::getline(lines, second));
+    EXPECT_FALSE(std::getline(lines, extra));
+
+    EXPECT_EQ(first,
+              "{\"path\":\"/data/dir \\\"x\\\"/evil\\tfile.exe\",\"size\":17,\"malicious\":true,"
+              "\"verdict\":\"Trojan\\\\Generic\",\"algorithm\":\"SHA1\","
+              "\"md5\":\"d5708d67cee304cde1a69dae5a463a9e\","
+              "\"sha1\":\"0f1c2f5ae1e07e3a5a0ee3f5ff3b0c4c6e61b4b6\",\"cached\":false,\"hash_us\":42}");
+    EXPECT_EQ(second,
+              "{\"path\":\"/data/clean.txt\",\"size\":5,\"malicious\":false,"
+              "\"md5\":\"00000000000000000000000000000000\",\"cached\":true,\"hash_us\":0}");
+}
+
+TEST(ResultSinkTest, BinaryRoundTrip) {
+    const auto path = std::filesystem::temp_directory_path() / "result_sink_test.bin";
+    ScanRecord clean;
+    clean.path = "/data/clean.txt";
+    clean.size = 123456789012ull;
+    clean.from_cache = true;
+    clean.digests.algorithms = DIGEST_ALL;
+    clean.digests.sha256[31] = 0xab;
+    {
+        BinaryResultSink sink(path.string());
+        const std::vector<ScanRecord> first = {MakeFinding()};
+        const std::vector<ScanRecord> second = {clean};
+        sink.OnResults(first);
+        sink.OnResults(second);
+        sink.OnScanFinished();
+    }
+
+    const auto records = BinaryResultSink::ReadFile(path.string());
+    ASSERT_EQ(records.size(), 2u);
+    const ScanRecord expected = MakeFinding();
+    EXPECT_EQ(records[0].path, expected.path);
+    EXPECT_EQ(records[0].size, expected.size);
+    EXPECT_TRUE(records[0].malicious);
+    EXPECT_FALSE(records[0].from_cache);
+    EXPECT_EQ(records[0].algorithm, DIGEST_SHA1);
+    EXPECT_EQ(records[0].verdict, expected.verdict);
+    EXPECT_EQ(records[0].digests.algorithms, expected.digests.algorithms);
+    EXPECT_EQ(records[0].digests.md5, expected.digests.md5);
+    EXPECT_EQ(records[0].digests.sha1, expected.digests.sha1);
+    EXPECT_EQ(records[0].hash_time, expected.hash_time);
+
+    EXPECT_EQ(records[1].path, clean.path);
+    EXPECT_EQ(records[1].size, clean.size);
+    EXPECT_FALSE(records[1].malicious);
+    EXPECT_TRUE(records[1].from_cache);
+    EXPECT_EQ(records[1].digests.sha256, clean.digests.sha256);
+
+    // Обрезанный файл не читается молча
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    EXPECT_THROW(BinaryResultSink::ReadFile(path.string()), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST(ResultSinkTest, RejectsForeignFile) {
+    const auto path = std::filesystem::temp_directory_path() / "result_sink_foreign.bin";
+    {
+        std::ofstream file(path);
+        file << "not a results file at all";
+    }
+    EXPECT_THROW(BinaryResultSink::ReadFile(path.string()), std::runtime_error);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "RingBlockQueue.h"
+
+TEST(RingBlockQueueTest, FifoWithinCapacity) {
+    RingBlockQueue<int> queue(3);
+    EXPECT_EQ(queue.Capacity(), 4u);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.Push(i));
+    }
+    int extra = 4;
+    EXPECT_FALSE(queue.TryPush(extra));
+    EXPECT_EQ(queue.Size(), 4u);
+
+    for (int i = 0; i < 4; ++i) {
+        auto value = queue.TryGet();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, i);
+    }
+    EXPECT_FALSE(queue.TryGet().has_value());
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(RingBlockQueueTest, MoveOnlyValuesAndCleanup) {
+    auto counter = std::make_shared<int>(0);
+    {
+        RingBlockQueue<std::shared_ptr<int>> queue(8);
+        queue.Push(counter);
+        queue.Push(counter);
+        EXPECT_EQ(counter.use_count(), 3);
+        auto value = queue.Get();
+        ASSERT_TRUE(value.has_value());
+    }
+    // Оставшийся в очереди элемент разрушается вместе с ней
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(RingBlockQueueTest, LockDrainsThenReturnsNullopt) {
+    RingBlockQueue<int> queue(8);
+    queue.Push(1);
+    queue.Push(2);
+    queue.Lock();
+
+    // После закрытия новые значения не принимаются
+    EXPECT_FALSE(queue.Push(3));
+    EXPECT_EQ(queue.Get(), 1);
+    EXPECT_EQ(queue.Get(), 2);
+    EXPECT_FALSE(queue.Get().has_value());
+}
+
+TEST(RingBlockQueueTest, LockWakesBlockedConsumersAndProducers) {
+    RingBlockQueue<int> empty_queue(4);
+    RingBlockQueue<int> full_queue(1);
+    EXPECT_EQ(full_queue.Capacity(), 2u);
+    full_queue.Push(0);
+    full_queue.Push(0);
+
+    std::atomic<int> finished{0};
+    std::thread consumer([&] {
+        EXPECT_FALSE(empty_queue.Get().has_value());
+        ++finished;
+    });
+    std::thread producer([&] {
+        EXPECT_FALSE(full_queue.Push(1));
+        ++finished;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(finished.load(), 0);
+
+    empty_queue.Lock();
+    full_queue.Lock();
+    consumer.join();
+    producer.join();
+    EXPECT_EQ(finished.load(), 2);
+}
+
+TEST(RingBlockQueueTest, FullQueueBlocksProducer) {
+    RingBlockQueue<int> queue(2);
+    queue.Push(0);
+    queue.Push(1);
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.Push(2);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+
+    EXPECT_EQ(queue.Get(), 0);
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.Get(), 1);
+    EXPECT_EQ(queue.Get(), 2);
+}
+
+TEST(RingBlockQueueTest, ManyProducersManyConsumers) {
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 50000;
+    RingBlockQueue<int> queue(64);
+    std::vector<std::atomic<int>> seen(PRODUCERS * PER_PRODUCER);
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 4; ++c) {
+        consumers.emplace_back([&] {
+            while (auto value = queue.Get()) {
+                seen[*value].fetch_add(1);
+            }
+        });
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                queue.Push(p * PER_PRODUCER + i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    queue.Lock();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    for (size_t i = 0; i < seen.size(); ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << "значение " << i;
+    }
+}
+
+TEST(RingBlockQueueTest, StatsTrackTraffic) {
+    RingBlockQueue<int> queue(8);
+    for (int i = 0; i < 3; ++i) {
+        queue.Push(i);
+    }
+    queue.Get();
+    queue.TryGet();
+    const QueueStats stats = queue.Stats();
+    EXPECT_EQ(stats.enabled, instrumentation::ENABLED);
+    if constexpr (instrumentation::ENABLED) {
+        EXPECT_EQ(stats.pushes, 3u);
+        EXPECT_EQ(stats.pops, 2u);
+        EXPECT_EQ(stats.high_water, 3u);
+    } else {
+        // Выключенные счетчики не занимают места в очереди
+        EXPECT_EQ(stats.pushes, 0u);
+        EXPECT_EQ(stats.high_water, 0u);
+    }
+    EXPECT_EQ(stats.waiting, 0u);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LatencyHistogram.h"
+#include "MetricsExporter.h"
+#include "ScanMetrics.h"
+
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogramTest, BucketsCoverValuesContiguously) {
+    for (uint64_t ns : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456789ull, (1ull << 40) - 1}) {
+        const size_t index = LatencyHistogram::bucket_index(ns);
+        EXPECT_LE(LatencyHistogram::bucket_lower(index), ns) << ns;
+        EXPECT_GE(LatencyHistogram::bucket_upper(index), ns) << ns;
+    }
+    for (size_t i = 0; i + 1 < LatencyHistogram::BUCKET_COUNT; ++i) {
+        EXPECT_EQ(LatencyHistogram::bucket_upper(i) + 1, LatencyHistogram::bucket_lower(i + 1)) << i;
+    }
+    EXPECT_EQ(LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::BUCKET_COUNT - 1);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.Record(std::chrono::microseconds(i));
+    }
+    EXPECT_EQ(histogram.count(), 1000u);
+    EXPECT_EQ(histogram.max(), 1000us);
+    EXPECT_EQ(histogram.mean(), std::chrono::nanoseconds(500500));
+
+    // Погрешность корзины - 1/16 значения
+    const auto p50 = histogram.Percentile(0.5);
+    EXPECT_GE(p50, 500us);
+    EXPECT_LE(p50, 500us + 500us / 16);
+    const auto p99 = histogram.Percentile(0.99);
+    EXPECT_GE(p99, 990us);
+    EXPECT_LE(p99, 1000us);
+    EXPECT_EQ(histogram.Percentile(1.0), 1000us);
+    EXPECT_EQ(LatencyHistogram().Percentile(0.5), 0ns);
+}
+
+TEST(ScanMetricsTest, SnapshotSumsAllThreads) {
+    ScanMetrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&metrics] {
+            for (int i = 0; i < 1000; ++i) {
+                metrics.AddFile();
+                metrics.AddBytes(10);
+                metrics.Record(ScanStage::Hash, std::chrono::microseconds(i % 100 + 1));
+            }
+            metrics.AddSkipped(SkipReason::CacheHit);
+            metrics.AddQueued(5);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Задачи, поставленные одним потоком, забирает другой
+    std::thread([&metrics] { metrics.AddQueued(-40); }).join();
+
+    const MetricsSnapshot snapshot = metrics.Snapshot();
+    EXPECT_EQ(snapshot.files_checked, 8000u);
+    EXPECT_EQ(snapshot.bytes_read, 80000u);
+    EXPECT_EQ(snapshot.skipped[static_cast<size_t>(SkipReason::CacheHit)], 8u);
+    EXPECT_EQ(snapshot.queued_files, 0);
+    const LatencyHistogram& hash = snapshot.stages[static_cast<size_t>(ScanStage::Hash)];
+    EXPECT_EQ(hash.count(), 8000u);
+    EXPECT_EQ(hash.max(), 100us);
+    EXPECT_EQ(snapshot.stages[static_cast<size_t>(ScanStage::Open)].count(), 0u);
+    EXPECT_GT(snapshot.files_per_second, 0.0);
+
+    {
+        ScanMetrics::BusyScope busy(metrics);
+        EXPECT_EQ(metrics.Snapshot().busy_workers, 1);
+    }
+    EXPECT_EQ(metrics.Snapshot().busy_workers, 0);
+}
+
+TEST(MetricsExporterTest, FormatsContainStageSummaries) {
+    ScanMetrics metrics;
+    metrics.AddFile();
+    metrics.AddBytes(4096);
+    metrics.AddSkipped(SkipReason::SizeFilter);
+    metrics.AddFailedCompletion();
+    metrics.Record(ScanStage::Read, 250us);
+    const MetricsSnapshot snapshot = metrics.Snapshot();
+
+    const std::string prometheus = MetricsExporter::FormatPrometheus(snapshot);
+    EXPECT_NE(prometheus.find("# TYPE scanner_files_checked_total counter\nscanner_files_checked_total 1\n"),
+              std::string::npos);
+    EXPECT_NE(prometheus.find("scanner_bytes_read_total 4096\n"), std::string::npos);
+    EXPECT_NE(prometheus.find("scanner_files_skipped_total{reason=\"size_filter\"} 1\n"), std::string::npos);
+    EXPECT_NE(prometheus.find("scanner_failed_completions_total 1\n"), std::string::npos);
+    EXPECT_NE(prometheus.find("scanner_stage_latency_seconds{stage=\"read\",quantile=\"0.5\"} 0.00025\n"),
+              std::string::npos);
+    EXPECT_NE(prometheus.find("scanner_stage_latency_seconds_count{stage=\"read\"} 1\n"), std::string::npos);
+
+    const std::string json = MetricsExporter::FormatJson(snapshot);
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_NE(json.find("\"files_checked\":1,"), std::string::npos);
+    EXPECT_NE(json.find("\"size_filter\":1"), std::string::npos);
+    EXPECT_NE(json.find("\"failed_completions\":1,"), std::string::npos);
+    EXPECT_NE(json.find("\"read\":{\"count\":1,\"mean_us\":250.000,\"p50_us\":250.000"), std::string::npos);
+}
+
+TEST(MetricsExporterTest, WritesFilePeriodically) {
+    const auto path = std::filesystem::temp_directory_path() / "metrics_exporter_test.prom";
+    ScanMetrics metrics;
+    {
+        MetricsExporter exporter(path.string(), MetricsFormat::Prometheus, 10ms,
+                                 [&metrics] { return metrics.Snapshot(); });
+        // Первый сброс уже в конструкторе
+        ASSERT_TRUE(std::filesystem::exists(path));
+        metrics.AddFile();
+    }
+    // Последний сброс - в деструкторе, с уже добавленным файлом
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_NE(content.str().find("scanner_files_checked_total 1\n"), std::string::npos);
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+    std::filesystem::remove(path);
+
+    EXPECT_THROW(MetricsExporter("/nonexistent_dir/metrics.prom", MetricsFormat::Json, 10ms,
+                                 [&metrics] { return metrics.Snapshot(); }),
+                 std::runtime_error);
+}
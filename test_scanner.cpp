@@ -3,7 +3,13 @@
 #include <fstream>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
 #include "Scanner.h"
+#include "ScanStream.h"
+#include "ScanSession.h"
 
 class ScannerTest : public ::testing::Test {
 protected:
@@ -151,4 +157,613 @@ TEST_F(ScannerTest, CurrentStatsBeforeScan) {
     EXPECT_EQ(stats.total_files, 0);
     EXPECT_EQ(stats.malicious_files, 0);
     EXPECT_EQ(stats.errors, 0);
-}
\ No newline at end of file
+}
+TEST_F(ScannerTest, ScanWithCompiledBase) {
+    auto image_path = test_dir / "test_hashes.img";
+    {
+        HashBase hash_base;
+        hash_base.load_hashes(csv_path.string());
+        hash_base.save_image(image_path.string());
+    }
+    
+    Scanner scanner(image_path.string(), log_path.string(), 2);
+    auto result = scanner.Scan(scan_dir);
+    
+    EXPECT_EQ(result.total_files, 3);
+    EXPECT_EQ(result.malicious_files, 1);
+}
+
+TEST_F(ScannerTest, ScanWithPrefilter) {
+    ScannerOptions options;
+    options.use_prefilter = true;
+    
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    auto result = scanner.Scan(scan_dir);
+    
+    EXPECT_EQ(result.total_files, 3);
+    EXPECT_EQ(result.malicious_files, 1);
+    EXPECT_EQ(result.prefilter_checks, 3);
+    EXPECT_LE(result.prefilter_false_positives, 2);
+}
+
+TEST_F(ScannerTest, ReloadBaseSwapsSignatures) {
+    auto empty_csv = test_dir / "empty_hashes.csv";
+    std::ofstream(empty_csv).close();
+    
+    Scanner scanner(empty_csv.string(), log_path.string(), 2);
+    auto scan_malicious = [&]() {
+        return scanner.Scan(scan_dir).malicious_files;
+    };
+    EXPECT_EQ(scan_malicious(), 0);
+    
+    scanner.ReloadBase(csv_path.string());
+    EXPECT_EQ(scan_malicious(), 1);
+    
+    // Ошибка загрузки не трогает опубликованную базу
+    EXPECT_THROW(scanner.ReloadBase((test_dir / "missing.csv").string()), std::runtime_error);
+    EXPECT_EQ(scan_malicious(), 1);
+}
+
+TEST_F(ScannerTest, ApplyBaseDeltaRemovesSignature) {
+    auto delta_path = test_dir / "remove.delta";
+    {
+        std::ofstream delta(delta_path);
+        delta << "-d5708d67cee304cde1a69dae5a463a9e\n";
+    }
+    
+    Scanner scanner(csv_path.string(), log_path.string(), 2);
+    scanner.ApplyBaseDelta(delta_path.string());
+    
+    EXPECT_EQ(scanner.Scan(scan_dir).malicious_files, 0);
+}
+
+TEST_F(ScannerTest, ApplyBaseDeltaRejectsLargeImage) {
+    auto image_path = test_dir / "test_hashes.img";
+    {
+        HashBase hash_base;
+        hash_base.load_hashes(csv_path.string());
+        hash_base.save_image(image_path.string());
+    }
+    auto delta_path = test_dir / "remove.delta";
+    {
+        std::ofstream delta(delta_path);
+        delta << "-d5708d67cee304cde1a69dae5a463a9e\n";
+    }
+
+    ScannerOptions options;
+    options.max_delta_image_bytes = 0;
+    Scanner scanner(image_path.string(), log_path.string(), 2, options);
+    EXPECT_THROW(scanner.ApplyBaseDelta(delta_path.string()), std::runtime_error);
+    // Отказ не трогает опубликованную базу
+    EXPECT_EQ(scanner.Scan(scan_dir).malicious_files, 1);
+
+    // База из CSV уже в куче, ее дельта не ограничена
+    Scanner heap_scanner(csv_path.string(), log_path.string(), 2, options);
+    heap_scanner.ApplyBaseDelta(delta_path.string());
+    EXPECT_EQ(heap_scanner.Scan(scan_dir).malicious_files, 0);
+}
+
+TEST_F(ScannerTest, ReloadDuringScan) {
+    for (int i = 0; i < 200; ++i) {
+        std::ofstream file(scan_dir / ("reload_" + std::to_string(i) + ".txt"));
+        file << "content " << i;
+    }
+    
+    Scanner scanner(csv_path.string(), log_path.string(), 4);
+    std::atomic<bool> done{false};
+    std::thread reloader([&]() {
+        while (!done.load()) {
+            scanner.ReloadBase(csv_path.string());
+        }
+    });
+    
+    auto result = scanner.Scan(scan_dir);
+    done.store(true);
+    reloader.join();
+    
+    EXPECT_EQ(result.total_files, 203);
+    EXPECT_EQ(result.malicious_files, 1);
+    EXPECT_EQ(result.errors, 0);
+}
+
+TEST_F(ScannerTest, ScanWithMixedAlgorithmBase) {
+    auto mixed_csv = test_dir / "mixed_hashes.csv";
+    {
+        std::ofstream csv(mixed_csv);
+        csv << "sha1:0f1c2f5ae1e07e3a5a0ee3f5ff3b0c4c6e61b4b6;Unrelated\n";
+        csv << "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3;TestVirus\n";
+    }
+    
+    Scanner scanner(mixed_csv.string(), log_path.string(), 2);
+    auto result = scanner.Scan(scan_dir);
+    
+    EXPECT_EQ(result.total_files, 3);
+    EXPECT_EQ(result.malicious_files, 1);
+    
+    std::ifstream log(log_path);
+    std::string content((std::istreambuf_iterator<char>(log)), std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("SHA256:  e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3"),
+              std::string::npos);
+}
+
+TEST_F(ScannerTest, SizeFilterSkipsFilesWithoutOpening) {
+    auto sized_csv = test_dir / "sized_hashes.csv";
+    {
+        std::ofstream csv(sized_csv);
+        csv << "d5708d67cee304cde1a69dae5a463a9e;TestVirus;17\n";
+        csv << "f5ac8127b3b6b85cdc13f237c6005d80;FalsePositive;100000\n";
+    }
+    
+    ScannerOptions options;
+    options.use_size_filter = true;
+    Scanner scanner(sized_csv.string(), log_path.string(), 2, options);
+    auto result = scanner.Scan(scan_dir);
+    
+    EXPECT_EQ(result.skipped_by_size, 2);
+    EXPECT_EQ(result.total_files, 1);
+    EXPECT_EQ(result.malicious_files, 1);
+    
+    // База без размеров: фильтр отключается, ничего не пропускается
+    Scanner plain_scanner(csv_path.string(), log_path.string(), 2, options);
+    auto plain_result = plain_scanner.Scan(scan_dir);
+    EXPECT_EQ(plain_result.skipped_by_size, 0);
+    EXPECT_EQ(plain_result.total_files, 3);
+}
+
+TEST_F(ScannerTest, DigestCacheReusesUnchangedFiles) {
+    ScannerOptions options;
+    options.digest_cache_path = (test_dir / "digests.cache").string();
+    options.digest_cache_racy_window = std::chrono::nanoseconds(0);
+    
+    {
+        Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+        auto result = scanner.Scan(scan_dir);
+        EXPECT_EQ(result.cache_hits, 0);
+        EXPECT_EQ(result.cache_misses, 3);
+        EXPECT_EQ(result.malicious_files, 1);
+    }
+    
+    // Меняем один файл: хешируется заново только он
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    {
+        std::ofstream clean_file(scan_dir / "clean.txt", std::ios::app);
+        clean_file << " changed";
+    }
+    
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    auto result = scanner.Scan(scan_dir);
+    EXPECT_EQ(result.cache_hits, 2);
+    EXPECT_EQ(result.cache_misses, 1);
+    EXPECT_EQ(result.total_files, 3);
+    EXPECT_EQ(result.malicious_files, 1);
+}
+
+TEST_F(ScannerTest, IoUringReadModeMatchesBlockingScan) {
+    ScannerOptions options;
+    options.read_options.strategy = ReadStrategy::IoUring;
+    options.digest_cache_path = (test_dir / "digests.cache").string();
+    
+    // Без io_uring сканер откатывается на обычное чтение - результат тот же
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    auto result = scanner.Scan(scan_dir);
+    EXPECT_EQ(result.total_files, 3);
+    EXPECT_EQ(result.malicious_files, 1);
+    EXPECT_EQ(result.errors, 0);
+    EXPECT_EQ(result.cache_misses, 3);
+}
+
+TEST_F(ScannerTest, PipelineStagesMatchBlockingScan) {
+    ScannerOptions options;
+    options.use_pipeline = true;
+    options.pipeline.read_threads = 2;
+    options.pipeline.hash_threads = 2;
+    options.pipeline.buffer_count = 2;
+    options.pipeline.buffer_size = 4096;
+    
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    auto result = scanner.Scan(scan_dir);
+    EXPECT_EQ(result.total_files, 3);
+    EXPECT_EQ(result.malicious_files, 1);
+    EXPECT_EQ(result.errors, 0);
+}
+
+namespace {
+
+class CollectingSink : public ResultSink {
+public:
+    std::mutex mutex;
+    std::vector<ScanRecord> records;
+    size_t batches = 0;
+    bool finished = false;
+
+    void OnResults(std::span<const ScanRecord> batch) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.insert(records.end(), batch.begin(), batch.end());
+        ++batches;
+    }
+    void OnScanFinished() override { finished = true; }
+};
+
+class ThrowingSink : public ResultSink {
+public:
+    void OnResults(std::span<const ScanRecord>) override {
+        throw std::runtime_error("приемник недоступен");
+    }
+};
+
+} // namespace
+
+TEST_F(ScannerTest, ScanDeliversFindingsToSink) {
+    Scanner scanner(csv_path.string(), log_path.string(), 2);
+    CollectingSink sink;
+    auto result = scanner.Scan(scan_dir, sink);
+    
+    EXPECT_EQ(result.malicious_files, 1);
+    EXPECT_TRUE(sink.finished);
+    ASSERT_EQ(sink.records.size(), 1u);
+    const ScanRecord& finding = sink.records.front();
+    EXPECT_EQ(finding.path, scan_dir / "malware.exe");
+    EXPECT_TRUE(finding.malicious);
+    EXPECT_EQ(finding.verdict, "TestVirus");
+    EXPECT_EQ(finding.algorithm, DIGEST_MD5);
+    EXPECT_EQ(digest_to_hex(finding.digests.md5), "d5708d67cee304cde1a69dae5a463a9e");
+    EXPECT_EQ(finding.size, 17u);
+}
+
+TEST_F(ScannerTest, ReportCleanFilesThroughPipeline) {
+    ScannerOptions options;
+    options.report_clean_files = true;
+    options.use_pipeline = true;
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    CollectingSink sink;
+    scanner.Scan(scan_dir, sink);
+    
+    ASSERT_EQ(sink.records.size(), 3u);
+    size_t malicious = 0;
+    for (const auto& record : sink.records) {
+        malicious += record.malicious ? 1 : 0;
+        EXPECT_EQ(record.size, std::filesystem::file_size(record.path));
+    }
+    EXPECT_EQ(malicious, 1u);
+}
+
+TEST_F(ScannerTest, SinkErrorIsRethrownFromScan) {
+    Scanner scanner(csv_path.string(), log_path.string(), 2);
+    ThrowingSink sink;
+    EXPECT_THROW(scanner.Scan(scan_dir, sink), std::runtime_error);
+    
+    // Сканер остается рабочим
+    auto result = scanner.Scan(scan_dir);
+    EXPECT_EQ(result.total_files, 3u);
+}
+
+TEST_F(ScannerTest, ScanStreamAppliesBackpressure) {
+    for (int i = 0; i < 200; ++i) {
+        std::ofstream(scan_dir / ("extra_" + std::to_string(i) + ".txt")) << "extra " << i;
+    }
+    ScannerOptions options;
+    options.report_clean_files = true;
+    options.result_queue_capacity = 2;
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    
+    ScanStream stream(scanner, scan_dir, 1);
+    size_t received = 0;
+    while (auto record = stream.Next()) {
+        ++received;
+        if (received == 1) {
+            // Потребитель медленный: сканер ждет, а не копит результаты
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT_LT(scanner.GetCurrentStats().total_files, 203u);
+        }
+    }
+    auto result = stream.Wait();
+    EXPECT_EQ(received, 203u);
+    EXPECT_EQ(result.total_files, 203u);
+}
+
+TEST_F(ScannerTest, ReloadBaseFromStreamConsumer) {
+    for (int i = 0; i < 200; ++i) {
+        std::ofstream(scan_dir / ("extra_" + std::to_string(i) + ".txt")) << "extra " << i;
+    }
+    ScannerOptions options;
+    options.report_clean_files = true;
+    options.result_queue_capacity = 2;
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+
+    // Потоки сканирования стоят на полной очереди результатов; перезагрузка
+    // из потока потребителя не должна ждать их снимков базы
+    ScanStream stream(scanner, scan_dir, 1);
+    size_t received = 0;
+    while (auto record = stream.Next()) {
+        if (++received == 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            scanner.ReloadBase(csv_path.string());
+        }
+    }
+    EXPECT_EQ(received, 203u);
+    EXPECT_EQ(stream.Wait().malicious_files, 1u);
+}
+
+TEST_F(ScannerTest, ScanResultsGeneratorYieldsFindings) {
+    Scanner scanner(csv_path.string(), log_path.string(), 2);
+    std::vector<std::string> verdicts;
+    for (const ScanRecord& record : scanner.ScanResults(scan_dir)) {
+        verdicts.push_back(record.verdict);
+    }
+    ASSERT_EQ(verdicts.size(), 1u);
+    EXPECT_EQ(verdicts.front(), "TestVirus");
+    
+    auto missing = scanner.ScanResults(test_dir / "missing");
+    EXPECT_THROW(missing.begin(), std::runtime_error);
+}
+
+TEST_F(ScannerTest, StatsAreCountedPerScan) {
+    Scanner scanner(csv_path.string(), log_path.string(), 2);
+    EXPECT_EQ(scanner.GetCurrentStats().total_files, 0u);
+    for (int i = 0; i < 3; ++i) {
+        auto result = scanner.Scan(scan_dir);
+        EXPECT_EQ(result.total_files, 3u);
+        EXPECT_EQ(result.malicious_files, 1u);
+        EXPECT_EQ(scanner.GetCurrentStats().total_files, 3u);
+    }
+}
+
+TEST_F(ScannerTest, ScanSeveralRoots) {
+    auto second_root = test_dir / "second_root";
+    std::filesystem::create_directories(second_root);
+    std::ofstream(second_root / "copy.exe") << "malicious content";
+    std::ofstream(second_root / "other.txt") << "other";
+    
+    Scanner scanner(csv_path.string(), log_path.string(), 2);
+    CollectingSink sink;
+    auto result = scanner.Scan({scan_dir, second_root}, &sink);
+    EXPECT_EQ(result.total_files, 5u);
+    EXPECT_EQ(result.malicious_files, 2u);
+    EXPECT_EQ(sink.records.size(), 2u);
+    
+    // Ошибка во втором корне не теряет задачи первого
+    EXPECT_THROW(scanner.Scan({scan_dir, test_dir / "missing"}), std::runtime_error);
+    EXPECT_EQ(scanner.Scan(second_root).total_files, 2u);
+}
+
+TEST_F(ScannerTest, ConcurrentSessionsShareScanner) {
+    for (int i = 0; i < 100; ++i) {
+        std::ofstream(scan_dir / ("extra_" + std::to_string(i) + ".txt")) << "extra " << i;
+    }
+    ScannerOptions options;
+    options.digest_cache_path = (test_dir / "digests.cache").string();
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    
+    std::vector<Scanner::ScanResult> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i] { results[i] = scanner.Scan(scan_dir); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& result : results) {
+        EXPECT_EQ(result.total_files, 103u);
+        EXPECT_EQ(result.malicious_files, 1u);
+        EXPECT_EQ(result.errors, 0u);
+        EXPECT_EQ(result.cache_hits + result.cache_misses, 103u);
+    }
+}
+
+TEST_F(ScannerTest, SessionStatsAreIndependent) {
+    ScannerOptions options;
+    options.use_pipeline = true;
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    CollectingSink sink;
+    auto first = scanner.CreateSession(&sink);
+    auto second = scanner.CreateSession();
+    first->AddRoot(scan_dir);
+    second->AddRoot(scan_dir / "subdir");
+    first->AddRoot(scan_dir / "subdir");
+    
+    auto second_result = second->Wait();
+    auto first_result = first->Wait();
+    EXPECT_EQ(second_result.total_files, 1u);
+    EXPECT_EQ(second_result.malicious_files, 0u);
+    EXPECT_EQ(first_result.total_files, 4u);
+    EXPECT_EQ(first_result.malicious_files, 1u);
+    EXPECT_EQ(sink.records.size(), 1u);
+    // Повторный Wait возвращает тот же итог
+    EXPECT_EQ(first->Wait().total_files, 4u);
+}
+
+TEST_F(ScannerTest, MetricsCoverEveryStage) {
+    const auto metrics_path = test_dir / "scanner.json";
+    // Обычное чтение, конвейер и io_uring пишут одни и те же стадии
+    for (int mode = 0; mode < 3; ++mode) {
+        ScannerOptions options;
+        options.use_pipeline = mode == 1;
+        if (mode == 2) {
+            options.read_options.strategy = ReadStrategy::IoUring;
+        }
+        options.metrics_path = metrics_path.string();
+        options.metrics_format = MetricsFormat::Json;
+        Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+        scanner.Scan(scan_dir);
+        
+        const MetricsSnapshot metrics = scanner.GetMetrics();
+        EXPECT_EQ(metrics.files_checked, 3u);
+        EXPECT_EQ(metrics.bytes_read, std::filesystem::file_size(scan_dir / "clean.txt") +
+                                      std::filesystem::file_size(scan_dir / "malware.exe") +
+                                      std::filesystem::file_size(scan_dir / "subdir" / "nested.txt"));
+        for (const auto& stage : metrics.stages) {
+            EXPECT_EQ(stage.count(), 3u) << "mode " << mode;
+        }
+        EXPECT_EQ(metrics.queued_files, 0);
+        EXPECT_EQ(metrics.busy_workers, 0);
+        EXPECT_EQ(metrics.worker_threads, 2u);
+    }
+    EXPECT_TRUE(std::filesystem::exists(metrics_path));
+}
+
+TEST_F(ScannerTest, TraceCoversFileStages) {
+    const auto trace_path = test_dir / "trace.json";
+    auto read_trace = [&trace_path] {
+        std::ifstream file(trace_path);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    auto count = [](const std::string& text, const std::string& needle) {
+        size_t result = 0;
+        for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+            ++result;
+        }
+        return result;
+    };
+    for (int mode = 0; mode < 3; ++mode) {
+        ScannerOptions options;
+        options.use_pipeline = mode == 1;
+        if (mode == 2) {
+            options.read_options.strategy = ReadStrategy::IoUring;
+        }
+        options.trace_path = trace_path.string();
+        Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+        scanner.Scan(scan_dir);
+
+        const std::string trace = read_trace();
+        // Дорожка на каждый файл, с очередью и путем
+        EXPECT_EQ(count(trace, "\"name\":\"file\",\"ph\":\"b\""), 3u) << "mode " << mode;
+        EXPECT_EQ(count(trace, "\"name\":\"queue\",\"ph\":\"b\""), 3u) << "mode " << mode;
+        EXPECT_NE(trace.find((scan_dir / "subdir" / "nested.txt").string()), std::string::npos);
+        EXPECT_EQ(count(trace, "\"name\":\"walk\",\"ph\":\"X\""), 2u) << "mode " << mode;
+        EXPECT_EQ(count(trace, "\"name\":\"lookup\",\"ph\":\"X\""), 3u) << "mode " << mode;
+        EXPECT_EQ(count(trace, "\"name\":\"log\",\"ph\":\"X\""), 3u) << "mode " << mode;
+        if (mode == 0) {
+            for (const char* stage : {"digest", "open", "read", "hash"}) {
+                EXPECT_EQ(count(trace, std::string("\"name\":\"") + stage + "\",\"ph\":\"X\""), 3u) << stage;
+            }
+        } else {
+            // Движок и конвейер: передача до вердикта - одним отрезком на дорожке файла
+            EXPECT_EQ(count(trace, "\"name\":\"digest\",\"ph\":\"b\""), 3u) << "mode " << mode;
+        }
+    }
+
+    // Половина файлов: из трех попадают первый и третий
+    ScannerOptions options;
+    options.trace_path = trace_path.string();
+    options.trace_sample_rate = 0.5;
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    scanner.Scan(scan_dir);
+    EXPECT_EQ(count(read_trace(), "\"name\":\"file\",\"ph\":\"b\""), 2u);
+
+    options.trace_path = (test_dir / "missing" / "trace.json").string();
+    EXPECT_THROW(Scanner(csv_path.string(), log_path.string(), 2, options), std::runtime_error);
+}
+
+TEST_F(ScannerTest, ScansArchiveMembersWithArchivePaths) {
+    // Вредоносное содержимое только внутри gzip
+    std::filesystem::remove(scan_dir / "malware.exe");
+    const auto archive_path = scan_dir / "payload.exe.gz";
+    gzFile archive = gzopen(archive_path.c_str(), "wb");
+    ASSERT_NE(archive, nullptr);
+    gzputs(archive, "malicious content");
+    gzclose(archive);
+
+    Scanner plain(csv_path.string(), log_path.string(), 2);
+    EXPECT_EQ(plain.Scan(scan_dir).malicious_files, 0u);
+
+    ScannerOptions options;
+    options.scan_archives = true;
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    CollectingSink sink;
+    const auto result = scanner.Scan(scan_dir, sink);
+    EXPECT_EQ(result.malicious_files, 1u);
+    EXPECT_EQ(result.archive_members, 1u);
+    EXPECT_EQ(result.archive_members_skipped, 0u);
+    // Сам архив и его член - оба проверенные объекты
+    EXPECT_EQ(result.total_files, 4u);
+    EXPECT_EQ(result.errors, 0u);
+    ASSERT_EQ(sink.records.size(), 1u);
+    EXPECT_EQ(sink.records.front().path.native(), archive_path.native() + "!payload.exe");
+    EXPECT_EQ(sink.records.front().size, 17u);
+    EXPECT_EQ(sink.records.front().verdict, "TestVirus");
+}
+
+TEST_F(ScannerTest, ArchiveScanUsesDigestCacheForPlainFiles) {
+    const auto archive_path = scan_dir / "payload.exe.gz";
+    gzFile archive = gzopen(archive_path.c_str(), "wb");
+    ASSERT_NE(archive, nullptr);
+    gzputs(archive, "malicious content");
+    gzclose(archive);
+
+    ScannerOptions options;
+    options.scan_archives = true;
+    options.digest_cache_path = (test_dir / "digests.cache").string();
+    options.digest_cache_racy_window = std::chrono::nanoseconds(0);
+    {
+        Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+        const auto result = scanner.Scan(scan_dir);
+        EXPECT_EQ(result.cache_hits, 0u);
+        EXPECT_EQ(result.cache_misses, 4u);
+        EXPECT_EQ(result.malicious_files, 2u);
+    }
+
+    // Не-архивы берутся из кэша, архив снова читается ради членов
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    const auto result = scanner.Scan(scan_dir);
+    EXPECT_EQ(result.cache_hits, 3u);
+    EXPECT_EQ(result.cache_misses, 1u);
+    EXPECT_EQ(result.malicious_files, 2u);
+    EXPECT_EQ(result.archive_members, 1u);
+    EXPECT_EQ(result.total_files, 5u);
+    EXPECT_EQ(result.errors, 0u);
+}
+
+TEST_F(ScannerTest, BatchHashingMatchesPerFileScan) {
+    // Больше файлов, чем полос: несколько пачек в одной директории
+    for (int i = 0; i < 40; ++i) {
+        std::ofstream(scan_dir / ("small_" + std::to_string(i) + ".txt")) << "small file " << i;
+    }
+    std::ofstream(scan_dir / "subdir" / "copy.bin") << "malicious content";
+    ScannerOptions options;
+    options.batch_small_files = true;
+    options.metrics_path = (test_dir / "batch.prom").string();
+    Scanner scanner(csv_path.string(), log_path.string(), 2, options);
+    CollectingSink sink;
+    const auto result = scanner.Scan(scan_dir, sink);
+
+    EXPECT_EQ(result.total_files, 44u);
+    EXPECT_EQ(result.malicious_files, 2u);
+    EXPECT_EQ(result.errors, 0u);
+    ASSERT_EQ(sink.records.size(), 2u);
+    for (const auto& record : sink.records) {
+        EXPECT_EQ(record.size, 17u);
+        EXPECT_EQ(record.verdict, "TestVirus");
+    }
+    const MetricsSnapshot metrics = scanner.GetMetrics();
+    EXPECT_EQ(metrics.files_checked, 44u);
+    uint64_t total_bytes = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(scan_dir)) {
+        total_bytes += entry.is_regular_file() ? entry.file_size() : 0;
+    }
+    EXPECT_EQ(metrics.bytes_read, total_bytes);
+    EXPECT_EQ(metrics.queued_files, 0);
+}
+
+TEST_F(ScannerTest, SizeFilterAppliesToArchiveMembers) {
+    // В базе только размер члена; у самого архива размер другой
+    auto sized_csv = test_dir / "sized_hashes.csv";
+    std::ofstream(sized_csv) << "d5708d67cee304cde1a69dae5a463a9e;TestVirus;17\n";
+    std::filesystem::remove(scan_dir / "malware.exe");
+    const auto archive_path = scan_dir / "payload.exe.gz";
+    gzFile archive = gzopen(archive_path.c_str(), "wb");
+    ASSERT_NE(archive, nullptr);
+    gzputs(archive, "malicious content");
+    gzclose(archive);
+    ASSERT_NE(std::filesystem::file_size(archive_path), 17u);
+
+    ScannerOptions options;
+    options.use_size_filter = true;
+    options.scan_archives = true;
+    Scanner scanner(sized_csv.string(), log_path.string(), 2, options);
+    const auto result = scanner.Scan(scan_dir);
+    EXPECT_EQ(result.malicious_files, 1u);
+    EXPECT_EQ(result.archive_members, 1u);
+    // clean.txt и nested.txt пропущены по размеру, архив - нет
+    EXPECT_EQ(result.skipped_by_size, 2u);
+    EXPECT_EQ(result.errors, 0u);
+}
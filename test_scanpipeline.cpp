@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ScanPipeline.h"
+
+class ScanPipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "scan_pipeline_test";
+        std::filesystem::create_directories(test_dir);
+        options.buffer_size = 16 << 10;
+        options.buffer_count = 4;
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(test_dir, ec);
+    }
+
+    std::filesystem::path CreateTestFile(const std::string& filename, size_t size) {
+        std::string content(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            content[i] = static_cast<char>((i * 131 + size) % 251);
+        }
+        const auto file_path = test_dir / filename;
+        std::ofstream file(file_path, std::ios::binary);
+        file.write(content.data(), content.size());
+        return file_path;
+    }
+
+    static void ExpectSameDigests(const FileDigests& actual, const FileDigests& expected) {
+        EXPECT_EQ(actual.algorithms, expected.algorithms);
+        EXPECT_EQ(actual.md5, expected.md5);
+        EXPECT_EQ(actual.sha1, expected.sha1);
+        EXPECT_EQ(actual.sha256, expected.sha256);
+    }
+
+    std::filesystem::path test_dir;
+    PipelineOptions options;
+};
+
+TEST_F(ScanPipelineTest, MatchesBlockingDigestsAtBufferBoundaries) {
+    ScanPipeline pipeline(options, 2);
+    const size_t buffer = pipeline.buffer_size();
+    const std::vector<size_t> sizes = {0, 1, buffer - 1, buffer, buffer + 1, 7 * buffer + 3, 3 << 20};
+
+    MD5Compute reference;
+    for (unsigned algorithms : {static_cast<unsigned>(DIGEST_MD5), DIGEST_ALL}) {
+        std::vector<std::optional<FileDigests>> results(sizes.size());
+        std::vector<std::filesystem::path> files;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            files.push_back(CreateTestFile("file_" + std::to_string(i), sizes[i]));
+            pipeline.Submit(files.back(), algorithms, [&results, i](std::optional<FileDigests> digests) {
+                results[i] = std::move(digests);
+            });
+        }
+        pipeline.Drain();
+
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            SCOPED_TRACE("size " + std::to_string(sizes[i]));
+            auto expected = reference.computeFileDigests(files[i], algorithms);
+            ASSERT_TRUE(expected.has_value());
+            ASSERT_TRUE(results[i].has_value());
+            ExpectSameDigests(*results[i], *expected);
+        }
+    }
+}
+
+TEST_F(ScanPipelineTest, MissingFileCompletesWithError) {
+    ScanPipeline pipeline(options, 1);
+    std::atomic<int> calls{0};
+    bool has_value = true;
+    pipeline.Submit(test_dir / "missing.bin", DIGEST_MD5, [&](std::optional<FileDigests> digests) {
+        has_value = digests.has_value();
+        calls.fetch_add(1);
+    });
+    pipeline.Drain();
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_FALSE(has_value);
+}
+
+TEST_F(ScanPipelineTest, ThrowingCompletionIsCounted) {
+    ScanMetrics metrics;
+    ScanPipeline pipeline(options, 1, &metrics);
+    pipeline.Submit(CreateTestFile("one", 100), DIGEST_MD5, [](std::optional<FileDigests>) {
+        throw std::runtime_error("completion");
+    });
+    std::atomic<int> calls{0};
+    pipeline.Submit(CreateTestFile("two", 100), DIGEST_MD5, [&](std::optional<FileDigests>) { calls.fetch_add(1); });
+    pipeline.Drain();
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_EQ(metrics.Snapshot().failed_completions, 1u);
+}
+
+TEST_F(ScanPipelineTest, StagesRunOnSeparateThreads) {
+    options.read_threads = 1;
+    options.hash_threads = 1;
+    options.report_threads = 1;
+    ScanPipeline pipeline(options, 4);
+    const auto submitter = std::this_thread::get_id();
+    std::thread::id reporter;
+    pipeline.Submit(CreateTestFile("one", 100), DIGEST_MD5, [&](std::optional<FileDigests>) {
+        reporter = std::this_thread::get_id();
+    });
+    pipeline.Drain();
+    EXPECT_NE(reporter, std::thread::id());
+    EXPECT_NE(reporter, submitter);
+}
+
+TEST_F(ScanPipelineTest, ManyFilesThroughSmallPoolAndQueues) {
+    // Буферов и мест в очередях меньше, чем файлов и кусков: стадии
+    // ждут друг друга, но не блокируются навсегда
+    options.read_threads = 3;
+    options.hash_threads = 2;
+    options.report_threads = 2;
+    options.buffer_count = 2;
+    options.read_queue_depth = 2;
+    options.hash_queue_depth = 1;
+    options.report_queue_depth = 1;
+    const int files = 150;
+    std::vector<std::filesystem::path> paths;
+    for (int i = 0; i < files; ++i) {
+        paths.push_back(CreateTestFile("many_" + std::to_string(i), static_cast<size_t>(i) * 1013));
+    }
+
+    std::mutex results_mutex;
+    std::vector<std::optional<FileDigests>> results(files);
+    {
+        ScanPipeline pipeline(options, 1);
+        for (int i = 0; i < files; ++i) {
+            pipeline.Submit(paths[i], DIGEST_ALL, [&, i](std::optional<FileDigests> digests) {
+                std::lock_guard<std::mutex> lock(results_mutex);
+                results[i] = std::move(digests);
+            });
+        }
+        // Деструктор дожидается всех поставленных файлов
+    }
+
+    MD5Compute reference;
+    for (int i = 0; i < files; ++i) {
+        auto expected = reference.computeFileDigests(paths[i], DIGEST_ALL);
+        ASSERT_TRUE(results[i].has_value());
+        ExpectSameDigests(*results[i], *expected);
+    }
+}
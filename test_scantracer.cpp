@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "ScanTracer.h"
+
+namespace {
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+size_t count(const std::string& text, const std::string& needle) {
+    size_t result = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++result;
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(ScanTracerTest, WritesChromeTraceAndDrainsBuffers) {
+    const auto path = std::filesystem::temp_directory_path() / "scan_tracer_test.json";
+    ScanTracer tracer;
+    const FileTrace trace = tracer.StartFile(tracer.ReserveFiles(1));
+    ASSERT_NE(trace.id, 0u);
+    {
+        ScanTracer::Scope walk(&tracer, "walk");
+        ScanTracer::Scope::Annotate("/data/dir \"x\"");
+    }
+    // Пустой Scope ничего не пишет, Annotate без открытого отрезка - тоже
+    { ScanTracer::Scope skipped(nullptr, "walk"); }
+    ScanTracer::Scope::Annotate("/nowhere");
+    std::thread([&] {
+        tracer.FileSpan("queue", trace, trace.queued, tracer.Now());
+        tracer.Span("lookup", tracer.Now(), tracer.Now());
+    }).join();
+    tracer.FileSpan("file", trace, trace.queued, tracer.Now(), "/data/file.bin");
+
+    EXPECT_EQ(tracer.Write(path.string()), 4u);
+    const std::string json = read_file(path);
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\""), 0u);
+    EXPECT_EQ(count(json, "\"ph\":\"X\""), 2u);
+    EXPECT_EQ(count(json, "\"ph\":\"b\""), 2u);
+    EXPECT_EQ(count(json, "\"ph\":\"e\""), 2u);
+    // Два потока - две дорожки с именами
+    EXPECT_EQ(count(json, "\"name\":\"thread_name\""), 2u);
+    EXPECT_NE(json.find("\"args\":{\"path\":\"/data/dir \\\"x\\\"\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"cat\":\"file\",\"id\":\"1\",\"args\":{\"path\":\"/data/file.bin\"}"), std::string::npos);
+    EXPECT_EQ(json.find("/nowhere"), std::string::npos);
+
+    // Отрезки забраны: следующая запись - пустая трасса
+    EXPECT_EQ(tracer.Write(path.string()), 0u);
+    EXPECT_EQ(count(read_file(path), "\"ph\":\"X\""), 0u);
+    std::filesystem::remove(path);
+}
+
+TEST(ScanTracerTest, SamplesEveryNthFileAndDirectory) {
+    ScanTracer tracer(0.25);
+    const uint64_t first = tracer.ReserveFiles(8);
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(tracer.ReserveFiles(1), 8u);
+    size_t sampled = 0;
+    for (uint64_t i = first; i < first + 8; ++i) {
+        sampled += tracer.SampledFile(i);
+    }
+    EXPECT_EQ(sampled, 2u);
+    EXPECT_TRUE(tracer.SampleDirectory());
+    EXPECT_FALSE(tracer.SampleDirectory());
+    EXPECT_FALSE(tracer.SampleDirectory());
+    EXPECT_FALSE(tracer.SampleDirectory());
+    EXPECT_TRUE(tracer.SampleDirectory());
+
+    EXPECT_THROW(ScanTracer(0.0), std::runtime_error);
+    EXPECT_THROW(ScanTracer(1.5), std::runtime_error);
+}
+
+TEST(ScanTracerTest, DropsSpansOverLimit) {
+    const auto path = std::filesystem::temp_directory_path() / "scan_tracer_limit.json";
+    ScanTracer tracer(1.0, 2);
+    for (int i = 0; i < 5; ++i) {
+        tracer.Span("lookup", tracer.Now(), tracer.Now());
+    }
+    EXPECT_EQ(tracer.Write(path.string()), 2u);
+    EXPECT_NE(read_file(path).find("\"dropped_events\":3"), std::string::npos);
+    EXPECT_THROW(tracer.Write("/nonexistent_dir/trace.json"), std::runtime_error);
+    std::filesystem::remove(path);
+}
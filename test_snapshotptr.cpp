@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "SnapshotPtr.h"
+
+namespace {
+
+constexpr size_t SNAPSHOT_COUNT = 4000;
+std::atomic<bool> released[SNAPSHOT_COUNT + 1];
+
+// Отмечает свое освобождение: читатель проверяет, что снимок под guard жив
+struct Snapshot {
+    size_t id;
+    explicit Snapshot(size_t id) : id(id) {}
+    ~Snapshot() { released[id].store(true); }
+};
+
+} // namespace
+
+TEST(SnapshotPtrTest, PublishReplacesSnapshot) {
+    SnapshotPtr<int> ptr(std::make_shared<const int>(1));
+    EXPECT_EQ(*ptr.read(), 1);
+    ptr.publish(std::make_shared<const int>(2));
+    EXPECT_EQ(*ptr.read(), 2);
+    EXPECT_EQ(*ptr.snapshot(), 2);
+}
+
+TEST(SnapshotPtrTest, BackToBackPublishesKeepReadersSnapshotsAlive) {
+    for (auto& flag : released) {
+        flag.store(false);
+    }
+    SnapshotPtr<Snapshot> ptr(std::make_shared<const Snapshot>(0));
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> violations{0};
+    std::atomic<size_t> reads{0};
+
+    std::vector<std::thread> readers;
+    const unsigned reader_count = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < reader_count; ++i) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                auto guard = ptr.read();
+                const size_t id = guard->id;
+                // Застреваем с открытым guard, пока писатель публикует дальше
+                std::this_thread::yield();
+                if (released[id].load()) {
+                    violations.fetch_add(1);
+                }
+                reads.fetch_add(1);
+            }
+        });
+    }
+
+    // Публикации парами подряд: вторая не должна освободить снимок,
+    // который читатель взял между ними
+    for (size_t id = 1; id <= SNAPSHOT_COUNT; id += 2) {
+        ptr.publish(std::make_shared<const Snapshot>(id));
+        ptr.publish(std::make_shared<const Snapshot>(id + 1));
+        std::this_thread::yield();
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(violations.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_FALSE(released[SNAPSHOT_COUNT].load());
+}
+
+TEST(SnapshotPtrTest, WriterSleepsWhileReaderHoldsGuard) {
+    SnapshotPtr<int> ptr(std::make_shared<const int>(1));
+    std::atomic<bool> published{false};
+    timespec writer_cpu{};
+    std::thread writer;
+    {
+        auto guard = ptr.read();
+        writer = std::thread([&] {
+            ptr.publish(std::make_shared<const int>(2));
+            published.store(true);
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &writer_cpu);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        EXPECT_FALSE(published.load());
+        EXPECT_EQ(*guard, 1);
+    }
+    writer.join();
+
+    EXPECT_EQ(*ptr.read(), 2);
+    // Писатель спал, а не крутился все 200 мс
+    EXPECT_LT(writer_cpu.tv_sec * 1000 + writer_cpu.tv_nsec / 1000000, 50);
+}
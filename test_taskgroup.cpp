@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include "TaskGroup.h"
+#include "ThreadPool.h"
+
+TEST(TaskGroupTest, WaitReturnsWhenEmpty) {
+    TaskGroup group;
+    group.Wait();
+    EXPECT_EQ(group.Pending(), 0u);
+}
+
+TEST(TaskGroupTest, WaitsForTasksSpawnedByTasks) {
+    // Задачи порождают новые: счетчик растет, пока первая волна не кончилась
+    TaskGroup group;
+    std::atomic<int> done{0};
+    ThreadPool<std::function<void()>> pool(3);
+    for (int i = 0; i < 50; ++i) {
+        group.Add();
+        pool.Add([&] {
+            group.Add();
+            pool.Add([&] {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                done.fetch_add(1);
+                group.Done();
+            });
+            done.fetch_add(1);
+            group.Done();
+        });
+    }
+    group.Wait();
+    EXPECT_EQ(done.load(), 100);
+    EXPECT_EQ(group.Pending(), 0u);
+}
+
+TEST(TaskGroupTest, TaskIsReleasedWithoutRunning) {
+    TaskGroup group;
+    group.Add(2);
+    {
+        TaskGroup::Task first(group);
+        TaskGroup::Task moved = std::move(first);
+        EXPECT_EQ(group.Pending(), 2u);
+    }
+    EXPECT_EQ(group.Pending(), 1u);
+    group.Done();
+    group.Wait();
+}
+
+TEST(TaskGroupTest, CancelReleasesUnsubmittedTasks) {
+    TaskGroup group;
+    group.Add(3);
+    std::thread waiter([&group] { group.Wait(); });
+    {
+        TaskGroup::Task submitted(group);
+    }
+    // Две задачи так и не попали в пул
+    group.Cancel(2);
+    waiter.join();
+    EXPECT_EQ(group.Pending(), 0u);
+    group.Cancel(0);
+    EXPECT_EQ(group.Pending(), 0u);
+}
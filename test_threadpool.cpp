@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "UniqueFunction.h"
+#include "WorkStealingDeque.h"
+
+TEST(WorkStealingDequeTest, OwnerPopsInLifoOrder) {
+    WorkStealingDeque<int> deque(4);
+    int values[4] = {0, 1, 2, 3};
+    for (int& value : values) {
+        EXPECT_TRUE(deque.push(&value));
+    }
+    // Емкость исчерпана
+    int extra = 4;
+    EXPECT_FALSE(deque.push(&extra));
+
+    EXPECT_EQ(deque.pop(), &values[3]);
+    EXPECT_EQ(deque.steal(), &values[0]);
+    EXPECT_EQ(deque.pop(), &values[2]);
+    EXPECT_EQ(deque.pop(), &values[1]);
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, EveryItemTakenExactlyOnce) {
+    constexpr int ITEMS = 100000;
+    WorkStealingDeque<int> deque(256);
+    std::vector<int> values(ITEMS);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> done{false};
+
+    auto take = [&](int* item) {
+        if (item != nullptr) {
+            taken[item - values.data()].fetch_add(1);
+        }
+    };
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; ++i) {
+        thieves.emplace_back([&] {
+            while (!done.load()) {
+                take(deque.steal());
+            }
+        });
+    }
+
+    // Владелец кладет и забирает вперемешку с ворами
+    for (int i = 0; i < ITEMS; ++i) {
+        while (!deque.push(&values[i])) {
+            take(deque.pop());
+        }
+        if (i % 3 == 0) {
+            take(deque.pop());
+        }
+    }
+    while (int* item = deque.pop()) {
+        take(item);
+    }
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    for (int i = 0; i < ITEMS; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << "элемент " << i;
+    }
+}
+
+TEST(ThreadPoolTest, RejectsZeroThreads) {
+    EXPECT_THROW(ThreadPool<std::function<void()>>(0), std::invalid_argument);
+}
+
+TEST(ThreadPoolTest, DestructorRunsAllExternalTasks) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool<std::function<void()>> pool(4);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; ++p) {
+            producers.emplace_back([&] {
+                for (int i = 0; i < 5000; ++i) {
+                    pool.Add([&counter] { counter.fetch_add(1); });
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+    EXPECT_EQ(counter.load(), 20000);
+}
+
+TEST(ThreadPoolTest, TasksAddedByTasksAreDrained) {
+    // Дерево задач: каждая порождает двух потомков, как обход директорий.
+    // Деструктор должен дождаться и тех, что добавлены уже во время остановки.
+    std::atomic<int> counter{0};
+    std::function<void(int)> spawn;
+    {
+        ThreadPool<std::function<void()>> pool(4);
+        spawn = [&](int depth) {
+            counter.fetch_add(1);
+            if (depth > 0) {
+                pool.Add([&spawn, depth] { spawn(depth - 1); });
+                pool.Add([&spawn, depth] { spawn(depth - 1); });
+            }
+        };
+        pool.Add([&spawn] { spawn(14); });
+    }
+    EXPECT_EQ(counter.load(), (1 << 15) - 1);
+}
+
+TEST(ThreadPoolTest, OverflowGoesToSharedQueue) {
+    // Один поток добавляет больше задач, чем вмещает его дек
+    std::atomic<int> counter{0};
+    const int tasks = static_cast<int>(WorkStealingDeque<int>::DEFAULT_CAPACITY) * 3;
+    {
+        ThreadPool<std::function<void()>> pool(2);
+        pool.Add([&] {
+            for (int i = 0; i < tasks; ++i) {
+                pool.Add([&counter] { counter.fetch_add(1); });
+            }
+        });
+    }
+    EXPECT_EQ(counter.load(), tasks);
+}
+
+TEST(ThreadPoolTest, WorkerRunsTaskInlineWhenQueuesAreFull) {
+    // Дек и общая очередь заполнены: поток пула выполняет задачу сам,
+    // и число ожидающих задач не превышает емкости очередей
+    std::atomic<int> counter{0};
+    std::atomic<int> max_depth{0};
+    const int tasks = static_cast<int>(WorkStealingDeque<int>::DEFAULT_CAPACITY) * 4;
+    {
+        ThreadPool<std::function<void()>> pool(1, 16);
+        pool.Add([&] {
+            for (int i = 0; i < tasks; ++i) {
+                pool.Add([&counter] { counter.fetch_add(1); });
+            }
+            max_depth = counter.load();
+        });
+    }
+    EXPECT_EQ(counter.load(), tasks);
+    // Часть задач выполнена еще внутри порождающей задачи
+    EXPECT_GT(max_depth.load(), 0);
+}
+
+TEST(ThreadPoolTest, ExternalAddWaitsForQueueSpace) {
+    std::atomic<bool> release{false};
+    std::atomic<int> counter{0};
+    std::atomic<bool> producer_done{false};
+    {
+        ThreadPool<std::function<void()>> pool(1, 4);
+        pool.Add([&release] {
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        });
+        std::thread producer([&] {
+            for (int i = 0; i < 64; ++i) {
+                pool.Add([&counter] { counter.fetch_add(1); });
+            }
+            producer_done = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        // Единственный поток занят, очередь на 4 задачи заполнена
+        EXPECT_FALSE(producer_done.load());
+        release = true;
+        producer.join();
+    }
+    EXPECT_EQ(counter.load(), 64);
+}
+
+TEST(ThreadPoolTest, AddBatchRunsEveryTaskOnce) {
+    constexpr int TASKS = 5000;
+    std::vector<std::atomic<int>> runs(TASKS);
+    {
+        ThreadPool<UniqueFunction<void()>> pool(4);
+        std::vector<UniqueFunction<void()>> batch;
+        for (int i = 0; i < TASKS; ++i) {
+            batch.emplace_back([&runs, i] { runs[i].fetch_add(1); });
+        }
+        EXPECT_TRUE(pool.AddBatch(batch));
+        EXPECT_TRUE(pool.AddBatch({}));
+    }
+    for (int i = 0; i < TASKS; ++i) {
+        ASSERT_EQ(runs[i].load(), 1) << "задача " << i;
+    }
+}
+
+TEST(ThreadPoolTest, BatchIsSharedBetweenWorkers) {
+    // Остаток пачки крадут соседи: задачи пачки выполняются на нескольких потоках
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    {
+        ThreadPool<UniqueFunction<void()>> pool(4);
+        std::vector<UniqueFunction<void()>> batch;
+        for (int i = 0; i < 64; ++i) {
+            batch.emplace_back([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            });
+        }
+        pool.AddBatch(batch);
+    }
+    EXPECT_GT(threads.size(), 1u);
+}
+
+TEST(ThreadPoolTest, BatchesFromWorkersAndMoveOnlyTasks) {
+    std::atomic<int> sum{0};
+    {
+        ThreadPool<UniqueFunction<void()>> pool(3);
+        for (int directory = 0; directory < 100; ++directory) {
+            pool.Add([&pool, &sum] {
+                std::vector<UniqueFunction<void()>> files;
+                for (int i = 0; i < 50; ++i) {
+                    files.emplace_back([&sum, value = std::make_unique<int>(i)] { sum.fetch_add(*value); });
+                }
+                pool.AddBatch(files);
+            });
+        }
+    }
+    EXPECT_EQ(sum.load(), 100 * (49 * 50 / 2));
+}
+
+TEST(ThreadPoolTest, ExceptionsDoNotStopWorkers) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool<std::function<void()>> pool(1);
+        pool.Add([] { throw std::runtime_error("ошибка задачи"); });
+        pool.Add([&counter] { counter.fetch_add(1); });
+    }
+    EXPECT_EQ(counter.load(), 1);
+}
+
+TEST(ThreadPoolTest, StatsCountTasksAndSwallowedExceptions) {
+    ThreadPool<std::function<void()>> pool(1);
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 3; ++i) {
+        pool.Add([] { throw std::runtime_error("ошибка задачи"); });
+    }
+    for (int i = 0; i < 10; ++i) {
+        pool.Add([&counter] { counter.fetch_add(1); });
+    }
+    while (counter.load() < 10) {
+        std::this_thread::yield();
+    }
+    // Один поток берет задачи по порядку: исключения уже посчитаны
+    PoolStats stats = pool.Stats();
+    EXPECT_EQ(stats.swallowed_exceptions, 3u);
+    ASSERT_EQ(stats.workers.size(), 1u);
+    EXPECT_EQ(stats.enabled, instrumentation::ENABLED);
+    if constexpr (instrumentation::ENABLED) {
+        // Счетчик задачи растет после ее возврата - ждем последнюю
+        while (pool.Stats().workers[0].tasks < 13) {
+            std::this_thread::yield();
+        }
+        stats = pool.Stats();
+        EXPECT_GT(stats.workers[0].busy.count(), 0);
+        EXPECT_EQ(stats.injection.pushes, 13u);
+        EXPECT_EQ(stats.injection.pops, 13u);
+        EXPECT_GE(stats.injection.high_water, 1u);
+    } else {
+        EXPECT_EQ(stats.workers[0].tasks, 0u);
+        EXPECT_EQ(stats.injection.pushes, 0u);
+    }
+}
+
+TEST(ThreadPoolTest, WakesParkedWorkers) {
+    ThreadPool<std::function<void()>> pool(4);
+    for (int round = 0; round < 20; ++round) {
+        // Даем потокам уснуть, затем проверяем, что новая задача их будит
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::atomic<bool> ran{false};
+        pool.Add([&ran] { ran = true; });
+        while (!ran.load()) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include "UniqueFunction.h"
+
+namespace {
+
+// Считает живые копии, чтобы проверить, что объекты разрушаются ровно один раз
+struct Tracked {
+    static inline int alive = 0;
+    Tracked() { ++alive; }
+    Tracked(const Tracked&) { ++alive; }
+    Tracked(Tracked&&) noexcept { ++alive; }
+    ~Tracked() { --alive; }
+};
+
+} // namespace
+
+TEST(UniqueFunctionTest, EmptyThrowsOnCall) {
+    UniqueFunction<void()> function;
+    EXPECT_FALSE(function);
+    EXPECT_THROW(function(), std::bad_function_call);
+
+    UniqueFunction<void()> null_function(nullptr);
+    EXPECT_FALSE(null_function);
+}
+
+TEST(UniqueFunctionTest, HoldsMoveOnlyCallables) {
+    auto value = std::make_unique<int>(41);
+    UniqueFunction<int(int)> function([value = std::move(value)](int delta) { return *value + delta; });
+    ASSERT_TRUE(function);
+    EXPECT_EQ(function(1), 42);
+
+    UniqueFunction<int(int)> moved(std::move(function));
+    EXPECT_FALSE(function);
+    EXPECT_EQ(moved(2), 43);
+}
+
+TEST(UniqueFunctionTest, ForwardsArgumentsByReference) {
+    UniqueFunction<void(std::string&)> append([](std::string& text) { text += "!"; });
+    std::string text = "ok";
+    append(text);
+    EXPECT_EQ(text, "ok!");
+}
+
+TEST(UniqueFunctionTest, InlineAndHeapCallablesDestroyedOnce) {
+    Tracked::alive = 0;
+    {
+        UniqueFunction<void()> small([tracked = Tracked()]() {});
+        // Не помещается во встроенный буфер - хранится в куче
+        std::array<char, UniqueFunction<void()>::INLINE_SIZE + 8> padding {};
+        UniqueFunction<void()> large([tracked = Tracked(), padding]() { (void)padding; });
+        EXPECT_EQ(Tracked::alive, 2);
+
+        UniqueFunction<void()> small_moved(std::move(small));
+        UniqueFunction<void()> large_moved;
+        large_moved = std::move(large);
+        EXPECT_EQ(Tracked::alive, 2);
+
+        small_moved = std::move(large_moved);
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(UniqueFunctionTest, FitsScannerFileTask) {
+    // Замыкание задачи на файл: [this, shared_ptr директории, имя]
+    struct FileTask {
+        void* self;
+        std::shared_ptr<const std::string> directory;
+        std::string name;
+        void operator()() {}
+    };
+    EXPECT_LE(sizeof(FileTask), UniqueFunction<void()>::INLINE_SIZE);
+    EXPECT_EQ(sizeof(UniqueFunction<void()>), 64u);
+}